@@ -2,7 +2,7 @@
 #include "ZQ_FaceRecognizerArcFaceZQCNN.h"
 #include "ZQ_FaceRecognizerSphereFaceZQCNN.h"
 #include "ZQ_FaceDatabaseMaker.h"
-#include "ZQ_CNN_Net.h"
+#include "ZQ_CNN_Model.h"
 #include "ZQ_CNN_CompileConfig.h"
 #if ZQ_CNN_USE_BLAS_GEMM
 #include <openblas\cblas.h>
@@ -41,23 +41,25 @@ int main(int argc, const char** argv)
 	max_thread_num = __max(1, __min(max_thread_num, omp_get_num_procs() - 1));
 	std::vector<ZQ_FaceRecognizer*> recognizers(max_thread_num);
 	
+	/*the recognizers of all threads share one copy of the weights*/
+	ZQ_CNN_Model model;
 	if(1)
 	{
-		ZQ_CNN_Net net;
-		if (!net.LoadFrom(proto_file, model_file, false))
+		if (!model.LoadFrom(proto_file, model_file, false))
 		{
 			printf("failed to load net (%s, %s)\n", proto_file.c_str(), model_file.c_str());
 			return EXIT_FAILURE;
 		}
 
 		int c, h, w;
-		net.GetInputDim(c, h, w);
+		model.GetInputDim(c, h, w);
 		if (c == 3 && h == 112 && w == 112)
 		{
 			for (int i = 0; i < max_thread_num; i++)
 			{
-				recognizers[i] = new ZQ_FaceRecognizerArcFaceZQCNN();
-				if (!recognizers[i]->Init("", proto_file, model_file, out_blob_name))
+				ZQ_FaceRecognizerArcFaceZQCNN* recognizer = new ZQ_FaceRecognizerArcFaceZQCNN();
+				recognizers[i] = recognizer;
+				if (!recognizer->InitShared(model, out_blob_name))
 				{
 					for (int j = 0; j < i; j++)
 						delete recognizers[j];
@@ -68,8 +70,9 @@ int main(int argc, const char** argv)
 		{
 			for (int i = 0; i < max_thread_num; i++)
 			{
-				recognizers[i] = new ZQ_FaceRecognizerSphereFaceZQCNN();
-				if (!recognizers[i]->Init("", proto_file, model_file, out_blob_name))
+				ZQ_FaceRecognizerSphereFaceZQCNN* recognizer = new ZQ_FaceRecognizerSphereFaceZQCNN();
+				recognizers[i] = recognizer;
+				if (!recognizer->InitShared(model, out_blob_name))
 				{
 					for (int j = 0; j < i; j++)
 						delete recognizers[j];
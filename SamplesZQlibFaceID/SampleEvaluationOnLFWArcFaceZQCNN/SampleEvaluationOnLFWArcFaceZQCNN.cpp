@@ -20,12 +20,20 @@ bool EvaluationArcFaceZQCNNOnLFW(const std::string& prototxt_file, const std::st
 	int real_num_threads = __max(1, __min(max_thread_num, omp_get_num_procs() - 1));
 
 	std::vector<ZQ_FaceRecognizer*> recognizers(real_num_threads);
+	/*the recognizers of all threads share one copy of the weights*/
+	ZQ_CNN_Model model;
+	if (!model.LoadFrom(prototxt_file, caffemodel_file))
+	{
+		printf("failed to load prototxt: %s, caffemodel %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
+		return false;
+	}
 	for (int i = 0; i < real_num_threads; i++)
 	{
-		recognizers[i] = new ZQ_FaceRecognizerArcFaceZQCNN();
-		if (!recognizers[i]->Init("", prototxt_file, caffemodel_file, out_blob_name))
+		ZQ_FaceRecognizerArcFaceZQCNN* recognizer = new ZQ_FaceRecognizerArcFaceZQCNN();
+		recognizers[i] = recognizer;
+		if (!recognizer->InitShared(model, out_blob_name))
 		{
-			printf("failed to load prototxt: %s, caffemodel %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
+			printf("failed to init with out_blob_name %s\n", out_blob_name.c_str());
 			return false;
 		}
 	}
@@ -22,12 +22,20 @@ bool EvaluationSphereFaceZQCNNOnLFW(const std::string& prototxt_file, const std:
 
 	std::vector<ZQ_FaceRecognizer*> recognizers(real_num_threads);
 
+	/*the recognizers of all threads share one copy of the weights*/
+	ZQ_CNN_Model model;
+	if (!model.LoadFrom(prototxt_file, caffemodel_file))
+	{
+		printf("failed to load sphereface prototxt: %s, caffemodel %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
+		return false;
+	}
 	for (int i = 0; i < real_num_threads; i++)
 	{
-		recognizers[i] = new ZQ_FaceRecognizerSphereFaceZQCNN();
-		if (!recognizers[i]->Init("", prototxt_file, caffemodel_file, out_blob_name))
+		ZQ_FaceRecognizerSphereFaceZQCNN* recognizer = new ZQ_FaceRecognizerSphereFaceZQCNN();
+		recognizers[i] = recognizer;
+		if (!recognizer->InitShared(model, out_blob_name))
 		{
-			printf("failed to load sphereface prototxt: %s, caffemodel %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
+			printf("failed to init sphereface with out_blob_name %s\n", out_blob_name.c_str());
 			return false;
 		}
 	}
@@ -140,23 +140,22 @@ int make_database(int argc, char** argv, bool compact)
 	max_thread_num = __max(1, __min(omp_get_num_procs() - 1, max_thread_num));
 	std::vector<ZQ_FaceRecognizerArcFaceZQCNN> recognizer_112X112(max_thread_num);
 	std::vector<ZQ_FaceRecognizerSphereFaceZQCNN> recognizer_112X96(max_thread_num);
-	ZQ_CNN_Net* net = new ZQ_CNN_Net();
-	if (!net->LoadFrom(prototxt_file, caffemodel_file, false))
+	/*the recognizers of all threads share one copy of the weights*/
+	ZQ_CNN_Model model;
+	if (!model.LoadFrom(prototxt_file, caffemodel_file, false))
 	{
 		printf("failed to init recognizer with model %s %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
-		delete net;
 		return EXIT_FAILURE;
 	}
 	int c, h, w;
-	net->GetInputDim(c, h, w);
-	delete net;
+	model.GetInputDim(c, h, w);
 
 	std::vector<ZQ_FaceRecognizer*> recognizers;
 	if (c == 3 && h == 112 && w == 112)
 	{
 		for (int i = 0; i < max_thread_num; i++)
 		{
-			if (!recognizer_112X112[i].Init("", prototxt_file, caffemodel_file, out_blob_name))
+			if (!recognizer_112X112[i].InitShared(model, out_blob_name))
 			{
 				printf("failed to init recognizer with model %s %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
 				return EXIT_FAILURE;
@@ -186,7 +185,7 @@ int make_database(int argc, char** argv, bool compact)
 	{
 		for (int i = 0; i < max_thread_num; i++)
 		{
-			if (!recognizer_112X96[i].Init("", prototxt_file, caffemodel_file, out_blob_name))
+			if (!recognizer_112X96[i].InitShared(model, out_blob_name))
 			{
 				printf("failed to init recognizer with model %s %s\n", prototxt_file.c_str(), caffemodel_file.c_str());
 				return EXIT_FAILURE;
@@ -0,0 +1,218 @@
+#ifndef _ZQ_CNN_TEST_UTILS_H_
+#define _ZQ_CNN_TEST_UTILS_H_
+#pragma once
+#include "ZQ_CNN_Tensor4D.h"
+#include "ZQ_CNN_BBox.h"
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+namespace ZQ
+{
+	/*the files of TestsZQCNN/data: an image (.bgr) is int width, int height and the BGR rows, a blob (.ref) is
+	int N, C, H, W and the compact N*C*H*W floats, boxes (.ref) are int count and for each box col1, row1, col2, row2,
+	score and ppoint[10] as floats. The .ref files are the outputs of ZQCNN before the memory plan, Winograd and the
+	other options of the nets were added, written by makeReferences, so a change of the outputs shared by all the
+	options still shows*/
+	class ZQ_CNN_TestUtils
+	{
+	public:
+		class Image
+		{
+		public:
+			int width, height;
+			std::vector<unsigned char> bgr;
+			Image() :width(0), height(0) {}
+
+			/*mirrored left to right*/
+			Image Flip() const
+			{
+				Image dst = *this;
+				for (int h = 0; h < height; h++)
+				{
+					for (int w = 0; w < width; w++)
+						memcpy(&dst.bgr[(h*width + w) * 3], &bgr[(h*width + width - 1 - w) * 3], 3);
+				}
+				return dst;
+			}
+		};
+
+		/*the repository root is the first argument, or ../../ as for the samples*/
+		static std::string GetRootDir(int argc, char** argv)
+		{
+			std::string root = argc > 1 ? argv[1] : "../..";
+			return root + "/";
+		}
+
+		static bool LoadImage(const std::string& file, Image& image)
+		{
+			FILE* in = fopen(file.c_str(), "rb");
+			if (in == 0)
+			{
+				printf("failed to open %s\n", file.c_str());
+				return false;
+			}
+			bool ret = fread(&image.width, sizeof(int), 1, in) == 1 && fread(&image.height, sizeof(int), 1, in) == 1
+				&& image.width > 0 && image.height > 0;
+			if (ret)
+			{
+				image.bgr.resize(image.width*image.height * 3);
+				ret = fread(&image.bgr[0], 1, image.bgr.size(), in) == image.bgr.size();
+			}
+			fclose(in);
+			if (!ret)
+				printf("failed to read %s\n", file.c_str());
+			return ret;
+		}
+
+		static bool SaveBlob(const std::string& file, const ZQ_CNN_Tensor4D& blob)
+		{
+			int dims[4] = { blob.GetN(), blob.GetC(), blob.GetH(), blob.GetW() };
+			std::vector<float> data(dims[0] * dims[1] * dims[2] * dims[3]);
+			blob.ConvertToCompactNCHW(&data[0]);
+			FILE* out = fopen(file.c_str(), "wb");
+			if (out == 0)
+				return false;
+			bool ret = fwrite(dims, sizeof(int), 4, out) == 4 && fwrite(&data[0], sizeof(float), data.size(), out) == data.size();
+			fclose(out);
+			return ret;
+		}
+
+		/*the compact C*H*W floats of each image*/
+		static bool LoadBlob(const std::string& file, std::vector<std::vector<float> >& images)
+		{
+			FILE* in = fopen(file.c_str(), "rb");
+			if (in == 0)
+			{
+				printf("failed to open %s\n", file.c_str());
+				return false;
+			}
+			int dims[4];
+			bool ret = fread(dims, sizeof(int), 4, in) == 4;
+			if (ret)
+			{
+				images.resize(dims[0]);
+				for (int n = 0; n < dims[0] && ret; n++)
+				{
+					images[n].resize(dims[1] * dims[2] * dims[3]);
+					ret = fread(&images[n][0], sizeof(float), images[n].size(), in) == images[n].size();
+				}
+			}
+			fclose(in);
+			if (!ret)
+				printf("failed to read %s\n", file.c_str());
+			return ret;
+		}
+
+		static bool SaveBoxes(const std::string& file, const std::vector<ZQ_CNN_BBox>& boxes)
+		{
+			FILE* out = fopen(file.c_str(), "wb");
+			if (out == 0)
+				return false;
+			int count = boxes.size();
+			bool ret = fwrite(&count, sizeof(int), 1, out) == 1;
+			for (int i = 0; i < count && ret; i++)
+			{
+				float vals[15] = { (float)boxes[i].col1, (float)boxes[i].row1, (float)boxes[i].col2, (float)boxes[i].row2,
+					boxes[i].score };
+				memcpy(vals + 5, boxes[i].ppoint, sizeof(float) * 10);
+				ret = fwrite(vals, sizeof(float), 15, out) == 15;
+			}
+			fclose(out);
+			return ret;
+		}
+
+		static bool LoadBoxes(const std::string& file, std::vector<ZQ_CNN_BBox>& boxes)
+		{
+			FILE* in = fopen(file.c_str(), "rb");
+			if (in == 0)
+			{
+				printf("failed to open %s\n", file.c_str());
+				return false;
+			}
+			int count = 0;
+			bool ret = fread(&count, sizeof(int), 1, in) == 1 && count >= 0;
+			boxes.resize(ret ? count : 0);
+			for (int i = 0; i < boxes.size() && ret; i++)
+			{
+				float vals[15];
+				ret = fread(vals, sizeof(float), 15, in) == 15;
+				boxes[i].col1 = vals[0];
+				boxes[i].row1 = vals[1];
+				boxes[i].col2 = vals[2];
+				boxes[i].row2 = vals[3];
+				boxes[i].score = vals[4];
+				memcpy(boxes[i].ppoint, vals + 5, sizeof(float) * 10);
+			}
+			fclose(in);
+			if (!ret)
+				printf("failed to read %s\n", file.c_str());
+			return ret;
+		}
+
+		/*max |a - ref| / max |ref|, a is image n of the blob*/
+		static float RelativeDiff(const ZQ_CNN_Tensor4D& a, const std::vector<float>& ref, int n = 0)
+		{
+			std::vector<float> data(a.GetN()*a.GetC()*a.GetH()*a.GetW());
+			if (data.size() == 0)
+				return 1e30f;
+			a.ConvertToCompactNCHW(&data[0]);
+			return RelativeDiff(data, ref, n);
+		}
+
+		static float RelativeDiff(const std::vector<float>& a, const std::vector<float>& ref, int n = 0)
+		{
+			int len = ref.size();
+			if (a.size() < (n + 1)*len)
+				return 1e30f;
+			float max_val = 1e-30f, max_diff = 0;
+			for (int j = 0; j < len; j++)
+			{
+				max_val = __max(max_val, fabs(ref[j]));
+				max_diff = __max(max_diff, fabs(a[n*len + j] - ref[j]));
+			}
+			return max_diff / max_val;
+		}
+
+		static float CosineSimilarity(const std::vector<float>& a, const std::vector<float>& b)
+		{
+			double score = 0, len0 = 0, len1 = 0;
+			for (int i = 0; i < __min(a.size(), b.size()); i++)
+			{
+				score += a[i] * b[i];
+				len0 += a[i] * a[i];
+				len1 += b[i] * b[i];
+			}
+			return score / (sqrt(len0*len1) + 1e-64);
+		}
+
+		/*the max difference of the corners and the landmarks in pixels, or of the scores times score_weight,
+		1e30 if the numbers of boxes differ*/
+		static float BoxesDiff(const std::vector<ZQ_CNN_BBox>& a, const std::vector<ZQ_CNN_BBox>& b, float score_weight)
+		{
+			if (a.size() != b.size())
+				return 1e30f;
+			float diff = 0;
+			for (int i = 0; i < a.size(); i++)
+			{
+				diff = __max(diff, __max(fabs((float)a[i].col1 - b[i].col1), fabs((float)a[i].row1 - b[i].row1)));
+				diff = __max(diff, __max(fabs((float)a[i].col2 - b[i].col2), fabs((float)a[i].row2 - b[i].row2)));
+				for (int j = 0; j < 10; j++)
+					diff = __max(diff, fabs(a[i].ppoint[j] - b[i].ppoint[j]));
+				diff = __max(diff, fabs(a[i].score - b[i].score)*score_weight);
+			}
+			return diff;
+		}
+
+		/*prints the check and returns whether it passed*/
+		static bool Check(const std::string& name, float diff, float max_diff)
+		{
+			bool passed = diff <= max_diff;
+			printf("%-48s diff %-12g%s\n", name.c_str(), diff, passed ? "" : " FAILED");
+			return passed;
+		}
+	};
+}
+#endif
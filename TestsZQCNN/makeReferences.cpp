@@ -0,0 +1,108 @@
+#include "ZQ_CNN_Net.h"
+#include "ZQ_CNN_MTCNN.h"
+#include "ZQ_CNN_TestUtils.h"
+#include <vector>
+#include <iostream>
+using namespace ZQ;
+using namespace std;
+
+static bool save_net_outputs(ZQ_CNN_Net& net, ZQ_CNN_Tensor4D& input, const std::vector<std::string>& names,
+	const std::string& ref_prefix)
+{
+	if (!net.Forward(input))
+		return false;
+	for (int i = 0; i < names.size(); i++)
+	{
+		const ZQ_CNN_Tensor4D* ptr = net.GetBlobByName(names[i]);
+		if (ptr == 0 || !ZQ_CNN_TestUtils::SaveBlob(ref_prefix + "_" + names[i] + ".ref", *ptr))
+			return false;
+	}
+	return true;
+}
+
+/*writes the .ref files of TestsZQCNN/data with this build, the tests compare the nets with them. It is not built by
+default, and should only be run with a version of ZQCNN whose outputs are known to be right (the files in the repository
+were made with ZQCNN before the memory plan, Winograd and the other options of the nets were added)*/
+int main(int argc, char** argv)
+{
+	std::string root = ZQ_CNN_TestUtils::GetRootDir(argc, argv);
+	std::string data_dir = root + "TestsZQCNN/data/";
+
+	//testInt8
+	ZQ_CNN_Net mobilefacenet;
+	if (!mobilefacenet.LoadFrom(root + "model/mobilefacenet-v1.zqparams", root + "model/mobilefacenet-v1.nchwbin"))
+	{
+		cout << "failed to load mobilefacenet\n";
+		return EXIT_FAILURE;
+	}
+	const char* face_names[2] = { "00_", "01_" };
+	for (int i = 0; i < 2; i++)
+	{
+		ZQ_CNN_TestUtils::Image image;
+		ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
+		if (!ZQ_CNN_TestUtils::LoadImage(data_dir + face_names[i] + ".bgr", image)
+			|| !input.ConvertFromBGR(&image.bgr[0], image.width, image.height, image.width * 3, 0, 1)
+			|| !save_net_outputs(mobilefacenet, input, std::vector<std::string>(1, "fc5"),
+				data_dir + "mobilefacenet-v1_" + face_names[i]))
+		{
+			cout << "failed to run mobilefacenet on " << face_names[i] << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	//testNetOptions
+	ZQ_CNN_Net libfacedetection;
+	if (!libfacedetection.LoadFrom(root + "model/libfacedetection.zqparams", root + "model/libfacedetection.nchwbin"))
+	{
+		cout << "failed to load libfacedetection\n";
+		return EXIT_FAILURE;
+	}
+	std::vector<std::string> out_names;
+	out_names.push_back("mbox_loc");
+	out_names.push_back("mbox_conf_flatten");
+	const char* image_names[2] = { "4_320x240", "11_320x240" };
+	for (int i = 0; i < 2; i++)
+	{
+		ZQ_CNN_TestUtils::Image image;
+		ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
+		if (!ZQ_CNN_TestUtils::LoadImage(data_dir + image_names[i] + ".bgr", image)
+			|| !input.ConvertFromBGR(&image.bgr[0], image.width, image.height, image.width * 3)
+			|| !save_net_outputs(libfacedetection, input, out_names, data_dir + "libfacedetection_" + image_names[i]))
+		{
+			cout << "failed to run libfacedetection on " << image_names[i] << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	//testMTCNNModes, the third image is the first one mirrored
+	ZQ_CNN_MTCNN mtcnn;
+	if (!mtcnn.Init(root + "model/det1.zqparams", root + "model/det1_bgr.nchwbin",
+		root + "model/det2.zqparams", root + "model/det2_bgr.nchwbin",
+		root + "model/det3.zqparams", root + "model/det3_bgr.nchwbin", 1, true,
+		root + "model/det4-dw48-v2s.zqparams", root + "model/det4-dw48-v2s.nchwbin"))
+	{
+		cout << "failed to init mtcnn\n";
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		ZQ_CNN_TestUtils::Image image;
+		if (!ZQ_CNN_TestUtils::LoadImage(data_dir + image_names[i % 2] + ".bgr", image))
+			return EXIT_FAILURE;
+		if (i == 2)
+			image = image.Flip();
+		mtcnn.SetPara(image.width, image.height, 20, 0.6, 0.7, 0.7, 0.4, 0.5, 0.5, 0.709, 4, 12, 2);
+		std::vector<ZQ_CNN_BBox> boxes;
+		std::string name = std::string(image_names[i % 2]) + (i == 2 ? "_flip" : "");
+		if (!mtcnn.Find(&image.bgr[0], image.width, image.height, image.width * 3, boxes)
+			|| !ZQ_CNN_TestUtils::SaveBoxes(data_dir + "mtcnn_" + name + ".ref", boxes))
+		{
+			cout << "failed to run mtcnn on " << name << "\n";
+			return EXIT_FAILURE;
+		}
+		printf("%s: %d faces\n", name.c_str(), (int)boxes.size());
+	}
+
+	cout << "done\n";
+	return EXIT_SUCCESS;
+}
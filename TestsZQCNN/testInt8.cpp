@@ -0,0 +1,106 @@
+#include "ZQ_CNN_Net.h"
+#include "ZQ_CNN_TestUtils.h"
+#include <vector>
+#include <iostream>
+using namespace ZQ;
+using namespace std;
+
+/*the blob fc5 of the latest Forward, compact C*H*W*/
+static bool get_feature(ZQ_CNN_Net& net, std::vector<float>& feat)
+{
+	const ZQ_CNN_Tensor4D* ptr = net.GetBlobByName("fc5");
+	if (ptr == 0)
+		return false;
+	feat.resize(ptr->GetC()*ptr->GetH()*ptr->GetW());
+	ptr->ConvertToCompactNCHW(&feat[0]);
+	return true;
+}
+
+/*calibrate MobileFaceNet to int8 on two faces and their mirrors, save it, load it back both from the int8_scale of the
+saved param file and from the saved int8 weights, and check the features against the stored float features*/
+int main(int argc, char** argv)
+{
+	std::string root = ZQ_CNN_TestUtils::GetRootDir(argc, argv);
+	std::string param_file = root + "model/mobilefacenet-v1.zqparams";
+	std::string model_file = root + "model/mobilefacenet-v1.nchwbin";
+	std::string int8_param_file = "mobilefacenet-v1-int8.zqparams";
+	std::string int8_model_file = "mobilefacenet-v1-int8.int8bin";
+	const char* face_names[2] = { "00_", "01_" };
+	const float max_float_diff = 1e-4f;
+	const float min_similarity = 0.98f;
+
+	std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> inputs(4);
+	std::vector<std::vector<float> > refs(2);
+	for (int i = 0; i < 2; i++)
+	{
+		ZQ_CNN_TestUtils::Image image, mirror;
+		std::vector<std::vector<float> > ref;
+		std::string data_name = root + "TestsZQCNN/data/" + face_names[i];
+		if (!ZQ_CNN_TestUtils::LoadImage(data_name + ".bgr", image)
+			|| !ZQ_CNN_TestUtils::LoadBlob(root + "TestsZQCNN/data/mobilefacenet-v1_" + face_names[i] + "_fc5.ref", ref))
+			return EXIT_FAILURE;
+		refs[i] = ref[0];
+		mirror = image.Flip();
+		inputs[i * 2].ConvertFromBGR(&image.bgr[0], image.width, image.height, image.width * 3, 0, 1);
+		inputs[i * 2 + 1].ConvertFromBGR(&mirror.bgr[0], mirror.width, mirror.height, mirror.width * 3, 0, 1);
+	}
+	std::vector<ZQ_CNN_Tensor4D*> samples;
+	for (int i = 0; i < inputs.size(); i++)
+		samples.push_back(&inputs[i]);
+
+	ZQ_CNN_Net float_net, int8_net, int8_param_net, int8_model_net;
+	if (!float_net.LoadFrom(param_file, model_file) || !int8_net.LoadFrom(param_file, model_file))
+	{
+		cout << "failed to load net\n";
+		return EXIT_FAILURE;
+	}
+	float_net.TurnOffInt8();
+	if (!int8_net.CalibrateInt8(samples))
+	{
+		cout << "failed to calibrate\n";
+		return EXIT_FAILURE;
+	}
+	if (!int8_net.SaveInt8Param(param_file, int8_param_file, int8_model_file))
+	{
+		cout << "failed to save int8 net\n";
+		return EXIT_FAILURE;
+	}
+	if (!int8_param_net.LoadFrom(int8_param_file, model_file)
+		|| !int8_model_net.LoadFrom(int8_param_file, model_file, false, 1e-12, false, int8_model_file))
+	{
+		cout << "failed to load int8 net\n";
+		return EXIT_FAILURE;
+	}
+
+	bool passed = true;
+	for (int i = 0; i < 2; i++)
+	{
+		ZQ_CNN_Tensor4D& input = inputs[i * 2];
+		std::vector<float> float_feat, int8_feat, param_feat, model_feat;
+		if (!float_net.Forward(input) || !get_feature(float_net, float_feat)
+			|| !int8_net.Forward(input) || !get_feature(int8_net, int8_feat)
+			|| !int8_param_net.Forward(input) || !get_feature(int8_param_net, param_feat)
+			|| !int8_model_net.Forward(input) || !get_feature(int8_model_net, model_feat))
+		{
+			cout << "failed to run\n";
+			return EXIT_FAILURE;
+		}
+		std::string name = face_names[i];
+		passed = ZQ_CNN_TestUtils::Check(name + " float", ZQ_CNN_TestUtils::RelativeDiff(float_feat, refs[i]),
+			max_float_diff) && passed;
+		passed = ZQ_CNN_TestUtils::Check(name + " int8 (1 - similarity)",
+			1 - ZQ_CNN_TestUtils::CosineSimilarity(int8_feat, refs[i]), 1 - min_similarity) && passed;
+		passed = ZQ_CNN_TestUtils::Check(name + " int8 reloaded from param",
+			ZQ_CNN_TestUtils::RelativeDiff(param_feat, int8_feat), 0) && passed;
+		passed = ZQ_CNN_TestUtils::Check(name + " int8 reloaded from int8 model",
+			ZQ_CNN_TestUtils::RelativeDiff(model_feat, int8_feat), 0) && passed;
+	}
+
+	if (!passed)
+	{
+		cout << "check failed\n";
+		return EXIT_FAILURE;
+	}
+	cout << "check passed\n";
+	return EXIT_SUCCESS;
+}
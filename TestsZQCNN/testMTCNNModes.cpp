@@ -0,0 +1,103 @@
+#include "ZQ_CNN_MTCNN.h"
+#include "ZQ_CNN_TestUtils.h"
+#include <vector>
+#include <iostream>
+using namespace ZQ;
+using namespace std;
+
+/*Find must give the stored boxes, scores and landmarks up to rounding, FindBatch on one image and FindVideo on a
+keyframe must give the same as Find. FindBatch on all the images in groups of two puts the faces of two images in one
+batch, which is split over the threads in other batches than Find, so it is compared with the stored results up to
+rounding, with and without the overlap of Pnet and the other nets*/
+int main(int argc, char** argv)
+{
+	std::string root = ZQ_CNN_TestUtils::GetRootDir(argc, argv);
+	std::string model_dir = root + "model/";
+	//the third image is the first one mirrored
+	const int image_num = 3;
+	const char* image_names[image_num] = { "4_320x240", "11_320x240", "4_320x240_flip" };
+	const float max_pixel_diff = 0.02f;
+	const float score_weight = 1000;
+
+	std::vector<ZQ_CNN_TestUtils::Image> images(image_num);
+	std::vector<std::vector<ZQ_CNN_BBox> > refs(image_num);
+	std::vector<ZQ_CNN_MTCNN::ImageRef> image_refs;
+	for (int i = 0; i < image_num; i++)
+	{
+		if (i < 2 && !ZQ_CNN_TestUtils::LoadImage(root + "TestsZQCNN/data/" + image_names[i] + ".bgr", images[i]))
+			return EXIT_FAILURE;
+		if (i == 2)
+			images[i] = images[0].Flip();
+		if (!ZQ_CNN_TestUtils::LoadBoxes(root + "TestsZQCNN/data/mtcnn_" + image_names[i] + ".ref", refs[i]))
+			return EXIT_FAILURE;
+		image_refs.push_back(ZQ_CNN_MTCNN::ImageRef(&images[i].bgr[0], images[i].width, images[i].height,
+			images[i].width * 3));
+	}
+
+	bool passed = true;
+	int thread_nums[2] = { 1, 4 };
+	for (int t = 0; t < 2; t++)
+	{
+		ZQ_CNN_MTCNN mtcnn;
+		if (!mtcnn.Init(model_dir + "det1.zqparams", model_dir + "det1_bgr.nchwbin",
+			model_dir + "det2.zqparams", model_dir + "det2_bgr.nchwbin",
+			model_dir + "det3.zqparams", model_dir + "det3_bgr.nchwbin", thread_nums[t], true,
+			model_dir + "det4-dw48-v2s.zqparams", model_dir + "det4-dw48-v2s.nchwbin"))
+		{
+			cout << "failed to init\n";
+			return EXIT_FAILURE;
+		}
+		mtcnn.SetPara(images[0].width, images[0].height, 20, 0.6, 0.7, 0.7, 0.4, 0.5, 0.5, 0.709, 4, 12, 2);
+		char prefix[100];
+		sprintf(prefix, "%d threads ", thread_nums[t]);
+
+		std::vector<std::vector<ZQ_CNN_BBox> > find_boxes(image_num), batch_boxes;
+		for (int i = 0; i < image_num; i++)
+		{
+			std::string name = prefix + std::string(image_names[i]);
+			std::vector<ZQ_CNN_BBox> boxes;
+			mtcnn.Find(image_refs[i].bgr_img, image_refs[i].width, image_refs[i].height, image_refs[i].widthStep,
+				find_boxes[i]);
+			passed = ZQ_CNN_TestUtils::Check(name + " Find",
+				ZQ_CNN_TestUtils::BoxesDiff(find_boxes[i], refs[i], score_weight), max_pixel_diff) && passed;
+			if (!mtcnn.FindBatch(std::vector<ZQ_CNN_MTCNN::ImageRef>(1, image_refs[i]), batch_boxes, 1))
+			{
+				cout << "failed to run FindBatch\n";
+				return EXIT_FAILURE;
+			}
+			passed = ZQ_CNN_TestUtils::Check(name + " FindBatch of one image",
+				ZQ_CNN_TestUtils::BoxesDiff(batch_boxes[0], find_boxes[i], score_weight), 0) && passed;
+			mtcnn.ResetVideo();
+			mtcnn.FindVideo(image_refs[i].bgr_img, image_refs[i].width, image_refs[i].height, image_refs[i].widthStep,
+				boxes);
+			passed = ZQ_CNN_TestUtils::Check(name + " FindVideo on a keyframe",
+				ZQ_CNN_TestUtils::BoxesDiff(boxes, find_boxes[i], score_weight), 0) && passed;
+		}
+		for (int overlap = 0; overlap < 2; overlap++)
+		{
+			if (overlap)
+				mtcnn.TurnOnBatchOverlap();
+			else
+				mtcnn.TurnOffBatchOverlap();
+			if (!mtcnn.FindBatch(image_refs, batch_boxes, 2))
+			{
+				cout << "failed to run FindBatch\n";
+				return EXIT_FAILURE;
+			}
+			for (int i = 0; i < image_num; i++)
+			{
+				passed = ZQ_CNN_TestUtils::Check(prefix + std::string(image_names[i])
+					+ (overlap ? " FindBatch, overlap" : " FindBatch"),
+					ZQ_CNN_TestUtils::BoxesDiff(batch_boxes[i], refs[i], score_weight), max_pixel_diff) && passed;
+			}
+		}
+	}
+
+	if (!passed)
+	{
+		cout << "check failed\n";
+		return EXIT_FAILURE;
+	}
+	cout << "check passed\n";
+	return EXIT_SUCCESS;
+}
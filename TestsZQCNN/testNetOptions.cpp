@@ -0,0 +1,177 @@
+#include "ZQ_CNN_Model.h"
+#include "ZQ_CNN_AsyncNet.h"
+#include "ZQ_CNN_GemmTuner.h"
+#include "ZQ_CNN_TestUtils.h"
+#include <vector>
+#include <iostream>
+using namespace ZQ;
+using namespace std;
+
+/*max relative diff of the wanted blobs of the latest Forward (image n of each) to the stored outputs*/
+static float outputs_diff(ZQ_CNN_ExecContext& net, const std::vector<std::string>& names,
+	const std::vector<std::vector<float> >& refs, int n = 0)
+{
+	float diff = 0;
+	for (int i = 0; i < names.size(); i++)
+	{
+		const ZQ_CNN_Tensor4D* ptr = net.GetBlobByName(names[i]);
+		if (ptr == 0)
+			return 1e30f;
+		diff = __max(diff, ZQ_CNN_TestUtils::RelativeDiff(*ptr, refs[i], n));
+	}
+	return diff;
+}
+
+/*run libfacedetection (concat, permute, flatten and reshape layers, 3x3 convolutions) with each option of the net, in a
+batch of two images, through ZQ_CNN_AsyncNet, and after tuning the gemm, and compare with the stored outputs*/
+int main(int argc, char** argv)
+{
+	std::string root = ZQ_CNN_TestUtils::GetRootDir(argc, argv);
+	std::string param_file = root + "model/libfacedetection.zqparams";
+	std::string model_file = root + "model/libfacedetection.nchwbin";
+	std::string gemm_cache_file = "libfacedetection.gemmcache";
+	const char* image_names[2] = { "4_320x240", "11_320x240" };
+	std::vector<std::string> names;
+	names.push_back("mbox_loc");
+	names.push_back("mbox_conf_flatten");
+	const float max_diff = 1e-4f;
+	const int thread_num = 4;
+
+	ZQ_CNN_Model model;
+	if (!model.LoadFrom(param_file, model_file))
+	{
+		cout << "failed to load model\n";
+		return EXIT_FAILURE;
+	}
+	int C, H, W;
+	std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> inputs(2);
+	ZQ_CNN_Tensor4D_NHW_C_Align128bit batch_input;
+	std::vector<float> batch_data;
+	std::vector<std::vector<std::vector<float> > > refs(2, std::vector<std::vector<float> >(names.size()));
+	for (int i = 0; i < 2; i++)
+	{
+		ZQ_CNN_TestUtils::Image image;
+		if (!ZQ_CNN_TestUtils::LoadImage(root + "TestsZQCNN/data/" + image_names[i] + ".bgr", image))
+			return EXIT_FAILURE;
+		for (int j = 0; j < names.size(); j++)
+		{
+			std::vector<std::vector<float> > ref;
+			if (!ZQ_CNN_TestUtils::LoadBlob(root + "TestsZQCNN/data/libfacedetection_" + image_names[i] + "_"
+				+ names[j] + ".ref", ref))
+				return EXIT_FAILURE;
+			refs[i][j] = ref[0];
+		}
+		inputs[i].ConvertFromBGR(&image.bgr[0], image.width, image.height, image.width * 3);
+		C = inputs[i].GetC();
+		H = inputs[i].GetH();
+		W = inputs[i].GetW();
+		batch_data.resize(C*H*W * 2);
+		inputs[i].ConvertToCompactNCHW(&batch_data[C*H*W*i]);
+	}
+	batch_input.ConvertFromCompactNCHW(&batch_data[0], 2, C, H, W);
+
+	//each net turns on one option over float, no winograd, no band epilogue, one thread, one layer at a time
+	const int net_num = 6;
+	const char* net_names[net_num] = { "plain", "winograd", "band epilogue", "memory plan", "dag schedule", "all on" };
+	std::vector<ZQ_CNN_ExecContext> nets(net_num);
+	for (int k = 0; k < net_num; k++)
+	{
+		if (!nets[k].Init(model))
+		{
+			cout << "failed to init\n";
+			return EXIT_FAILURE;
+		}
+		nets[k].TurnOffInt8();
+		if (k < net_num - 1)
+		{
+			nets[k].TurnOffWinograd();
+			nets[k].TurnOffBandEpilogue();
+		}
+	}
+	nets[1].TurnOnWinograd();
+	nets[2].TurnOnBandEpilogue();
+	nets[3].TurnOnMemoryPlan();
+	nets[4].SetNumThreads(thread_num);
+	nets[4].TurnOnDAGSchedule();
+	ZQ_CNN_ExecContext& all_net = nets[net_num - 1];
+	all_net.TurnOnMemoryPlan();
+	all_net.SetNumThreads(thread_num);
+	all_net.TurnOnDAGSchedule();
+
+	bool passed = true;
+	for (int i = 0; i < 2; i++)
+	{
+		for (int k = 0; k < net_num; k++)
+		{
+			if (!nets[k].Forward(inputs[i], names))
+			{
+				cout << "failed to run\n";
+				return EXIT_FAILURE;
+			}
+			passed = ZQ_CNN_TestUtils::Check(std::string(image_names[i]) + " " + net_names[k],
+				outputs_diff(nets[k], names, refs[i]), max_diff) && passed;
+		}
+	}
+
+	//the concat and reshape views are made for each shape, N = 2 gives other strides than N = 1
+	if (!all_net.Forward(batch_input, names))
+	{
+		cout << "failed to run\n";
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		passed = ZQ_CNN_TestUtils::Check(std::string(image_names[i]) + " all on, batch of two",
+			outputs_diff(all_net, names, refs[i], i), max_diff) && passed;
+	}
+
+	ZQ_CNN_AsyncNet async_net;
+	if (!async_net.Init(model, names, 4, 20000, 1, thread_num))
+	{
+		cout << "failed to init ZQ_CNN_AsyncNet\n";
+		return EXIT_FAILURE;
+	}
+	std::vector<std::future<ZQ_CNN_AsyncNet::Result> > futures;
+	for (int j = 0; j < 4; j++)
+		futures.push_back(async_net.Submit(inputs[j % 2]));
+	for (int j = 0; j < 4; j++)
+	{
+		ZQ_CNN_AsyncNet::Result result = futures[j].get();
+		if (!result.succeeded)
+		{
+			cout << "failed to run ZQ_CNN_AsyncNet\n";
+			return EXIT_FAILURE;
+		}
+		float diff = 0;
+		for (int i = 0; i < result.outputs.size(); i++)
+			diff = __max(diff, ZQ_CNN_TestUtils::RelativeDiff(result.outputs[i].data, refs[j % 2][i]));
+		char name[100];
+		sprintf(name, "ZQ_CNN_AsyncNet request %d (batch size %d)", j, result.batch_size);
+		passed = ZQ_CNN_TestUtils::Check(name, diff, max_diff) && passed;
+	}
+	async_net.Stop();
+
+	if (!all_net.TuneGemm(gemm_cache_file) || !ZQ_CNN_GemmTuner::LoadCache(gemm_cache_file))
+	{
+		cout << "failed to tune gemm\n";
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (!all_net.Forward(inputs[i], names))
+		{
+			cout << "failed to run\n";
+			return EXIT_FAILURE;
+		}
+		passed = ZQ_CNN_TestUtils::Check(std::string(image_names[i]) + " all on, tuned gemm",
+			outputs_diff(all_net, names, refs[i]), max_diff) && passed;
+	}
+
+	if (!passed)
+	{
+		cout << "check failed\n";
+		return EXIT_FAILURE;
+	}
+	cout << "check passed\n";
+	return EXIT_SUCCESS;
+}
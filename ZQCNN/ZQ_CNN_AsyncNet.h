@@ -0,0 +1,301 @@
+#ifndef _ZQ_CNN_ASYNC_NET_H_
+#define _ZQ_CNN_ASYNC_NET_H_
+#pragma once
+#include "ZQ_CNN_Model.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <chrono>
+
+namespace ZQ
+{
+	/*an asynchronous front end of a ZQ_CNN_Model for serving. Submit queues one image and returns a future, a worker
+	takes the queued images of the same size as the oldest one (at most max_batch_size, and waits for more at most
+	max_wait_us after the oldest one was submitted), runs them as one batch, and gives each image its own outputs.
+	A batch of N > 1 images uses the batch gemm of the convolutions and inner products*/
+	class ZQ_CNN_AsyncNet
+	{
+	public:
+		/*one wanted output of one image, compact C*H*W*/
+		class Output
+		{
+		public:
+			int C, H, W;
+			std::vector<float> data;
+			Output() :C(0), H(0), W(0) {}
+		};
+
+		class Result
+		{
+		public:
+			bool succeeded;
+			std::vector<Output> outputs;	//in the order of output_names
+			int batch_size;		//the number of images run in the same Forward
+			Result() :succeeded(false), batch_size(0) {}
+		};
+
+		ZQ_CNN_AsyncNet() :max_batch_size(1), max_wait_us(0), stop(true), num_batches(0), num_images(0) {}
+		~ZQ_CNN_AsyncNet() { Stop(); }
+
+		/*the model must be loaded before, and should live longer than this. The outputs must keep N of the input
+		(e.g. features or scores per image). num_workers batches can run at the same time, each with num_threads threads*/
+		bool Init(const ZQ_CNN_Model& model, const std::vector<std::string>& output_names, int max_batch_size = 8,
+			int max_wait_us = 2000, int num_workers = 1, int num_threads = 1)
+		{
+			Stop();
+			if (output_names.size() == 0)
+				return false;
+			num_workers = __max(1, num_workers);
+			contexts.clear();
+			contexts.resize(num_workers);
+			for (int i = 0; i < num_workers; i++)
+			{
+				if (!contexts[i].Init(model))
+				{
+					contexts.clear();
+					return false;
+				}
+				contexts[i].SetNumThreads(num_threads);
+				contexts[i].TurnOnMemoryPlan();	//Forward keeps the output_names
+			}
+			this->output_names = output_names;
+			this->max_batch_size = __max(1, max_batch_size);
+			this->max_wait_us = __max(0, max_wait_us);
+			num_batches = 0;
+			num_images = 0;
+			stop = false;
+			for (int i = 0; i < num_workers; i++)
+				workers.push_back(std::thread(&ZQ_CNN_AsyncNet::_worker_loop, this, i));
+			return true;
+		}
+
+		/*the running batches are finished, the queued images fail*/
+		void Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			cond.notify_all();
+			for (int i = 0; i < workers.size(); i++)
+				workers[i].join();
+			workers.clear();
+			std::lock_guard<std::mutex> lock(mutex);
+			while (queue.size() > 0)
+			{
+				queue.front()->promise.set_value(Result());
+				delete queue.front();
+				queue.pop_front();
+			}
+		}
+
+		/*input must have N = 1, it is copied before return*/
+		std::future<Result> Submit(const ZQ_CNN_Tensor4D& input)
+		{
+			Request* request = new Request();
+			std::future<Result> future = request->promise.get_future();
+			if (input.GetN() != 1 || input.GetC() <= 0 || input.GetH() <= 0 || input.GetW() <= 0)
+			{
+				request->promise.set_value(Result());
+				delete request;
+				return future;
+			}
+			request->C = input.GetC();
+			request->H = input.GetH();
+			request->W = input.GetW();
+			request->data.resize(request->C*request->H*request->W);
+			input.ConvertToCompactNCHW(&request->data[0]);
+			_push(request);
+			return future;
+		}
+
+		/*data is compact C*H*W, it is copied before return*/
+		std::future<Result> Submit(const float* data, int C, int H, int W)
+		{
+			Request* request = new Request();
+			std::future<Result> future = request->promise.get_future();
+			if (data == 0 || C <= 0 || H <= 0 || W <= 0)
+			{
+				request->promise.set_value(Result());
+				delete request;
+				return future;
+			}
+			request->C = C;
+			request->H = H;
+			request->W = W;
+			request->data.assign(data, data + C*H*W);
+			_push(request);
+			return future;
+		}
+
+		/*the number of Forward and of images since Init*/
+		void GetBatchStat(__int64& num_batches, __int64& num_images)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			num_batches = this->num_batches;
+			num_images = this->num_images;
+		}
+
+	private:
+		class Request
+		{
+		public:
+			int C, H, W;
+			std::vector<float> data;
+			std::chrono::steady_clock::time_point submit_time;
+			std::promise<Result> promise;
+		};
+
+		std::vector<ZQ_CNN_ExecContext> contexts;
+		std::vector<std::string> output_names;
+		int max_batch_size;
+		int max_wait_us;
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;	//for queue, stop and the stat
+		std::condition_variable cond;
+		std::deque<Request*> queue;
+		bool stop;
+		__int64 num_batches, num_images;
+
+		void _push(Request* request)
+		{
+			request->submit_time = std::chrono::steady_clock::now();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!stop)
+				{
+					queue.push_back(request);
+					request = 0;
+				}
+			}
+			if (request)
+			{
+				request->promise.set_value(Result());
+				delete request;
+				return;
+			}
+			cond.notify_all();
+		}
+
+		static bool _same_size(const Request* a, const Request* b)
+		{
+			return a->C == b->C && a->H == b->H && a->W == b->W;
+		}
+
+		/*with the mutex*/
+		int _count_same_size_as_oldest() const
+		{
+			int count = 0;
+			for (int i = 0; i < queue.size() && count < max_batch_size; i++)
+			{
+				if (_same_size(queue[i], queue[0]))
+					count++;
+			}
+			return count;
+		}
+
+		/*wait for a full batch, or the deadline of the oldest image, false if stopped*/
+		bool _take_batch(std::vector<Request*>& batch)
+		{
+			batch.clear();
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				if (stop)
+					return false;
+				if (queue.size() == 0)
+				{
+					cond.wait(lock);
+					continue;
+				}
+				std::chrono::steady_clock::time_point deadline = queue.front()->submit_time + std::chrono::microseconds(max_wait_us);
+				if (_count_same_size_as_oldest() >= max_batch_size || std::chrono::steady_clock::now() >= deadline)
+					break;
+				cond.wait_until(lock, deadline);
+			}
+			Request* oldest = queue.front();
+			for (int i = 0; i < queue.size() && batch.size() < max_batch_size;)
+			{
+				if (_same_size(queue[i], oldest))
+				{
+					batch.push_back(queue[i]);
+					queue.erase(queue.begin() + i);
+				}
+				else
+					i++;
+			}
+			num_batches++;
+			num_images += batch.size();
+			return true;
+		}
+
+		void _worker_loop(int worker_id)
+		{
+			ZQ_CNN_ExecContext& context = contexts[worker_id];
+			ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
+			std::vector<float> batch_data;
+			std::vector<Request*> batch;
+			while (_take_batch(batch))
+			{
+				int N = batch.size();
+				int C = batch[0]->C, H = batch[0]->H, W = batch[0]->W;
+				int CHW = C*H*W;
+				batch_data.resize((__int64)N*CHW);
+				for (int n = 0; n < N; n++)
+					memcpy(&batch_data[(__int64)n*CHW], &batch[n]->data[0], sizeof(float)*CHW);
+
+				std::vector<Result> results(N);
+				bool ret = input.ConvertFromCompactNCHW(&batch_data[0], N, C, H, W)
+					&& context.Forward(input, output_names);
+				for (int i = 0; i < output_names.size() && ret; i++)
+				{
+					const ZQ_CNN_Tensor4D* blob = context.GetBlobByName(output_names[i]);
+					if (blob == 0 || blob->GetN() != N)
+					{
+						ret = false;
+						break;
+					}
+					for (int n = 0; n < N; n++)
+						_get_slice(*blob, n, results[n]);
+				}
+				for (int n = 0; n < N; n++)
+				{
+					results[n].succeeded = ret;
+					results[n].batch_size = N;
+					if (!ret)
+						results[n].outputs.clear();
+					batch[n]->promise.set_value(results[n]);
+					delete batch[n];
+				}
+			}
+		}
+
+		static void _get_slice(const ZQ_CNN_Tensor4D& blob, int n, Result& result)
+		{
+			result.outputs.push_back(Output());
+			Output& output = result.outputs.back();
+			output.C = blob.GetC();
+			output.H = blob.GetH();
+			output.W = blob.GetW();
+			output.data.resize(output.C*output.H*output.W);
+			int HW = output.H*output.W;
+			const float* slice_ptr = blob.GetFirstPixelPtr() + (__int64)n*blob.GetSliceStep();
+			for (int h = 0; h < output.H; h++)
+			{
+				for (int w = 0; w < output.W; w++)
+				{
+					const float* pix_ptr = slice_ptr + h*blob.GetWidthStep() + w*blob.GetPixelStep();
+					for (int c = 0; c < output.C; c++)
+						output.data[c*HW + h*output.W + w] = pix_ptr[c];
+				}
+			}
+		}
+	};
+}
+
+#endif
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "ZQ_CNN_BBox.h"
+#include "ZQ_CNN_ThreadPool.h"
 #include <string>
 #include <math.h>
 #include <stdlib.h>
@@ -94,42 +95,49 @@ namespace ZQ
 				}
 				else
 				{
-					int chunk_size = ceil(box_num / thread_num);
-#pragma omp parallel for schedule(static, chunk_size) num_threads(thread_num)
-					for (int num = 0; num < box_num; num++)
+					//the boxes are split into parts, each box is checked by one part, the suppressed ones are removed after
+					std::vector<char> suppressed(box_num, 0);
+					int num_parts = __min(thread_num, box_num);
+					ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
 					{
-						if (boundingBox.at(num).exist)
+						int num_begin = box_num*i / num_parts;
+						int num_end = box_num*(i + 1) / num_parts;
+						for (int num = num_begin; num < num_end; num++)
 						{
+							if (!boundingBox[num].exist)
+								continue;
 							//the iou
-							maxY = __max(boundingBox[num].row1, boundingBox[order].row1);
-							maxX = __max(boundingBox[num].col1, boundingBox[order].col1);
-							minY = __min(boundingBox[num].row2, boundingBox[order].row2);
-							minX = __min(boundingBox[num].col2, boundingBox[order].col2);
-							//maxX1 and maxY1 reuse 
-							maxX = __max(minX - maxX + 1, 0);
-							maxY = __max(minY - maxY + 1, 0);
-							//IOU reuse for the area of two bbox
-							IOU = maxX * maxY;
+							float cur_maxY = __max(boundingBox[num].row1, boundingBox[order].row1);
+							float cur_maxX = __max(boundingBox[num].col1, boundingBox[order].col1);
+							float cur_minY = __min(boundingBox[num].row2, boundingBox[order].row2);
+							float cur_minX = __min(boundingBox[num].col2, boundingBox[order].col2);
+							cur_maxX = __max(cur_minX - cur_maxX + 1, 0);
+							cur_maxY = __max(cur_minY - cur_maxY + 1, 0);
+							float cur_IOU = cur_maxX * cur_maxY;
 							float area1 = boundingBox[num].area;
 							float area2 = boundingBox[order].area;
 							if (!modelname.compare("Union"))
-								IOU = IOU / (area1 + area2 - IOU);
+								cur_IOU = cur_IOU / (area1 + area2 - cur_IOU);
 							else if (!modelname.compare("Min"))
 							{
-								IOU = IOU / __min(area1, area2);
+								cur_IOU = cur_IOU / __min(area1, area2);
 							}
-							if (IOU > overlap_threshold)
+							if (cur_IOU > overlap_threshold)
+								suppressed[num] = 1;
+						}
+					});
+					for (int num = 0; num < box_num; num++)
+					{
+						if (!suppressed[num])
+							continue;
+						cur_overlap++;
+						boundingBox[num].exist = false;
+						for (std::vector<ZQ_CNN_OrderScore>::iterator it = bboxScore.begin(); it != bboxScore.end(); it++)
+						{
+							if ((*it).oriOrder == num)
 							{
-								cur_overlap++;
-								boundingBox.at(num).exist = false;
-								for (std::vector<ZQ_CNN_OrderScore>::iterator it = bboxScore.begin(); it != bboxScore.end(); it++)
-								{
-									if ((*it).oriOrder == num)
-									{
-										(*it).oriOrder = -1;
-										break;
-									}
-								}
+								(*it).oriOrder = -1;
+								break;
 							}
 						}
 					}
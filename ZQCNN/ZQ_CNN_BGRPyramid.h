@@ -0,0 +1,250 @@
+#ifndef _ZQ_CNN_BGR_PYRAMID_H_
+#define _ZQ_CNN_BGR_PYRAMID_H_
+#pragma once
+#include "ZQ_CNN_CompileConfig.h"
+#include <vector>
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace ZQ
+{
+	/*an image pyramid of a BGR image in unsigned char, each level is made from the level before it (the first one from the
+	image): halved with a 2x2 box filter while it is at least twice as large as the level, then resized with bilinear.
+	The resizing is in fixed-point (7 bits for the weights of each direction), the center of the pixels is aligned as
+	ZQ_CNN_Tensor4D::ResizeBilinear*/
+	class ZQ_CNN_BGRPyramid
+	{
+	public:
+		ZQ_CNN_BGRPyramid() :image(0), image_W(0), image_H(0), image_widthStep(0) {}
+
+		/*the sizes of the levels from large to small, the built levels are dropped*/
+		void SetLevelSizes(const std::vector<int>& level_W, const std::vector<int>& level_H)
+		{
+			this->level_W = level_W;
+			this->level_H = level_H;
+			int level_num = level_W.size();
+			level_data.resize(level_num);
+			level_ptr.assign(level_num, (const unsigned char*)0);
+			level_widthStep.assign(level_num, 0);
+		}
+
+		/*the image should live until the levels are not used, the built levels are dropped*/
+		void SetImage(const unsigned char* bgr_img, int width, int height, int widthStep)
+		{
+			image = bgr_img;
+			image_W = width;
+			image_H = height;
+			image_widthStep = widthStep;
+			level_ptr.assign(level_W.size(), (const unsigned char*)0);
+		}
+
+		/*level i-1 must be built before level i*/
+		bool BuildLevel(int i)
+		{
+			if (i < 0 || i >= level_W.size() || level_W[i] <= 0 || level_H[i] <= 0)
+				return false;
+			const unsigned char* src = image;
+			int src_W = image_W, src_H = image_H, src_widthStep = image_widthStep;
+			if (i > 0)
+			{
+				src = level_ptr[i - 1];
+				src_W = level_W[i - 1];
+				src_H = level_H[i - 1];
+				src_widthStep = level_widthStep[i - 1];
+			}
+			if (src == 0)
+				return false;
+			if (src_W == level_W[i] && src_H == level_H[i])
+			{
+				level_ptr[i] = src;
+				level_widthStep[i] = src_widthStep;
+				return true;
+			}
+			int cur = 0;
+			while (src_W >= level_W[i] * 2 && src_H >= level_H[i] * 2)
+			{
+				std::vector<unsigned char>& half = half_data[cur];
+				half.resize((__int64)(src_W / 2) * 3 * (src_H / 2));
+				HalveBGR(src, src_W, src_H, src_widthStep, &half[0], (src_W / 2) * 3);
+				src = &half[0];
+				src_W /= 2;
+				src_H /= 2;
+				src_widthStep = src_W * 3;
+				cur = 1 - cur;
+			}
+			level_widthStep[i] = level_W[i] * 3;
+			level_data[i].resize((__int64)level_widthStep[i] * level_H[i]);
+			if (src_W == level_W[i] && src_H == level_H[i])
+			{
+				for (int h = 0; h < src_H; h++)
+					memcpy(&level_data[i][0] + h*level_widthStep[i], src + h*src_widthStep, src_W * 3);
+			}
+			else
+			{
+				ResizeBilinearBGR(src, src_W, src_H, src_widthStep, &level_data[i][0], level_W[i], level_H[i], level_widthStep[i],
+					row_buf);
+			}
+			level_ptr[i] = &level_data[i][0];
+			return true;
+		}
+
+		/*0 if the level is not built*/
+		const unsigned char* GetLevel(int i, int& width, int& height, int& widthStep) const
+		{
+			if (i < 0 || i >= level_W.size())
+				return 0;
+			width = level_W[i];
+			height = level_H[i];
+			widthStep = level_widthStep[i];
+			return level_ptr[i];
+		}
+
+		/*dst is (src_W/2) x (src_H/2), each pixel is the rounded mean of 2x2 pixels of src*/
+		static void HalveBGR(const unsigned char* src, int src_W, int src_H, int src_widthStep,
+			unsigned char* dst, int dst_widthStep)
+		{
+			int dst_W = src_W / 2, dst_H = src_H / 2;
+			int row_len = dst_W * 2 * 3;
+			std::vector<unsigned short> sum(row_len + 16);
+			for (int h = 0; h < dst_H; h++)
+			{
+				const unsigned char* row0 = src + (2 * h)*src_widthStep;
+				const unsigned char* row1 = row0 + src_widthStep;
+				int k = 0;
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+				__m128i zero = _mm_setzero_si128();
+				for (; k + 16 <= row_len; k += 16)
+				{
+					__m128i a = _mm_loadu_si128((const __m128i*)(row0 + k));
+					__m128i b = _mm_loadu_si128((const __m128i*)(row1 + k));
+					_mm_storeu_si128((__m128i*)(&sum[k]), _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+					_mm_storeu_si128((__m128i*)(&sum[k + 8]), _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+				}
+#endif
+				for (; k < row_len; k++)
+					sum[k] = row0[k] + row1[k];
+				unsigned char* dst_row = dst + h*dst_widthStep;
+				for (int w = 0; w < dst_W; w++)
+				{
+					const unsigned short* s = &sum[w * 6];
+					dst_row[w * 3] = (s[0] + s[3] + 2) >> 2;
+					dst_row[w * 3 + 1] = (s[1] + s[4] + 2) >> 2;
+					dst_row[w * 3 + 2] = (s[2] + s[5] + 2) >> 2;
+				}
+			}
+		}
+
+		/*bilinear resizing, the weights are in 1/128, row_buf is the buffer of the two rows resized horizontally*/
+		static void ResizeBilinearBGR(const unsigned char* src, int src_W, int src_H, int src_widthStep,
+			unsigned char* dst, int dst_W, int dst_H, int dst_widthStep, std::vector<short>& row_buf)
+		{
+			const int bits = 7;
+			const int one = 1 << bits;
+			std::vector<int> x_ofs(dst_W * 2);
+			std::vector<short> x_alpha(dst_W);
+			for (int w = 0; w < dst_W; w++)
+			{
+				int x0, alpha;
+				_map_coord(w, src_W, dst_W, bits, x0, alpha);
+				x_ofs[w * 2] = x0 * 3;
+				x_ofs[w * 2 + 1] = __min(x0 + 1, src_W - 1) * 3;
+				x_alpha[w] = alpha;
+			}
+
+			int row_len = dst_W * 3;
+			row_buf.resize(row_len * 2 + 16);
+			short* rows[2] = { &row_buf[0], &row_buf[row_len + 8] };
+			int row_y[2] = { -1, -1 };
+			for (int h = 0; h < dst_H; h++)
+			{
+				int y0, beta;
+				_map_coord(h, src_H, dst_H, bits, y0, beta);
+				int y1 = __min(y0 + 1, src_H - 1);
+				if (row_y[0] != y0)
+				{
+					if (row_y[1] == y0)
+					{
+						short* tmp = rows[0];
+						rows[0] = rows[1];
+						rows[1] = tmp;
+						row_y[0] = y0;
+						row_y[1] = -1;
+					}
+					else
+					{
+						_resize_row(src + y0*src_widthStep, &x_ofs[0], &x_alpha[0], dst_W, one, rows[0]);
+						row_y[0] = y0;
+					}
+				}
+				if (row_y[1] != y1)
+				{
+					_resize_row(src + y1*src_widthStep, &x_ofs[0], &x_alpha[0], dst_W, one, rows[1]);
+					row_y[1] = y1;
+				}
+
+				const short* r0 = rows[0];
+				const short* r1 = rows[1];
+				unsigned char* dst_row = dst + h*dst_widthStep;
+				int k = 0;
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+				__m128i weight = _mm_set1_epi32(((one - beta) & 0xFFFF) | (beta << 16));
+				__m128i round = _mm_set1_epi32(1 << (2 * bits - 1));
+				for (; k + 8 <= row_len; k += 8)
+				{
+					__m128i a = _mm_loadu_si128((const __m128i*)(r0 + k));
+					__m128i b = _mm_loadu_si128((const __m128i*)(r1 + k));
+					__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weight);
+					__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weight);
+					lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 2 * bits);
+					hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 2 * bits);
+					__m128i val = _mm_packs_epi32(lo, hi);
+					_mm_storel_epi64((__m128i*)(dst_row + k), _mm_packus_epi16(val, val));
+				}
+#endif
+				for (; k < row_len; k++)
+					dst_row[k] = (r0[k] * (one - beta) + r1[k] * beta + (1 << (2 * bits - 1))) >> (2 * bits);
+			}
+		}
+
+	private:
+		const unsigned char* image;
+		int image_W, image_H, image_widthStep;
+		std::vector<int> level_W, level_H;
+		std::vector<std::vector<unsigned char> > level_data;
+		std::vector<const unsigned char*> level_ptr;	//the data of the level, or of the level it is the same as
+		std::vector<int> level_widthStep;
+		std::vector<unsigned char> half_data[2];
+		std::vector<short> row_buf;
+
+		/*the source coordinate of the center of dst pixel i, as the integer part and the rounded fraction in 1/(1<<bits)*/
+		static void _map_coord(int i, int src_len, int dst_len, int bits, int& i0, int& frac)
+		{
+			__int64 fx = (((__int64)(2 * i + 1) * src_len << 16) / (2 * dst_len)) - (1 << 15);
+			if (fx < 0)
+				fx = 0;
+			i0 = (int)(fx >> 16);
+			frac = (int)(((fx & 0xFFFF) + (1 << (15 - bits))) >> (16 - bits));
+			if (i0 >= src_len - 1)
+			{
+				i0 = src_len - 1;
+				frac = 0;
+			}
+		}
+
+		static void _resize_row(const unsigned char* src_row, const int* x_ofs, const short* x_alpha, int dst_W, int one, short* dst_row)
+		{
+			for (int w = 0; w < dst_W; w++)
+			{
+				const unsigned char* p0 = src_row + x_ofs[w * 2];
+				const unsigned char* p1 = src_row + x_ofs[w * 2 + 1];
+				int alpha = x_alpha[w];
+				dst_row[w * 3] = p0[0] * (one - alpha) + p1[0] * alpha;
+				dst_row[w * 3 + 1] = p0[1] * (one - alpha) + p1[1] * alpha;
+				dst_row[w * 3 + 2] = p0[2] * (one - alpha) + p1[2] * alpha;
+			}
+		}
+	};
+}
+
+#endif
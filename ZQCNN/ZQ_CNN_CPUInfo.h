@@ -0,0 +1,132 @@
+#ifndef _ZQ_CNN_CPU_INFO_H_
+#define _ZQ_CNN_CPU_INFO_H_
+#pragma once
+#include "ZQ_CNN_CompileConfig.h"
+#include "math/zq_cpu_c.h"
+#include <string>
+#if !__ARM_NEON
+#if defined(_WIN32)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace ZQ
+{
+	/*the instruction set the kernels are compiled for, and the one the running cpu supports*/
+	class ZQ_CNN_CPUInfo
+	{
+	public:
+		static int GetCompiledSSEType() { return ZQ_CNN_USE_SSETYPE; }
+
+		/*checked once with cpuid, AVX and AVX512 need the os to save the ymm and zmm registers*/
+		static int GetSupportedSSEType()
+		{
+			return zq_cpu_sse_type();
+		}
+
+		/*a ZQ_CNN_DISPATCH_SSETYPE build runs its AVX2+FMA kernels on an AVX2 cpu (and its AVX512 gemm kernels on an AVX512 cpu),
+		and its SSE kernels on the others*/
+		static int GetSelectedSSEType()
+		{
+#if ZQ_CNN_DISPATCH_SSETYPE
+			return ZQ_CNN_CAN_RUN_512BIT ? ZQ_CNN_SSETYPE_AVX512 : ZQ_CNN_CAN_RUN_256BIT ? ZQ_CNN_SSETYPE_AVX2 : ZQ_CNN_SSETYPE_SSE;
+#else
+			return GetCompiledSSEType();
+#endif
+		}
+
+		static bool IsCompiledSSETypeSupported()
+		{
+			return GetSupportedSSEType() >= GetSelectedSSEType();
+		}
+
+		/*run the kernels of at most sse_type, call it before loading any model (tensors keep the type they are created with)*/
+		static void LimitSSEType(int sse_type)
+		{
+			zq_cpu_limit_sse_type(sse_type);
+		}
+
+		static const char* GetSSETypeName(int sse_type)
+		{
+			switch (sse_type)
+			{
+			case ZQ_CNN_SSETYPE_SSE:
+				return "SSE";
+			case ZQ_CNN_SSETYPE_AVX:
+				return "AVX";
+			case ZQ_CNN_SSETYPE_AVX2:
+				return "AVX2+FMA";
+			case ZQ_CNN_SSETYPE_AVX512:
+				return "AVX512F";
+			default:
+				return "NONE";
+			}
+		}
+
+		/*the brand string, such as "Intel(R) Xeon(R) Gold 6148 CPU @ 2.40GHz"*/
+		static std::string GetCPUName()
+		{
+#if __ARM_NEON
+			return "ARM";
+#else
+			unsigned int regs[12] = { 0 };
+			if (!_cpuid(0x80000000, regs) || regs[0] < 0x80000004)
+				return "unknown";
+			for (int i = 0; i < 3; i++)
+				_cpuid(0x80000002 + i, regs + i * 4);
+			char name[49];
+			memcpy(name, regs, 48);
+			name[48] = '\0';
+			std::string str(name);
+			size_t first = str.find_first_not_of(' ');
+			return first == std::string::npos ? "unknown" : str.substr(first);
+#endif
+		}
+
+		/*such as "compiled: AVX, cpu: AVX2+FMA, selected: AVX"*/
+		static std::string GetSelectedPath()
+		{
+#if __ARM_NEON
+#if __ARM_NEON_FP16
+			return "compiled: NEON FP16, cpu: NEON, selected: NEON FP16";
+#elif __ARM_NEON_ARMV8
+			return "compiled: NEON ARMV8, cpu: NEON, selected: NEON ARMV8";
+#else
+			return "compiled: NEON, cpu: NEON, selected: NEON";
+#endif
+#else
+			std::string path = "compiled: ";
+#if ZQ_CNN_DISPATCH_SSETYPE
+			path += "SSE, AVX2+FMA and AVX512F";
+#else
+			path += GetSSETypeName(GetCompiledSSEType());
+#endif
+			path += ", cpu: ";
+			path += GetSSETypeName(GetSupportedSSEType());
+			path += ", selected: ";
+			path += IsCompiledSSETypeSupported() ? GetSSETypeName(GetSelectedSSEType()) : "NONE (unsupported cpu)";
+			return path;
+#endif
+		}
+
+	private:
+#if !__ARM_NEON
+		static bool _cpuid(unsigned int leaf, unsigned int regs[4])
+		{
+#if defined(_WIN32)
+			int tmp[4];
+			__cpuidex(tmp, leaf, 0);
+			for (int i = 0; i < 4; i++)
+				regs[i] = tmp[i];
+			return true;
+#else
+			return __get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]) != 0;
+#endif
+		}
+#endif
+	};
+}
+
+#endif
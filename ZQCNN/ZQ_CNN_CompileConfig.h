@@ -11,6 +11,16 @@
 #define ZQ_CNN_SSETYPE_SSE 1
 #define ZQ_CNN_SSETYPE_AVX 2
 #define ZQ_CNN_SSETYPE_AVX2 3
+#define ZQ_CNN_SSETYPE_AVX512 4
+
+// build the SSE, the AVX2+FMA and the AVX512 gemm kernels together and choose them by the cpu at runtime,
+// can be given by the compiler with -DZQ_CNN_DISPATCH_SSETYPE=1, and the code should then be compiled for SSE4.1 only
+#ifndef ZQ_CNN_DISPATCH_SSETYPE
+#define ZQ_CNN_DISPATCH_SSETYPE 0
+#endif
+#if ZQ_CNN_DISPATCH_SSETYPE && !defined(ZQ_CNN_USE_SSETYPE)
+#define ZQ_CNN_USE_SSETYPE ZQ_CNN_SSETYPE_AVX512
+#endif
 
 #if defined(_WIN32)
 
@@ -18,7 +28,9 @@
 #define ZQ_DECLSPEC_ALIGN16 __declspec(align(16))
 
 // your settings
+#ifndef ZQ_CNN_USE_SSETYPE
 #define ZQ_CNN_USE_SSETYPE ZQ_CNN_SSETYPE_AVX2
+#endif
 #define ZQ_CNN_USE_BLAS_GEMM 0 // if you want to use openblas, set to 1
 #if ZQ_CNN_USE_BLAS_GEMM == 0
 #define ZQ_CNN_USE_MKL_GEMM 1
@@ -29,12 +41,21 @@
 
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_DISPATCH_SSETYPE
+#define ZQ_CNN_USE_FMADD128 0 // the 128bit kernels are the ones for the cpus without FMA
+#else
 #define ZQ_CNN_USE_FMADD128 1 
+#endif
 #define ZQ_CNN_USE_FMADD256 1 
 #else
 #define ZQ_CNN_USE_FMADD128 0
 #define ZQ_CNN_USE_FMADD256 0 
 #endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+#define ZQ_CNN_USE_FMADD512 1
+#else
+#define ZQ_CNN_USE_FMADD512 0
+#endif
 
 
 /**   for linux system      **/
@@ -69,8 +90,10 @@
 #define ZQ_CNN_USE_BLAS_GEMM 1
 #endif
 #else
-// your settings
+// your settings, can also be given by the compiler, such as -DZQ_CNN_USE_SSETYPE=3 for AVX2
+#ifndef ZQ_CNN_USE_SSETYPE
 #define ZQ_CNN_USE_SSETYPE ZQ_CNN_SSETYPE_AVX
+#endif
 #define ZQ_CNN_USE_BLAS_GEMM 0 // if you want to use openblas, set to 1
 #if ZQ_CNN_USE_BLAS_GEMM == 0
 #define ZQ_CNN_USE_MKL_GEMM 0
@@ -81,12 +104,21 @@
 
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_DISPATCH_SSETYPE
+#define ZQ_CNN_USE_FMADD128 0 // the 128bit kernels are the ones for the cpus without FMA
+#else
 #define ZQ_CNN_USE_FMADD128 1 
+#endif
 #define ZQ_CNN_USE_FMADD256 1 
 #else
 #define ZQ_CNN_USE_FMADD128 0
 #define ZQ_CNN_USE_FMADD256 0 
 #endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+#define ZQ_CNN_USE_FMADD512 1
+#else
+#define ZQ_CNN_USE_FMADD512 0
+#endif
 
 #endif //__ARM_NEON
 
@@ -116,5 +148,65 @@
 
 #endif// defined(WIN32) || defined(_WINDOWS_)
 
+// max size of the im2col matrix built at once by gemm convolution, set to 0 to build it for the whole image
+#ifndef ZQ_CNN_GEMM_IM2COL_TILE_BYTES
+#define ZQ_CNN_GEMM_IM2COL_TILE_BYTES (256*1024)
+#endif
+
+// max size of the output rows a convolution computes before doing its epilogue (bias, prelu and the folded layers) on them,
+// set to 0 to do the epilogue once on the whole output
+#ifndef ZQ_CNN_EPILOGUE_TILE_BYTES
+#define ZQ_CNN_EPILOGUE_TILE_BYTES (128*1024)
+#endif
+
+// max number of input shapes whose memory plans ZQ_CNN_Net keeps (e.g. the image pyramid of MTCNN), the older ones are 
+// dropped together when it is reached
+#ifndef ZQ_CNN_MAX_CACHED_PLANS
+#define ZQ_CNN_MAX_CACHED_PLANS 32
+#endif
+
+// the AVX2 kernels of a ZQ_CNN_DISPATCH_SSETYPE build are compiled between ZQ_CNN_TARGET_AVX2_BEGIN and ZQ_CNN_TARGET_AVX2_END
+// (at file scope), and must only be called if ZQ_CNN_CAN_RUN_256BIT, the AVX512 ones the same way with ZQ_CNN_TARGET_AVX512_xxx
+// and ZQ_CNN_CAN_RUN_512BIT
+#if ZQ_CNN_DISPATCH_SSETYPE
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" int zq_cpu_sse_type(); // ZQ_GEMM/math/zq_cpu_c.h
+#else
+int zq_cpu_sse_type();
+#endif
+#define ZQ_CNN_CAN_RUN_256BIT (zq_cpu_sse_type() >= ZQ_CNN_SSETYPE_AVX2)
+#define ZQ_CNN_CAN_RUN_512BIT (zq_cpu_sse_type() >= ZQ_CNN_SSETYPE_AVX512)
+#if defined(__clang__)
+#define ZQ_CNN_TARGET_AVX2_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+#define ZQ_CNN_TARGET_AVX2_END _Pragma("clang attribute pop")
+#define ZQ_CNN_TARGET_AVX512_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+#define ZQ_CNN_TARGET_AVX512_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define ZQ_CNN_TARGET_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define ZQ_CNN_TARGET_AVX2_END _Pragma("GCC pop_options")
+#define ZQ_CNN_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+#define ZQ_CNN_TARGET_AVX512_END _Pragma("GCC pop_options")
+#else
+#define ZQ_CNN_TARGET_AVX2_BEGIN
+#define ZQ_CNN_TARGET_AVX2_END
+#define ZQ_CNN_TARGET_AVX512_BEGIN
+#define ZQ_CNN_TARGET_AVX512_END
+#endif
+#else
+#define ZQ_CNN_CAN_RUN_256BIT 1
+#define ZQ_CNN_CAN_RUN_512BIT 1
+#define ZQ_CNN_TARGET_AVX2_BEGIN
+#define ZQ_CNN_TARGET_AVX2_END
+#define ZQ_CNN_TARGET_AVX512_BEGIN
+#define ZQ_CNN_TARGET_AVX512_END
+#endif
+
+// int8 kernels use _mm256_dpbusd_epi32 if the compiler is given -mavx512vnni -mavx512vl, else _mm256_maddubs_epi16 with AVX2
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+#define ZQ_CNN_USE_VNNI 1
+#else
+#define ZQ_CNN_USE_VNNI 0
+#endif
+
 
 #endif// _ZQ_CNN_COMPILE_CONFIG_H_
@@ -1,6 +1,8 @@
 #include "layers_c/zq_cnn_convolution_32f_align_c.h"
 #include "layers_c/zq_cnn_depthwise_convolution_32f_align_c.h"
 #include "layers_c/zq_cnn_convolution_gemm_32f_align_c.h"
+#include "layers_c/zq_cnn_convolution_winograd_32f_align_c.h"
+#include "layers_c/zq_cnn_convolution_8i_c.h"
 #include "layers_c/zq_cnn_innerproduct_32f_align_c.h"
 #include "layers_c/zq_cnn_innerproduct_gemm_32f_align_c.h"
 #include "layers_c/zq_cnn_addbias_32f_align_c.h"
@@ -16,14 +18,25 @@
 #include "layers_c/zq_cnn_normalize_32f_align_c.h"
 #include "layers_c/zq_cnn_reduction_32f_align_c.h"
 #include "layers_c/zq_cnn_sqrt_32f_align_c.h"
+#include "layers_c/zq_cnn_permute_32f_align_c.h"
 #include "ZQ_CNN_Forward_SSEUtils.h"
 #include "ZQ_CNN_BBoxUtils.h"
+#include "ZQ_CNN_ThreadPool.h"
 #include <algorithm>
 #include <math.h>
 #include "ZQ_CNN_CompileConfig.h"
 
 using namespace ZQ;
 
+/*number of parts to split the rows (or slices, or channels) into, each part should have enough work for one thread*/
+static int _get_num_of_parts(int num_threads, int rows, double mul_count)
+{
+	const double min_mul_count_per_part = 256 * 1024;
+	int num_parts = __min(num_threads, rows);
+	num_parts = __min(num_parts, (int)(mul_count / min_mul_count_per_part));
+	return __max(num_parts, 1);
+}
+
 void _convolution_handle_special_channel_case_N_equal_one(bool& has_handled, int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep)
@@ -196,7 +209,7 @@ void _convolution_handle_special_channel_case_N_largerthan_one(bool& has_handled
 void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-	void** buffer, __int64* buffer_len)
+	void** buffer, __int64* buffer_len, const float* packed_filters)
 {
 	bool has_handled = false;
 	int out_HW = out_H*out_W;
@@ -252,11 +265,11 @@ void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_dat
 			{
 				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
 				{
-					if (in_C == 3)
+					if (in_C == 3 || packed_filters)
 					{
 						zq_cnn_conv_no_padding_gemm_32f_align128bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
+							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, packed_filters);
 					}
 					else
 					{
@@ -346,7 +359,7 @@ void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_dat
 void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-	void** buffer, __int64* buffer_len)
+	void** buffer, __int64* buffer_len, const float* packed_filters)
 {
 	bool has_handled = false;
 	int out_HW = out_H*out_W;
@@ -425,11 +438,11 @@ void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_dat
 				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
 				{
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
-					if (in_C == 3)
+					if (in_C == 3 || packed_filters)
 					{
 						zq_cnn_conv_no_padding_gemm_32f_align128bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
+							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, packed_filters);
 					}
 					else
 					{
@@ -443,11 +456,11 @@ void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_dat
 				else if (align_mode == ZQ_CNN_Tensor4D::ALIGN_256bit)
 				{
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-					if (in_C == 3)
+					if (in_C == 3 || packed_filters)
 					{
 						zq_cnn_conv_no_padding_gemm_32f_align256bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
+							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, packed_filters);
 					}
 					else
 					{
@@ -604,7 +617,7 @@ void _convolution_nopadding_case_N_equal_one(int align_mode, const float* in_dat
 void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-	void** buffer, __int64* buffer_len)
+	void** buffer, __int64* buffer_len, const float* packed_filters)
 {
 	const static int batch_limited_size = 100 * 1024 * 1024;
 
@@ -657,11 +670,11 @@ void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* i
 			{
 				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
 				{
-					if (in_C <= 4)
+					if (in_C <= 4 || packed_filters)
 					{
 						zq_cnn_conv_no_padding_gemm_32f_align128bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len);
+							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len,packed_filters);
 						has_handled = true;
 					}
 					else
@@ -761,7 +774,7 @@ void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* i
 void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-	void** buffer, __int64* buffer_len)
+	void** buffer, __int64* buffer_len, const float* packed_filters)
 {
 	const static int batch_limited_size = 100 * 1024 * 1024;
 
@@ -775,34 +788,27 @@ void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* i
 	filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
 	dilation_H, dilation_W,	out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep);*/
 
+	/*an image with enough pixels fills the gemm by itself, then the gemm of each image (with the packed filters)
+	is faster than the batch gemm, the batch gemm is for the small images*/
+	if (out_HW >= 8)
+	{
+		for (int n = 0; n < out_N; n++)
+		{
+			_convolution_nopadding_case_N_equal_one(align_mode, in_data + (__int64)n*in_sliceStep, 1, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+				dilation_H, dilation_W, out_data + (__int64)n*out_sliceStep, 1, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,
+				buffer, buffer_len, packed_filters);
+		}
+		return;
+	}
+
 #if (ZQ_CNN_USE_BLAS_GEMM || ZQ_CNN_USE_MKL_GEMM || ZQ_CNN_USE_ZQ_GEMM)
-	//gemm
+	//gemm, out_HW < 8 here
 	if (!has_handled)
 	{
 		if (in_pixStep == filter_pixStep)
 		{
-			if (out_HW >= 8)
-			{
-				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
-				{
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
-					zq_cnn_conv_no_padding_gemm_32f_align128bit_same_pixstep(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-						filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-						dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-					has_handled = true;
-#endif
-				}
-				else if (align_mode == ZQ_CNN_Tensor4D::ALIGN_256bit)
-				{
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-					zq_cnn_conv_no_padding_gemm_32f_align256bit_same_pixstep(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-						filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-						dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-					has_handled = true;
-#endif
-				}
-			}
-			else if (out_NHW >= 8 || (out_H == 1 && out_W == 1))
+			if (out_NHW >= 8 || (out_H == 1 && out_W == 1))
 			{
 				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
 				{
@@ -826,55 +832,7 @@ void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* i
 		}
 		else
 		{
-			if (out_HW >= 8 && out_N >= 16)
-			{
-				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
-				{
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
-					if (in_C <= 4)
-					{
-						zq_cnn_conv_no_padding_gemm_32f_align128bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-						has_handled = true;
-					}
-					else
-					{
-						zq_cnn_conv_no_padding_gemm_32f_align128bit_same_or_notsame_pixstep(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-						has_handled = true;
-					}
-#endif
-				}
-				else if (align_mode == ZQ_CNN_Tensor4D::ALIGN_256bit)
-				{
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-					if (in_C <= 8)
-					{
-						zq_cnn_conv_no_padding_gemm_32f_align256bit_same_or_notsame_pixstep_C3(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-						has_handled = true;
-					}
-					else
-					{
-						zq_cnn_conv_no_padding_gemm_32f_align256bit_same_or_notsame_pixstep(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-							filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-							dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-						has_handled = true;
-					}
-#endif
-				}
-				else
-				{
-					zq_cnn_conv_no_padding_gemm_32f_align0_same_or_notsame_pixstep(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
-						filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-						dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-					has_handled = true;
-				}
-			}
-			else if (out_NHW >= 8 && out_N >= 16)
+			if (out_NHW >= 8)
 			{
 				if (align_mode == ZQ_CNN_Tensor4D::ALIGN_128bit)
 				{
@@ -991,28 +949,315 @@ void _convolution_nopadding_case_N_largerthan_one(int align_mode, const float* i
 }
 #endif //__ARM_NEON
 
-void ZQ_CNN_Forward_SSEUtils::_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+void ZQ_CNN_Forward_SSEUtils::ConvolutionPrePack(const ZQ_CNN_Tensor4D& filters, void*& packed_filters, __int64& packed_filters_len)
+{
+	zq_cnn_conv_gemm_32f_prepack_compact(filters.GetFirstPixelPtr(), filters.GetN(), filters.GetH(), filters.GetW(), filters.GetC(),
+		filters.GetPixelStep(), filters.GetWidthStep(), filters.GetSliceStep(), &packed_filters, &packed_filters_len);
+}
+
+void ZQ_CNN_Forward_SSEUtils::ConvolutionWinogradPrePack(const ZQ_CNN_Tensor4D& filters, int winograd_tile, void*& winograd_filters, __int64& winograd_filters_len)
+{
+	zq_cnn_winograd_transform_filters_32f(winograd_tile, filters.GetFirstPixelPtr(), filters.GetN(), filters.GetC(),
+		filters.GetPixelStep(), filters.GetWidthStep(), filters.GetSliceStep(), &winograd_filters, &winograd_filters_len);
+}
+
+void _convolution_nopadding_single_thread(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-	void** buffer, __int64* buffer_len)
+	void** buffer, __int64* buffer_len, const float* packed_filters, const float* winograd_filters, int winograd_tile)
 {
+	/*winograd is used only if the image is not too small for the tiles*/
+	if (winograd_filters && filter_H == 3 && filter_W == 3 && strideH == 1 && strideW == 1 && dilation_H == 1 && dilation_W == 1
+		&& out_H >= winograd_tile * 2 && out_W >= winograd_tile * 2)
+	{
+		zq_cnn_conv_no_padding_winograd_32f(winograd_tile, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			winograd_filters, filter_N, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
+		return;
+	}
 	if (out_N > 1)
 	{
 		_convolution_nopadding_case_N_largerthan_one(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-			dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len);
+			dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len,packed_filters);
 	}
 	else
 	{
 		_convolution_nopadding_case_N_equal_one(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-			dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len);
+			dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,buffer,buffer_len,packed_filters);
+	}
+}
+
+void ZQ_CNN_Forward_SSEUtils::_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
+	void** buffer, __int64* buffer_len, int num_threads, const float* packed_filters,
+	const float* winograd_filters, int winograd_tile, const std::vector<EpilogueOp>& epilogue)
+{
+	double mul_count = (double)out_N*out_H*out_W*filter_N*filter_H*filter_W*filter_C;
+	bool split_N = out_N >= num_threads;
+	int num_parts = _get_num_of_parts(num_threads, split_N ? out_N : out_H, mul_count);
+	if (num_parts <= 1)
+	{
+		_convolution_nopadding_part(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+			dilation_H, dilation_W, out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, packed_filters,
+			winograd_filters, winograd_tile, epilogue, 0, 0);
+		return;
+	}
+
+	/*each part uses its own buffer*/
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		void** cur_buffer = buffer ? buffer + i : 0;
+		__int64* cur_buffer_len = buffer_len ? buffer_len + i : 0;
+		if (split_N)
+		{
+			int n_begin = out_N*i / num_parts;
+			int cur_N = out_N*(i + 1) / num_parts - n_begin;
+			_convolution_nopadding_part(align_mode, in_data + n_begin*in_sliceStep, cur_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+				dilation_H, dilation_W, out_data + n_begin*out_sliceStep, cur_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,
+				cur_buffer, cur_buffer_len, packed_filters, winograd_filters, winograd_tile, epilogue, n_begin, 0);
+		}
+		else
+		{
+			int h_begin = out_H*i / num_parts;
+			int cur_out_H = out_H*(i + 1) / num_parts - h_begin;
+			int cur_in_H = (cur_out_H - 1)*strideH + (filter_H - 1)*dilation_H + 1;
+			_convolution_nopadding_part(align_mode, in_data + h_begin*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+				dilation_H, dilation_W, out_data + h_begin*out_widthStep, out_N, cur_out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep,
+				cur_buffer, cur_buffer_len, packed_filters, winograd_filters, winograd_tile, epilogue, 0, h_begin);
+		}
+	});
+}
+
+/*the output is computed in bands of rows, the epilogue of each band is done while it is still in cache,
+out_data is at slice n_begin and row h_begin of the whole output*/
+void ZQ_CNN_Forward_SSEUtils::_convolution_nopadding_part(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+	int strideH, int strideW, int dilation_H, int dilation_W, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
+	void** buffer, __int64* buffer_len, const float* packed_filters, const float* winograd_filters, int winograd_tile,
+	const std::vector<EpilogueOp>& epilogue, int n_begin, int h_begin)
+{
+	int band_H = out_H, min_band_H = out_H;
+#if ZQ_CNN_EPILOGUE_TILE_BYTES > 0
+	if (epilogue.size() > 0)
+	{
+		/*a band should have enough pixels (and winograd tiles) for the kernel chosen for the whole output,
+		and the winograd tiles of the bands should be those of the whole output*/
+		int tile = winograd_filters ? __max(winograd_tile, 1) : 1;
+		min_band_H = __max((64 + out_W - 1) / __max(out_W, 1), tile * 2);
+		band_H = ZQ_CNN_EPILOGUE_TILE_BYTES / __max(out_N*out_widthStep*(int)sizeof(float), 1);
+		band_H = (__max(band_H, min_band_H) + tile - 1) / tile*tile;
+	}
+#endif
+	for (int h = 0; h < out_H; h += band_H)
+	{
+		if (out_H - h < band_H + min_band_H)
+			band_H = out_H - h;
+		int cur_in_H = band_H == out_H ? in_H : (band_H - 1)*strideH + (filter_H - 1)*dilation_H + 1;
+		float* cur_out_data = out_data + h*out_widthStep;
+		_convolution_nopadding_single_thread(align_mode, in_data + h*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+			dilation_H, dilation_W, cur_out_data, out_N, band_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, packed_filters,
+			winograd_filters, winograd_tile);
+		if (epilogue.size() > 0)
+			_apply_epilogue(epilogue, cur_out_data, out_N, band_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, n_begin, h_begin + h);
+	}
+}
+
+void ZQ_CNN_Forward_SSEUtils::ConvolutionInt8PrePack(const ZQ_CNN_Tensor4D& filters, const float* in_scales, void*& int8_filters, __int64& int8_filters_len)
+{
+	zq_cnn_conv_gemm_8i_pack_filters(filters.GetFirstPixelPtr(), filters.GetN(), filters.GetH(), filters.GetW(), filters.GetC(),
+		filters.GetPixelStep(), filters.GetWidthStep(), filters.GetSliceStep(), in_scales, &int8_filters, &int8_filters_len);
+}
+
+void ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionInt8PrePack(const ZQ_CNN_Tensor4D& filters, const float* in_scales, void*& int8_filters, __int64& int8_filters_len)
+{
+	zq_cnn_depthwise_conv_8i_pack_filters(filters.GetFirstPixelPtr(), filters.GetH(), filters.GetW(), filters.GetC(),
+		filters.GetPixelStep(), filters.GetWidthStep(), in_scales, &int8_filters, &int8_filters_len);
+}
+
+int ZQ_CNN_Forward_SSEUtils::Int8PackFormat()
+{
+	return zq_cnn_8i_pack_format();
+}
+
+bool ZQ_CNN_Forward_SSEUtils::ConvolutionInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias, const ZQ_CNN_Tensor4D* slope,
+	const float* in_scales, const void* int8_filters, int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW, ZQ_CNN_Tensor4D& output,
+	void** buffer, __int64* buffer_len, int num_threads)
+{
+	int in_N = input.GetN();
+	int in_H = input.GetH();
+	int in_W = input.GetW();
+	int in_C = input.GetC();
+	int filter_N = filters.GetN();
+	int filter_H = filters.GetH();
+	int filter_W = filters.GetW();
+	int filter_C = filters.GetC();
+	int need_H = (in_H - (filter_H - 1)*dilation_H - 1 + (padH << 1)) / strideH + 1;
+	int need_W = (in_W - (filter_W - 1)*dilation_W - 1 + (padW << 1)) / strideW + 1;
+	if (in_N <= 0 || in_H <= 0 || in_W <= 0 || in_C == 0 || need_H < 0 || need_W < 0)
+	{
+		output.ChangeSize(0, 0, 0, 0, 0, 0);
+		return true;
+	}
+	if (in_scales == 0 || int8_filters == 0 || filter_C != in_C || (bias && bias->GetC() != filter_N) || (slope && slope->GetC() != filter_N))
+		return false;
+	if (output.GetN() != in_N || output.GetH() != need_H || output.GetW() != need_W || output.GetC() != filter_N)
+		output.ChangeSize(in_N, need_H, need_W, filter_N, 0, 0);
+	if (padH != 0 || padW != 0)
+	{
+		if (!input.Padding(padW, padH, 0))
+			return false;
+	}
+
+	int in_sliceStep = input.GetSliceStep();
+	int in_widthStep = input.GetWidthStep();
+	int in_pixStep = input.GetPixelStep();
+	int out_sliceStep = output.GetSliceStep();
+	int out_widthStep = output.GetWidthStep();
+	int out_pixStep = output.GetPixelStep();
+	const float* in_data = input.GetFirstPixelPtr() - padH*in_widthStep - padW*in_pixStep;
+	float* out_data = output.GetFirstPixelPtr();
+	const float* bias_data = bias ? bias->GetFirstPixelPtr() : 0;
+	const float* slope_data = slope ? slope->GetFirstPixelPtr() : 0;
+	in_H += padH << 1;
+	in_W += padW << 1;
+
+	double mul_count = (double)in_N*need_H*need_W*filter_N*filter_H*filter_W*filter_C;
+	bool split_N = in_N >= num_threads;
+	int num_parts = _get_num_of_parts(num_threads, split_N ? in_N : need_H, mul_count);
+	if (num_parts <= 1)
+	{
+		zq_cnn_conv_no_padding_gemm_8i(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+			int8_filters, filter_N, filter_H, filter_W, filter_C, strideH, strideW, dilation_H, dilation_W,
+			out_data, in_N, need_H, need_W, filter_N, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data, buffer, buffer_len);
+		return true;
+	}
+
+	/*each part uses its own buffer*/
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		void** cur_buffer = buffer ? buffer + i : 0;
+		__int64* cur_buffer_len = buffer_len ? buffer_len + i : 0;
+		if (split_N)
+		{
+			int n_begin = in_N*i / num_parts;
+			int cur_N = in_N*(i + 1) / num_parts - n_begin;
+			zq_cnn_conv_no_padding_gemm_8i(in_data + n_begin*in_sliceStep, cur_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+				int8_filters, filter_N, filter_H, filter_W, filter_C, strideH, strideW, dilation_H, dilation_W,
+				out_data + n_begin*out_sliceStep, cur_N, need_H, need_W, filter_N, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data,
+				cur_buffer, cur_buffer_len);
+		}
+		else
+		{
+			int h_begin = need_H*i / num_parts;
+			int cur_out_H = need_H*(i + 1) / num_parts - h_begin;
+			int cur_in_H = (cur_out_H - 1)*strideH + (filter_H - 1)*dilation_H + 1;
+			zq_cnn_conv_no_padding_gemm_8i(in_data + h_begin*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+				int8_filters, filter_N, filter_H, filter_W, filter_C, strideH, strideW, dilation_H, dilation_W,
+				out_data + h_begin*out_widthStep, in_N, cur_out_H, need_W, filter_N, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data,
+				cur_buffer, cur_buffer_len);
+		}
+	});
+	return true;
+}
+
+bool ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias, const ZQ_CNN_Tensor4D* slope,
+	const float* in_scales, const void* int8_filters, int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output,
+	void** buffer, __int64* buffer_len, int num_threads)
+{
+	int in_N = input.GetN();
+	int in_H = input.GetH();
+	int in_W = input.GetW();
+	int in_C = input.GetC();
+	int filter_H = filters.GetH();
+	int filter_W = filters.GetW();
+	if (in_N <= 0 || in_H <= 0 || in_W <= 0 || in_C == 0
+		|| (in_H - filter_H + (padH << 1)) < 0 || (in_W - filter_W + (padW << 1)) < 0)
+	{
+		output.ChangeSize(0, 0, 0, 0, 0, 0);
+		return true;
+	}
+	if (in_scales == 0 || int8_filters == 0 || filters.GetC() != in_C || filters.GetN() != 1 || (bias && bias->GetC() != in_C) || (slope && slope->GetC() != in_C))
+		return false;
+	int need_H = (in_H - filter_H + (padH << 1)) / strideH + 1;
+	int need_W = (in_W - filter_W + (padW << 1)) / strideW + 1;
+	if (output.GetN() != in_N || output.GetH() != need_H || output.GetW() != need_W || output.GetC() != in_C)
+		output.ChangeSize(in_N, need_H, need_W, in_C, 0, 0);
+	if (padH != 0 || padW != 0)
+	{
+		if (!input.Padding(padW, padH, 0))
+			return false;
+	}
+
+	int in_sliceStep = input.GetSliceStep();
+	int in_widthStep = input.GetWidthStep();
+	int in_pixStep = input.GetPixelStep();
+	int out_sliceStep = output.GetSliceStep();
+	int out_widthStep = output.GetWidthStep();
+	int out_pixStep = output.GetPixelStep();
+	const float* in_data = input.GetFirstPixelPtr() - padH*in_widthStep - padW*in_pixStep;
+	float* out_data = output.GetFirstPixelPtr();
+	const float* bias_data = bias ? bias->GetFirstPixelPtr() : 0;
+	const float* slope_data = slope ? slope->GetFirstPixelPtr() : 0;
+	in_H += padH << 1;
+	in_W += padW << 1;
+
+	double mul_count = (double)in_N*need_H*need_W*in_C*filter_H*filter_W;
+	bool split_N = in_N >= num_threads;
+	int num_parts = _get_num_of_parts(num_threads, split_N ? in_N : need_H, mul_count);
+	if (num_parts <= 1)
+	{
+		zq_cnn_depthwise_conv_no_padding_8i(in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+			int8_filters, filter_H, filter_W, strideH, strideW,
+			out_data, in_N, need_H, need_W, in_C, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data, buffer, buffer_len);
+		return true;
 	}
+
+	/*each part uses its own buffer*/
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		void** cur_buffer = buffer ? buffer + i : 0;
+		__int64* cur_buffer_len = buffer_len ? buffer_len + i : 0;
+		if (split_N)
+		{
+			int n_begin = in_N*i / num_parts;
+			int cur_N = in_N*(i + 1) / num_parts - n_begin;
+			zq_cnn_depthwise_conv_no_padding_8i(in_data + n_begin*in_sliceStep, cur_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+				int8_filters, filter_H, filter_W, strideH, strideW,
+				out_data + n_begin*out_sliceStep, cur_N, need_H, need_W, in_C, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data,
+				cur_buffer, cur_buffer_len);
+		}
+		else
+		{
+			int h_begin = need_H*i / num_parts;
+			int cur_out_H = need_H*(i + 1) / num_parts - h_begin;
+			int cur_in_H = (cur_out_H - 1)*strideH + filter_H;
+			zq_cnn_depthwise_conv_no_padding_8i(in_data + h_begin*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep, in_scales,
+				int8_filters, filter_H, filter_W, strideH, strideW,
+				out_data + h_begin*out_widthStep, in_N, cur_out_H, need_W, in_C, out_pixStep, out_widthStep, out_sliceStep, bias_data, slope_data,
+				cur_buffer, cur_buffer_len);
+		}
+	});
+	return true;
+}
+
+bool ZQ_CNN_Forward_SSEUtils::InnerProductInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias,
+	const float* in_scales, const void* int8_filters, ZQ_CNN_Tensor4D& output, void** buffer, __int64* buffer_len, int num_threads)
+{
+	if (input.GetN() > 0 && (filters.GetH() != input.GetH() || filters.GetW() != input.GetW()))
+		return false;
+	/*an inner product is a convolution whose filters cover the whole input*/
+	return ConvolutionInt8(input, filters, bias, 0, in_scales, int8_filters, 1, 1, 1, 1, 0, 0, output, buffer, buffer_len, num_threads);
 }
 
 #if __ARM_NEON
 
-void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+void _depthwise_convolution_nopadding_single_thread(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep, const float* bias, const float* slope)
 {
@@ -1359,7 +1604,7 @@ void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding(int align_mode, c
 
 #else
 
-void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+void _depthwise_convolution_nopadding_single_thread(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep, const float* bias, const float* slope)
 {
@@ -2053,8 +2298,199 @@ void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding(int align_mode, c
 
 #endif
 
+void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+	int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep, const float* bias, const float* slope,
+	int num_threads, const std::vector<EpilogueOp>& epilogue)
+{
+	double mul_count = (double)out_N*out_H*out_W*out_C*filter_H*filter_W;
+	bool split_N = out_N >= num_threads;
+	int num_parts = _get_num_of_parts(num_threads, split_N ? out_N : out_H, mul_count);
+	if (num_parts <= 1)
+	{
+		_depthwise_convolution_nopadding_part(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+			out_data, out_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, bias, slope, epilogue, 0, 0);
+		return;
+	}
+
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		if (split_N)
+		{
+			int n_begin = out_N*i / num_parts;
+			int cur_N = out_N*(i + 1) / num_parts - n_begin;
+			_depthwise_convolution_nopadding_part(align_mode, in_data + n_begin*in_sliceStep, cur_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+				out_data + n_begin*out_sliceStep, cur_N, out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, bias, slope, epilogue, n_begin, 0);
+		}
+		else
+		{
+			int h_begin = out_H*i / num_parts;
+			int cur_out_H = out_H*(i + 1) / num_parts - h_begin;
+			int cur_in_H = (cur_out_H - 1)*strideH + filter_H;
+			_depthwise_convolution_nopadding_part(align_mode, in_data + h_begin*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+				out_data + h_begin*out_widthStep, in_N, cur_out_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, bias, slope, epilogue, 0, h_begin);
+		}
+	});
+}
+
+/*the same as _convolution_nopadding_part*/
+void ZQ_CNN_Forward_SSEUtils::_depthwise_convolution_nopadding_part(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+	const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+	int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep, const float* bias, const float* slope,
+	const std::vector<EpilogueOp>& epilogue, int n_begin, int h_begin)
+{
+	int band_H = out_H, min_band_H = out_H;
+#if ZQ_CNN_EPILOGUE_TILE_BYTES > 0
+	if (epilogue.size() > 0)
+	{
+		min_band_H = (64 + out_W - 1) / __max(out_W, 1);
+		band_H = __max(ZQ_CNN_EPILOGUE_TILE_BYTES / __max(out_N*out_widthStep*(int)sizeof(float), 1), min_band_H);
+	}
+#endif
+	for (int h = 0; h < out_H; h += band_H)
+	{
+		if (out_H - h < band_H + min_band_H)
+			band_H = out_H - h;
+		int cur_in_H = band_H == out_H ? in_H : (band_H - 1)*strideH + filter_H;
+		float* cur_out_data = out_data + h*out_widthStep;
+		_depthwise_convolution_nopadding_single_thread(align_mode, in_data + h*strideH*in_widthStep, in_N, cur_in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			filter_data, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
+			cur_out_data, out_N, band_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, bias, slope);
+		if (epilogue.size() > 0)
+			_apply_epilogue(epilogue, cur_out_data, out_N, band_H, out_W, out_C, out_pixStep, out_widthStep, out_sliceStep, n_begin, h_begin + h);
+	}
+}
+
+bool ZQ_CNN_Forward_SSEUtils::ApplyEpilogue(ZQ_CNN_Tensor4D& data, const std::vector<EpilogueOp>& epilogue)
+{
+	std::vector<EpilogueOp> ops;
+	if (!_make_epilogue(data, &epilogue, ops))
+		return false;
+	int N = data.GetN(), H = data.GetH(), W = data.GetW(), C = data.GetC();
+	if (N <= 0 || H <= 0 || W <= 0 || C <= 0)
+		return true;
+	_apply_epilogue(ops, data.GetFirstPixelPtr(), N, H, W, C, data.GetPixelStep(), data.GetWidthStep(), data.GetSliceStep(), 0, 0);
+	return true;
+}
+
+bool ZQ_CNN_Forward_SSEUtils::_make_epilogue(const ZQ_CNN_Tensor4D& output, const std::vector<EpilogueOp>* epilogue, std::vector<EpilogueOp>& ops)
+{
+	if (epilogue)
+		ops.insert(ops.end(), epilogue->begin(), epilogue->end());
+	int N = output.GetN(), H = output.GetH(), W = output.GetW(), C = output.GetC();
+	for (int i = 0; i < ops.size(); i++)
+	{
+		EpilogueOp& op = ops[i];
+		int align_mode = __min(op.align_mode, (int)output.GetAlignType());
+		if (op.a)
+			align_mode = __min(align_mode, (int)op.a->GetAlignType());
+		if (op.b)
+			align_mode = __min(align_mode, (int)op.b->GetAlignType());
 #if __ARM_NEON
-void ZQ_CNN_Forward_SSEUtils::_inner_product(int align_mode, const float* in_data, int in_N, int in_H, int in_W, 
+		align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
+#else
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
+		align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
+#elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
+		align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
+#elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_SSE
+		align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
+#else
+		align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_0);
+#endif
+#endif
+		op.align_mode = align_mode;
+		switch (op.type)
+		{
+		case EpilogueOp::BIAS:
+		case EpilogueOp::PRELU:
+			if (op.a == 0 || op.a->GetC() != C)
+				return false;
+			break;
+		case EpilogueOp::BIAS_PRELU:
+		case EpilogueOp::BATCHNORM_B_A:
+			if (op.a == 0 || op.a->GetC() != C || op.b == 0 || op.b->GetC() != C)
+				return false;
+			break;
+		case EpilogueOp::SCALE:
+			if (op.a == 0 || op.a->GetC() != C || (op.b && op.b->GetC() != C))
+				return false;
+			break;
+		case EpilogueOp::ELTWISE_SUM:
+			if (op.a == 0 || op.a->GetN() != N || op.a->GetH() != H || op.a->GetW() != W || op.a->GetC() != C)
+				return false;
+			break;
+		case EpilogueOp::RELU:
+		case EpilogueOp::SCALAR_ADD:
+		case EpilogueOp::SCALAR_MUL:
+		case EpilogueOp::SCALAR_MAX:
+		case EpilogueOp::SCALAR_MIN:
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+void ZQ_CNN_Forward_SSEUtils::_apply_epilogue(const std::vector<EpilogueOp>& ops, float* data, int N, int H, int W, int C, int pixStep, int widthStep, int sliceStep,
+	int n_begin, int h_begin)
+{
+	for (int i = 0; i < ops.size(); i++)
+	{
+		const EpilogueOp& op = ops[i];
+		const float* a_data = op.a ? op.a->GetFirstPixelPtr() : 0;
+		const float* b_data = op.b ? op.b->GetFirstPixelPtr() : 0;
+		switch (op.type)
+		{
+		case EpilogueOp::BIAS:
+			_addbias(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, a_data);
+			break;
+		case EpilogueOp::PRELU:
+			_prelu(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, a_data);
+			break;
+		case EpilogueOp::BIAS_PRELU:
+			_addbias_prelu(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, a_data, b_data);
+			break;
+		case EpilogueOp::RELU:
+			_relu(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, op.scalar);
+			break;
+		case EpilogueOp::SCALE:
+			_scalebias(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, a_data, b_data);
+			break;
+		case EpilogueOp::BATCHNORM_B_A:
+			_batchnorm_b_a(op.align_mode, data, N, H, W, C, pixStep, widthStep, sliceStep, b_data, a_data);
+			break;
+		case EpilogueOp::ELTWISE_SUM:
+		{
+			const float* in_data[2] = { data, a_data + n_begin*op.a->GetSliceStep() + h_begin*op.a->GetWidthStep() };
+			int in_pixStep[2] = { pixStep, op.a->GetPixelStep() };
+			int in_widthStep[2] = { widthStep, op.a->GetWidthStep() };
+			int in_sliceStep[2] = { sliceStep, op.a->GetSliceStep() };
+			_eltwise_sum(op.align_mode, 2, in_data, N, H, W, C, in_pixStep, in_widthStep, in_sliceStep, data, pixStep, widthStep, sliceStep);
+			break;
+		}
+		case EpilogueOp::SCALAR_ADD:
+			_scalaroperation_add(op.align_mode, op.scalar, data, N, H, W, C, pixStep, widthStep, sliceStep);
+			break;
+		case EpilogueOp::SCALAR_MUL:
+			_scalaroperation_mul(op.align_mode, op.scalar, data, N, H, W, C, pixStep, widthStep, sliceStep);
+			break;
+		case EpilogueOp::SCALAR_MAX:
+			_scalaroperation_max(op.align_mode, op.scalar, data, N, H, W, C, pixStep, widthStep, sliceStep);
+			break;
+		case EpilogueOp::SCALAR_MIN:
+			_scalaroperation_min(op.align_mode, op.scalar, data, N, H, W, C, pixStep, widthStep, sliceStep);
+			break;
+		}
+	}
+}
+
+#if __ARM_NEON
+void _inner_product_single_thread(int align_mode, const float* in_data, int in_N, int in_H, int in_W, 
 	int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	float* out_data, int out_N, int out_sliceStep,void**buffer, __int64* buffer_len)
@@ -2104,7 +2540,7 @@ void ZQ_CNN_Forward_SSEUtils::_inner_product(int align_mode, const float* in_dat
 
 #else
 
-void ZQ_CNN_Forward_SSEUtils::_inner_product(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
+void _inner_product_single_thread(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
 	int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 	const float* filter_data, int filter_N, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 	float* out_data, int out_N, int out_sliceStep, void**buffer, __int64* buffer_len)
@@ -2180,6 +2616,46 @@ void ZQ_CNN_Forward_SSEUtils::_inner_product(int align_mode, const float* in_dat
 
 #endif //__ARM_NEON
 
+void ZQ_CNN_Forward_SSEUtils::_inner_product(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
+	int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+	const float* filter_data, int filter_N, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+	float* out_data, int out_N, int out_sliceStep, void**buffer, __int64* buffer_len, int num_threads)
+{
+	double mul_count = (double)out_N*filter_N*in_H*in_W*in_C;
+	/*split the slices for batch input, otherwise split the output channels by groups of 8*/
+	bool split_N = out_N >= num_threads;
+	int num_parts = _get_num_of_parts(num_threads, split_N ? out_N : (filter_N + 7) / 8, mul_count);
+	if (num_parts <= 1)
+	{
+		_inner_product_single_thread(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+			filter_data, filter_N, filter_pixStep, filter_widthStep, filter_sliceStep, out_data, out_N, out_sliceStep, buffer, buffer_len);
+		return;
+	}
+
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		void** cur_buffer = buffer ? buffer + i : 0;
+		__int64* cur_buffer_len = buffer_len ? buffer_len + i : 0;
+		if (split_N)
+		{
+			int n_begin = out_N*i / num_parts;
+			int cur_N = out_N*(i + 1) / num_parts - n_begin;
+			_inner_product_single_thread(align_mode, in_data + n_begin*in_sliceStep, cur_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data, filter_N, filter_pixStep, filter_widthStep, filter_sliceStep, out_data + n_begin*out_sliceStep, cur_N, out_sliceStep,
+				cur_buffer, cur_buffer_len);
+		}
+		else
+		{
+			int num_groups = (filter_N + 7) / 8;
+			int c_begin = num_groups*i / num_parts * 8;
+			int c_end = __min(filter_N, num_groups*(i + 1) / num_parts * 8);
+			_inner_product_single_thread(align_mode, in_data, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
+				filter_data + c_begin*filter_sliceStep, c_end - c_begin, filter_pixStep, filter_widthStep, filter_sliceStep, out_data + c_begin, out_N, out_sliceStep,
+				cur_buffer, cur_buffer_len);
+		}
+	});
+}
+
 #if __ARM_NEON
 void  ZQ_CNN_Forward_SSEUtils::_addbias(int align_mode, float* data, int N, int H, int W, int C, 
 	int pixelStep, int widthStep, int sliceStep, const float* bias_Data)
@@ -4285,6 +4761,140 @@ bool ZQ_CNN_Forward_SSEUtils::_prior_box_text(const ZQ_CNN_Tensor4D& input, cons
 	return true;
 }
 
+bool ZQ_CNN_Forward_SSEUtils::_permute(const ZQ_CNN_Tensor4D& input, const int order[4], ZQ_CNN_Tensor4D& output, int num_threads)
+{
+	if (&input == &output)
+		return input.Permute_NCHW(output, order, 1);
+	int out_N, out_C, out_H, out_W;
+	if (!ZQ_CNN_Tensor4D::Permute_NCHW_get_size(order, input.GetN(), input.GetC(), input.GetH(), input.GetW(), out_N, out_C, out_H, out_W))
+		return false;
+	if (!output.ChangeSize(out_N, out_H, out_W, out_C, 0, 0))
+		return false;
+	if (output.IsReshapeViewOf(input) || out_N*out_C*out_H*out_W == 0)
+		return true;
+	int in_axis_steps[4] = { input.GetSliceStep(), 1, input.GetWidthStep(), input.GetPixelStep() };
+	int dims[4] = { out_N, out_C, out_H, out_W };
+	int in_steps[4], out_steps[4] = { output.GetSliceStep(), 1, output.GetWidthStep(), output.GetPixelStep() };
+	for (int i = 0; i < 4; i++)
+		in_steps[i] = in_axis_steps[order[i]];
+	int align_mode = __min(input.GetAlignType(), output.GetAlignType());
+	_permute_copy(align_mode, input.GetFirstPixelPtr(), dims, in_steps, output.GetFirstPixelPtr(), out_steps, num_threads);
+
+	int out_pixStep = output.GetPixelStep();
+	if (out_pixStep > out_C)
+	{
+		float* slice_ptr = output.GetFirstPixelPtr();
+		for (int n = 0; n < out_N; n++, slice_ptr += output.GetSliceStep())
+		{
+			float* row_ptr = slice_ptr;
+			for (int h = 0; h < out_H; h++, row_ptr += output.GetWidthStep())
+			{
+				float* pix_ptr = row_ptr + out_C;
+				for (int w = 0; w < out_W; w++, pix_ptr += out_pixStep)
+					memset(pix_ptr, 0, sizeof(float)*(out_pixStep - out_C));
+			}
+		}
+	}
+	return true;
+}
+
+bool ZQ_CNN_Forward_SSEUtils::_reshape(const ZQ_CNN_Tensor4D& input, int out_N, int out_C, int out_H, int out_W, ZQ_CNN_Tensor4D& output, int num_threads)
+{
+	std::vector<int> shape(4);
+	shape[0] = out_N; shape[1] = out_C; shape[2] = out_H; shape[3] = out_W;
+	if (&input == &output)
+		return input.Reshape_NCHW(output, shape, 1);
+	if (!output.ChangeSize(out_N, out_H, out_W, out_C, 0, 0))
+		return false;
+	if (output.IsReshapeViewOf(input) || out_N*out_C*out_H*out_W == 0)
+		return true;
+	int N = input.GetN(), C = input.GetC(), H = input.GetH(), W = input.GetW();
+	int in_pixStep = input.GetPixelStep(), in_widthStep = input.GetWidthStep(), in_sliceStep = input.GetSliceStep();
+	int out_pixStep = output.GetPixelStep(), out_widthStep = output.GetWidthStep(), out_sliceStep = output.GetSliceStep();
+	int align_mode = __min(input.GetAlignType(), output.GetAlignType());
+	const float* in_data = input.GetFirstPixelPtr();
+	float* out_data = output.GetFirstPixelPtr();
+	if (out_N == N && out_C == C && out_H == H && out_W == W)
+	{
+		int dims[4] = { N, C, H, W };
+		int in_steps[4] = { in_sliceStep, 1, in_widthStep, in_pixStep };
+		int out_steps[4] = { out_sliceStep, 1, out_widthStep, out_pixStep };
+		_permute_copy(align_mode, in_data, dims, in_steps, out_data, out_steps, num_threads);
+	}
+	else if (out_N == N && out_C == C && out_H*out_W == H*W && in_widthStep == W*in_pixStep && out_widthStep == out_W*out_pixStep)
+	{
+		//the pixels keep their order
+		int dims[4] = { N, C, 1, H*W };
+		int in_steps[4] = { in_sliceStep, 1, 0, in_pixStep };
+		int out_steps[4] = { out_sliceStep, 1, 0, out_pixStep };
+		_permute_copy(align_mode, in_data, dims, in_steps, out_data, out_steps, num_threads);
+	}
+	else if (out_N == N && out_H == 1 && out_W == 1)
+	{
+		//channel c*H*W+h*W+w of the output
+		int dims[4] = { N, C, H, W };
+		int in_steps[4] = { in_sliceStep, 1, in_widthStep, in_pixStep };
+		int out_steps[4] = { out_sliceStep, H*W, W, 1 };
+		_permute_copy(align_mode, in_data, dims, in_steps, out_data, out_steps, num_threads);
+	}
+	else if (out_N == N && H == 1 && W == 1)
+	{
+		//channel c*out_H*out_W+h*out_W+w of the input
+		int dims[4] = { N, out_C, out_H, out_W };
+		int in_steps[4] = { in_sliceStep, out_H*out_W, out_W, 1 };
+		int out_steps[4] = { out_sliceStep, 1, out_widthStep, out_pixStep };
+		_permute_copy(align_mode, in_data, dims, in_steps, out_data, out_steps, num_threads);
+	}
+	else
+	{
+		return input.Reshape_NCHW(output, shape, 1);
+	}
+	return true;
+}
+
+static void _permute_copy_single_thread(int align_mode, const float* in_data, const int dims[4], const int in_steps[4],
+	float* out_data, const int out_steps[4])
+{
+#if __ARM_NEON || ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	if (align_mode != ZQ_CNN_Tensor4D::ALIGN_0)
+	{
+		zq_cnn_permute_32f_align128bit(in_data, dims[0], dims[1], dims[2], dims[3], in_steps[0], in_steps[1], in_steps[2], in_steps[3],
+			out_data, out_steps[0], out_steps[1], out_steps[2], out_steps[3]);
+		return;
+	}
+#endif
+	zq_cnn_permute_32f_align0(in_data, dims[0], dims[1], dims[2], dims[3], in_steps[0], in_steps[1], in_steps[2], in_steps[3],
+		out_data, out_steps[0], out_steps[1], out_steps[2], out_steps[3]);
+}
+
+void ZQ_CNN_Forward_SSEUtils::_permute_copy(int align_mode, const float* in_data, const int dims[4], const int in_steps[4],
+	float* out_data, const int out_steps[4], int num_threads)
+{
+	/*split the largest dim that is not contiguous in the input or the output*/
+	int split_dim = -1;
+	for (int i = 0; i < 4; i++)
+	{
+		if (in_steps[i] != 1 && out_steps[i] != 1 && (split_dim < 0 || dims[i] > dims[split_dim]))
+			split_dim = i;
+	}
+	double count = (double)dims[0] * dims[1] * dims[2] * dims[3];
+	int num_parts = split_dim < 0 ? 1 : _get_num_of_parts(num_threads, dims[split_dim], count);
+	if (num_parts <= 1)
+	{
+		_permute_copy_single_thread(align_mode, in_data, dims, in_steps, out_data, out_steps);
+		return;
+	}
+
+	ZQ_CNN_ThreadPool::ParallelFor(num_parts, num_parts, [&](int i, int thread_id)
+	{
+		int cur_dims[4] = { dims[0], dims[1], dims[2], dims[3] };
+		int begin = dims[split_dim] * i / num_parts;
+		cur_dims[split_dim] = dims[split_dim] * (i + 1) / num_parts - begin;
+		_permute_copy_single_thread(align_mode, in_data + begin*in_steps[split_dim], cur_dims, in_steps,
+			out_data + begin*out_steps[split_dim], out_steps);
+	});
+}
+
 bool ZQ_CNN_Forward_SSEUtils::_concat_NCHW_get_size(const std::vector<ZQ_CNN_Tensor4D*>& inputs, int axis, int& out_N, int& out_C, int& out_H, int& out_W)
 {
 	if (axis < 0 || axis >= 4)
@@ -4366,10 +4976,6 @@ bool ZQ_CNN_Forward_SSEUtils::_concat_NCHW(const std::vector<ZQ_CNN_Tensor4D*>&
 	{
 		return output.ChangeSize(0, 0, 0, 0, 0, 0);
 	}
-	else if (valid_inputs.size() == 1)
-	{
-		return output.CopyData(*valid_inputs[0]);
-	}
 	else
 	{
 		if (output.GetN() != out_N || output.GetC() != out_C || output.GetH() != out_H || output.GetW() != out_W)
@@ -4395,7 +5001,9 @@ bool ZQ_CNN_Forward_SSEUtils::_concat_NCHW(const std::vector<ZQ_CNN_Tensor4D*>&
 			const float* in_ptr = valid_inputs[i]->GetFirstPixelPtr();
 			const float* in_slice_ptr = in_ptr;
 			float* out_slice_ptr = out_ptr;
-			for (int n = 0; n < in_N; n++)
+			//the input has been written into its place of output (see ZQ_CNN_Tensor4D::SetChannelView)
+			bool in_place = in_ptr == out_ptr && in_pixStep == out_pixStep && in_widthStep == out_widthStep && in_sliceStep == out_sliceStep;
+			for (int n = 0; n < in_N && !in_place; n++)
 			{
 				const float* in_row_ptr = in_slice_ptr;
 				float* out_row_ptr = out_slice_ptr;
@@ -15,9 +15,71 @@ namespace ZQ
 	class ZQ_CNN_Forward_SSEUtils
 	{
 	public:
+		/*an element-wise op done by a convolution (or depthwise convolution) on its output, on each band of rows right after 
+		the band is computed so that it is still in cache. The ops are done in order, each gives the same as its layer*/
+		class EpilogueOp
+		{
+		public:
+			enum OpType {
+				BIAS,			//x+a
+				PRELU,			//prelu with slope a
+				BIAS_PRELU,		//prelu of x+a with slope b
+				RELU,			//relu with slope scalar
+				SCALE,			//x*a+b, b can be 0
+				BATCHNORM_B_A,	//x*b+a, the b and a of batchnorm
+				ELTWISE_SUM,	//x+a, a has the shape of the output
+				SCALAR_ADD,		//x+scalar
+				SCALAR_MUL,		//x*scalar
+				SCALAR_MAX,		//max(x,scalar)
+				SCALAR_MIN		//min(x,scalar)
+			};
+			EpilogueOp(int type = RELU, const ZQ_CNN_Tensor4D* a = 0, const ZQ_CNN_Tensor4D* b = 0, float scalar = 0,
+				int align_mode = ZQ_CNN_Tensor4D::ALIGN_256bit) :type(type), a(a), b(b), scalar(scalar), align_mode(align_mode) {}
+			int type;
+			const ZQ_CNN_Tensor4D* a;
+			const ZQ_CNN_Tensor4D* b;
+			float scalar;
+			int align_mode;	//the max align mode to use
+		};
+
+		/*do the ops on the whole tensor, for the kernels that cannot do them on bands*/
+		static bool ApplyEpilogue(ZQ_CNN_Tensor4D& data, const std::vector<EpilogueOp>& epilogue);
+
+		/*pack the filters once for the gemm path which is used when input and filters have different pixStep,
+		packed_filters is reallocated (with _aligned_malloc) if packed_filters_len is not enough*/
+		static void ConvolutionPrePack(const ZQ_CNN_Tensor4D& filters, void*& packed_filters, __int64& packed_filters_len);
+
+		/*transform 3x3 filters for winograd F(2x2,3x3) (winograd_tile = 2) or F(4x4,3x3) (winograd_tile = 4)*/
+		static void ConvolutionWinogradPrePack(const ZQ_CNN_Tensor4D& filters, int winograd_tile, void*& winograd_filters, __int64& winograd_filters_len);
+
+		/*quantize the filters for ConvolutionInt8 and InnerProductInt8 (or DepthwiseConvolutionInt8),
+		in_scales (one for each input channel) are given by calibration, they must be the same when running*/
+		static void ConvolutionInt8PrePack(const ZQ_CNN_Tensor4D& filters, const float* in_scales, void*& int8_filters, __int64& int8_filters_len);
+		static void DepthwiseConvolutionInt8PrePack(const ZQ_CNN_Tensor4D& filters, const float* in_scales, void*& int8_filters, __int64& int8_filters_len);
+
+		/*int8 filters packed by builds with another format cannot be used here*/
+		static int Int8PackFormat();
+
+		/*int8 versions of convolution, depthwise convolution and inner product, the input is quantized with in_scales,
+		filters only give the shape, bias and slope can be 0*/
+		static bool ConvolutionInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias, const ZQ_CNN_Tensor4D* slope,
+			const float* in_scales, const void* int8_filters, int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW, ZQ_CNN_Tensor4D& output,
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1);
+		static bool DepthwiseConvolutionInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias, const ZQ_CNN_Tensor4D* slope,
+			const float* in_scales, const void* int8_filters, int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output,
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1);
+		static bool InnerProductInt8(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D* bias,
+			const float* in_scales, const void* int8_filters, ZQ_CNN_Tensor4D& output, void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1);
+
+		/*convolution, depthwise convolution and inner product can split the work across num_threads threads,
+		in that case buffer and buffer_len (if not 0) should point to arrays of num_threads elements, one for each thread,
+		packed_filters (if not 0) should be made by ConvolutionPrePack,
+		winograd_filters (if not 0) should be made by ConvolutionWinogradPrePack, it is used for 3x3 convolution with stride 1,
+		epilogue (if not 0) is done after the bias and prelu*/
 		static bool ConvolutionWithBias(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D& bias,
 			int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW, ZQ_CNN_Tensor4D& output,
-			void** buffer = 0, __int64* buffer_len = 0)
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1, const float* packed_filters = 0,
+			const float* winograd_filters = 0, int winograd_tile = 0, const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -70,7 +132,6 @@ namespace ZQ
 			float* in_firstPixelData = input.GetFirstPixelPtr() - padH*in_widthStep - padW*in_pixStep;
 			const float* filter_firstPixelData = filters.GetFirstPixelPtr();
 			float* out_firstPixelData = output.GetFirstPixelPtr();
-			const float* bias_firstPixelData = bias.GetFirstPixelPtr();
 
 			int align_mode = __min((int)input.GetAlignType(), __min((int)filters.GetAlignType(), (int)output.GetAlignType()));
 			if (in_C == 1)
@@ -82,7 +143,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -95,12 +156,13 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_0;
 			//output.Reset();
 
+			std::vector<EpilogueOp> ops(1, EpilogueOp(EpilogueOp::BIAS, &bias, 0, 0, align_mode));
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW, dilation_H, dilation_W,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-			//printf("out_data = %f\n", out_firstPixelData[0]);
-			_addbias(__min(bias.GetAlignType(), align_mode), out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep,
-				bias_firstPixelData);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, num_threads, packed_filters,
+				winograd_filters, winograd_tile, ops);
 			//printf("out_data = %f\n", out_firstPixelData[0]);
 
 			double t2 = omp_get_wtime();
@@ -110,7 +172,8 @@ namespace ZQ
 
 		static bool ConvolutionWithBiasPReLU(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D& bias,
 			const ZQ_CNN_Tensor4D& slope, int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW, ZQ_CNN_Tensor4D& output,
-			void** buffer = 0, __int64* buffer_len = 0)
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1, const float* packed_filters = 0,
+			const float* winograd_filters = 0, int winograd_tile = 0, const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -164,8 +227,6 @@ namespace ZQ
 			float* in_firstPixelData = input.GetFirstPixelPtr() - padH*in_widthStep - padW*in_pixStep;
 			const float* filter_firstPixelData = filters.GetFirstPixelPtr();
 			float* out_firstPixelData = output.GetFirstPixelPtr();
-			const float* bias_firstPixelData = bias.GetFirstPixelPtr();
-			const float* slope_firstPixelData = slope.GetFirstPixelPtr();
 
 			int align_mode = __min((int)input.GetAlignType(), __min((int)filters.GetAlignType(), (int)output.GetAlignType()));
 			if (in_C == 1)
@@ -177,7 +238,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -190,12 +251,13 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_128bit;
 			//output.Reset();
 
+			std::vector<EpilogueOp> ops(1, EpilogueOp(EpilogueOp::BIAS_PRELU, &bias, &slope, 0, align_mode));
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW, dilation_H, dilation_W,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-			//printf("out_data = %f\n", out_firstPixelData[0]);
-			_addbias_prelu(__min(__min(bias.GetAlignType(),slope.GetAlignType()), align_mode), out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep,
-				bias_firstPixelData, slope_firstPixelData);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, num_threads, packed_filters,
+				winograd_filters, winograd_tile, ops);
 			//printf("out_data = %f\n", out_firstPixelData[0]);
 
 			double t2 = omp_get_wtime();
@@ -205,7 +267,8 @@ namespace ZQ
 
 		static bool ConvolutionWithPReLU(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters,
 			const ZQ_CNN_Tensor4D& slope, int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW, ZQ_CNN_Tensor4D& output,
-			void** buffer = 0, __int64* buffer_len = 0)
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1, const float* packed_filters = 0,
+			const float* winograd_filters = 0, int winograd_tile = 0, const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -258,7 +321,6 @@ namespace ZQ
 			float* in_firstPixelData = input.GetFirstPixelPtr() - padH*in_widthStep - padW*in_pixStep;
 			const float* filter_firstPixelData = filters.GetFirstPixelPtr();
 			float* out_firstPixelData = output.GetFirstPixelPtr();
-			const float* slope_firstPixelData = slope.GetFirstPixelPtr();
 
 			int align_mode = __min((int)input.GetAlignType(), __min((int)filters.GetAlignType(), (int)output.GetAlignType()));
 			if (in_C == 1)
@@ -270,7 +332,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -283,12 +345,13 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_128bit;
 			//output.Reset();
 
+			std::vector<EpilogueOp> ops(1, EpilogueOp(EpilogueOp::PRELU, &slope, 0, 0, align_mode));
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW, dilation_H, dilation_W,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
-			//printf("out_data = %f\n", out_firstPixelData[0]);
-			_prelu(__min(slope.GetAlignType(), align_mode), out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep,
-				slope_firstPixelData);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, num_threads, packed_filters,
+				winograd_filters, winograd_tile, ops);
 			//printf("out_data = %f\n", out_firstPixelData[0]);
 
 			double t2 = omp_get_wtime();
@@ -297,7 +360,8 @@ namespace ZQ
 		}
 
 		static bool Convolution(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, int strideH, int strideW, int dilation_H, int dilation_W, int padH, int padW,
-			ZQ_CNN_Tensor4D& output, void** buffer = 0, __int64* buffer_len = 0)
+			ZQ_CNN_Tensor4D& output, void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1, const float* packed_filters = 0,
+			const float* winograd_filters = 0, int winograd_tile = 0, const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			int in_N = input.GetN();
 			int in_H = input.GetH();
@@ -358,7 +422,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -371,16 +435,21 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_128bit;
 			//output.Reset();
 			
+			std::vector<EpilogueOp> ops;
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW, dilation_H, dilation_W,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, buffer, buffer_len, num_threads, packed_filters,
+				winograd_filters, winograd_tile, ops);
 
 			//printf("out_data = %f\n", out_firstPixelData[0]);
 			return true;
 		}
 
 		static bool DepthwiseConvolutionWithBias(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D& bias,
-			int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output)
+			int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output, int num_threads = 1,
+			const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -444,7 +513,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -454,9 +523,12 @@ namespace ZQ
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_0);
 #endif
 #endif
+			std::vector<EpilogueOp> ops;
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_depthwise_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, bias_firstPixelData, NULL);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, bias_firstPixelData, NULL, num_threads, ops);
 		
 			double t2 = omp_get_wtime();
 			//printf("utils:conv: %.3f ms\n", (t2 - t1) * 1000);
@@ -464,7 +536,8 @@ namespace ZQ
 		}
 
 		static bool DepthwiseConvolutionWithBiasPReLU(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D& bias,
-			const ZQ_CNN_Tensor4D& prelu_slope, int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output)
+			const ZQ_CNN_Tensor4D& prelu_slope, int strideH, int strideW, int padH, int padW, ZQ_CNN_Tensor4D& output, int num_threads = 1,
+			const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -532,7 +605,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -542,9 +615,12 @@ namespace ZQ
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_0);
 #endif
 #endif
+			std::vector<EpilogueOp> ops;
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_depthwise_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, bias_firstPixelData, slope_data);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, bias_firstPixelData, slope_data, num_threads, ops);
 
 			double t2 = omp_get_wtime();
 			//printf("utils:conv: %.3f ms\n", (t2 - t1) * 1000);
@@ -552,7 +628,7 @@ namespace ZQ
 		}
 
 		static bool DepthwiseConvolution(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, int strideH, int strideW, int padH, int padW, 
-			ZQ_CNN_Tensor4D& output)
+			ZQ_CNN_Tensor4D& output, int num_threads = 1, const std::vector<EpilogueOp>* epilogue = 0)
 		{
 			//num_threads = 1;
 			int in_N = input.GetN();
@@ -614,7 +690,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -626,15 +702,18 @@ namespace ZQ
 #endif
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_128bit;
 			//output.Reset();
+			std::vector<EpilogueOp> ops;
+			if (!_make_epilogue(output, epilogue, ops))
+				return false;
 			_depthwise_convolution_nopadding(align_mode, in_firstPixelData, in_N, in_H + (padH << 1), in_W + (padW << 1), in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_H, filter_W, filter_C, filter_pixStep, filter_widthStep, filter_sliceStep, strideH, strideW,
-				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, NULL, NULL);
+				out_firstPixelData, need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep, NULL, NULL, num_threads, ops);
 
 			return true;
 		}
 
 		static bool InnerProductWithBias(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, const ZQ_CNN_Tensor4D& bias, 
-			ZQ_CNN_Tensor4D& output, void** buffer = 0, __int64* buffer_len = 0)
+			ZQ_CNN_Tensor4D& output, void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1)
 		{
 			double t1 = omp_get_wtime();
 			int in_N = input.GetN();
@@ -691,7 +770,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -704,7 +783,7 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_0;
 			_inner_product(align_mode, in_firstPixelData, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_pixStep, filter_widthStep, filter_sliceStep,
-				out_firstPixelData, need_N, out_sliceStep, buffer, buffer_len);
+				out_firstPixelData, need_N, out_sliceStep, buffer, buffer_len, num_threads);
 			_addbias(__min(output.GetAlignType(), align_mode), output.GetFirstPixelPtr(), need_N, need_H, need_W, need_C, out_pixStep, out_widthStep, out_sliceStep,
 				bias_firstPixelData);
 
@@ -714,7 +793,7 @@ namespace ZQ
 		}
 
 		static bool InnerProduct(ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& filters, ZQ_CNN_Tensor4D& output, 
-			void** buffer = 0, __int64* buffer_len = 0)
+			void** buffer = 0, __int64* buffer_len = 0, int num_threads = 1)
 		{
 			int in_N = input.GetN();
 			int in_H = input.GetH();
@@ -768,7 +847,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -781,7 +860,7 @@ namespace ZQ
 			//align_mode = ZQ_CNN_Tensor4D::ALIGN_0;
 			_inner_product(align_mode, in_firstPixelData, in_N, in_H, in_W, in_C, in_pixStep, in_widthStep, in_sliceStep,
 				filter_firstPixelData, filter_N, filter_pixStep, filter_widthStep, filter_sliceStep,
-				out_firstPixelData, need_N, out_sliceStep, buffer, buffer_len);
+				out_firstPixelData, need_N, out_sliceStep, buffer, buffer_len, num_threads);
 
 			return true;
 		}
@@ -834,7 +913,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -897,7 +976,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -932,7 +1011,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -967,7 +1046,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -999,7 +1078,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1035,7 +1114,7 @@ namespace ZQ
 #if __ARM_NEON
 				align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 				align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 				align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1075,7 +1154,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1114,7 +1193,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1151,7 +1230,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1279,7 +1358,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1311,7 +1390,7 @@ namespace ZQ
 			int sliceStep = input.GetSliceStep();
 
 			int align_mode = __min(input.GetAlignType(), __min(scale.GetAlignType(), bias.GetAlignType()));
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1344,7 +1423,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1397,7 +1476,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1453,7 +1532,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1507,7 +1586,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1561,7 +1640,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1612,7 +1691,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1663,7 +1742,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1693,7 +1772,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1723,7 +1802,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1753,7 +1832,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1784,7 +1863,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1814,7 +1893,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1845,7 +1924,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1875,7 +1954,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1906,7 +1985,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1936,7 +2015,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1967,7 +2046,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -1997,7 +2076,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2028,7 +2107,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2058,7 +2137,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2089,7 +2168,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2119,7 +2198,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2167,7 +2246,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2200,7 +2279,7 @@ namespace ZQ
 #if __ARM_NEON
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_128bit);
 #else
-#if ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX2
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX2
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
 #elif ZQ_CNN_USE_SSETYPE == ZQ_CNN_SSETYPE_AVX
 			align_mode = __min(align_mode, ZQ_CNN_Tensor4D::ALIGN_256bit);
@@ -2214,19 +2293,26 @@ namespace ZQ
 			return true;
 		}
 
-		static bool Permute(const ZQ_CNN_Tensor4D& input, const int order[4], ZQ_CNN_Tensor4D& output)
+		/*Permute, Flatten and Reshape copy nothing if the output is a reshape view of the input (see ZQ_CNN_Tensor4D::SetReshapeView)*/
+		static bool Permute(const ZQ_CNN_Tensor4D& input, const int order[4], ZQ_CNN_Tensor4D& output, int num_threads = 1)
 		{
-			return input.Permute_NCHW(output, order, 1);
+			return _permute(input, order, output, num_threads);
 		}
 
-		static bool Flatten(const ZQ_CNN_Tensor4D& input, int axis, int end_axis, ZQ_CNN_Tensor4D& output)
+		static bool Flatten(const ZQ_CNN_Tensor4D& input, int axis, int end_axis, ZQ_CNN_Tensor4D& output, int num_threads = 1)
 		{
-			return input.Flatten_NCHW(output, axis, end_axis, 1);
+			int out_N, out_C, out_H, out_W;
+			if (!ZQ_CNN_Tensor4D::Flatten_NCHW_get_size(axis, end_axis, input.GetN(), input.GetC(), input.GetH(), input.GetW(), out_N, out_C, out_H, out_W))
+				return false;
+			return _reshape(input, out_N, out_C, out_H, out_W, output, num_threads);
 		}
 
-		static bool Reshape(const ZQ_CNN_Tensor4D& input, const std::vector<int>& shape, ZQ_CNN_Tensor4D& output)
+		static bool Reshape(const ZQ_CNN_Tensor4D& input, const std::vector<int>& shape, ZQ_CNN_Tensor4D& output, int num_threads = 1)
 		{
-			return input.Reshape_NCHW(output, shape, 1);
+			int out_N, out_C, out_H, out_W;
+			if (!ZQ_CNN_Tensor4D::Reshape_NCHW_get_size(shape, input.GetN(), input.GetC(), input.GetH(), input.GetW(), out_N, out_C, out_H, out_W))
+				return false;
+			return _reshape(input, out_N, out_C, out_H, out_W, output, num_threads);
 		}
 
 		static bool PriorBox(const ZQ_CNN_Tensor4D& input, const ZQ_CNN_Tensor4D& data,
@@ -2293,17 +2379,38 @@ namespace ZQ
 			int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, 
 			int filter_pixStep, int filter_widthStep, int filter_sliceStep,	int strideH, int strideW, int dilation_H, int dilation_W,
 			float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
-			void** buffer, __int64* buffer_len);
+			void** buffer, __int64* buffer_len, int num_threads, const float* packed_filters,
+			const float* winograd_filters, int winograd_tile, const std::vector<EpilogueOp>& epilogue);
+
+		static void _convolution_nopadding_part(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
+			int in_C, int in_pixStep, int in_widthStep, int in_sliceStep, const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C,
+			int filter_pixStep, int filter_widthStep, int filter_sliceStep, int strideH, int strideW, int dilation_H, int dilation_W,
+			float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
+			void** buffer, __int64* buffer_len, const float* packed_filters, const float* winograd_filters, int winograd_tile,
+			const std::vector<EpilogueOp>& epilogue, int n_begin, int h_begin);
 
 		static void _depthwise_convolution_nopadding(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
 			int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 			const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
 			int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep, 
-			const float* bias, const float* slope);
+			const float* bias, const float* slope, int num_threads, const std::vector<EpilogueOp>& epilogue);
+
+		static void _depthwise_convolution_nopadding_part(int align_mode, const float* in_data, int in_N, int in_H, int in_W,
+			int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
+			const float* filter_data, int filter_N, int filter_H, int filter_W, int filter_C, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
+			int strideH, int strideW, float* out_data, int out_N, int out_H, int out_W, int out_C, int out_pixStep, int out_widthStep, int out_sliceStep,
+			const float* bias, const float* slope, const std::vector<EpilogueOp>& epilogue, int n_begin, int h_begin);
+
+		/*append epilogue to ops and decide the align mode of each op, return false if an op does not fit output*/
+		static bool _make_epilogue(const ZQ_CNN_Tensor4D& output, const std::vector<EpilogueOp>* epilogue, std::vector<EpilogueOp>& ops);
+
+		/*do the ops on the rows [h_begin, h_begin+H) of the slices [n_begin, n_begin+N) of the output, data points to the first of them*/
+		static void _apply_epilogue(const std::vector<EpilogueOp>& ops, float* data, int N, int H, int W, int C, int pixStep, int widthStep, int sliceStep,
+			int n_begin, int h_begin);
 
 		static void _inner_product(int align_mode, const float* in_data, int in_N, int in_H, int in_W, int in_C, int in_pixStep, int in_widthStep, int in_sliceStep,
 			const float* filter_data, int filter_N, int filter_pixStep, int filter_widthStep, int filter_sliceStep,
-			float* out_data, int out_N, int out_sliceStep, void** buffer, __int64* buffer_len);
+			float* out_data, int out_N, int out_sliceStep, void** buffer, __int64* buffer_len, int num_threads);
 
 		static void _addbias(int align_mode, float* data, int N, int H, int W, int C, int pixelStep, int widthStep, int sliceStep, 
 			const float* bias_Data);
@@ -2432,6 +2539,14 @@ namespace ZQ
 			bool flip, int num_priors, bool clip, int img_w, int img_h, float step_w, float step_h, float offset,
 			ZQ_CNN_Tensor4D& output);
 
+		static bool _permute(const ZQ_CNN_Tensor4D& input, const int order[4], ZQ_CNN_Tensor4D& output, int num_threads);
+
+		static bool _reshape(const ZQ_CNN_Tensor4D& input, int out_N, int out_C, int out_H, int out_W, ZQ_CNN_Tensor4D& output, int num_threads);
+
+		/*element (n,c,h,w) of dims is copied from in_data[n*in_steps[0]+c*in_steps[1]+h*in_steps[2]+w*in_steps[3]] to out_data (with out_steps)*/
+		static void _permute_copy(int align_mode, const float* in_data, const int dims[4], const int in_steps[4], 
+			float* out_data, const int out_steps[4], int num_threads);
+
 		static bool _concat_NCHW_get_size(const std::vector<ZQ_CNN_Tensor4D*>& inputs, int axis, int& out_N, int& out_C, int& out_H, int& out_W);
 
 		static bool _concat_NCHW(const std::vector<ZQ_CNN_Tensor4D*>& inputs, int axis, ZQ_CNN_Tensor4D& output);
@@ -0,0 +1,196 @@
+#ifndef _ZQ_CNN_GEMM_TUNER_H_
+#define _ZQ_CNN_GEMM_TUNER_H_
+#pragma once
+#include "ZQ_CNN_CompileConfig.h"
+#include "ZQ_CNN_CPUInfo.h"
+#include "math/zq_gemm_32f_align_c.h"
+#include <omp.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+namespace ZQ
+{
+	/*measures every kernel of zq_gemm_32f_AnoTrans_Btrans_auto on the gemm shapes a net really produces,
+	and makes auto use the fastest one for each shape. The winners can be saved to a cache file, which
+	is only loaded on the same cpu and the same compiled instruction set*/
+	class ZQ_CNN_GemmTuner
+	{
+	public:
+		struct Shape
+		{
+			int M, N, K;
+			Shape(int M = 0, int N = 0, int K = 0) :M(M), N(N), K(K) {}
+			bool operator<(const Shape& other) const
+			{
+				if (M != other.M) return M < other.M;
+				if (N != other.N) return N < other.N;
+				return K < other.K;
+			}
+		};
+
+		static std::string GetCacheKey()
+		{
+			return ZQ_CNN_CPUInfo::GetCPUName() + " | " + ZQ_CNN_CPUInfo::GetSSETypeName(ZQ_CNN_CPUInfo::GetSelectedSSEType());
+		}
+
+		/*false if the file is missing or made for another cpu*/
+		static bool LoadCache(const std::string& file)
+		{
+			std::ifstream fin(file.c_str());
+			if (!fin.is_open())
+				return false;
+			std::string line;
+			if (!std::getline(fin, line) || line != "cpu " + GetCacheKey())
+				return false;
+			std::lock_guard<std::mutex> lock(_mutex());
+			while (std::getline(fin, line))
+			{
+				std::istringstream sin(line);
+				Shape shape;
+				std::string name;
+				if (!(sin >> shape.M >> shape.N >> shape.K >> name))
+					continue;
+				int kernel_id = zq_gemm_32f_AnoTrans_Btrans_kernel_id(name.c_str());
+				if (kernel_id < 0)
+					continue;
+				zq_gemm_32f_AnoTrans_Btrans_set_tuned(shape.M, shape.N, shape.K, kernel_id);
+				_winners()[shape] = name;
+			}
+			return true;
+		}
+
+		static bool SaveCache(const std::string& file)
+		{
+			std::ofstream fout(file.c_str());
+			if (!fout.is_open())
+			{
+				std::cout << "failed to write " << file << "\n";
+				return false;
+			}
+			std::lock_guard<std::mutex> lock(_mutex());
+			fout << "cpu " << GetCacheKey() << "\n";
+			for (std::map<Shape, std::string>::const_iterator it = _winners().begin(); it != _winners().end(); ++it)
+				fout << it->first.M << " " << it->first.N << " " << it->first.K << " " << it->second << "\n";
+			return true;
+		}
+
+		/*collect the shapes of all zq_gemm_32f_AnoTrans_Btrans_auto calls until StopRecording*/
+		static void StartRecording()
+		{
+			std::lock_guard<std::mutex> lock(_mutex());
+			_recorded().clear();
+			zq_gemm_32f_AnoTrans_Btrans_set_recorder(_record, 0);
+		}
+
+		static void StopRecording(std::vector<Shape>& shapes)
+		{
+			zq_gemm_32f_AnoTrans_Btrans_set_recorder(0, 0);
+			std::lock_guard<std::mutex> lock(_mutex());
+			shapes.assign(_recorded().begin(), _recorded().end());
+			_recorded().clear();
+		}
+
+		/*tune the shapes that have no winner yet, return the number of tuned shapes.
+		Nets may run at the same time, but they make the timings less accurate*/
+		static int Tune(const std::vector<Shape>& shapes, bool show_debug_info = false)
+		{
+			int count = 0;
+			for (int i = 0; i < shapes.size(); i++)
+			{
+				const Shape& shape = shapes[i];
+				{
+					std::lock_guard<std::mutex> lock(_mutex());
+					if (_winners().find(shape) != _winners().end())
+						continue;
+				}
+				int best_id = _tune_one(shape);
+				const char* name = zq_gemm_32f_AnoTrans_Btrans_kernel_name(best_id);
+				zq_gemm_32f_AnoTrans_Btrans_set_tuned(shape.M, shape.N, shape.K, best_id);
+				{
+					std::lock_guard<std::mutex> lock(_mutex());
+					_winners()[shape] = name;
+				}
+				if (show_debug_info)
+					printf("gemm M=%d N=%d K=%d: %s\n", shape.M, shape.N, shape.K, name);
+				count++;
+			}
+			return count;
+		}
+
+	private:
+		static std::mutex& _mutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::map<Shape, std::string>& _winners()
+		{
+			static std::map<Shape, std::string> winners;
+			return winners;
+		}
+
+		static std::set<Shape>& _recorded()
+		{
+			static std::set<Shape> recorded;
+			return recorded;
+		}
+
+		static void _record(int M, int N, int K, void* arg)
+		{
+			std::lock_guard<std::mutex> lock(_mutex());
+			_recorded().insert(Shape(M, N, K));
+		}
+
+		static int _tune_one(const Shape& shape)
+		{
+			int M = shape.M, N = shape.N, K = shape.K;
+			float* A = (float*)_aligned_malloc(sizeof(float)*M*K, 64);
+			float* Bt = (float*)_aligned_malloc(sizeof(float)*N*K, 64);
+			float* C = (float*)_aligned_malloc(sizeof(float)*M*N, 64);
+			int best_id = 0;
+			if (A && Bt && C)
+			{
+				for (int i = 0; i < M*K; i++)
+					A[i] = (i % 17 - 8) * 0.125f;
+				for (int i = 0; i < N*K; i++)
+					Bt[i] = (i % 13 - 6) * 0.125f;
+				double best_time = -1;
+				for (int id = 0; id < zq_gemm_32f_AnoTrans_Btrans_kernel_count(); id++)
+				{
+					if (!zq_gemm_32f_AnoTrans_Btrans_kernel_usable(id, K, A, K, Bt, K))
+						continue;
+					/*warm up, then take the best of several runs lasting at least 2ms in total*/
+					zq_gemm_32f_AnoTrans_Btrans_by_kernel(id, M, N, K, A, K, Bt, K, C, N);
+					double min_time = -1, total_time = 0;
+					for (int iter = 0; iter < 3 || total_time < 0.002; iter++)
+					{
+						double t1 = omp_get_wtime();
+						zq_gemm_32f_AnoTrans_Btrans_by_kernel(id, M, N, K, A, K, Bt, K, C, N);
+						double t2 = omp_get_wtime();
+						total_time += t2 - t1;
+						if (min_time < 0 || t2 - t1 < min_time)
+							min_time = t2 - t1;
+					}
+					if (best_time < 0 || min_time < best_time)
+					{
+						best_time = min_time;
+						best_id = id;
+					}
+				}
+			}
+			if (A) _aligned_free(A);
+			if (Bt) _aligned_free(Bt);
+			if (C) _aligned_free(C);
+			return best_id;
+		}
+	};
+}
+
+#endif
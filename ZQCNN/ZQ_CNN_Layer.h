@@ -18,14 +18,30 @@ namespace ZQ
 		void** buffer;
 		__int64* buffer_len;
 		bool use_buffer;
+		bool use_winograd;
+		bool use_int8;
+		bool use_epilogue;
 		bool show_debug_info;
+		int num_threads;	//buffer and buffer_len have num_threads elements
 		float ignore_small_value;
 		float last_cost_time;
+		bool is_shared_copy;	//weights are owned by another layer, DONT FREE
 
-		ZQ_CNN_Layer() :show_debug_info(false),use_buffer(false),ignore_small_value(0),last_cost_time(0) {}
+		/*the following layers folded into the output of this layer by ZQ_CNN_Net, the first used_fused_op_num of them are 
+		done here if use_epilogue. the residual of the k-th ELTWISE_SUM op (a is 0 here) is bottom k+1*/
+		std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp> fused_ops;
+		int used_fused_op_num;
+
+		bool int8_filters_loaded;	//int8_filters are read from an int8 model file, the next Prepack does not quantize them again
+
+		ZQ_CNN_Layer() :show_debug_info(false),use_buffer(false),use_winograd(false),use_int8(false),use_epilogue(false),num_threads(1),ignore_small_value(0),last_cost_time(0),is_shared_copy(false),used_fused_op_num(0),
+			int8_filters_loaded(false) {}
 		virtual ~ZQ_CNN_Layer() {}
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops) = 0;
 
+		//a copy with its own params and states that shares the weights of this layer, used by ZQ_CNN_ExecContext
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const = 0;
+
 		virtual bool ReadParam(const std::string& line) = 0;
 
 		virtual bool LayerSetup(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops) = 0;
@@ -46,7 +62,72 @@ namespace ZQ
 		virtual bool LoadBinary_NCHW(const char* buffer, __int64 buffer_len, __int64& readed_length_in_bytes) = 0;
 
 		virtual __int64 GetNumOfMulAdd() const = 0;
+
+		//pad_H or pad_W is not 0, so the pixels around the bottom are read
+		virtual bool HasPadding() const { return false; }
+
+		//should be called after the weights are loaded or changed
+		virtual void Prepack() {}
 	public:
+		static ZQ_CNN_Layer* _as_shared_copy(ZQ_CNN_Layer* layer)
+		{
+			if (layer)
+				layer->is_shared_copy = true;
+			return layer;
+		}
+
+		/*return 0 if there is no epilogue to do*/
+		const std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp>* _get_epilogue(const std::vector<ZQ_CNN_Tensor4D*>* bottoms,
+			std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp>& ops) const
+		{
+			int op_num = __min(used_fused_op_num, (int)fused_ops.size());
+			if (!use_epilogue || op_num <= 0)
+				return 0;
+			ops.assign(fused_ops.begin(), fused_ops.begin() + op_num);
+			int residual_idx = 1;
+			for (int i = 0; i < ops.size(); i++)
+			{
+				if (ops[i].type == ZQ_CNN_Forward_SSEUtils::EpilogueOp::ELTWISE_SUM && ops[i].a == 0)
+				{
+					ops[i].a = residual_idx < bottoms->size() ? (*bottoms)[residual_idx] : 0;
+					residual_idx++;
+				}
+			}
+			return &ops;
+		}
+
+		/*int8_scale is one scale for all input channels or one for each channel, separated by ','*/
+		static void _read_int8_scale(const std::vector<std::string>& para, std::vector<float>& scales)
+		{
+			scales.clear();
+			if (para.size() < 2)
+				return;
+			const char* str = para[1].c_str();
+			while (*str != '\0')
+			{
+				scales.push_back(atof(str));
+				while (*str != '\0' && *str != ',')
+					str++;
+				if (*str == ',')
+					str++;
+			}
+		}
+
+		/*make scales have C elements, return false (and clear it) if it cannot*/
+		bool _check_int8_scale(std::vector<float>& scales, int C) const
+		{
+			if (scales.size() == 1)
+				scales.resize(C, scales[0]);
+			if (scales.size() != C)
+			{
+				if (scales.size() > 0)
+					std::cout << "warning: " << scales.size() << " int8_scale for " << C << " channels in Layer " << name << ", it runs in float\n";
+				scales.clear();
+				return false;
+			}
+			return true;
+		}
+
 		static std::vector<std::vector<std::string> > split_line(const std::string& line)
 		{
 			std::vector<std::string> first_splits = _split_blank(line.c_str());
@@ -149,6 +230,8 @@ namespace ZQ
 		int H, W, C;
 		bool has_H_val, has_W_val;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Input(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops) 
 		{ return true; }
 
@@ -246,11 +329,17 @@ namespace ZQ
 	public:
 		ZQ_CNN_Layer_Convolution() :filters(0), bias(0), num_output(0), kernel_H(0), kernel_W(0),
 			stride_H(1), stride_W(1), dilate_H(1), dilate_W(1), pad_H(0), pad_W(), 
-			with_bias(false), with_prelu(false), prelu_slope(0), bottom_C(0) {}
+			with_bias(false), with_prelu(false), prelu_slope(0), bottom_C(0), packed_filters(0), packed_filters_len(0),
+			winograd_filters(0), winograd_filters_len(0), winograd_tile(0), int8_filters(0), int8_filters_len(0) {}
 		~ZQ_CNN_Layer_Convolution() {
+			if (is_shared_copy)
+				return;
 			if (filters)delete filters;
 			if (bias)delete bias;
 			if (prelu_slope) delete prelu_slope;
+			if (packed_filters) _aligned_free(packed_filters);
+			if (winograd_filters) _aligned_free(winograd_filters);
+			if (int8_filters) _aligned_free(int8_filters);
 		}
 		ZQ_CNN_Tensor4D* filters;
 		ZQ_CNN_Tensor4D* bias;
@@ -272,12 +361,51 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		//filters packed for the gemm path, only made if the filters have padded channels
+		void* packed_filters;
+		__int64 packed_filters_len;
+
+		//transformed filters for winograd F(winograd_tile x winograd_tile, 3x3), only made for 3x3 stride 1 layers
+		void* winograd_filters;
+		__int64 winograd_filters_len;
+		int winograd_tile;
+
+		//scales of the input channels given by int8 calibration (empty to run in float), int8_filters are quantized with them
+		std::vector<float> int8_scale;
+		void* int8_filters;
+		__int64 int8_filters_len;
+
 	public:
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Convolution(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
+			std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp> ops;
+			const std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp>* epilogue = _get_epilogue(bottoms, ops);
+			if (use_int8 && int8_filters && int8_scale.size() == filters->GetC())
+			{
+				if (filters == 0 || (with_bias && bias == 0) || (with_prelu && prelu_slope == 0))
+					return false;
+				double t1 = omp_get_wtime();
+				void** tmp_buffer = use_buffer ? buffer : 0;
+				__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+				bool ret = ZQ_CNN_Forward_SSEUtils::ConvolutionInt8(*((*bottoms)[0]), *filters, with_bias ? bias : 0, with_prelu ? prelu_slope : 0,
+					&int8_scale[0], int8_filters, stride_H, stride_W, dilate_H, dilate_W, pad_H, pad_W, *((*tops)[0]),
+					tmp_buffer, tmp_buffer_len, num_threads);
+				if (ret && epilogue)
+					ret = ZQ_CNN_Forward_SSEUtils::ApplyEpilogue(*((*tops)[0]), *epilogue);
+				double t2 = omp_get_wtime();
+				last_cost_time = t2 - t1;
+				if (show_debug_info)
+				{
+					printf("Conv layer:%s int8 %.3f ms NHW %dx%dx%d filter: NHWC %d x %d x %d x %d\n",
+						name.c_str(), 1000 * (t2 - t1), (*tops)[0]->GetN(), (*tops)[0]->GetH(), (*tops)[0]->GetW(), filters->GetN(), filters->GetH(), filters->GetW(), filters->GetC());
+				}
+				return ret;
+			}
 			if (with_bias)
 			{
 				if (with_prelu)
@@ -287,9 +415,11 @@ namespace ZQ
 					double t1 = omp_get_wtime();
 					void** tmp_buffer = use_buffer ? buffer : 0;
 					__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+					const float* tmp_winograd_filters = use_winograd ? (const float*)winograd_filters : 0;
 					bool ret = ZQ_CNN_Forward_SSEUtils::ConvolutionWithBiasPReLU(*((*bottoms)[0]),
 						*filters, *bias, *prelu_slope, stride_H, stride_W, dilate_H, dilate_W, pad_H, pad_W, *((*tops)[0]),
-						tmp_buffer, tmp_buffer_len);
+						tmp_buffer, tmp_buffer_len, num_threads, (const float*)packed_filters,
+						tmp_winograd_filters, winograd_tile, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -310,9 +440,11 @@ namespace ZQ
 					double t1 = omp_get_wtime();
 					void** tmp_buffer = use_buffer ? buffer : 0;
 					__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+					const float* tmp_winograd_filters = use_winograd ? (const float*)winograd_filters : 0;
 					bool ret = ZQ_CNN_Forward_SSEUtils::ConvolutionWithBias(*((*bottoms)[0]),
 						*filters, *bias, stride_H, stride_W, dilate_H, dilate_W, pad_H, pad_W, *((*tops)[0]),
-						tmp_buffer, tmp_buffer_len);
+						tmp_buffer, tmp_buffer_len, num_threads, (const float*)packed_filters,
+						tmp_winograd_filters, winograd_tile, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -336,8 +468,10 @@ namespace ZQ
 					double t1 = omp_get_wtime();
 					void** tmp_buffer = use_buffer ? buffer : 0;
 					__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+					const float* tmp_winograd_filters = use_winograd ? (const float*)winograd_filters : 0;
 					bool ret = ZQ_CNN_Forward_SSEUtils::ConvolutionWithPReLU(*((*bottoms)[0]), *filters, *prelu_slope, stride_H, stride_W, dilate_H, dilate_W, pad_H, pad_W, *((*tops)[0]),
-						tmp_buffer, tmp_buffer_len);
+						tmp_buffer, tmp_buffer_len, num_threads, (const float*)packed_filters,
+						tmp_winograd_filters, winograd_tile, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -358,8 +492,10 @@ namespace ZQ
 					double t1 = omp_get_wtime();
 					void** tmp_buffer = use_buffer ? buffer : 0;
 					__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+					const float* tmp_winograd_filters = use_winograd ? (const float*)winograd_filters : 0;
 					bool ret = ZQ_CNN_Forward_SSEUtils::Convolution(*((*bottoms)[0]), *filters, stride_H, stride_W, dilate_H, dilate_W, pad_H, pad_W, *((*tops)[0]),
-						tmp_buffer, tmp_buffer_len);
+						tmp_buffer, tmp_buffer_len, num_threads, (const float*)packed_filters,
+						tmp_winograd_filters, winograd_tile, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -523,6 +659,10 @@ namespace ZQ
 						name = paras[n][1];
 					}
 				}
+				else if (_my_strcmpi("int8_scale", paras[n][0].c_str()) == 0)
+				{
+					_read_int8_scale(paras[n], int8_scale);
+				}
 				else
 				{
 					std::cout << "warning: unknown para " << paras[n][0] << " in Layer " << name << "\n";
@@ -751,6 +891,27 @@ namespace ZQ
 				total_num += (__int64)top_H*top_W*top_C*3;
 			return total_num;
 		}
+
+		virtual bool HasPadding() const { return pad_H != 0 || pad_W != 0; }
+
+		virtual void Prepack()
+		{
+			if (filters == 0)
+				return;
+			if (filters->GetPixelStep() != filters->GetC())
+				ZQ_CNN_Forward_SSEUtils::ConvolutionPrePack(*filters, packed_filters, packed_filters_len);
+
+			/*winograd does not pay off for few channels, and layers with many channels usually have small feature maps,
+			which suit F(2x2,3x3) better than F(4x4,3x3)*/
+			if (kernel_H == 3 && kernel_W == 3 && stride_H == 1 && stride_W == 1 && dilate_H == 1 && dilate_W == 1
+				&& filters->GetC() >= 32 && filters->GetN() >= 32)
+			{
+				winograd_tile = filters->GetC() >= 256 ? 2 : 4;
+				ZQ_CNN_Forward_SSEUtils::ConvolutionWinogradPrePack(*filters, winograd_tile, winograd_filters, winograd_filters_len);
+			}
+			if (!int8_filters_loaded && _check_int8_scale(int8_scale, filters->GetC()))
+				ZQ_CNN_Forward_SSEUtils::ConvolutionInt8PrePack(*filters, &int8_scale[0], int8_filters, int8_filters_len);
+		}
 	};
 
 
@@ -759,11 +920,14 @@ namespace ZQ
 	public:
 		ZQ_CNN_Layer_DepthwiseConvolution() :filters(0), bias(0), num_output(0), kernel_H(0), kernel_W(0),
 			stride_H(1), stride_W(1),dilate_H(1),dilate_W(1), pad_H(0), pad_W(), with_bias(false), bottom_C(0), 
-			with_prelu(false), prelu_slope(0) {}
+			with_prelu(false), prelu_slope(0), int8_filters(0), int8_filters_len(0) {}
 		~ZQ_CNN_Layer_DepthwiseConvolution() {
+			if (is_shared_copy)
+				return;
 			if (filters)delete filters;
 			if (bias)delete bias;
 			if (prelu_slope)delete prelu_slope;
+			if (int8_filters) _aligned_free(int8_filters);
 		}
 		ZQ_CNN_Tensor4D* filters;
 		ZQ_CNN_Tensor4D* bias;
@@ -785,12 +949,41 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		//scales of the input channels given by int8 calibration (empty to run in float), int8_filters are quantized with them
+		std::vector<float> int8_scale;
+		void* int8_filters;
+		__int64 int8_filters_len;
+
 	public:
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_DepthwiseConvolution(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
+			std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp> ops;
+			const std::vector<ZQ_CNN_Forward_SSEUtils::EpilogueOp>* epilogue = _get_epilogue(bottoms, ops);
+			if (use_int8 && int8_filters && int8_scale.size() == filters->GetC())
+			{
+				if (filters == 0 || (with_bias && bias == 0) || (with_prelu && prelu_slope == 0))
+					return false;
+				double t1 = omp_get_wtime();
+				void** tmp_buffer = use_buffer ? buffer : 0;
+				__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+				bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionInt8(*((*bottoms)[0]), *filters, with_bias ? bias : 0, with_prelu ? prelu_slope : 0,
+					&int8_scale[0], int8_filters, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]), tmp_buffer, tmp_buffer_len, num_threads);
+				if (ret && epilogue)
+					ret = ZQ_CNN_Forward_SSEUtils::ApplyEpilogue(*((*tops)[0]), *epilogue);
+				double t2 = omp_get_wtime();
+				last_cost_time = t2 - t1;
+				if (show_debug_info)
+				{
+					printf("DwConv layer:%s int8 %.3f ms NHW %dx%dx%d filter: NHWC %d x %d x %d x %d\n",
+						name.c_str(), 1000 * (t2 - t1), (*tops)[0]->GetN(), (*tops)[0]->GetH(), (*tops)[0]->GetW(), filters->GetN(), filters->GetH(), filters->GetW(), filters->GetC());
+				}
+				return ret;
+			}
 			if (with_bias)
 			{
 				if (with_prelu)
@@ -798,7 +991,7 @@ namespace ZQ
 					if (filters == 0 || bias == 0 || prelu_slope == 0)
 						return false;
 					double t1 = omp_get_wtime();
-					bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionWithBiasPReLU(*((*bottoms)[0]), *filters, *bias, *prelu_slope, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]));
+					bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionWithBiasPReLU(*((*bottoms)[0]), *filters, *bias, *prelu_slope, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]), num_threads, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -819,7 +1012,7 @@ namespace ZQ
 					if (filters == 0 || bias == 0)
 						return false;
 					double t1 = omp_get_wtime();
-					bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionWithBias(*((*bottoms)[0]), *filters, *bias, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]));
+					bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionWithBias(*((*bottoms)[0]), *filters, *bias, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]), num_threads, epilogue);
 					double t2 = omp_get_wtime();
 					last_cost_time = t2 - t1;
 					if (show_debug_info)
@@ -841,7 +1034,7 @@ namespace ZQ
 				if (filters == 0)
 					return false;
 				double t1 = omp_get_wtime();
-				bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolution(*((*bottoms)[0]), *filters, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]));
+				bool ret = ZQ_CNN_Forward_SSEUtils::DepthwiseConvolution(*((*bottoms)[0]), *filters, stride_H, stride_W, pad_H, pad_W, *((*tops)[0]), num_threads, epilogue);
 				double t2 = omp_get_wtime();
 				last_cost_time = t2 - t1;
 				if (show_debug_info)
@@ -1004,6 +1197,10 @@ namespace ZQ
 						name = paras[n][1];
 					}
 				}
+				else if (_my_strcmpi("int8_scale", paras[n][0].c_str()) == 0)
+				{
+					_read_int8_scale(paras[n], int8_scale);
+				}
 				else
 				{
 					std::cout << "warning: unknown para " << paras[n][0] << " in Layer " << name << "\n";
@@ -1208,6 +1405,14 @@ namespace ZQ
 				total_num += (__int64)top_H*top_W*top_C * 3;
 			return total_num;
 		}
+
+		virtual bool HasPadding() const { return pad_H != 0 || pad_W != 0; }
+
+		virtual void Prepack()
+		{
+			if (filters && !int8_filters_loaded && _check_int8_scale(int8_scale, filters->GetC()))
+				ZQ_CNN_Forward_SSEUtils::DepthwiseConvolutionInt8PrePack(*filters, &int8_scale[0], int8_filters, int8_filters_len);
+		}
 	};
 
 	class ZQ_CNN_Layer_BatchNormScale : public ZQ_CNN_Layer
@@ -1221,6 +1426,8 @@ namespace ZQ
 		ZQ_CNN_Layer_BatchNormScale() : mean(0), var(0), scale(0), bias(0), 
 			b(0), a(0), eps(0), with_bias(false), bottom_C(0) {}
 		~ZQ_CNN_Layer_BatchNormScale() {
+			if (is_shared_copy)
+				return;
 			if (mean) delete mean;
 			if (var) delete var;
 			if (scale) delete scale;
@@ -1243,6 +1450,8 @@ namespace ZQ
 		int bottom_W;
 
 	public:
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_BatchNormScale(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -1579,6 +1788,8 @@ namespace ZQ
 	public:
 		ZQ_CNN_Layer_BatchNorm() : mean(0), var(0), b(0), a(0),eps(0), bottom_C(0) {}
 		~ZQ_CNN_Layer_BatchNorm() {
+			if (is_shared_copy)
+				return;
 			if (mean) delete mean;
 			if (var) delete var;
 			if (b)delete b;
@@ -1597,6 +1808,8 @@ namespace ZQ
 		int bottom_W;
 
 	public:
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_BatchNorm(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -1835,6 +2048,8 @@ namespace ZQ
 	public:
 		ZQ_CNN_Layer_Scale() :scale(0), bias(0), with_bias(false), bottom_C(0) {}
 		~ZQ_CNN_Layer_Scale() {
+			if (is_shared_copy)
+				return;
 			if (scale)	delete scale;
 			if (bias)	delete bias;
 		}
@@ -1848,6 +2063,8 @@ namespace ZQ
 		int bottom_W;
 
 	public:
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Scale(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -2131,8 +2348,12 @@ namespace ZQ
 		ZQ_CNN_Layer_PReLU() :slope(0), bottom_C(0) {}
 		~ZQ_CNN_Layer_PReLU() 
 		{
+			if (is_shared_copy)
+				return;
 			if (slope) delete slope;
 		}
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_PReLU(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -2330,6 +2551,8 @@ namespace ZQ
 		ZQ_CNN_Layer_ReLU() :slope(0),bottom_C(0) {}
 		~ZQ_CNN_Layer_ReLU(){}
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_ReLU(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -2478,6 +2701,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Pooling(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -2702,17 +2927,42 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
-		ZQ_CNN_Layer_InnerProduct() :filters(0), bias(0), with_bias(false) {}
+		//scales of the input channels given by int8 calibration (empty to run in float), int8_filters are quantized with them
+		std::vector<float> int8_scale;
+		void* int8_filters;
+		__int64 int8_filters_len;
+
+		ZQ_CNN_Layer_InnerProduct() :filters(0), bias(0), with_bias(false), int8_filters(0), int8_filters_len(0) {}
 		~ZQ_CNN_Layer_InnerProduct()
 		{
+			if (is_shared_copy)
+				return;
 			if (filters) delete filters;
 			if (bias) delete bias;
+			if (int8_filters) _aligned_free(int8_filters);
 		}
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_InnerProduct(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
 
+			if (use_int8 && int8_filters && int8_scale.size() == filters->GetC())
+			{
+				if (filters == 0 || (with_bias && bias == 0))
+					return false;
+				double t1 = omp_get_wtime();
+				void** tmp_buffer = use_buffer ? buffer : 0;
+				__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
+				bool ret = ZQ_CNN_Forward_SSEUtils::InnerProductInt8(*((*bottoms)[0]), *filters, with_bias ? bias : 0,
+					&int8_scale[0], int8_filters, *((*tops)[0]), tmp_buffer, tmp_buffer_len, num_threads);
+				double t2 = omp_get_wtime();
+				last_cost_time = t2 - t1;
+				if (show_debug_info)
+					printf("Innerproduct layer: %s int8 cost : %.3f ms\n", name.c_str(), 1000 * (t2 - t1));
+				return ret;
+			}
 
 			if (with_bias)
 			{
@@ -2722,7 +2972,7 @@ namespace ZQ
 				void** tmp_buffer = use_buffer ? buffer : 0;
 				__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
 				bool ret = ZQ_CNN_Forward_SSEUtils::InnerProductWithBias(*((*bottoms)[0]), 
-					*filters, *bias, *((*tops)[0]), tmp_buffer, tmp_buffer_len);
+					*filters, *bias, *((*tops)[0]), tmp_buffer, tmp_buffer_len, num_threads);
 				double t2 = omp_get_wtime();
 				last_cost_time = t2 - t1;
 				if (show_debug_info)
@@ -2739,7 +2989,7 @@ namespace ZQ
 				void** tmp_buffer = use_buffer ? buffer : 0;
 				__int64* tmp_buffer_len = use_buffer ? buffer_len : 0;
 				bool ret = ZQ_CNN_Forward_SSEUtils::InnerProduct(*((*bottoms)[0]), *filters, *((*tops)[0]),
-					tmp_buffer,tmp_buffer_len);
+					tmp_buffer, tmp_buffer_len, num_threads);
 				double t2 = omp_get_wtime();
 				last_cost_time = t2 - t1;
 				if (show_debug_info)
@@ -2830,6 +3080,10 @@ namespace ZQ
 						name = paras[n][1];
 					}
 				}
+				else if (_my_strcmpi("int8_scale", paras[n][0].c_str()) == 0)
+				{
+					_read_int8_scale(paras[n], int8_scale);
+				}
 				else
 				{
 					std::cout << "warning: unknown para " << paras[n][0] << " in Layer " << name << "\n";
@@ -2871,7 +3125,7 @@ namespace ZQ
 			kernel_W = bottom_W;
 			if (filters)
 			{
-				if (filters->ChangeSize(num_output, kernel_H, kernel_W, bottom_C, 0, 0))
+				if (!filters->ChangeSize(num_output, kernel_H, kernel_W, bottom_C, 0, 0))
 					return false;
 			}
 			else
@@ -2885,7 +3139,7 @@ namespace ZQ
 			{
 				if (bias)
 				{
-					if (bias->ChangeSize(1, 1, 1, num_output, 0, 0))
+					if (!bias->ChangeSize(1, 1, 1, num_output, 0, 0))
 						return false;
 				}
 				else
@@ -3057,6 +3311,11 @@ namespace ZQ
 			return (__int64)top_H*top_W*filters->GetN()*filters->GetH()*filters->GetW()*filters->GetC();
 		}
 
+		virtual void Prepack()
+		{
+			if (filters && !int8_filters_loaded && _check_int8_scale(int8_scale, filters->GetC()))
+				ZQ_CNN_Forward_SSEUtils::ConvolutionInt8PrePack(*filters, &int8_scale[0], int8_filters, int8_filters_len);
+		}
 	};
 
 	class ZQ_CNN_Layer_Softmax : public ZQ_CNN_Layer
@@ -3070,6 +3329,8 @@ namespace ZQ
 
 		ZQ_CNN_Layer_Softmax() { axis = 1; }
 		~ZQ_CNN_Layer_Softmax() {}
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Softmax(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -3209,6 +3470,8 @@ namespace ZQ
 
 		ZQ_CNN_Layer_Dropout():dropout_ratio(1.0f) {}
 		~ZQ_CNN_Layer_Dropout(){}
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Dropout(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -3348,6 +3611,8 @@ namespace ZQ
 
 		ZQ_CNN_Layer_Copy() {}
 		~ZQ_CNN_Layer_Copy() {}
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Copy(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -3483,6 +3748,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Eltwise(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -3688,6 +3955,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_ScalarOperation(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -3956,6 +4225,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_UnaryOperation(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() != 2 || tops->size() == 0 
@@ -4212,6 +4483,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_LRN(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -4389,6 +4662,8 @@ namespace ZQ
 	public:
 		ZQ_CNN_Layer_Normalize():across_spatial(false),channel_shared(false), eps(1e-10),scale(0){}
 		~ZQ_CNN_Layer_Normalize(){
+			if (is_shared_copy)
+				return;
 			if (scale) delete scale;
 		}
 
@@ -4401,6 +4676,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Normalize(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -4590,13 +4867,15 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Permute(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
 
 			double t1 = omp_get_wtime();
-			bool ret = ZQ_CNN_Forward_SSEUtils::Permute(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], order, *((*tops)[0]));
+			bool ret = ZQ_CNN_Forward_SSEUtils::Permute(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], order, *((*tops)[0]), num_threads);
 			int C = (*bottoms)[0]->GetC();
 			double t2 = omp_get_wtime();
 			last_cost_time = t2 - t1;
@@ -4757,13 +5036,15 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Flatten(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
 
 			double t1 = omp_get_wtime();
-			bool ret = ZQ_CNN_Forward_SSEUtils::Flatten(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], axis, end_axis, *((*tops)[0]));
+			bool ret = ZQ_CNN_Forward_SSEUtils::Flatten(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], axis, end_axis, *((*tops)[0]), num_threads);
 			double t2 = omp_get_wtime();
 			last_cost_time = t2 - t1;
 			if (show_debug_info)
@@ -4924,13 +5205,15 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Reshape(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
 				return false;
 
 			double t1 = omp_get_wtime();
-			bool ret = ZQ_CNN_Forward_SSEUtils::Reshape(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], shape, *((*tops)[0]));
+			bool ret = ZQ_CNN_Forward_SSEUtils::Reshape(*(*(std::vector<const ZQ_CNN_Tensor4D*>*)bottoms)[0], shape, *((*tops)[0]), num_threads);
 			const float* ptr = (*bottoms)[0]->GetFirstPixelPtr();
 			double t2 = omp_get_wtime();
 			last_cost_time = t2 - t1;
@@ -5138,6 +5421,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_PriorBox(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -5470,6 +5755,8 @@ namespace ZQ
 		~ZQ_CNN_Layer_PriorBoxText() {}
 
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_PriorBoxText(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -5610,6 +5897,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_PriorBox_MXNET(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -5842,6 +6131,8 @@ namespace ZQ
 
 		int axis;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Concat(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -5994,6 +6285,8 @@ namespace ZQ
 		int num_loc_classes;
 
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_DetectionOutput(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() < 3 || tops->size() == 0 
@@ -6223,6 +6516,8 @@ namespace ZQ
 		int num_loc_classes;
 
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_DetectionOutput_MXNET(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() < 3 || tops->size() == 0
@@ -6393,6 +6688,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Reduction(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -6606,6 +6903,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Sqrt(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -6746,6 +7045,8 @@ namespace ZQ
 		int bottom_H;
 		int bottom_W;
 
+		virtual ZQ_CNN_Layer* CloneSharedWeights() const { return _as_shared_copy(new ZQ_CNN_Layer_Tile(*this)); }
+
 		virtual bool Forward(std::vector<ZQ_CNN_Tensor4D*>* bottoms, std::vector<ZQ_CNN_Tensor4D*>* tops)
 		{
 			if (bottoms == 0 || tops == 0 || bottoms->size() == 0 || tops->size() == 0 || (*bottoms)[0] == 0 || (*tops)[0] == 0)
@@ -1,8 +1,12 @@
 #ifndef _ZQ_CNN_MTCNN_H_
 #define _ZQ_CNN_MTCNN_H_
 #pragma once
-#include "ZQ_CNN_Net.h"
+#include "ZQ_CNN_Model.h"
 #include "ZQ_CNN_BBoxUtils.h"
+#include "ZQ_CNN_ThreadPool.h"
+#include "ZQ_CNN_BGRPyramid.h"
+#include <atomic>
+#include <thread>
 #include <omp.h>
 namespace ZQ
 {
@@ -27,6 +31,18 @@ namespace ZQ
 			pnet_stride = 2;
 			special_handle_very_big_face = false;
 			force_run_pnet_multithread = false;
+			use_pnet_mosaic = false;
+			pnet_mosaic_max_area = 160 * 160;
+			use_cascaded_pyramid = false;
+			use_fused_crop = false;
+			frame_img = 0;
+			frame_widthStep = 0;
+			video_keyframe_interval = 10;
+			video_motion_margin = 0.25f;
+			video_min_track_ratio = 0.8f;
+			video_frame_count = 0;
+			video_keyframe_face_num = 0;
+			use_batch_overlap = false;
 			show_debug_info = false;
 			limit_r_num = 0;
 			limit_o_num = 0;
@@ -43,7 +59,8 @@ namespace ZQ
 #else
 		const int BATCH_SIZE = 64;
 #endif
-		std::vector<ZQ_CNN_Net> pnet, rnet, onet, lnet;
+		ZQ_CNN_Model pnet_model, rnet_model, onet_model, lnet_model;
+		std::vector<ZQ_CNN_ExecContext> pnet, rnet, onet, lnet;
 		bool has_lnet;
 		int thread_num;
 		float thresh[3], nms_thresh[3];
@@ -63,6 +80,25 @@ namespace ZQ
 		bool force_run_pnet_multithread;
 		std::vector<float> scales;
 		std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> pnet_images;
+		bool use_pnet_mosaic;
+		int pnet_mosaic_max_area;
+		ZQ_CNN_Tensor4D_NHW_C_Align128bit pnet_mosaic;
+		std::vector<int> mosaic_off_x, mosaic_off_y;	//where each scale is in pnet_mosaic
+		int mosaic_W, mosaic_H;
+		int mosaic_first;	//the scales before it are larger than pnet_mosaic_max_area and run alone
+		bool use_cascaded_pyramid;
+		ZQ_CNN_BGRPyramid bgr_pyramid;
+		bool use_fused_crop;
+		const unsigned char* frame_img;	//the BGR image being found, for the fused crops
+		int frame_widthStep;
+		int video_keyframe_interval;
+		float video_motion_margin;
+		float video_min_track_ratio;
+		int video_frame_count;	//frames since the last keyframe, 0 if the next one is a keyframe
+		int video_keyframe_face_num;
+		std::vector<ZQ_CNN_BBox> video_tracks;
+		std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> batch_inputs;	//the inputs of two groups of FindBatch
+		bool use_batch_overlap;
 		ZQ_CNN_Tensor4D_NHW_C_Align128bit input, rnet_image, onet_image;
 		bool show_debug_info;
 		int limit_r_num;
@@ -71,6 +107,26 @@ namespace ZQ
 	public:
 		void TurnOnShowDebugInfo() { show_debug_info = true; }
 		void TurnOffShowDebugInfo() { show_debug_info = false; }
+		/*put the scales of Pnet not larger than max_scale_area pixels in one image and run one Forward for them instead of
+		one for each scale, the larger scales are run alone (one scale in a large image is faster). The scores are the same
+		as long as Pnet has no padding, SetPara turns it off if Pnet has padding or its cells do not match pnet_size and
+		pnet_stride. It is used instead of both the single and the multi thread Pnet, call it before SetPara*/
+		void TurnOnPnetMosaic(int max_scale_area = 160 * 160) { use_pnet_mosaic = true; pnet_mosaic_max_area = max_scale_area; }
+		void TurnOffPnetMosaic() { use_pnet_mosaic = false; }
+		/*make each scale of Pnet from the scale before it (instead of the whole image) with the fixed-point resizing of
+		ZQ_CNN_BGRPyramid, the multi thread Pnet runs on the built scales while the next ones are built. The scores differ
+		a little from the default resizing*/
+		void TurnOnCascadedPyramid() { use_cascaded_pyramid = true; }
+		void TurnOffCascadedPyramid() { use_cascaded_pyramid = false; }
+		/*FindBatch runs Pnet of a group at the same time as Rnet, Onet (and Lnet) of the group before, on two of the
+		threads, instead of one after the other*/
+		void TurnOnBatchOverlap() { use_batch_overlap = true; }
+		void TurnOffBatchOverlap() { use_batch_overlap = false; }
+		/*make the batches of Rnet, Onet and Lnet from the BGR image with ZQ_CNN_Tensor4D::ResizeBilinearRectFromBGR, which
+		resizes and normalizes each face into its slice in one pass. With the cascaded pyramid and no Pnet scale of 1, the
+		float copy of the whole image is not made either (except in FindBatch). The results are the same up to rounding*/
+		void TurnOnFusedCrop() { use_fused_crop = true; }
+		void TurnOffFusedCrop() { use_fused_crop = false; }
 		void SetLimit(int limit_r = 0, int limit_o = 0, int limit_l = 0) 
 		{
 			limit_r_num = limit_r;
@@ -78,118 +134,31 @@ namespace ZQ
 			limit_l_num = limit_l;
 		}
 
-		bool Init(const string& pnet_param, const string& pnet_model, const string& rnet_param, const string& rnet_model,
-			const string& onet_param, const string& onet_model, int thread_num = 1, 
-			bool has_lnet = false, const string& lnet_param = "", const std::string& lnet_model = "")
+		bool Init(const string& pnet_param, const string& pnet_model_file, const string& rnet_param, const string& rnet_model_file,
+			const string& onet_param, const string& onet_model_file, int thread_num = 1, 
+			bool has_lnet = false, const string& lnet_param = "", const std::string& lnet_model_file = "")
 		{
-			if (thread_num < 1)
-				force_run_pnet_multithread = true;
-			else
-				force_run_pnet_multithread = false;
-			thread_num = __max(1, thread_num);
-			pnet.resize(thread_num);
-			rnet.resize(thread_num);
-			onet.resize(thread_num);
-			this->has_lnet = has_lnet;
-			if (has_lnet)
-			{
-				lnet.resize(thread_num);
-			}
-			bool ret = true;
-			for (int i = 0; i < thread_num; i++)
-			{
-				ret = pnet[i].LoadFrom(pnet_param, pnet_model,true,1e-9, true) 
-					&& rnet[i].LoadFrom(rnet_param, rnet_model, true, 1e-9, true)
-					&& onet[i].LoadFrom(onet_param, onet_model, true, 1e-9, true);
-				if (has_lnet && ret)
-					ret = lnet[i].LoadFrom(lnet_param, lnet_model, true, 1e-9, true);
-				if (!ret)
-					break;
-			}
-			if (!ret)
-			{
-				pnet.clear();
-				rnet.clear();
-				onet.clear();
-				if (has_lnet)
-					lnet.clear();
-				this->thread_num = 0;
-			}
-			else
-				this->thread_num = thread_num;
-			if (show_debug_info)
-			{
-				printf("rnet = %.1f M, onet = %.1f M\n", rnet[0].GetNumOfMulAdd() / (1024.0*1024.0),
-					onet[0].GetNumOfMulAdd() / (1024.0*1024.0));
-				if (has_lnet)
-					printf("lnet = %.1f M\n", lnet[0].GetNumOfMulAdd() / (1024.0*1024.0));
-			}
-			int C, H, W;
-			rnet[0].GetInputDim(C, H, W);
-			rnet_size = H;
-			onet[0].GetInputDim(C, H, W);
-			onet_size = H;
-			if (has_lnet)
-			{
-				lnet[0].GetInputDim(C, H, W);
-				lnet_size = H;
-			}
-			return ret;
+			bool ret = pnet_model.LoadFrom(pnet_param, pnet_model_file, true, 1e-9, true)
+				&& rnet_model.LoadFrom(rnet_param, rnet_model_file, true, 1e-9, true)
+				&& onet_model.LoadFrom(onet_param, onet_model_file, true, 1e-9, true);
+			if (has_lnet && ret)
+				ret = lnet_model.LoadFrom(lnet_param, lnet_model_file, true, 1e-9, true);
+			return _init_nets(ret, thread_num, has_lnet);
 		}
 
 		bool InitFromBuffer(
-			const char* pnet_param, __int64 pnet_param_len, const char* pnet_model, __int64 pnet_model_len,
-			const char* rnet_param, __int64 rnet_param_len, const char* rnet_model, __int64 rnet_model_len,
-			const char* onet_param, __int64 onet_param_len, const char* onet_model, __int64 onet_model_len,
+			const char* pnet_param, __int64 pnet_param_len, const char* pnet_model_buf, __int64 pnet_model_len,
+			const char* rnet_param, __int64 rnet_param_len, const char* rnet_model_buf, __int64 rnet_model_len,
+			const char* onet_param, __int64 onet_param_len, const char* onet_model_buf, __int64 onet_model_len,
 			int thread_num = 1, bool has_lnet = false, 
-			const char* lnet_param = 0, __int64 lnet_param_len = 0, const char* lnet_model = 0, __int64 lnet_model_len = 0)
+			const char* lnet_param = 0, __int64 lnet_param_len = 0, const char* lnet_model_buf = 0, __int64 lnet_model_len = 0)
 		{
-			if (thread_num < 1)
-				force_run_pnet_multithread = true;
-			else
-				force_run_pnet_multithread = false;
-			thread_num = __max(1, thread_num);
-			pnet.resize(thread_num);
-			rnet.resize(thread_num);
-			onet.resize(thread_num);
-			this->has_lnet = has_lnet;
-			if(has_lnet)
-				lnet.resize(thread_num);
-			bool ret = true;
-			for (int i = 0; i < thread_num; i++)
-			{
-				ret = pnet[i].LoadFromBuffer(pnet_param, pnet_param_len,pnet_model,pnet_model_len, true, 1e-9, true)
-					&& rnet[i].LoadFromBuffer(rnet_param, rnet_param_len, rnet_model, rnet_model_len, true, 1e-9, true)
-					&& onet[i].LoadFromBuffer(onet_param, onet_param_len, onet_model, onet_model_len, true, 1e-9, true);
-				if (has_lnet && ret)
-					ret = lnet[i].LoadFromBuffer(lnet_param, lnet_param_len, lnet_model, lnet_model_len, true, 1e-9, true);
-				if (!ret)
-					break;
-			}
-			if (!ret)
-			{
-				pnet.clear();
-				rnet.clear();
-				onet.clear();
-				if (has_lnet)
-					lnet.clear();
-				this->thread_num = 0;
-			}
-			else
-				this->thread_num = thread_num;
-			if (show_debug_info)
-			{
-				printf("rnet = %.1f M, onet = %.1f M\n", rnet[0].GetNumOfMulAdd() / (1024.0*1024.0),
-					onet[0].GetNumOfMulAdd() / (1024.0*1024.0));
-				if (has_lnet)
-					printf("lnet = %.1f M\n", lnet[0].GetNumOfMulAdd() / (1024.0*1024.0));
-			}
-			int C, H, W;
-			rnet[0].GetInputDim(C, H, W);
-			rnet_size = H;
-			onet[0].GetInputDim(C, H, W);
-			onet_size = H;
-			return ret;
+			bool ret = pnet_model.LoadFromBuffer(pnet_param, pnet_param_len, pnet_model_buf, pnet_model_len, true, 1e-9, true)
+				&& rnet_model.LoadFromBuffer(rnet_param, rnet_param_len, rnet_model_buf, rnet_model_len, true, 1e-9, true)
+				&& onet_model.LoadFromBuffer(onet_param, onet_param_len, onet_model_buf, onet_model_len, true, 1e-9, true);
+			if (has_lnet && ret)
+				ret = lnet_model.LoadFromBuffer(lnet_param, lnet_param_len, lnet_model_buf, lnet_model_len, true, 1e-9, true);
+			return _init_nets(ret, thread_num, has_lnet);
 		}
 
 		void SetPara(int w, int h, int min_face_size = 60, float pthresh = 0.6, float rthresh = 0.7, float othresh = 0.7,
@@ -211,6 +180,12 @@ namespace ZQ
 				nms_thresh_per_scale = 0.45;
 			else
 				nms_thresh_per_scale = 0.495;
+			if (use_pnet_mosaic && !_check_pnet_mosaic())
+			{
+				printf("Pnet has padding or does not match pnet_size %d and pnet_stride %d, the Pnet mosaic is turned off\n",
+					pnet_size, pnet_stride);
+				use_pnet_mosaic = false;
+			}
 			if (width != w || height != h || factor != scale_factor)
 			{
 				scales.clear();
@@ -263,72 +238,180 @@ namespace ZQ
 
 				pnet_images.resize(count);
 			}
+			std::vector<int> level_W, level_H;
+			for (int i = 0; i < scales.size(); i++)
+			{
+				level_W.push_back((int)ceil(width*scales[i]));
+				level_H.push_back((int)ceil(height*scales[i]));
+			}
+			bgr_pyramid.SetLevelSizes(level_W, level_H);
+			_layout_pnet_mosaic();
 		}
 
 		bool Find(const unsigned char* bgr_img, int _width, int _height, int _widthStep, std::vector<ZQ_CNN_BBox>& results)
 		{
 			double t1 = omp_get_wtime();
-			std::vector<ZQ_CNN_BBox> firstBbox, secondBbox, thirdBbox;
+			std::vector<ZQ_CNN_BBox> firstBbox;
 			if (!_Pnet_stage(bgr_img, _width, _height, _widthStep, firstBbox))
 				return false;
-			//results = firstBbox;
-			//return true;
-			if (limit_r_num > 0)
-			{
-				_select(firstBbox, limit_r_num, _width, _height);
-			}
+			return _find_from_first_bbox(firstBbox, _width, _height, results, t1);
+		}
 
-			double t2 = omp_get_wtime();
-			if (!_Rnet_stage(firstBbox, secondBbox))
-				return false;
-			//results = secondBbox;
-			//return true;
+		/*the frames are given in order (call ResetVideo for a new stream), a keyframe runs Find and gives the same results,
+		the other frames run only Rnet, Onet (and Lnet) on the faces of the frame before, each enlarged by motion_margin of
+		its size on each side. A keyframe is every keyframe_interval frames, or after a frame keeping fewer than
+		min_track_ratio of the faces of the last keyframe. The faces coming in between are found at the next keyframe*/
+		void SetVideoPara(int keyframe_interval = 10, float motion_margin = 0.25f, float min_track_ratio = 0.8f)
+		{
+			video_keyframe_interval = __max(1, keyframe_interval);
+			video_motion_margin = __max(0.0f, motion_margin);
+			video_min_track_ratio = min_track_ratio;
+			ResetVideo();
+		}
 
-			if (limit_o_num > 0)
-			{
-				_select(secondBbox, limit_o_num, _width, _height);
-			}
+		void ResetVideo()
+		{
+			video_frame_count = 0;
+			video_tracks.clear();
+		}
 
-			if (!has_lnet || !do_landmark)
+		bool FindVideo(const unsigned char* bgr_img, int _width, int _height, int _widthStep, std::vector<ZQ_CNN_BBox>& results)
+		{
+			bool ret, lost = false;
+			if (video_frame_count == 0)
 			{
-				double t3 = omp_get_wtime();
-				if (!_Onet_stage(secondBbox, results))
-					return false;
-
-				double t4 = omp_get_wtime();
+				ret = Find(bgr_img, _width, _height, _widthStep, results);
+				video_keyframe_face_num = ret ? results.size() : 0;
 				if (show_debug_info)
-				{
-					printf("final found num: %d\n", (int)results.size());
-					printf("total cost: %.3f ms (P: %.3f ms, R: %.3f ms, O: %.3f ms)\n",
-						1000 * (t4 - t1), 1000 * (t2 - t1), 1000 * (t3 - t2), 1000 * (t4 - t3));
-				}
+					printf("video keyframe: %d faces\n", ret ? (int)results.size() : 0);
 			}
 			else
 			{
-				double t3 = omp_get_wtime();
-				if (!_Onet_stage(secondBbox, thirdBbox))
-					return false;
-
-				if (limit_l_num > 0)
+				double t1 = omp_get_wtime();
+				results.clear();
+				if (width != _width || height != _height || video_tracks.size() == 0)
+					ret = false;
+				else if (!use_fused_crop && !input.ConvertFromBGR(bgr_img, width, height, _widthStep))
+					ret = false;
+				else
 				{
-					_select(thirdBbox, limit_l_num, _width, _height);
+					frame_img = bgr_img;
+					frame_widthStep = _widthStep;
+					std::vector<ZQ_CNN_BBox> firstBbox(video_tracks.size());
+					for (int i = 0; i < video_tracks.size(); i++)
+					{
+						const ZQ_CNN_BBox& track = video_tracks[i];
+						float size = __max(track.col2 - track.col1, track.row2 - track.row1)*(1 + 2 * video_motion_margin);
+						float cx = 0.5f*(track.col1 + track.col2);
+						float cy = 0.5f*(track.row1 + track.row2);
+						ZQ_CNN_BBox& bbox = firstBbox[i];
+						bbox.col1 = round(cx - 0.5f*size);
+						bbox.row1 = round(cy - 0.5f*size);
+						bbox.col2 = round(cx + 0.5f*size);
+						bbox.row2 = round(cy + 0.5f*size);
+						bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+						bbox.score = track.score;
+						bbox.exist = true;
+					}
+					ret = _find_from_first_bbox(firstBbox, _width, _height, results, t1);
 				}
+				lost = video_tracks.size() > 0 && (!ret || results.size() < video_min_track_ratio*video_keyframe_face_num);
+				if (show_debug_info)
+					printf("video tracking: %d faces -> %d faces%s\n", (int)video_tracks.size(), ret ? (int)results.size() : 0,
+						lost ? ", next is a keyframe" : "");
+			}
+			video_tracks = ret ? results : std::vector<ZQ_CNN_BBox>();
+			video_frame_count = lost ? 0 : (video_frame_count + 1) % video_keyframe_interval;
+			return ret;
+		}
 
-				double t4 = omp_get_wtime();
-
-				if (!_Lnet_stage(thirdBbox, results))
+		class ImageRef
+		{
+		public:
+			const unsigned char* bgr_img;
+			int width, height, widthStep;
+			ImageRef(const unsigned char* bgr_img = 0, int width = 0, int height = 0, int widthStep = 0)
+				:bgr_img(bgr_img), width(width), height(height), widthStep(widthStep) {}
+		};
+
+		/*Find for many images of the size given to SetPara. The images are taken in groups of group_size, and the faces
+		of a group are put in the same batches of Rnet, Onet (and Lnet), see also TurnOnBatchOverlap. results[i] is empty
+		if nothing is found in images[i], false if an image has another size or a crop or a Forward of Rnet, Onet or Lnet
+		fails (as Find)*/
+		bool FindBatch(const std::vector<ImageRef>& images, std::vector<std::vector<ZQ_CNN_BBox> >& results, int group_size = 2)
+		{
+			int image_num = images.size();
+			results.clear();
+			results.resize(image_num);
+			for (int i = 0; i < image_num; i++)
+			{
+				if (images[i].width != width || images[i].height != height)
 					return false;
+			}
+			if (image_num == 0)
+				return true;
+			group_size = __max(1, group_size);
+			int group_num = (image_num + group_size - 1) / group_size;
+			if (batch_inputs.size() != group_size * 2)
+			{
+				batch_inputs.clear();
+				batch_inputs.resize(group_size * 2);
+			}
 
-				double t5 = omp_get_wtime();
-				if (show_debug_info)
+			double t1 = omp_get_wtime();
+			std::vector<std::vector<ZQ_CNN_BBox> > firstBbox(image_num);
+			std::vector<char> has_first(image_num, 0);
+			bool ret = true;
+			//the input of image i is kept in batch_inputs[(i / group_size) % 2 * group_size + i % group_size]
+			auto run_pnet = [&](int g)
+			{
+				for (int i = g*group_size; i < __min(image_num, (g + 1)*group_size); i++)
 				{
-					printf("final found num: %d\n", (int)results.size());
-					printf("total cost: %.3f ms (P: %.3f ms, R: %.3f ms, O: %.3f ms, L: %.3f ms)\n",
-						1000 * (t5 - t1), 1000 * (t2 - t1), 1000 * (t3 - t2), 1000 * (t4 - t3), 1000 * (t5 - t4));
+					has_first[i] = _Pnet_stage(images[i].bgr_img, images[i].width, images[i].height, images[i].widthStep, firstBbox[i], true);
+					input.Swap(batch_inputs[g % 2 * group_size + i % group_size]);
+				}
+			};
+			auto run_rest = [&](int g)
+			{
+				std::vector<const ZQ_CNN_Tensor4D*> group_inputs;
+				std::vector<std::vector<ZQ_CNN_BBox> > group_boxes;
+				std::vector<int> group_ids;
+				for (int i = g*group_size; i < __min(image_num, (g + 1)*group_size); i++)
+				{
+					if (!has_first[i])
+						continue;
+					group_inputs.push_back(&batch_inputs[g % 2 * group_size + i % group_size]);
+					group_boxes.push_back(std::vector<ZQ_CNN_BBox>());
+					group_boxes.back().swap(firstBbox[i]);
+					group_ids.push_back(i);
+				}
+				if (!_find_from_first_bbox_batch(group_inputs, group_boxes))
+				{
+					ret = false;
+					return;
 				}
+				for (int j = 0; j < group_ids.size(); j++)
+					results[group_ids[j]].swap(group_boxes[j]);
+			};
+
+			run_pnet(0);
+			for (int g = 0; g < group_num; g++)
+			{
+				ZQ_CNN_ThreadPool::ParallelFor(2, use_batch_overlap ? __min(2, thread_num) : 1, [&](int lane, int thread_id)
+				{
+					if (lane == 0)
+					{
+						if (g + 1 < group_num)
+							run_pnet(g + 1);
+					}
+					else
+						run_rest(g);
+				});
 			}
-			
-			return true;
+			double t2 = omp_get_wtime();
+			if (show_debug_info)
+				printf("FindBatch: %d images in %d groups, cost %.3f ms\n", image_num, group_num, 1000 * (t2 - t1));
+			return ret;
 		}
 
 		bool Find106(const unsigned char* bgr_img, int _width, int _height, int _widthStep, std::vector<ZQ_CNN_BBox106>& results)
@@ -381,1167 +464,1287 @@ namespace ZQ
 		}
 
 	private:
-		void _compute_Pnet_single_thread(std::vector<std::vector<float> >& maps, 
-			std::vector<int>& mapH, std::vector<int>& mapW)
+		/*the part of Init and InitFromBuffer after the models are loaded (ret is whether they are): prunes the models and
+		makes the nets of the threads*/
+		bool _init_nets(bool ret, int thread_num, bool has_lnet)
 		{
-			int scale_num = 0;
-			for (int i = 0; i < scales.size(); i++)
-			{
-				int changedH = (int)ceil(height*scales[i]);
-				int changedW = (int)ceil(width*scales[i]);
-				if (changedH < pnet_size || changedW < pnet_size)
-					continue;
-				scale_num++;
-				mapH.push_back((changedH - pnet_size) / pnet_stride + 1);
-				mapW.push_back((changedW - pnet_size) / pnet_stride + 1);
-			}
-			maps.resize(scale_num);
-			for (int i = 0; i < scale_num; i++)
+			if (thread_num < 1)
+				force_run_pnet_multithread = true;
+			else
+				force_run_pnet_multithread = false;
+			thread_num = __max(1, thread_num);
+			pnet.resize(thread_num);
+			rnet.resize(thread_num);
+			onet.resize(thread_num);
+			this->has_lnet = has_lnet;
+			if (has_lnet)
+				lnet.resize(thread_num);
+			if (ret)
 			{
-				maps[i].resize(mapH[i] * mapW[i]);
+				//the other heads are never read
+				std::vector<std::string> rnet_outputs;
+				rnet_outputs.push_back("prob1");
+				rnet_outputs.push_back("conv5-2");
+				ret = pnet_model.PruneLayers(std::vector<std::string>(1, "prob1")) && rnet_model.PruneLayers(rnet_outputs);
 			}
-
-			for (int i = 0; i < scale_num; i++)
+			for (int i = 0; i < thread_num && ret; i++)
 			{
-				int changedH = (int)ceil(height*scales[i]);
-				int changedW = (int)ceil(width*scales[i]);
-				float cur_scale_x = (float)width / changedW;
-				float cur_scale_y = (float)height / changedH;
-				double t10 = omp_get_wtime();
-				if (scales[i] != 1)
-				{
-					input.ResizeBilinear(pnet_images[i], changedW, changedH, 0, 0);
-				}
-
-				double t11 = omp_get_wtime();
-				if (scales[i] != 1)
-					pnet[0].Forward(pnet_images[i]);
-				else
-					pnet[0].Forward(input);
-				double t12 = omp_get_wtime();
-				if (show_debug_info)
-					printf("Pnet [%d]: resolution [%dx%d], resize:%.3f ms, cost:%.3f ms\n",
-						i, changedW, changedH, 1000 * (t11 - t10), 1000 * (t12 - t11));
-				const ZQ_CNN_Tensor4D* score = pnet[0].GetBlobByName("prob1");
-				//score p
-				int scoreH = score->GetH();
-				int scoreW = score->GetW();
-				int scorePixStep = score->GetPixelStep();
-				const float *p = score->GetFirstPixelPtr() + 1;
-				for (int row = 0; row < scoreH; row++)
+				ret = pnet[i].Init(pnet_model) && rnet[i].Init(rnet_model) && onet[i].Init(onet_model);
+				if (has_lnet && ret)
+					ret = lnet[i].Init(lnet_model);
+				if (ret)
 				{
-					for (int col = 0; col < scoreW; col++)
-					{
-						if(row < mapH[i] && col < mapW[i])
-							maps[i][row*mapW[i] + col] = *p;
-						p += scorePixStep;
-					}
+					//only the output blobs are read
+					pnet[i].TurnOnMemoryPlan();
+					rnet[i].TurnOnMemoryPlan();
+					onet[i].TurnOnMemoryPlan();
+					if (has_lnet)
+						lnet[i].TurnOnMemoryPlan();
 				}
 			}
-		}
-		void _compute_Pnet_multi_thread(std::vector<std::vector<float> >& maps,
-			std::vector<int>& mapH, std::vector<int>& mapW)
-		{
-			if (thread_num <= 1)
+			if (!ret)
 			{
-				for (int i = 0; i < scales.size(); i++)
-				{
-					int changedH = (int)ceil(height*scales[i]);
-					int changedW = (int)ceil(width*scales[i]);
-					if (changedH < pnet_size || changedW < pnet_size)
-						continue;
-					if (scales[i] != 1)
-					{
-						input.ResizeBilinear(pnet_images[i], changedW, changedH, 0, 0);
-					}
-				}
+				pnet.clear();
+				rnet.clear();
+				onet.clear();
+				lnet.clear();
+				this->thread_num = 0;
+				return false;
 			}
-			else
+			this->thread_num = thread_num;
+			if (show_debug_info)
 			{
-#pragma omp parallel for num_threads(thread_num) schedule(dynamic, 1)
-				for (int i = 0; i < scales.size(); i++)
-				{
-					int changedH = (int)ceil(height*scales[i]);
-					int changedW = (int)ceil(width*scales[i]);
-					if (changedH < pnet_size || changedW < pnet_size)
-						continue;
-					if (scales[i] != 1)
-					{
-						input.ResizeBilinear(pnet_images[i], changedW, changedH, 0, 0);
-					}
-				}
+				printf("rnet = %.1f M, onet = %.1f M\n", rnet[0].GetNumOfMulAdd() / (1024.0*1024.0),
+					onet[0].GetNumOfMulAdd() / (1024.0*1024.0));
+				if (has_lnet)
+					printf("lnet = %.1f M\n", lnet[0].GetNumOfMulAdd() / (1024.0*1024.0));
 			}
-			int scale_num = 0;
-			for (int i = 0; i < scales.size(); i++)
+			int C, H, W;
+			rnet[0].GetInputDim(C, H, W);
+			rnet_size = H;
+			onet[0].GetInputDim(C, H, W);
+			onet_size = H;
+			if (has_lnet)
 			{
-				int changedH = (int)ceil(height*scales[i]);
-				int changedW = (int)ceil(width*scales[i]);
-				if (changedH < pnet_size || changedW < pnet_size)
-					continue;
-				scale_num++;
-				mapH.push_back((changedH - pnet_size) / pnet_stride + 1);
-				mapW.push_back((changedW - pnet_size) / pnet_stride + 1);
+				lnet[0].GetInputDim(C, H, W);
+				lnet_size = H;
 			}
-			maps.resize(scale_num);
-			for (int i = 0; i < scale_num; i++)
+			return true;
+		}
+
+		/*Rnet, Onet and Lnet on the candidates of Pnet (or of the faces tracked in video)*/
+		bool _find_from_first_bbox(std::vector<ZQ_CNN_BBox>& firstBbox, int _width, int _height, std::vector<ZQ_CNN_BBox>& results,
+			double t1)
+		{
+			std::vector<ZQ_CNN_BBox> secondBbox, thirdBbox;
+			//results = firstBbox;
+			//return true;
+			if (limit_r_num > 0)
 			{
-				maps[i].resize(mapH[i] * mapW[i]);
+				_select(firstBbox, limit_r_num, _width, _height);
 			}
-			
-			std::vector<int> task_rect_off_x;
-			std::vector<int> task_rect_off_y;
-			std::vector<int> task_rect_width;
-			std::vector<int> task_rect_height;
-			std::vector<float> task_scale;
-			std::vector<int> task_scale_id;
 
-			int stride = pnet_stride;
-			const int block_size = 64 * stride;
-			int cellsize = pnet_size;
-			int border_size = cellsize - stride;
-			int overlap_border_size = cellsize / stride;
-			int jump_size = block_size - border_size;
-			for (int i = 0; i < scales.size(); i++)
+			double t2 = omp_get_wtime();
+			if (!_Rnet_stage(firstBbox, secondBbox))
+				return false;
+			//results = secondBbox;
+			//return true;
+
+			if (limit_o_num > 0)
 			{
-				int changeH = (int)ceil(height*scales[i]);
-				int changeW = (int)ceil(width*scales[i]);
-				if (changeH < pnet_size || changeW < pnet_size)
-					continue;
-				int block_H_num = 0;
-				int block_W_num = 0;
-				int start = 0;
-				while (start < changeH)
+				_select(secondBbox, limit_o_num, _width, _height);
+			}
+
+			if (!has_lnet || !do_landmark)
+			{
+				double t3 = omp_get_wtime();
+				if (!_Onet_stage(secondBbox, results))
+					return false;
+
+				double t4 = omp_get_wtime();
+				if (show_debug_info)
 				{
-					block_H_num++;
-					if (start + block_size >= changeH)
-						break;
-					start += jump_size;
+					printf("final found num: %d\n", (int)results.size());
+					printf("total cost: %.3f ms (P: %.3f ms, R: %.3f ms, O: %.3f ms)\n",
+						1000 * (t4 - t1), 1000 * (t2 - t1), 1000 * (t3 - t2), 1000 * (t4 - t3));
 				}
-				start = 0;
-				while (start < changeW)
+			}
+			else
+			{
+				double t3 = omp_get_wtime();
+				if (!_Onet_stage(secondBbox, thirdBbox))
+					return false;
+
+				if (limit_l_num > 0)
 				{
-					block_W_num++;
-					if (start + block_size >= changeW)
-						break;
-					start += jump_size;
+					_select(thirdBbox, limit_l_num, _width, _height);
 				}
-				for (int s = 0; s < block_H_num; s++)
+
+				double t4 = omp_get_wtime();
+
+				if (!_Lnet_stage(thirdBbox, results))
+					return false;
+
+				double t5 = omp_get_wtime();
+				if (show_debug_info)
 				{
-					for (int t = 0; t < block_W_num; t++)
-					{
-						int rect_off_x = t * jump_size;
-						int rect_off_y = s * jump_size;
-						int rect_width = __min(changeW, rect_off_x + block_size) - rect_off_x;
-						int rect_height = __min(changeH, rect_off_y + block_size) - rect_off_y;
-						if (rect_width >= cellsize && rect_height >= cellsize)
-						{
-							task_rect_off_x.push_back(rect_off_x);
-							task_rect_off_y.push_back(rect_off_y);
-							task_rect_width.push_back(rect_width);
-							task_rect_height.push_back(rect_height);
-							task_scale.push_back(scales[i]);
-							task_scale_id.push_back(i);
-						}
-					}
+					printf("final found num: %d\n", (int)results.size());
+					printf("total cost: %.3f ms (P: %.3f ms, R: %.3f ms, O: %.3f ms, L: %.3f ms)\n",
+						1000 * (t5 - t1), 1000 * (t2 - t1), 1000 * (t3 - t2), 1000 * (t4 - t3), 1000 * (t5 - t4));
+				}
+			}
+			
+			return true;
+		}
+
+
+		/*_find_from_first_bbox for several images, the faces of all the images are put in the same batches of each net,
+		boxes are the candidates of Pnet of each image, and then the results*/
+		bool _find_from_first_bbox_batch(const std::vector<const ZQ_CNN_Tensor4D*>& images, std::vector<std::vector<ZQ_CNN_BBox> >& boxes)
+		{
+			if (limit_r_num > 0)
+			{
+				for (int k = 0; k < boxes.size(); k++)
+					_select(boxes[k], limit_r_num, width, height);
+			}
+			if (!_Rnet_stage_batch(images, boxes))
+				return false;
+			if (limit_o_num > 0)
+			{
+				for (int k = 0; k < boxes.size(); k++)
+					_select(boxes[k], limit_o_num, width, height);
+			}
+			if (!_Onet_stage_batch(images, boxes))
+				return false;
+			if (has_lnet && do_landmark)
+			{
+				if (limit_l_num > 0)
+				{
+					for (int k = 0; k < boxes.size(); k++)
+						_select(boxes[k], limit_l_num, width, height);
 				}
+				if (!_Lnet_stage_batch(images, boxes))
+					return false;
 			}
+			return true;
+		}
 
-			//
-			int task_num = task_scale.size();
-			std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> task_pnet_images(thread_num);
+		/*the crops [st_id, end_id) resized to net_size x net_size in one tensor, each from images[image_ids[i]],
+		a null image is the one given to Find and is cropped by _crop_rects*/
+		bool _crop_batch(const std::vector<const ZQ_CNN_Tensor4D*>& images, const std::vector<int>& image_ids,
+			const std::vector<int>& off_x, const std::vector<int>& off_y, const std::vector<int>& rect_w, const std::vector<int>& rect_h,
+			int st_id, int end_id, int net_size, ZQ_CNN_Tensor4D_NHW_C_Align128bit& crops, ZQ_CNN_Tensor4D_NHW_C_Align128bit& tmp)
+		{
+			if (image_ids[st_id] != image_ids[end_id - 1] && !crops.ChangeSize(end_id - st_id, net_size, net_size, 3, 0, 0))
+				return false;
+			for (int i = st_id; i < end_id;)
+			{
+				int j = i + 1;
+				while (j < end_id && image_ids[j] == image_ids[i])
+					j++;
+				std::vector<int> cur_off_x(off_x.begin() + i, off_x.begin() + j), cur_off_y(off_y.begin() + i, off_y.begin() + j);
+				std::vector<int> cur_rect_w(rect_w.begin() + i, rect_w.begin() + j), cur_rect_h(rect_h.begin() + i, rect_h.begin() + j);
+				const ZQ_CNN_Tensor4D* image = images[image_ids[i]];
+				ZQ_CNN_Tensor4D_NHW_C_Align128bit& dst = (i == st_id && j == end_id) ? crops : tmp;
+				if (image == 0 ? !_crop_rects(dst, net_size, cur_off_x, cur_off_y, cur_rect_w, cur_rect_h)
+					: !image->ResizeBilinearRect(dst, net_size, net_size, 0, 0, cur_off_x, cur_off_y, cur_rect_w, cur_rect_h))
+					return false;
+				if (&dst == &crops)
+					return true;
+				memcpy(crops.GetFirstPixelPtr() + (__int64)(i - st_id)*crops.GetSliceStep(), tmp.GetFirstPixelPtr(),
+					sizeof(float)*tmp.GetSliceStep()*(j - i));
+				i = j;
+			}
+			return true;
+		}
 
-			if (thread_num <= 1)
+		/*split the crops into batches of at most BATCH_SIZE over the threads, and run the net on each batch,
+		read_outputs(net, st_id, num). False if a crop or a Forward fails*/
+		template<class Func>
+		bool _forward_crops_batch(std::vector<ZQ_CNN_ExecContext>& nets, int net_size, const std::vector<const ZQ_CNN_Tensor4D*>& images,
+			const std::vector<int>& image_ids, const std::vector<int>& off_x, const std::vector<int>& off_y,
+			const std::vector<int>& rect_w, const std::vector<int>& rect_h, const Func& read_outputs)
+		{
+			int count = image_ids.size();
+			if (count == 0)
+				return true;
+			int batch_size = BATCH_SIZE;
+			int per_num = ceil((float)count / thread_num);
+			int need_thread_num = thread_num;
+			if (per_num > batch_size)
 			{
-				for (int i = 0; i < task_num; i++)
+				need_thread_num = ceil((float)count / batch_size);
+				per_num = batch_size;
+			}
+			std::atomic<bool> failed(false);
+			ZQ_CNN_ThreadPool::ParallelFor(need_thread_num, thread_num, [&](int pp, int thread_id)
+			{
+				int st_id = per_num*pp;
+				int end_id = __min(count, per_num*(pp + 1));
+				if (end_id <= st_id)
+					return;
+				ZQ_CNN_Tensor4D_NHW_C_Align128bit crops, tmp;
+				if (!_crop_batch(images, image_ids, off_x, off_y, rect_w, rect_h, st_id, end_id, net_size, crops, tmp)
+					|| !nets[thread_id].Forward(crops))
 				{
-					int thread_id = omp_get_thread_num();
-					int scale_id = task_scale_id[i];
-					float cur_scale = task_scale[i];
-					int i_rect_off_x = task_rect_off_x[i];
-					int i_rect_off_y = task_rect_off_y[i];
-					int i_rect_width = task_rect_width[i];
-					int i_rect_height = task_rect_height[i];
-					if (scale_id == 0 && scales[0] == 1)
+					failed = true;
+					return;
+				}
+				read_outputs(nets[thread_id], st_id, end_id - st_id);
+			});
+			return !failed;
+		}
+
+		/*the candidates of each image with the size checked by the stages, and their rects*/
+		void _collect_crops_batch(std::vector<std::vector<ZQ_CNN_BBox> >& boxes, std::vector<ZQ_CNN_BBox>& cands, std::vector<int>& image_ids,
+			std::vector<int>& off_x, std::vector<int>& off_y, std::vector<int>& rect_w, std::vector<int>& rect_h)
+		{
+			for (int k = 0; k < boxes.size(); k++)
+			{
+				for (int i = 0; i < boxes[k].size(); i++)
+				{
+					ZQ_CNN_BBox& bbox = boxes[k][i];
+					if (!bbox.exist)
+						continue;
+					int cur_w = bbox.col2 - bbox.col1;
+					int cur_h = bbox.row2 - bbox.row1;
+					if (cur_w <= 0.5*min_size || cur_h <= 0.5*min_size)
+						continue;
+					cands.push_back(bbox);
+					image_ids.push_back(k);
+					off_x.push_back(bbox.col1);
+					off_y.push_back(bbox.row1);
+					rect_w.push_back(cur_w);
+					rect_h.push_back(cur_h);
+				}
+			}
+		}
+
+		/*the stages of Find and FindBatch, boxes[k] are the faces of images[k] (see _crop_batch), the faces of all the
+		images are run in the same batches*/
+		bool _Rnet_stage_batch(const std::vector<const ZQ_CNN_Tensor4D*>& images, std::vector<std::vector<ZQ_CNN_BBox> >& boxes)
+		{
+			double t3 = omp_get_wtime();
+			std::vector<ZQ_CNN_BBox> cands;
+			std::vector<int> image_ids, off_x, off_y, rect_w, rect_h;
+			_collect_crops_batch(boxes, cands, image_ids, off_x, off_y, rect_w, rect_h);
+			std::vector<char> passed(cands.size(), 0);
+			if (!_forward_crops_batch(rnet, rnet_size, images, image_ids, off_x, off_y, rect_w, rect_h, [&](ZQ_CNN_ExecContext& net, int st_id, int cur_num)
+			{
+				const ZQ_CNN_Tensor4D* score = net.GetBlobByName("prob1");
+				const ZQ_CNN_Tensor4D* location = net.GetBlobByName("conv5-2");
+				for (int i = 0; i < cur_num; i++)
+				{
+					float cur_score = score->GetFirstPixelPtr()[i*score->GetSliceStep() + 1];
+					if (cur_score > thresh[1])
 					{
-						if (!input.ROI(task_pnet_images[thread_id],
-							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
-							continue;
+						ZQ_CNN_BBox& bbox = cands[st_id + i];
+						for (int j = 0; j < 4; j++)
+							bbox.regreCoord[j] = location->GetFirstPixelPtr()[i*location->GetSliceStep() + j];
+						bbox.area = rect_w[st_id + i] * rect_h[st_id + i];
+						bbox.score = cur_score;
+						passed[st_id + i] = 1;
 					}
-					else
+				}
+			}))
+				return false;
+			int count = 0;
+			for (int k = 0; k < boxes.size(); k++)
+			{
+				boxes[k].clear();
+				std::vector<ZQ_CNN_OrderScore> scores;
+				ZQ_CNN_OrderScore order;
+				for (int i = 0; i < cands.size(); i++)
+				{
+					if (image_ids[i] == k && passed[i])
 					{
-						if (!pnet_images[scale_id].ROI(task_pnet_images[thread_id],
-							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
-							continue;
+						order.score = cands[i].score;
+						order.oriOrder = boxes[k].size();
+						scores.push_back(order);
+						boxes[k].push_back(cands[i]);
 					}
+				}
+				//ZQ_CNN_BBoxUtils::_nms(boxes[k], scores, nms_thresh[1], "Union");
+				ZQ_CNN_BBoxUtils::_nms(boxes[k], scores, nms_thresh[1], "Min");
+				ZQ_CNN_BBoxUtils::_refine_and_square_bbox(boxes[k], width, height, true);
+				count += boxes[k].size();
+			}
 
-					if (!pnet[thread_id].Forward(task_pnet_images[thread_id]))
-						continue;
-					const ZQ_CNN_Tensor4D* score = pnet[thread_id].GetBlobByName("prob1");
+			double t4 = omp_get_wtime();
+			if (show_debug_info)
+				printf("run Rnet [%d] times, candidate after nms: %d \n", (int)cands.size(), count);
+			if (show_debug_info)
+				printf("stage 2: cost %.3f ms\n", 1000 * (t4 - t3));
+			return true;
+		}
 
-					int task_count = 0;
-					//score p
-					int scoreH = score->GetH();
-					int scoreW = score->GetW();
-					int scorePixStep = score->GetPixelStep();
-					const float *p = score->GetFirstPixelPtr() + 1;
-					ZQ_CNN_BBox bbox;
-					ZQ_CNN_OrderScore order;
-					for (int row = 0; row < scoreH; row++)
+		bool _Onet_stage_batch(const std::vector<const ZQ_CNN_Tensor4D*>& images, std::vector<std::vector<ZQ_CNN_BBox> >& boxes)
+		{
+			double t4 = omp_get_wtime();
+			std::vector<ZQ_CNN_BBox> all_cands, cands;
+			std::vector<int> all_image_ids, all_off_x, all_off_y, all_rect_w, all_rect_h;
+			std::vector<int> image_ids, off_x, off_y, rect_w, rect_h;
+			_collect_crops_batch(boxes, all_cands, all_image_ids, all_off_x, all_off_y, all_rect_w, all_rect_h);
+			std::vector<std::vector<ZQ_CNN_BBox> > early_accept(boxes.size());
+			for (int i = 0; i < all_cands.size(); i++)
+			{
+				if (!do_landmark && all_cands[i].score > early_accept_thresh)
+				{
+					early_accept[all_image_ids[i]].push_back(all_cands[i]);
+					continue;
+				}
+				cands.push_back(all_cands[i]);
+				image_ids.push_back(all_image_ids[i]);
+				off_x.push_back(all_off_x[i]);
+				off_y.push_back(all_off_y[i]);
+				rect_w.push_back(all_rect_w[i]);
+				rect_h.push_back(all_rect_h[i]);
+			}
+			std::vector<char> passed(cands.size(), 0);
+			if (!_forward_crops_batch(onet, onet_size, images, image_ids, off_x, off_y, rect_w, rect_h, [&](ZQ_CNN_ExecContext& net, int st_id, int cur_num)
+			{
+				const ZQ_CNN_Tensor4D* score = net.GetBlobByName("prob1");
+				const ZQ_CNN_Tensor4D* location = net.GetBlobByName("conv6-2");
+				const ZQ_CNN_Tensor4D* keyPoint = net.GetBlobByName("conv6-3");
+				for (int i = 0; i < cur_num; i++)
+				{
+					float cur_score = score->GetFirstPixelPtr()[i*score->GetSliceStep() + 1];
+					if (cur_score > thresh[2])
 					{
-						for (int col = 0; col < scoreW; col++)
+						ZQ_CNN_BBox& bbox = cands[st_id + i];
+						for (int j = 0; j < 4; j++)
+							bbox.regreCoord[j] = location->GetFirstPixelPtr()[i*location->GetSliceStep() + j];
+						if (keyPoint != 0)
 						{
-							int real_row = row + i_rect_off_y / stride;
-							int real_col = col + i_rect_off_x / stride;
-							if (real_row < mapH[scale_id] && real_col < mapW[scale_id])
-								maps[scale_id][real_row*mapW[scale_id] + real_col] = *p;
-
-							p += scorePixStep;
+							const float* keyPoint_ptr = keyPoint->GetFirstPixelPtr() + i*keyPoint->GetSliceStep();
+							for (int num = 0; num < 5; num++)
+							{
+								bbox.ppoint[num] = bbox.col1 + (bbox.col2 - bbox.col1)*keyPoint_ptr[num];
+								bbox.ppoint[num + 5] = bbox.row1 + (bbox.row2 - bbox.row1)*keyPoint_ptr[num + 5];
+							}
 						}
+						bbox.area = rect_w[st_id + i] * rect_h[st_id + i];
+						bbox.score = cur_score;
+						passed[st_id + i] = 1;
 					}
 				}
-			}
-			else
+			}))
+				return false;
+			int count = 0;
+			for (int k = 0; k < boxes.size(); k++)
 			{
-#pragma omp parallel for num_threads(thread_num)
-				for (int i = 0; i < task_num; i++)
+				boxes[k].clear();
+				for (int i = 0; i < cands.size(); i++)
 				{
-					int thread_id = omp_get_thread_num();
-					int scale_id = task_scale_id[i];
-					float cur_scale = task_scale[i];
-					int i_rect_off_x = task_rect_off_x[i];
-					int i_rect_off_y = task_rect_off_y[i];
-					int i_rect_width = task_rect_width[i];
-					int i_rect_height = task_rect_height[i];
-					if (scale_id == 0 && scales[0] == 1)
-					{
-						if (!input.ROI(task_pnet_images[thread_id],
-							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
-							continue;
-					}
-					else
-					{
-						if (!pnet_images[scale_id].ROI(task_pnet_images[thread_id],
-							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
-							continue;
-					}
-
-					if (!pnet[thread_id].Forward(task_pnet_images[thread_id]))
-						continue;
-					const ZQ_CNN_Tensor4D* score = pnet[thread_id].GetBlobByName("prob1");
-
-					int task_count = 0;
-					//score p
-					int scoreH = score->GetH();
-					int scoreW = score->GetW();
-					int scorePixStep = score->GetPixelStep();
-					const float *p = score->GetFirstPixelPtr() + 1;
-					ZQ_CNN_BBox bbox;
-					ZQ_CNN_OrderScore order;
-					for (int row = 0; row < scoreH; row++)
-					{
-						for (int col = 0; col < scoreW; col++)
-						{
-							int real_row = row + i_rect_off_y / stride;
-							int real_col = col + i_rect_off_x / stride;
-							if (real_row < mapH[scale_id] && real_col < mapW[scale_id])
-								maps[scale_id][real_row*mapW[scale_id] + real_col] = *p;
-
-							p += scorePixStep;
-						}
-					}
+					if (image_ids[i] == k && passed[i])
+						boxes[k].push_back(cands[i]);
+				}
+				count += boxes[k].size();
+				boxes[k].insert(boxes[k].end(), early_accept[k].begin(), early_accept[k].end());
+				std::vector<ZQ_CNN_OrderScore> scores(boxes[k].size());
+				for (int i = 0; i < boxes[k].size(); i++)
+				{
+					scores[i].score = boxes[k][i].score;
+					scores[i].oriOrder = i;
 				}
+				ZQ_CNN_BBoxUtils::_refine_and_square_bbox(boxes[k], width, height, false);
+				ZQ_CNN_BBoxUtils::_nms(boxes[k], scores, nms_thresh[2], "Min");
 			}
+
+			double t5 = omp_get_wtime();
+			if (show_debug_info)
+				printf("run Onet [%d] times, candidate before nms: %d \n", (int)cands.size(), count);
+			if (show_debug_info)
+				printf("stage 3: cost %.3f ms\n", 1000 * (t5 - t4));
+			return true;
 		}
 
-		bool _Pnet_stage(const unsigned char* bgr_img, int _width, int _height, int _widthStep, std::vector<ZQ_CNN_BBox>& firstBbox)
+		bool _Lnet_stage_batch(const std::vector<const ZQ_CNN_Tensor4D*>& images, std::vector<std::vector<ZQ_CNN_BBox> >& boxes)
 		{
-			if (thread_num <= 0)
+			double t4 = omp_get_wtime();
+			std::vector<ZQ_CNN_BBox> cands;
+			std::vector<int> image_ids, off_x, off_y, rect_w, rect_h;
+			_collect_crops_batch(boxes, cands, image_ids, off_x, off_y, rect_w, rect_h);
+			std::vector<ZQ_CNN_BBox> squared = cands;
+			ZQ_CNN_BBoxUtils::_square_bbox(squared, width, height);
+			for (int i = 0; i < squared.size(); i++)
+			{
+				off_x[i] = squared[i].col1;
+				off_y[i] = squared[i].row1;
+				rect_w[i] = squared[i].col2 - squared[i].col1;
+				rect_h[i] = squared[i].row2 - squared[i].row1;
+			}
+			if (!_forward_crops_batch(lnet, lnet_size, images, image_ids, off_x, off_y, rect_w, rect_h, [&](ZQ_CNN_ExecContext& net, int st_id, int cur_num)
+			{
+				const ZQ_CNN_Tensor4D* keyPoint = net.GetBlobByName("conv6-3");
+				for (int i = 0; i < cur_num; i++)
+				{
+					const ZQ_CNN_BBox& square = squared[st_id + i];
+					const float* keyPoint_ptr = keyPoint->GetFirstPixelPtr() + i*keyPoint->GetSliceStep();
+					for (int num = 0; num < 5; num++)
+					{
+						cands[st_id + i].ppoint[num] = square.col1 + (square.col2 - square.col1)*keyPoint_ptr[num];
+						cands[st_id + i].ppoint[num + 5] = square.row1 + (square.row2 - square.row1)*keyPoint_ptr[num + 5];
+					}
+				}
+			}))
 				return false;
+			for (int k = 0; k < boxes.size(); k++)
+			{
+				boxes[k].clear();
+				for (int i = 0; i < cands.size(); i++)
+				{
+					if (image_ids[i] == k)
+						boxes[k].push_back(cands[i]);
+				}
+			}
 
-			double t1 = omp_get_wtime();
-			firstBbox.clear();
-			if (width != _width || height != _height)
-				return false;
-			if (!input.ConvertFromBGR(bgr_img, width, height, _widthStep))
-				return false;
-			double t2 = omp_get_wtime();
+			double t5 = omp_get_wtime();
 			if (show_debug_info)
-				printf("convert cost: %.3f ms\n", 1000 * (t2 - t1));
+				printf("run Lnet [%d] times \n", (int)cands.size());
+			if (show_debug_info)
+				printf("stage 4: cost %.3f ms\n", 1000 * (t5 - t4));
+			return true;
+		}
 
-			std::vector<std::vector<float> > maps;
-			std::vector<int> mapH;
-			std::vector<int> mapW;
-			if (thread_num == 1 && !force_run_pnet_multithread)
+		void _compute_Pnet_single_thread(std::vector<std::vector<float> >& maps, 
+			std::vector<int>& mapH, std::vector<int>& mapW)
+		{
+			int scale_num = 0;
+			for (int i = 0; i < scales.size(); i++)
 			{
-				pnet[0].TurnOffShowDebugInfo();
-				//pnet[0].TurnOnShowDebugInfo();
-				_compute_Pnet_single_thread(maps, mapH, mapW);
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				if (changedH < pnet_size || changedW < pnet_size)
+					continue;
+				scale_num++;
+				mapH.push_back((changedH - pnet_size) / pnet_stride + 1);
+				mapW.push_back((changedW - pnet_size) / pnet_stride + 1);
 			}
-			else
+			maps.resize(scale_num);
+			for (int i = 0; i < scale_num; i++)
 			{
-				_compute_Pnet_multi_thread(maps, mapH, mapW);
+				maps[i].resize(mapH[i] * mapW[i]);
 			}
-			ZQ_CNN_OrderScore order;
-			std::vector<std::vector<ZQ_CNN_BBox> > bounding_boxes(scales.size());
-			std::vector<std::vector<ZQ_CNN_OrderScore> > bounding_scores(scales.size());
-			const int block_size = 32;
-			int stride = pnet_stride;
-			int cellsize = pnet_size;
-			int border_size = cellsize / stride;
-			
-			for (int i = 0; i < maps.size(); i++)
+
+			for (int i = 0; i < scale_num; i++)
 			{
-				double t13 = omp_get_wtime();
 				int changedH = (int)ceil(height*scales[i]);
 				int changedW = (int)ceil(width*scales[i]);
-				if (changedH < pnet_size || changedW < pnet_size)
-					continue;
 				float cur_scale_x = (float)width / changedW;
 				float cur_scale_y = (float)height / changedH;
-				
-				int count = 0;
+				double t10 = omp_get_wtime();
+				_make_pnet_image(i);
+
+				double t11 = omp_get_wtime();
+				if (scales[i] != 1)
+					pnet[0].Forward(pnet_images[i]);
+				else
+					pnet[0].Forward(input);
+				double t12 = omp_get_wtime();
+				if (show_debug_info)
+					printf("Pnet [%d]: resolution [%dx%d], resize:%.3f ms, cost:%.3f ms\n",
+						i, changedW, changedH, 1000 * (t11 - t10), 1000 * (t12 - t11));
+				const ZQ_CNN_Tensor4D* score = pnet[0].GetBlobByName("prob1");
 				//score p
-				int scoreH = mapH[i];
-				int scoreW = mapW[i];
-				const float *p = &maps[i][0];
-				if (scoreW <= block_size && scoreH < block_size)
+				int scoreH = score->GetH();
+				int scoreW = score->GetW();
+				int scorePixStep = score->GetPixelStep();
+				const float *p = score->GetFirstPixelPtr() + 1;
+				for (int row = 0; row < scoreH; row++)
 				{
-				
-					ZQ_CNN_BBox bbox;
-					ZQ_CNN_OrderScore order;
-					for (int row = 0; row < scoreH; row++)
+					for (int col = 0; col < scoreW; col++)
 					{
-						for (int col = 0; col < scoreW; col++)
-						{
-							if (*p > thresh[0])
-							{
-								bbox.score = *p;
-								order.score = *p;
-								order.oriOrder = count;
-								bbox.row1 = stride*row;
-								bbox.col1 = stride*col;
-								bbox.row2 = stride*row + cellsize;
-								bbox.col2 = stride*col + cellsize;
-								bbox.exist = true;
-								bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
-								bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
-									&& (col >= border_size && col < scoreW - border_size);
-								bounding_boxes[i].push_back(bbox);
-								bounding_scores[i].push_back(order);
-								count++;
-							}
-							p ++;
-						}
+						if(row < mapH[i] && col < mapW[i])
+							maps[i][row*mapW[i] + col] = *p;
+						p += scorePixStep;
 					}
-					int before_count = bounding_boxes[i].size();
-					ZQ_CNN_BBoxUtils::_nms(bounding_boxes[i], bounding_scores[i], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
-					int after_count = bounding_boxes[i].size();
-					for (int j = 0; j < after_count; j++)
+				}
+			}
+		}
+
+		/*the faces resized to net_size x net_size in one batch, from input or (use_fused_crop) from frame_img*/
+		bool _crop_rects(ZQ_CNN_Tensor4D& dst, int net_size, const std::vector<int>& off_x, const std::vector<int>& off_y,
+			const std::vector<int>& rect_w, const std::vector<int>& rect_h)
+		{
+			if (!use_fused_crop)
+				return input.ResizeBilinearRect(dst, net_size, net_size, 0, 0, off_x, off_y, rect_w, rect_h);
+			int num = off_x.size();
+			if (num == 0 || frame_img == 0 || !dst.ChangeSize(num, net_size, net_size, 3, 0, 0))
+				return false;
+			for (int i = 0; i < num; i++)
+			{
+				if (!dst.ResizeBilinearRectFromBGR(i, frame_img, width, height, frame_widthStep, off_x[i], off_y[i], rect_w[i], rect_h[i]))
+					return false;
+			}
+			return true;
+		}
+
+		/*true if nothing but FindBatch needs the float copy of the whole image: the faces are cropped from the BGR image
+		and every scale of Pnet is made by the cascaded pyramid*/
+		bool _can_skip_input() const
+		{
+			if (!use_fused_crop || !use_cascaded_pyramid)
+				return false;
+			for (int i = 0; i < scales.size(); i++)
+			{
+				if (scales[i] == 1)
+					return false;
+			}
+			return true;
+		}
+
+		/*resize the image of scale i into pnet_images[i] (the scale 1 uses input), the cascaded scales are made in order*/
+		bool _make_pnet_image(int i)
+		{
+			int changedH = (int)ceil(height*scales[i]);
+			int changedW = (int)ceil(width*scales[i]);
+			if (!use_cascaded_pyramid)
+				return scales[i] == 1 || input.ResizeBilinear(pnet_images[i], changedW, changedH, 0, 0);
+			if (!bgr_pyramid.BuildLevel(i))
+				return false;
+			if (scales[i] == 1)
+				return true;
+			int level_W, level_H, level_widthStep;
+			const unsigned char* level = bgr_pyramid.GetLevel(i, level_W, level_H, level_widthStep);
+			return pnet_images[i].ConvertFromBGR(level, level_W, level_H, level_widthStep);
+		}
+
+		/*bottom-left skyline packing of the rects [first, size) in a canvas of canvas_W cells, returns the canvas height*/
+		static int _pack_skyline(const std::vector<int>& rect_W, const std::vector<int>& rect_H, int first, int canvas_W,
+			std::vector<int>& off_x, std::vector<int>& off_y)
+		{
+			std::vector<int> sky(canvas_W, 0);	//the used height of each column
+			off_x.assign(rect_W.size(), 0);
+			off_y.assign(rect_W.size(), 0);
+			int canvas_H = 0;
+			for (int i = first; i < rect_W.size(); i++)
+			{
+				int best_x = 0, best_y = -1;
+				for (int x = 0; x + rect_W[i] <= canvas_W; x++)
+				{
+					if (x > 0 && sky[x] == sky[x - 1])
+						continue;
+					int y = 0;
+					for (int k = x; k < x + rect_W[i]; k++)
+						y = __max(y, sky[k]);
+					if (best_y < 0 || y < best_y)
 					{
-						ZQ_CNN_BBox& bbox = bounding_boxes[i][j];
-						bbox.row1 = round(bbox.row1 *cur_scale_y);
-						bbox.col1 = round(bbox.col1 *cur_scale_x);
-						bbox.row2 = round(bbox.row2 *cur_scale_y);
-						bbox.col2 = round(bbox.col2 *cur_scale_x);
-						bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+						best_x = x;
+						best_y = y;
 					}
-					double t14 = omp_get_wtime();
-					if (show_debug_info)
-						printf("nms cost: %.3f ms, (%d-->%d)\n", 1000 * (t14 - t13), before_count, after_count);
 				}
-				else
+				off_x[i] = best_x;
+				off_y[i] = best_y;
+				for (int k = best_x; k < best_x + rect_W[i]; k++)
+					sky[k] = best_y + rect_H[i];
+				canvas_H = __max(canvas_H, best_y + rect_H[i]);
+			}
+			return canvas_H;
+		}
+
+		/*the cells of a scale in the mosaic only see the pixels of that scale if Pnet has no padding and each cell sees
+		pnet_size x pnet_size pixels at pnet_stride, then a pnet_size x (pnet_size + pnet_stride) image gives 1 x 2 cells*/
+		bool _check_pnet_mosaic()
+		{
+			if (pnet.size() == 0 || pnet_model.HasPadding())
+				return false;
+			ZQ_CNN_Tensor4D_NHW_C_Align128bit probe;
+			if (!probe.ChangeSize(1, pnet_size, pnet_size + pnet_stride, 3, 0, 0))
+				return false;
+			probe.Reset();
+			if (!pnet[0].Forward(probe))
+				return false;
+			const ZQ_CNN_Tensor4D* score = pnet[0].GetBlobByName("prob1");
+			return score != 0 && score->GetH() == 1 && score->GetW() == 2;
+		}
+
+		/*each scale in the mosaic starts at a multiple of pnet_stride so that its cells are cells of the mosaic, the gutters
+		round the sizes up to pnet_stride. The widths from the first scale to the first two side by side are tried*/
+		void _layout_pnet_mosaic()
+		{
+			int stride = pnet_stride;
+			std::vector<int> rect_W, rect_H;
+			for (int i = 0; i < scales.size(); i++)
+			{
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				if (changedH < pnet_size || changedW < pnet_size)
+					break;
+				rect_W.push_back((changedW + stride - 1) / stride);
+				rect_H.push_back((changedH + stride - 1) / stride);
+			}
+			int scale_num = rect_W.size();
+			mosaic_off_x.assign(scale_num, 0);
+			mosaic_off_y.assign(scale_num, 0);
+			mosaic_W = mosaic_H = 0;
+			int first = 0;
+			while (first < scale_num && (__int64)rect_W[first] * rect_H[first] * stride*stride > pnet_mosaic_max_area)
+				first++;
+			mosaic_first = first;
+			if (first == scale_num)
+				return;
+			std::vector<int> try_W(1, rect_W[first]);
+			if (first + 1 < scale_num)
+			{
+				int step = __max(1, rect_W[first + 1] / 32);
+				for (int w = rect_W[first] + step; w < rect_W[first] + rect_W[first + 1]; w += step)
+					try_W.push_back(w);
+				try_W.push_back(rect_W[first] + rect_W[first + 1]);
+			}
+			__int64 best_area = -1;
+			std::vector<int> off_x, off_y;
+			for (int t = 0; t < try_W.size(); t++)
+			{
+				int canvas_H = _pack_skyline(rect_W, rect_H, first, try_W[t], off_x, off_y);
+				__int64 area = (__int64)try_W[t] * canvas_H;
+				if (best_area < 0 || area < best_area)
 				{
-					int before_count = 0, after_count = 0;
-					int block_H_num = __max(1, scoreH / block_size);
-					int block_W_num = __max(1, scoreW / block_size);
-					int block_num = block_H_num*block_W_num;
-					int width_per_block = scoreW / block_W_num;
-					int height_per_block = scoreH / block_H_num;
-					std::vector<std::vector<ZQ_CNN_BBox> > tmp_bounding_boxes(block_num);
-					std::vector<std::vector<ZQ_CNN_OrderScore> > tmp_bounding_scores(block_num);
-					std::vector<int> block_start_w(block_num), block_end_w(block_num);
-					std::vector<int> block_start_h(block_num), block_end_h(block_num);
-					for (int bh = 0; bh < block_H_num; bh++)
+					best_area = area;
+					mosaic_W = try_W[t] * stride;
+					mosaic_H = canvas_H*stride;
+					for (int i = first; i < scale_num; i++)
 					{
-						for (int bw = 0; bw < block_W_num; bw++)
-						{
-							int bb = bh * block_W_num + bw;
-							block_start_w[bb] = (bw == 0) ? 0 : (bw*width_per_block - border_size);
-							block_end_w[bb] = (bw == block_num - 1) ? scoreW : ((bw + 1)*width_per_block);
-							block_start_h[bb] = (bh == 0) ? 0 : (bh*height_per_block - border_size);
-							block_end_h[bb] = (bh == block_num - 1) ? scoreH : ((bh + 1)*height_per_block);
-						}
-					}
-					int chunk_size = 1;// ceil((float)block_num / thread_num);
-					if (thread_num <= 1)
-					{
-						for (int bb = 0; bb < block_num; bb++)
-						{
-							ZQ_CNN_BBox bbox;
-							ZQ_CNN_OrderScore order;
-							int count = 0;
-							for (int row = block_start_h[bb]; row < block_end_h[bb]; row++)
-							{
-								p = &maps[i][0] + row*scoreW + block_start_w[bb];
-								for (int col = block_start_w[bb]; col < block_end_w[bb]; col++)
-								{
-									if (*p > thresh[0])
-									{
-										bbox.score = *p;
-										order.score = *p;
-										order.oriOrder = count;
-										bbox.row1 = stride*row;
-										bbox.col1 = stride*col;
-										bbox.row2 = stride*row + cellsize;
-										bbox.col2 = stride*col + cellsize;
-										bbox.exist = true;
-										bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
-											&& (col >= border_size && col < scoreW - border_size);
-										bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
-										tmp_bounding_boxes[bb].push_back(bbox);
-										tmp_bounding_scores[bb].push_back(order);
-										count++;
-									}
-									p++;
-								}
-							}
-							int tmp_before_count = tmp_bounding_boxes[bb].size();
-							ZQ_CNN_BBoxUtils::_nms(tmp_bounding_boxes[bb], tmp_bounding_scores[bb], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
-							int tmp_after_count = tmp_bounding_boxes[bb].size();
-							before_count += tmp_before_count;
-							after_count += tmp_after_count;
-						}
-					}
-					else
-					{
-#pragma omp parallel for schedule(dynamic, chunk_size) num_threads(thread_num)
-						for (int bb = 0; bb < block_num; bb++)
-						{
-							ZQ_CNN_BBox bbox;
-							ZQ_CNN_OrderScore order;
-							int count = 0;
-							for (int row = block_start_h[bb]; row < block_end_h[bb]; row++)
-							{
-								const float* p = &maps[i][0] + row*scoreW + block_start_w[bb];
-								for (int col = block_start_w[bb]; col < block_end_w[bb]; col++)
-								{
-									if (*p > thresh[0])
-									{
-										bbox.score = *p;
-										order.score = *p;
-										order.oriOrder = count;
-										bbox.row1 = stride*row;
-										bbox.col1 = stride*col;
-										bbox.row2 = stride*row + cellsize;
-										bbox.col2 = stride*col + cellsize;
-										bbox.exist = true;
-										bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
-											&& (col >= border_size && col < scoreW - border_size);
-										bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
-										tmp_bounding_boxes[bb].push_back(bbox);
-										tmp_bounding_scores[bb].push_back(order);
-										count++;
-									}
-									p++;
-								}
-							}
-							int tmp_before_count = tmp_bounding_boxes[bb].size();
-							ZQ_CNN_BBoxUtils::_nms(tmp_bounding_boxes[bb], tmp_bounding_scores[bb], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
-							int tmp_after_count = tmp_bounding_boxes[bb].size();
-							before_count += tmp_before_count;
-							after_count += tmp_after_count;
-						}
-					}
-
-					count = 0;
-					for (int bb = 0; bb < block_num; bb++)
-					{
-						std::vector<ZQ_CNN_BBox>::iterator it = tmp_bounding_boxes[bb].begin();
-						for (; it != tmp_bounding_boxes[bb].end(); it++)
-						{
-							if ((*it).exist)
-							{
-								bounding_boxes[i].push_back(*it);
-								order.score = (*it).score;
-								order.oriOrder = count;
-								bounding_scores[i].push_back(order);
-								count++;
-							}
-						}
-					}
-
-					//ZQ_CNN_BBoxUtils::_nms(bounding_boxes[i], bounding_scores[i], nms_thresh_per_scale, "Union", 0);
-					after_count = bounding_boxes[i].size();
-					for (int j = 0; j < after_count; j++)
-					{
-						ZQ_CNN_BBox& bbox = bounding_boxes[i][j];
-						bbox.row1 = round(bbox.row1 *cur_scale_y);
-						bbox.col1 = round(bbox.col1 *cur_scale_x);
-						bbox.row2 = round(bbox.row2 *cur_scale_y);
-						bbox.col2 = round(bbox.col2 *cur_scale_x);
-						bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
-					}
-					double t14 = omp_get_wtime();
-					if (show_debug_info)
-						printf("nms cost: %.3f ms, (%d-->%d)\n", 1000 * (t14 - t13), before_count, after_count);
-				}
-
-			}
-
-			std::vector<ZQ_CNN_OrderScore> firstOrderScore;
-			int count = 0;
-			for (int i = 0; i < scales.size(); i++)
-			{
-				std::vector<ZQ_CNN_BBox>::iterator it = bounding_boxes[i].begin();
-				for (; it != bounding_boxes[i].end(); it++)
-				{
-					if ((*it).exist)
-					{
-						firstBbox.push_back(*it);
-						order.score = (*it).score;
-						order.oriOrder = count;
-						firstOrderScore.push_back(order);
-						count++;
+						mosaic_off_x[i] = off_x[i] * stride;
+						mosaic_off_y[i] = off_y[i] * stride;
 					}
 				}
 			}
-
-
-			//the first stage's nms
-			if (count < 1) return false;
-			double t15 = omp_get_wtime();
-			ZQ_CNN_BBoxUtils::_nms(firstBbox, firstOrderScore, nms_thresh[0], "Union", 0, 1);
-			ZQ_CNN_BBoxUtils::_refine_and_square_bbox(firstBbox, width, height,true);
-			double t16 = omp_get_wtime();
-			if (show_debug_info)
-				printf("nms cost: %.3f ms\n", 1000 * (t16 - t15));
-			if (show_debug_info)
-				printf("first stage candidate count: %d\n", count);
-			double t3 = omp_get_wtime();
-			if (show_debug_info)
-				printf("stage 1: cost %.3f ms\n", 1000 * (t3 - t2));
-			return true;
 		}
 
-		bool _Rnet_stage(std::vector<ZQ_CNN_BBox>& firstBbox, std::vector<ZQ_CNN_BBox>& secondBbox)
+		void _compute_Pnet_mosaic(std::vector<std::vector<float> >& maps,
+			std::vector<int>& mapH, std::vector<int>& mapW)
 		{
-			double t3 = omp_get_wtime();
-			secondBbox.clear();
-			std::vector<ZQ_CNN_BBox>::iterator it = firstBbox.begin();
-			std::vector<ZQ_CNN_OrderScore> secondScore;
-			std::vector<int> src_off_x, src_off_y, src_rect_w, src_rect_h;
-			int r_count = 0;
-			for (; it != firstBbox.end(); it++)
+			int scale_num = mosaic_off_x.size();
+			for (int i = 0; i < scale_num; i++)
 			{
-				if ((*it).exist)
-				{
-					int off_x = it->col1;
-					int off_y = it->row1;
-					int rect_w = it->col2 - off_x;
-					int rect_h = it->row2 - off_y;
-					if (/*off_x < 0 || off_x + rect_w > width || off_y < 0 || off_y + rect_h > height ||*/ rect_w <= 0.5*min_size || rect_h <= 0.5*min_size)
-					{
-						(*it).exist = false;
-						continue;
-					}
-					else
-					{
-						src_off_x.push_back(off_x);
-						src_off_y.push_back(off_y);
-						src_rect_w.push_back(rect_w);
-						src_rect_h.push_back(rect_h);
-						r_count++;
-						secondBbox.push_back(*it);
-					}
-				}
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				mapH.push_back((changedH - pnet_size) / pnet_stride + 1);
+				mapW.push_back((changedW - pnet_size) / pnet_stride + 1);
 			}
-
-			int batch_size = BATCH_SIZE;
-			int per_num = ceil((float)r_count / thread_num);
-			int need_thread_num = thread_num;
-			if (per_num > batch_size)
+			maps.resize(scale_num);
+			for (int i = 0; i < scale_num; i++)
 			{
-				need_thread_num = ceil((float)r_count / batch_size);
-				per_num = batch_size;
+				maps[i].resize(mapH[i] * mapW[i]);
 			}
-			std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> task_rnet_images(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_x(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_y(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_w(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_h(need_thread_num);
-			std::vector<std::vector<ZQ_CNN_BBox> > task_secondBbox(need_thread_num);
-			
+			if (scale_num == 0)
+				return;
 
-			for (int i = 0; i < need_thread_num; i++)
+			double t10 = omp_get_wtime();
+			if (mosaic_first < scale_num
+				&& (pnet_mosaic.GetN() != 1 || pnet_mosaic.GetH() != mosaic_H || pnet_mosaic.GetW() != mosaic_W))
 			{
-				int st_id = per_num*i;
-				int end_id = __min(r_count, per_num*(i + 1));
-				int cur_num = end_id - st_id;
-				if (cur_num > 0)
-				{
-					task_src_off_x[i].resize(cur_num);
-					task_src_off_y[i].resize(cur_num);
-					task_src_rect_w[i].resize(cur_num);
-					task_src_rect_h[i].resize(cur_num);
-					task_secondBbox[i].resize(cur_num);
-					for (int j = 0; j < cur_num; j++)
-					{
-						task_src_off_x[i][j] = src_off_x[st_id + j];
-						task_src_off_y[i][j] = src_off_y[st_id + j];
-						task_src_rect_w[i][j] = src_rect_w[st_id + j];
-						task_src_rect_h[i][j] = src_rect_h[st_id + j];
-						task_secondBbox[i][j] = secondBbox[st_id + j];
-					}
-				}
+				//the pixels out of the scales are never read by the cells of the scales
+				if (!pnet_mosaic.ChangeSize(1, mosaic_H, mosaic_W, 3, 0, 0))
+					return;
+				pnet_mosaic.Reset();
 			}
-
-			if (thread_num <= 1)
+			if (use_cascaded_pyramid)
 			{
-				for (int pp = 0; pp < need_thread_num; pp++)
-				{
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_rnet_images[pp], rnet_size, rnet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
-					{
-						continue;
-					}
-					rnet[0].Forward(task_rnet_images[pp]);
-					const ZQ_CNN_Tensor4D* score = rnet[0].GetBlobByName("prob1");
-					const ZQ_CNN_Tensor4D* location = rnet[0].GetBlobByName("conv5-2");
-					const float* score_ptr = score->GetFirstPixelPtr();
-					const float* location_ptr = location->GetFirstPixelPtr();
-					int score_sliceStep = score->GetSliceStep();
-					int location_sliceStep = location->GetSliceStep();
-					int task_count = 0;
-					for (int i = 0; i < task_secondBbox[pp].size(); i++)
-					{
-						if (score_ptr[i*score_sliceStep + 1] > thresh[1])
-						{
-							for (int j = 0; j < 4; j++)
-								task_secondBbox[pp][i].regreCoord[j] = location_ptr[i*location_sliceStep + j];
-							task_secondBbox[pp][i].area = task_src_rect_w[pp][i] * task_src_rect_h[pp][i];
-							task_secondBbox[pp][i].score = score_ptr[i*score_sliceStep + 1];
-							task_count++;
-						}
-						else
-						{
-							task_secondBbox[pp][i].exist = false;
-						}
-					}
-					if (task_count < 1)
-					{
-						task_secondBbox[pp].clear();
-						continue;
-					}
-					for (int i = task_secondBbox[pp].size() - 1; i >= 0; i--)
-					{
-						if (!task_secondBbox[pp][i].exist)
-							task_secondBbox[pp].erase(task_secondBbox[pp].begin() + i);
-					}
-				}
+				for (int i = 0; i < scale_num; i++)
+					_make_pnet_image(i);
 			}
-			else
+			ZQ_CNN_ThreadPool::ParallelFor(scale_num, thread_num, [&](int i, int thread_id)
 			{
-#pragma omp parallel for num_threads(thread_num) schedule(dynamic,1)
-				for (int pp = 0; pp < need_thread_num; pp++)
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				if (!use_cascaded_pyramid)
+					_make_pnet_image(i);
+				const ZQ_CNN_Tensor4D* image = scales[i] != 1 ? &pnet_images[i] : &input;
+				if (i < mosaic_first)
+					return;
+				int dst_widthStep = pnet_mosaic.GetWidthStep();
+				int dst_pixStep = pnet_mosaic.GetPixelStep();
+				float* dst_ptr = pnet_mosaic.GetFirstPixelPtr() + mosaic_off_y[i] * dst_widthStep + mosaic_off_x[i] * dst_pixStep;
+				for (int h = 0; h < changedH; h++)
 				{
-					int thread_id = omp_get_thread_num();
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_rnet_images[pp], rnet_size, rnet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
-					{
-						continue;
-					}
-					rnet[thread_id].Forward(task_rnet_images[pp]);
-					const ZQ_CNN_Tensor4D* score = rnet[thread_id].GetBlobByName("prob1");
-					const ZQ_CNN_Tensor4D* location = rnet[thread_id].GetBlobByName("conv5-2");
-					const float* score_ptr = score->GetFirstPixelPtr();
-					const float* location_ptr = location->GetFirstPixelPtr();
-					int score_sliceStep = score->GetSliceStep();
-					int location_sliceStep = location->GetSliceStep();
-					int task_count = 0;
-					for (int i = 0; i < task_secondBbox[pp].size(); i++)
-					{
-						if (score_ptr[i*score_sliceStep + 1] > thresh[1])
-						{
-							for (int j = 0; j < 4; j++)
-								task_secondBbox[pp][i].regreCoord[j] = location_ptr[i*location_sliceStep + j];
-							task_secondBbox[pp][i].area = task_src_rect_w[pp][i] * task_src_rect_h[pp][i];
-							task_secondBbox[pp][i].score = score_ptr[i*score_sliceStep + 1];
-							task_count++;
-						}
-						else
-						{
-							task_secondBbox[pp][i].exist = false;
-						}
-					}
-					if (task_count < 1)
-					{
-						task_secondBbox[pp].clear();
-						continue;
-					}
-					for (int i = task_secondBbox[pp].size() - 1; i >= 0; i--)
+					const float* src_row_ptr = image->GetFirstPixelPtr() + h*image->GetWidthStep();
+					float* dst_row_ptr = dst_ptr + h*dst_widthStep;
+					if (image->GetPixelStep() == dst_pixStep)
+						memcpy(dst_row_ptr, src_row_ptr, sizeof(float)*dst_pixStep*changedW);
+					else
 					{
-						if (!task_secondBbox[pp][i].exist)
-							task_secondBbox[pp].erase(task_secondBbox[pp].begin() + i);
+						for (int w = 0; w < changedW; w++)
+							memcpy(dst_row_ptr + w*dst_pixStep, src_row_ptr + w*image->GetPixelStep(), sizeof(float) * 3);
 					}
 				}
-			}
+			});
 
-			int count = 0;
-			for (int i = 0; i < need_thread_num; i++)
+			double t11 = omp_get_wtime();
+			//the few Forward of Pnet use all the threads
+			if (pnet[0].GetNumThreads() != thread_num)
+				pnet[0].SetNumThreads(thread_num);
+			for (int i = 0; i < mosaic_first; i++)
 			{
-				count += task_secondBbox[i].size();
+				if (!pnet[0].Forward(scales[i] != 1 ? pnet_images[i] : input))
+					return;
+				_get_Pnet_map(pnet[0].GetBlobByName("prob1"), 0, 0, mapH[i], mapW[i], maps[i]);
 			}
-			secondBbox.resize(count);
-			secondScore.resize(count);
-			int id = 0;
-			for (int i = 0; i < need_thread_num; i++)
+			double t12 = omp_get_wtime();
+			if (mosaic_first < scale_num)
 			{
-				for (int j = 0; j < task_secondBbox[i].size(); j++)
-				{
-					secondBbox[id] = task_secondBbox[i][j];
-					secondScore[id].score = secondBbox[id].score;
-					secondScore[id].oriOrder = id;
-					id++;
-				}
+				if (!pnet[0].Forward(pnet_mosaic))
+					return;
+				const ZQ_CNN_Tensor4D* score = pnet[0].GetBlobByName("prob1");
+				for (int i = mosaic_first; i < scale_num; i++)
+					_get_Pnet_map(score, mosaic_off_y[i] / pnet_stride, mosaic_off_x[i] / pnet_stride, mapH[i], mapW[i], maps[i]);
 			}
-
-			//ZQ_CNN_BBoxUtils::_nms(secondBbox, secondScore, nms_thresh[1], "Union");
-			ZQ_CNN_BBoxUtils::_nms(secondBbox, secondScore, nms_thresh[1], "Min");
-			ZQ_CNN_BBoxUtils::_refine_and_square_bbox(secondBbox, width, height, true);
-			count = secondBbox.size();
-
-			double t4 = omp_get_wtime();
+			double t13 = omp_get_wtime();
 			if (show_debug_info)
-				printf("run Rnet [%d] times, candidate after nms: %d \n", r_count, count);
-			if (show_debug_info)
-				printf("stage 2: cost %.3f ms\n", 1000 * (t4 - t3));
+				printf("Pnet mosaic: %d scales alone, %d scales in [%dx%d], resize:%.3f ms, alone:%.3f ms, mosaic:%.3f ms\n",
+					mosaic_first, scale_num - mosaic_first, mosaic_W, mosaic_H, 1000 * (t11 - t10), 1000 * (t12 - t11), 1000 * (t13 - t12));
+		}
 
-			return true;
+		/*the scores of the map at the cell (off_row, off_col) of prob1*/
+		static void _get_Pnet_map(const ZQ_CNN_Tensor4D* score, int off_row, int off_col, int mapH, int mapW, std::vector<float>& map)
+		{
+			int scoreWidthStep = score->GetWidthStep();
+			int scorePixStep = score->GetPixelStep();
+			const float* p = score->GetFirstPixelPtr() + off_row*scoreWidthStep + off_col*scorePixStep + 1;
+			for (int row = 0; row < mapH; row++)
+			{
+				for (int col = 0; col < mapW; col++)
+					map[row*mapW + col] = p[row*scoreWidthStep + col*scorePixStep];
+			}
 		}
 
-		bool _Onet_stage(std::vector<ZQ_CNN_BBox>& secondBbox, std::vector<ZQ_CNN_BBox>& thirdBbox)
+		void _compute_Pnet_multi_thread(std::vector<std::vector<float> >& maps,
+			std::vector<int>& mapH, std::vector<int>& mapW)
 		{
-			double t4 = omp_get_wtime();
-			thirdBbox.clear();
-			std::vector<ZQ_CNN_BBox>::iterator it = secondBbox.begin();
-			std::vector<ZQ_CNN_OrderScore> thirdScore;
-			std::vector<ZQ_CNN_BBox> early_accept_thirdBbox;
-			std::vector<int> src_off_x, src_off_y, src_rect_w, src_rect_h;
-			int o_count = 0;
-			for (; it != secondBbox.end(); it++)
+			if (pnet[0].GetNumThreads() != 1)
+				pnet[0].SetNumThreads(1);
+			if (thread_num <= 1)
 			{
-				if ((*it).exist)
+				for (int i = 0; i < scales.size(); i++)
 				{
-					int off_x = it->col1;
-					int off_y = it->row1;
-					int rect_w = it->col2 - off_x;
-					int rect_h = it->row2 - off_y;
-					if (/*off_x < 0 || off_x + rect_w > width || off_y < 0 || off_y + rect_h > height ||*/ rect_w <= 0.5*min_size || rect_h <= 0.5*min_size)
-					{
-						(*it).exist = false;
+					int changedH = (int)ceil(height*scales[i]);
+					int changedW = (int)ceil(width*scales[i]);
+					if (changedH < pnet_size || changedW < pnet_size)
 						continue;
-					}
-					else
-					{
-						if (!do_landmark && it->score > early_accept_thresh)
-						{
-							early_accept_thirdBbox.push_back(*it);
-						}
-						else
-						{
-							src_off_x.push_back(off_x);
-							src_off_y.push_back(off_y);
-							src_rect_w.push_back(rect_w);
-							src_rect_h.push_back(rect_h);
-							o_count++;
-							thirdBbox.push_back(*it);
-						}
-					}
+					_make_pnet_image(i);
 				}
 			}
-
-			int batch_size = BATCH_SIZE;
-			int per_num = ceil((float)o_count / thread_num);
-			int need_thread_num = thread_num;
-			if (per_num > batch_size)
+			else if (!use_cascaded_pyramid)
 			{
-				need_thread_num = ceil((float)o_count / batch_size);
-				per_num = batch_size;
+				ZQ_CNN_ThreadPool::ParallelFor(scales.size(), thread_num, [&](int i, int thread_id)
+				{
+					int changedH = (int)ceil(height*scales[i]);
+					int changedW = (int)ceil(width*scales[i]);
+					if (changedH < pnet_size || changedW < pnet_size)
+						return;
+					_make_pnet_image(i);
+				});
 			}
+			//else the cascaded scales are built by the first task below, the other tasks wait for their scales
+			int scale_num = 0;
+			for (int i = 0; i < scales.size(); i++)
+			{
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				if (changedH < pnet_size || changedW < pnet_size)
+					continue;
+				scale_num++;
+				mapH.push_back((changedH - pnet_size) / pnet_stride + 1);
+				mapW.push_back((changedW - pnet_size) / pnet_stride + 1);
+			}
+			maps.resize(scale_num);
+			for (int i = 0; i < scale_num; i++)
+			{
+				maps[i].resize(mapH[i] * mapW[i]);
+			}
+			
+			std::vector<int> task_rect_off_x;
+			std::vector<int> task_rect_off_y;
+			std::vector<int> task_rect_width;
+			std::vector<int> task_rect_height;
+			std::vector<float> task_scale;
+			std::vector<int> task_scale_id;
 
-			std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> task_onet_images(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_x(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_y(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_w(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_h(need_thread_num);
-			std::vector<std::vector<ZQ_CNN_BBox> > task_thirdBbox(need_thread_num);
-
-			for (int i = 0; i < need_thread_num; i++)
+			int stride = pnet_stride;
+			const int block_size = 64 * stride;
+			int cellsize = pnet_size;
+			int border_size = cellsize - stride;
+			int overlap_border_size = cellsize / stride;
+			int jump_size = block_size - border_size;
+			for (int i = 0; i < scales.size(); i++)
 			{
-				int st_id = per_num*i;
-				int end_id = __min(o_count, per_num*(i + 1));
-				int cur_num = end_id - st_id;
-				if (cur_num > 0)
+				int changeH = (int)ceil(height*scales[i]);
+				int changeW = (int)ceil(width*scales[i]);
+				if (changeH < pnet_size || changeW < pnet_size)
+					continue;
+				int block_H_num = 0;
+				int block_W_num = 0;
+				int start = 0;
+				while (start < changeH)
 				{
-					task_src_off_x[i].resize(cur_num);
-					task_src_off_y[i].resize(cur_num);
-					task_src_rect_w[i].resize(cur_num);
-					task_src_rect_h[i].resize(cur_num);
-					task_thirdBbox[i].resize(cur_num);
-					for (int j = 0; j < cur_num; j++)
+					block_H_num++;
+					if (start + block_size >= changeH)
+						break;
+					start += jump_size;
+				}
+				start = 0;
+				while (start < changeW)
+				{
+					block_W_num++;
+					if (start + block_size >= changeW)
+						break;
+					start += jump_size;
+				}
+				for (int s = 0; s < block_H_num; s++)
+				{
+					for (int t = 0; t < block_W_num; t++)
 					{
-						task_src_off_x[i][j] = src_off_x[st_id + j];
-						task_src_off_y[i][j] = src_off_y[st_id + j];
-						task_src_rect_w[i][j] = src_rect_w[st_id + j];
-						task_src_rect_h[i][j] = src_rect_h[st_id + j];
-						task_thirdBbox[i][j] = thirdBbox[st_id + j];
+						int rect_off_x = t * jump_size;
+						int rect_off_y = s * jump_size;
+						int rect_width = __min(changeW, rect_off_x + block_size) - rect_off_x;
+						int rect_height = __min(changeH, rect_off_y + block_size) - rect_off_y;
+						if (rect_width >= cellsize && rect_height >= cellsize)
+						{
+							task_rect_off_x.push_back(rect_off_x);
+							task_rect_off_y.push_back(rect_off_y);
+							task_rect_width.push_back(rect_width);
+							task_rect_height.push_back(rect_height);
+							task_scale.push_back(scales[i]);
+							task_scale_id.push_back(i);
+						}
 					}
 				}
 			}
 
+			//
+			int task_num = task_scale.size();
+			std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> task_pnet_images(thread_num);
+
 			if (thread_num <= 1)
 			{
-				for (int pp = 0; pp < need_thread_num; pp++)
+				for (int i = 0; i < task_num; i++)
 				{
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_onet_images[pp], onet_size, onet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
+					int thread_id = 0;
+					int scale_id = task_scale_id[i];
+					float cur_scale = task_scale[i];
+					int i_rect_off_x = task_rect_off_x[i];
+					int i_rect_off_y = task_rect_off_y[i];
+					int i_rect_width = task_rect_width[i];
+					int i_rect_height = task_rect_height[i];
+					if (scale_id == 0 && scales[0] == 1)
+					{
+						if (!input.ROI(task_pnet_images[thread_id],
+							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
+							continue;
+					}
+					else
 					{
+						if (!pnet_images[scale_id].ROI(task_pnet_images[thread_id],
+							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
+							continue;
+					}
+
+					if (!pnet[thread_id].Forward(task_pnet_images[thread_id]))
 						continue;
+					const ZQ_CNN_Tensor4D* score = pnet[thread_id].GetBlobByName("prob1");
+
+					int task_count = 0;
+					//score p
+					int scoreH = score->GetH();
+					int scoreW = score->GetW();
+					int scorePixStep = score->GetPixelStep();
+					const float *p = score->GetFirstPixelPtr() + 1;
+					ZQ_CNN_BBox bbox;
+					ZQ_CNN_OrderScore order;
+					for (int row = 0; row < scoreH; row++)
+					{
+						for (int col = 0; col < scoreW; col++)
+						{
+							int real_row = row + i_rect_off_y / stride;
+							int real_col = col + i_rect_off_x / stride;
+							if (real_row < mapH[scale_id] && real_col < mapW[scale_id])
+								maps[scale_id][real_row*mapW[scale_id] + real_col] = *p;
+
+							p += scorePixStep;
+						}
 					}
-					double t31 = omp_get_wtime();
-					onet[0].Forward(task_onet_images[pp]);
-					double t32 = omp_get_wtime();
-					const ZQ_CNN_Tensor4D* score = onet[0].GetBlobByName("prob1");
-					const ZQ_CNN_Tensor4D* location = onet[0].GetBlobByName("conv6-2");
-					const ZQ_CNN_Tensor4D* keyPoint = onet[0].GetBlobByName("conv6-3");
-					const float* score_ptr = score->GetFirstPixelPtr();
-					const float* location_ptr = location->GetFirstPixelPtr();
-					const float* keyPoint_ptr = 0;
-					if (keyPoint != 0)
-						keyPoint_ptr = keyPoint->GetFirstPixelPtr();
-					int score_sliceStep = score->GetSliceStep();
-					int location_sliceStep = location->GetSliceStep();
-					int keyPoint_sliceStep = 0;
-					if (keyPoint != 0)
-						keyPoint_sliceStep = keyPoint->GetSliceStep();
+				}
+			}
+			else
+			{
+				int first_task = use_cascaded_pyramid ? 1 : 0;
+				std::atomic<int> built_scale_num(use_cascaded_pyramid ? 0 : (int)scales.size());
+				ZQ_CNN_ThreadPool::ParallelFor(task_num + first_task, thread_num, [&](int i, int thread_id)
+				{
+					if (i < first_task)
+					{
+						for (int j = 0; j < scale_num; j++)
+						{
+							_make_pnet_image(j);
+							built_scale_num.store(j + 1);
+						}
+						return;
+					}
+					i -= first_task;
+					int scale_id = task_scale_id[i];
+					while (built_scale_num.load() <= scale_id)
+						std::this_thread::yield();
+					float cur_scale = task_scale[i];
+					int i_rect_off_x = task_rect_off_x[i];
+					int i_rect_off_y = task_rect_off_y[i];
+					int i_rect_width = task_rect_width[i];
+					int i_rect_height = task_rect_height[i];
+					if (scale_id == 0 && scales[0] == 1)
+					{
+						if (!input.ROI(task_pnet_images[thread_id],
+							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
+							return;
+					}
+					else
+					{
+						if (!pnet_images[scale_id].ROI(task_pnet_images[thread_id],
+							i_rect_off_x, i_rect_off_y, i_rect_width, i_rect_height, 0, 0))
+							return;
+					}
+
+					if (!pnet[thread_id].Forward(task_pnet_images[thread_id]))
+						return;
+					const ZQ_CNN_Tensor4D* score = pnet[thread_id].GetBlobByName("prob1");
+
 					int task_count = 0;
+					//score p
+					int scoreH = score->GetH();
+					int scoreW = score->GetW();
+					int scorePixStep = score->GetPixelStep();
+					const float *p = score->GetFirstPixelPtr() + 1;
+					ZQ_CNN_BBox bbox;
+					ZQ_CNN_OrderScore order;
+					for (int row = 0; row < scoreH; row++)
+					{
+						for (int col = 0; col < scoreW; col++)
+						{
+							int real_row = row + i_rect_off_y / stride;
+							int real_col = col + i_rect_off_x / stride;
+							if (real_row < mapH[scale_id] && real_col < mapW[scale_id])
+								maps[scale_id][real_row*mapW[scale_id] + real_col] = *p;
+
+							p += scorePixStep;
+						}
+					}
+				});
+			}
+		}
+
+		/*keep_input: make the float copy of the whole image in input even if _can_skip_input*/
+		bool _Pnet_stage(const unsigned char* bgr_img, int _width, int _height, int _widthStep, std::vector<ZQ_CNN_BBox>& firstBbox,
+			bool keep_input = false)
+		{
+			if (thread_num <= 0)
+				return false;
+
+			double t1 = omp_get_wtime();
+			firstBbox.clear();
+			if (width != _width || height != _height)
+				return false;
+			frame_img = bgr_img;
+			frame_widthStep = _widthStep;
+			if ((keep_input || !_can_skip_input()) && !input.ConvertFromBGR(bgr_img, width, height, _widthStep))
+				return false;
+			if (use_cascaded_pyramid)
+				bgr_pyramid.SetImage(bgr_img, width, height, _widthStep);
+			double t2 = omp_get_wtime();
+			if (show_debug_info)
+				printf("convert cost: %.3f ms\n", 1000 * (t2 - t1));
+
+			std::vector<std::vector<float> > maps;
+			std::vector<int> mapH;
+			std::vector<int> mapW;
+			if (use_pnet_mosaic)
+			{
+				_compute_Pnet_mosaic(maps, mapH, mapW);
+			}
+			else if (thread_num == 1 && !force_run_pnet_multithread)
+			{
+				pnet[0].TurnOffShowDebugInfo();
+				//pnet[0].TurnOnShowDebugInfo();
+				_compute_Pnet_single_thread(maps, mapH, mapW);
+			}
+			else
+			{
+				_compute_Pnet_multi_thread(maps, mapH, mapW);
+			}
+			ZQ_CNN_OrderScore order;
+			std::vector<std::vector<ZQ_CNN_BBox> > bounding_boxes(scales.size());
+			std::vector<std::vector<ZQ_CNN_OrderScore> > bounding_scores(scales.size());
+			const int block_size = 32;
+			int stride = pnet_stride;
+			int cellsize = pnet_size;
+			int border_size = cellsize / stride;
+			
+			for (int i = 0; i < maps.size(); i++)
+			{
+				double t13 = omp_get_wtime();
+				int changedH = (int)ceil(height*scales[i]);
+				int changedW = (int)ceil(width*scales[i]);
+				if (changedH < pnet_size || changedW < pnet_size)
+					continue;
+				float cur_scale_x = (float)width / changedW;
+				float cur_scale_y = (float)height / changedH;
+				
+				int count = 0;
+				//score p
+				int scoreH = mapH[i];
+				int scoreW = mapW[i];
+				const float *p = &maps[i][0];
+				if (scoreW <= block_size && scoreH < block_size)
+				{
+				
+					ZQ_CNN_BBox bbox;
 					ZQ_CNN_OrderScore order;
-					for (int i = 0; i < task_thirdBbox[pp].size(); i++)
+					for (int row = 0; row < scoreH; row++)
 					{
-						if (score_ptr[i*score_sliceStep + 1] > thresh[2])
+						for (int col = 0; col < scoreW; col++)
 						{
-							for (int j = 0; j < 4; j++)
-								task_thirdBbox[pp][i].regreCoord[j] = location_ptr[i*location_sliceStep + j];
-							if (keyPoint != 0)
+							if (*p > thresh[0])
 							{
-								for (int num = 0; num < 5; num++)
+								bbox.score = *p;
+								order.score = *p;
+								order.oriOrder = count;
+								bbox.row1 = stride*row;
+								bbox.col1 = stride*col;
+								bbox.row2 = stride*row + cellsize;
+								bbox.col2 = stride*col + cellsize;
+								bbox.exist = true;
+								bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+								bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
+									&& (col >= border_size && col < scoreW - border_size);
+								bounding_boxes[i].push_back(bbox);
+								bounding_scores[i].push_back(order);
+								count++;
+							}
+							p ++;
+						}
+					}
+					int before_count = bounding_boxes[i].size();
+					ZQ_CNN_BBoxUtils::_nms(bounding_boxes[i], bounding_scores[i], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
+					int after_count = bounding_boxes[i].size();
+					for (int j = 0; j < after_count; j++)
+					{
+						ZQ_CNN_BBox& bbox = bounding_boxes[i][j];
+						bbox.row1 = round(bbox.row1 *cur_scale_y);
+						bbox.col1 = round(bbox.col1 *cur_scale_x);
+						bbox.row2 = round(bbox.row2 *cur_scale_y);
+						bbox.col2 = round(bbox.col2 *cur_scale_x);
+						bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+					}
+					double t14 = omp_get_wtime();
+					if (show_debug_info)
+						printf("nms cost: %.3f ms, (%d-->%d)\n", 1000 * (t14 - t13), before_count, after_count);
+				}
+				else
+				{
+					int before_count = 0, after_count = 0;
+					int block_H_num = __max(1, scoreH / block_size);
+					int block_W_num = __max(1, scoreW / block_size);
+					int block_num = block_H_num*block_W_num;
+					int width_per_block = scoreW / block_W_num;
+					int height_per_block = scoreH / block_H_num;
+					std::vector<std::vector<ZQ_CNN_BBox> > tmp_bounding_boxes(block_num);
+					std::vector<std::vector<ZQ_CNN_OrderScore> > tmp_bounding_scores(block_num);
+					std::vector<int> block_start_w(block_num), block_end_w(block_num);
+					std::vector<int> block_start_h(block_num), block_end_h(block_num);
+					for (int bh = 0; bh < block_H_num; bh++)
+					{
+						for (int bw = 0; bw < block_W_num; bw++)
+						{
+							int bb = bh * block_W_num + bw;
+							block_start_w[bb] = (bw == 0) ? 0 : (bw*width_per_block - border_size);
+							block_end_w[bb] = (bw == block_num - 1) ? scoreW : ((bw + 1)*width_per_block);
+							block_start_h[bb] = (bh == 0) ? 0 : (bh*height_per_block - border_size);
+							block_end_h[bb] = (bh == block_num - 1) ? scoreH : ((bh + 1)*height_per_block);
+						}
+					}
+					int chunk_size = 1;// ceil((float)block_num / thread_num);
+					if (thread_num <= 1)
+					{
+						for (int bb = 0; bb < block_num; bb++)
+						{
+							ZQ_CNN_BBox bbox;
+							ZQ_CNN_OrderScore order;
+							int count = 0;
+							for (int row = block_start_h[bb]; row < block_end_h[bb]; row++)
+							{
+								p = &maps[i][0] + row*scoreW + block_start_w[bb];
+								for (int col = block_start_w[bb]; col < block_end_w[bb]; col++)
 								{
-									task_thirdBbox[pp][i].ppoint[num] = task_thirdBbox[pp][i].col1 +
-										(task_thirdBbox[pp][i].col2 - task_thirdBbox[pp][i].col1)*keyPoint_ptr[i*keyPoint_sliceStep + num];
-									task_thirdBbox[pp][i].ppoint[num + 5] = task_thirdBbox[pp][i].row1 +
-										(task_thirdBbox[pp][i].row2 - task_thirdBbox[pp][i].row1)*keyPoint_ptr[i*keyPoint_sliceStep + num + 5];
+									if (*p > thresh[0])
+									{
+										bbox.score = *p;
+										order.score = *p;
+										order.oriOrder = count;
+										bbox.row1 = stride*row;
+										bbox.col1 = stride*col;
+										bbox.row2 = stride*row + cellsize;
+										bbox.col2 = stride*col + cellsize;
+										bbox.exist = true;
+										bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
+											&& (col >= border_size && col < scoreW - border_size);
+										bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+										tmp_bounding_boxes[bb].push_back(bbox);
+										tmp_bounding_scores[bb].push_back(order);
+										count++;
+									}
+									p++;
+								}
+							}
+							int tmp_before_count = tmp_bounding_boxes[bb].size();
+							ZQ_CNN_BBoxUtils::_nms(tmp_bounding_boxes[bb], tmp_bounding_scores[bb], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
+							int tmp_after_count = tmp_bounding_boxes[bb].size();
+							before_count += tmp_before_count;
+							after_count += tmp_after_count;
+						}
+					}
+					else
+					{
+						std::atomic<int> all_before_count(0), all_after_count(0);
+						ZQ_CNN_ThreadPool::ParallelFor(block_num, thread_num, [&](int bb, int thread_id)
+						{
+							ZQ_CNN_BBox bbox;
+							ZQ_CNN_OrderScore order;
+							int count = 0;
+							for (int row = block_start_h[bb]; row < block_end_h[bb]; row++)
+							{
+								const float* p = &maps[i][0] + row*scoreW + block_start_w[bb];
+								for (int col = block_start_w[bb]; col < block_end_w[bb]; col++)
+								{
+									if (*p > thresh[0])
+									{
+										bbox.score = *p;
+										order.score = *p;
+										order.oriOrder = count;
+										bbox.row1 = stride*row;
+										bbox.col1 = stride*col;
+										bbox.row2 = stride*row + cellsize;
+										bbox.col2 = stride*col + cellsize;
+										bbox.exist = true;
+										bbox.need_check_overlap_count = (row >= border_size && row < scoreH - border_size)
+											&& (col >= border_size && col < scoreW - border_size);
+										bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
+										tmp_bounding_boxes[bb].push_back(bbox);
+										tmp_bounding_scores[bb].push_back(order);
+										count++;
+									}
+									p++;
 								}
 							}
-							task_thirdBbox[pp][i].area = task_src_rect_w[pp][i] * task_src_rect_h[pp][i];
-							task_thirdBbox[pp][i].score = score_ptr[i*score_sliceStep + 1];
-							task_count++;
-						}
-						else
-						{
-							task_thirdBbox[pp][i].exist = false;
-						}
+							int tmp_before_count = tmp_bounding_boxes[bb].size();
+							ZQ_CNN_BBoxUtils::_nms(tmp_bounding_boxes[bb], tmp_bounding_scores[bb], nms_thresh_per_scale, "Union", pnet_overlap_thresh_count);
+							int tmp_after_count = tmp_bounding_boxes[bb].size();
+							all_before_count += tmp_before_count;
+							all_after_count += tmp_after_count;
+						});
+						before_count = all_before_count;
+						after_count = all_after_count;
 					}
 
-					if (task_count < 1)
-					{
-						task_thirdBbox[pp].clear();
-						continue;
-					}
-					for (int i = task_thirdBbox[pp].size() - 1; i >= 0; i--)
-					{
-						if (!task_thirdBbox[pp][i].exist)
-							task_thirdBbox[pp].erase(task_thirdBbox[pp].begin() + i);
-					}
-				}
-			}
-			else
-			{
-#pragma omp parallel for num_threads(thread_num) schedule(dynamic,1)
-				for (int pp = 0; pp < need_thread_num; pp++)
-				{
-					int thread_id = omp_get_thread_num();
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_onet_images[pp], onet_size, onet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
-					{
-						continue;
-					}
-					double t31 = omp_get_wtime();
-					onet[thread_id].Forward(task_onet_images[pp]);
-					double t32 = omp_get_wtime();
-					const ZQ_CNN_Tensor4D* score = onet[thread_id].GetBlobByName("prob1");
-					const ZQ_CNN_Tensor4D* location = onet[thread_id].GetBlobByName("conv6-2");
-					const ZQ_CNN_Tensor4D* keyPoint = onet[thread_id].GetBlobByName("conv6-3");
-					const float* score_ptr = score->GetFirstPixelPtr();
-					const float* location_ptr = location->GetFirstPixelPtr();
-					const float* keyPoint_ptr = 0;
-					if (keyPoint != 0)
-						keyPoint_ptr = keyPoint->GetFirstPixelPtr();
-					int score_sliceStep = score->GetSliceStep();
-					int location_sliceStep = location->GetSliceStep();
-					int keyPoint_sliceStep = 0;
-					if (keyPoint != 0)
-						keyPoint_sliceStep = keyPoint->GetSliceStep();
-					int task_count = 0;
-					ZQ_CNN_OrderScore order;
-					for (int i = 0; i < task_thirdBbox[pp].size(); i++)
+					count = 0;
+					for (int bb = 0; bb < block_num; bb++)
 					{
-						if (score_ptr[i*score_sliceStep + 1] > thresh[2])
+						std::vector<ZQ_CNN_BBox>::iterator it = tmp_bounding_boxes[bb].begin();
+						for (; it != tmp_bounding_boxes[bb].end(); it++)
 						{
-							for (int j = 0; j < 4; j++)
-								task_thirdBbox[pp][i].regreCoord[j] = location_ptr[i*location_sliceStep + j];
-							if (keyPoint != 0)
+							if ((*it).exist)
 							{
-								for (int num = 0; num < 5; num++)
-								{
-									task_thirdBbox[pp][i].ppoint[num] = task_thirdBbox[pp][i].col1 +
-										(task_thirdBbox[pp][i].col2 - task_thirdBbox[pp][i].col1)*keyPoint_ptr[i*keyPoint_sliceStep + num];
-									task_thirdBbox[pp][i].ppoint[num + 5] = task_thirdBbox[pp][i].row1 +
-										(task_thirdBbox[pp][i].row2 - task_thirdBbox[pp][i].row1)*keyPoint_ptr[i*keyPoint_sliceStep + num + 5];
-								}
+								bounding_boxes[i].push_back(*it);
+								order.score = (*it).score;
+								order.oriOrder = count;
+								bounding_scores[i].push_back(order);
+								count++;
 							}
-							task_thirdBbox[pp][i].area = task_src_rect_w[pp][i] * task_src_rect_h[pp][i];
-							task_thirdBbox[pp][i].score = score_ptr[i*score_sliceStep + 1];
-							task_count++;
-						}
-						else
-						{
-							task_thirdBbox[pp][i].exist = false;
 						}
 					}
 
-					if (task_count < 1)
-					{
-						task_thirdBbox[pp].clear();
-						continue;
-					}
-					for (int i = task_thirdBbox[pp].size() - 1; i >= 0; i--)
+					//ZQ_CNN_BBoxUtils::_nms(bounding_boxes[i], bounding_scores[i], nms_thresh_per_scale, "Union", 0);
+					after_count = bounding_boxes[i].size();
+					for (int j = 0; j < after_count; j++)
 					{
-						if (!task_thirdBbox[pp][i].exist)
-							task_thirdBbox[pp].erase(task_thirdBbox[pp].begin() + i);
+						ZQ_CNN_BBox& bbox = bounding_boxes[i][j];
+						bbox.row1 = round(bbox.row1 *cur_scale_y);
+						bbox.col1 = round(bbox.col1 *cur_scale_x);
+						bbox.row2 = round(bbox.row2 *cur_scale_y);
+						bbox.col2 = round(bbox.col2 *cur_scale_x);
+						bbox.area = (bbox.row2 - bbox.row1)*(bbox.col2 - bbox.col1);
 					}
+					double t14 = omp_get_wtime();
+					if (show_debug_info)
+						printf("nms cost: %.3f ms, (%d-->%d)\n", 1000 * (t14 - t13), before_count, after_count);
 				}
+
 			}
 
+			std::vector<ZQ_CNN_OrderScore> firstOrderScore;
 			int count = 0;
-			for (int i = 0; i < need_thread_num; i++)
-			{
-				count += task_thirdBbox[i].size();
-			}
-			thirdBbox.resize(count);
-			thirdScore.resize(count);
-			int id = 0;
-			for (int i = 0; i < need_thread_num; i++)
+			for (int i = 0; i < scales.size(); i++)
 			{
-				for (int j = 0; j < task_thirdBbox[i].size(); j++)
+				std::vector<ZQ_CNN_BBox>::iterator it = bounding_boxes[i].begin();
+				for (; it != bounding_boxes[i].end(); it++)
 				{
-					thirdBbox[id] = task_thirdBbox[i][j];
-					thirdScore[id].score = task_thirdBbox[i][j].score;
-					thirdScore[id].oriOrder = id;
-					id++;
+					if ((*it).exist)
+					{
+						firstBbox.push_back(*it);
+						order.score = (*it).score;
+						order.oriOrder = count;
+						firstOrderScore.push_back(order);
+						count++;
+					}
 				}
 			}
-			ZQ_CNN_OrderScore order;
-			for (int i = 0; i < early_accept_thirdBbox.size(); i++)
-			{
-				order.score = early_accept_thirdBbox[i].score;
-				order.oriOrder = count++;
-				thirdScore.push_back(order);
-				thirdBbox.push_back(early_accept_thirdBbox[i]);
-			}
-			ZQ_CNN_BBoxUtils::_refine_and_square_bbox(thirdBbox, width, height, false);
-			ZQ_CNN_BBoxUtils::_nms(thirdBbox, thirdScore, nms_thresh[2], "Min");
-			double t5 = omp_get_wtime();
+
+
+			//the first stage's nms
+			if (count < 1) return false;
+			double t15 = omp_get_wtime();
+			ZQ_CNN_BBoxUtils::_nms(firstBbox, firstOrderScore, nms_thresh[0], "Union", 0, 1);
+			ZQ_CNN_BBoxUtils::_refine_and_square_bbox(firstBbox, width, height,true);
+			double t16 = omp_get_wtime();
+			if (show_debug_info)
+				printf("nms cost: %.3f ms\n", 1000 * (t16 - t15));
 			if (show_debug_info)
-				printf("run Onet [%d] times, candidate before nms: %d \n", o_count, count);
+				printf("first stage candidate count: %d\n", count);
+			double t3 = omp_get_wtime();
 			if (show_debug_info)
-				printf("stage 3: cost %.3f ms\n", 1000 * (t5 - t4));
+				printf("stage 1: cost %.3f ms\n", 1000 * (t3 - t2));
+			return true;
+		}
 
+		/*the stages of Find run the ones of FindBatch on the image given to Find alone*/
+		bool _Rnet_stage(std::vector<ZQ_CNN_BBox>& firstBbox, std::vector<ZQ_CNN_BBox>& secondBbox)
+		{
+			std::vector<const ZQ_CNN_Tensor4D*> images(1, (const ZQ_CNN_Tensor4D*)0);
+			std::vector<std::vector<ZQ_CNN_BBox> > boxes(1, firstBbox);
+			secondBbox.clear();
+			if (!_Rnet_stage_batch(images, boxes))
+				return false;
+			secondBbox.swap(boxes[0]);
 			return true;
 		}
 
+		bool _Onet_stage(std::vector<ZQ_CNN_BBox>& secondBbox, std::vector<ZQ_CNN_BBox>& thirdBbox)
+		{
+			std::vector<const ZQ_CNN_Tensor4D*> images(1, (const ZQ_CNN_Tensor4D*)0);
+			std::vector<std::vector<ZQ_CNN_BBox> > boxes(1, secondBbox);
+			thirdBbox.clear();
+			if (!_Onet_stage_batch(images, boxes))
+				return false;
+			thirdBbox.swap(boxes[0]);
+			return true;
+		}
 
 		bool _Lnet_stage(std::vector<ZQ_CNN_BBox>& thirdBbox, std::vector<ZQ_CNN_BBox>& fourthBbox)
 		{
-			double t4 = omp_get_wtime();
+			std::vector<const ZQ_CNN_Tensor4D*> images(1, (const ZQ_CNN_Tensor4D*)0);
+			std::vector<std::vector<ZQ_CNN_BBox> > boxes(1, thirdBbox);
 			fourthBbox.clear();
-			std::vector<ZQ_CNN_BBox>::iterator it = thirdBbox.begin();
-			std::vector<int> src_off_x, src_off_y, src_rect_w, src_rect_h;
-			int l_count = 0;
-			for (; it != thirdBbox.end(); it++)
-			{
-				if ((*it).exist)
-				{
-					int off_x = it->col1;
-					int off_y = it->row1;
-					int rect_w = it->col2 - off_x;
-					int rect_h = it->row2 - off_y;
-					if (/*off_x < 0 || off_x + rect_w > width || off_y < 0 || off_y + rect_h > height ||*/ rect_w <= 0.5*min_size || rect_h <= 0.5*min_size)
-					{
-						(*it).exist = false;
-						continue;
-					}
-					else
-					{
-						l_count++;
-						fourthBbox.push_back(*it);
-					}
-				}
-			}
-			std::vector<ZQ_CNN_BBox> copy_fourthBbox = fourthBbox;
-			ZQ_CNN_BBoxUtils::_square_bbox(copy_fourthBbox, width, height);
-			for (it = copy_fourthBbox.begin(); it != copy_fourthBbox.end(); ++it)
-			{
-				int off_x = it->col1;
-				int off_y = it->row1;
-				int rect_w = it->col2 - off_x;
-				int rect_h = it->row2 - off_y;
-				src_off_x.push_back(off_x);
-				src_off_y.push_back(off_y);
-				src_rect_w.push_back(rect_w);
-				src_rect_h.push_back(rect_h);
-			}
-
-			int batch_size = BATCH_SIZE;
-			int per_num = ceil((float)l_count / thread_num);
-			int need_thread_num = thread_num;
-			if (per_num > batch_size)
-			{
-				need_thread_num = ceil((float)l_count / batch_size);
-				per_num = batch_size;
-			}
-
-			std::vector<ZQ_CNN_Tensor4D_NHW_C_Align128bit> task_lnet_images(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_x(need_thread_num);
-			std::vector<std::vector<int> > task_src_off_y(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_w(need_thread_num);
-			std::vector<std::vector<int> > task_src_rect_h(need_thread_num);
-			std::vector<std::vector<ZQ_CNN_BBox> > task_fourthBbox(need_thread_num);
-			
-			for (int i = 0; i < need_thread_num; i++)
-			{
-				int st_id = per_num*i;
-				int end_id = __min(l_count, per_num*(i + 1));
-				int cur_num = end_id - st_id;
-				if (cur_num > 0)
-				{
-					task_src_off_x[i].resize(cur_num);
-					task_src_off_y[i].resize(cur_num);
-					task_src_rect_w[i].resize(cur_num);
-					task_src_rect_h[i].resize(cur_num);
-					task_fourthBbox[i].resize(cur_num);
-					for (int j = 0; j < cur_num; j++)
-					{
-						task_src_off_x[i][j] = src_off_x[st_id + j];
-						task_src_off_y[i][j] = src_off_y[st_id + j];
-						task_src_rect_w[i][j] = src_rect_w[st_id + j];
-						task_src_rect_h[i][j] = src_rect_h[st_id + j];
-						task_fourthBbox[i][j] = copy_fourthBbox[st_id + j];
-					}
-				}
-			}
-
-			if (thread_num <= 1)
-			{
-				for (int pp = 0; pp < need_thread_num; pp++)
-				{
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_lnet_images[pp], lnet_size, lnet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
-					{
-						continue;
-					}
-					double t31 = omp_get_wtime();
-					lnet[0].Forward(task_lnet_images[pp]);
-					double t32 = omp_get_wtime();
-					const ZQ_CNN_Tensor4D* keyPoint = lnet[0].GetBlobByName("conv6-3");
-					const float* keyPoint_ptr = keyPoint->GetFirstPixelPtr();
-					int keyPoint_sliceStep = keyPoint->GetSliceStep();
-					for (int i = 0; i < task_fourthBbox[pp].size(); i++)
-					{
-						for (int num = 0; num < 5; num++)
-						{
-							task_fourthBbox[pp][i].ppoint[num] = task_fourthBbox[pp][i].col1 +
-								(task_fourthBbox[pp][i].col2 - task_fourthBbox[pp][i].col1)*keyPoint_ptr[i*keyPoint_sliceStep + num];
-							task_fourthBbox[pp][i].ppoint[num + 5] = task_fourthBbox[pp][i].row1 +
-								(task_fourthBbox[pp][i].row2 - task_fourthBbox[pp][i].row1)*keyPoint_ptr[i*keyPoint_sliceStep + num + 5];
-						}
-					}
-				}
-			}
-			else
-			{
-#pragma omp parallel for num_threads(thread_num) schedule(dynamic,1)
-				for (int pp = 0; pp < need_thread_num; pp++)
-				{
-					int thread_id = omp_get_thread_num();
-					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_lnet_images[pp], lnet_size, lnet_size, 0, 0,
-						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
-					{
-						continue;
-					}
-					double t31 = omp_get_wtime();
-					lnet[thread_id].Forward(task_lnet_images[pp]);
-					double t32 = omp_get_wtime();
-					const ZQ_CNN_Tensor4D* keyPoint = lnet[thread_id].GetBlobByName("conv6-3");
-					const float* keyPoint_ptr = keyPoint->GetFirstPixelPtr();
-					int keyPoint_sliceStep = keyPoint->GetSliceStep();
-					for (int i = 0; i < task_fourthBbox[pp].size(); i++)
-					{
-						for (int num = 0; num < 5; num++)
-						{
-							task_fourthBbox[pp][i].ppoint[num] = task_fourthBbox[pp][i].col1 +
-								(task_fourthBbox[pp][i].col2 - task_fourthBbox[pp][i].col1)*keyPoint_ptr[i*keyPoint_sliceStep + num];
-							task_fourthBbox[pp][i].ppoint[num + 5] = task_fourthBbox[pp][i].row1 +
-								(task_fourthBbox[pp][i].row2 - task_fourthBbox[pp][i].row1)*keyPoint_ptr[i*keyPoint_sliceStep + num + 5];
-						}
-					}
-				}
-			}
-
-			int count = 0;
-			for (int i = 0; i < need_thread_num; i++)
-			{
-				count += task_fourthBbox[i].size();
-			}
-			fourthBbox.resize(count);
-			int id = 0;
-			for (int i = 0; i < need_thread_num; i++)
-			{
-				for (int j = 0; j < task_fourthBbox[i].size(); j++)
-				{
-					memcpy(fourthBbox[id].ppoint, task_fourthBbox[i][j].ppoint, sizeof(float) * 10);
-					id++;
-				}
-			}
-			double t5 = omp_get_wtime();
-			if (show_debug_info)
-				printf("run Lnet [%d] times \n", l_count);
-			if (show_debug_info)
-				printf("stage 4: cost %.3f ms\n", 1000 * (t5 - t4));
-
+			if (!_Lnet_stage_batch(images, boxes))
+				return false;
+			fourthBbox.swap(boxes[0]);
 			return true;
-
 		}
 
 
@@ -1649,7 +1852,7 @@ namespace ZQ
 				{
 					if (task_src_off_x[pp].size() == 0)
 						continue;
-					if (!input.ResizeBilinearRect(task_lnet_images[pp], lnet_size, lnet_size, 0, 0,
+					if (!_crop_rects(task_lnet_images[pp], lnet_size,
 						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
 					{
 						continue;
@@ -1675,16 +1878,14 @@ namespace ZQ
 			}
 			else
 			{
-#pragma omp parallel for num_threads(thread_num)
-				for (int pp = 0; pp < need_thread_num; pp++)
+				ZQ_CNN_ThreadPool::ParallelFor(need_thread_num, thread_num, [&](int pp, int thread_id)
 				{
-					int thread_id = omp_get_thread_num();
 					if (task_src_off_x.size() == 0)
-						continue;
-					if (!input.ResizeBilinearRect(task_lnet_images[pp], lnet_size, lnet_size, 0, 0,
+						return;
+					if (!_crop_rects(task_lnet_images[pp], lnet_size,
 						task_src_off_x[pp], task_src_off_y[pp], task_src_rect_w[pp], task_src_rect_h[pp]))
 					{
-						continue;
+						return;
 					}
 					double t31 = omp_get_wtime();
 					lnet[thread_id].Forward(task_lnet_images[pp]);
@@ -1703,7 +1904,7 @@ namespace ZQ
 								(task_fourthBbox[pp][i].row2 - task_fourthBbox[pp][i].row1)*keyPoint_ptr[i*keyPoint_sliceStep + num * 2 + 1];
 						}
 					}
-				}
+				});
 			}
 			int count = 0;
 			for (int i = 0; i < need_thread_num; i++)
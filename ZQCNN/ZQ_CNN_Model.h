@@ -0,0 +1,118 @@
+#ifndef _ZQ_CNN_MODEL_H_
+#define _ZQ_CNN_MODEL_H_
+#pragma once
+#include "ZQ_CNN_Net.h"
+namespace ZQ
+{
+	/*read-only weights and structure of a net, it should not be changed after loading,
+	any number of ZQ_CNN_ExecContext can share one model*/
+	class ZQ_CNN_Model
+	{
+		friend class ZQ_CNN_ExecContext;
+	public:
+		ZQ_CNN_Model() {}
+		~ZQ_CNN_Model() {}
+
+		bool LoadFrom(const std::string& param_file, const std::string& model_file, bool merge_bn = false, float ignore_small_value = 1e-12,
+			bool merge_prelu = false, const std::string& int8_model_file = "")
+		{
+			return net.LoadFrom(param_file, model_file, merge_bn, ignore_small_value, merge_prelu, int8_model_file);
+		}
+
+		bool LoadFromBuffer(const char*& param_buffer, __int64 param_buffer_len, const char*& model_buffer, __int64 model_buffer_len,
+			bool merge_bn = false, float ignore_small_value = 1e-12, bool merge_prelu = false)
+		{
+			return net.LoadFromBuffer(param_buffer, param_buffer_len, model_buffer, model_buffer_len, merge_bn, ignore_small_value, merge_prelu);
+		}
+
+		bool SwapInputRGBandBGR(const std::vector<std::string>& layer_names)
+		{
+			return net.SwapInputRGBandBGR(layer_names);
+		}
+
+		/*remove the layers that the blobs output_names do not depend on, call it before any context is initialized*/
+		bool PruneLayers(const std::vector<std::string>& output_names)
+		{
+			return net.PruneLayers(output_names);
+		}
+
+		bool SaveModel(const std::string& file) const
+		{
+			return net.SaveModel(file);
+		}
+
+		void GetInputDim(int& in_C, int& in_H, int& in_W) const { net.GetInputDim(in_C, in_H, in_W); }
+
+		__int64 GetNumOfMulAdd() const { return net.GetNumOfMulAdd(); }
+
+		bool HasPadding() const { return net.HasPadding(); }
+
+	private:
+		ZQ_CNN_Net net;
+	};
+
+	/*blobs and buffer of one thread running a shared ZQ_CNN_Model,
+	different contexts can call Forward at the same time*/
+	class ZQ_CNN_ExecContext
+	{
+	public:
+		ZQ_CNN_ExecContext() {}
+		~ZQ_CNN_ExecContext() {}
+
+		/*the model must be loaded before, and should live longer than this context*/
+		bool Init(const ZQ_CNN_Model& model)
+		{
+			return net._share_model_from(model.net);
+		}
+
+		void TurnOnShowDebugInfo() { net.TurnOnShowDebugInfo(); }
+		void TurnOffShowDebugInfo() { net.TurnOffShowDebugInfo(); }
+		void TurnOnUseBuffer() { net.TurnOnUseBuffer(); }
+		void TurnOffUseBuffer() { net.TurnOffUseBuffer(); }
+		void TurnOnWinograd() { net.TurnOnWinograd(); }
+		void TurnOffWinograd() { net.TurnOffWinograd(); }
+		void TurnOnInt8() { net.TurnOnInt8(); }
+		void TurnOffInt8() { net.TurnOffInt8(); }
+		void SetNumThreads(int num) { net.SetNumThreads(num); }
+		int GetNumThreads() const { return net.GetNumThreads(); }
+		void TurnOnMemoryPlan() { net.TurnOnMemoryPlan(); }
+		void TurnOffMemoryPlan() { net.TurnOffMemoryPlan(); }
+		void TurnOnBandEpilogue() { net.TurnOnBandEpilogue(); }
+		void TurnOffBandEpilogue() { net.TurnOffBandEpilogue(); }
+		void TurnOnDAGSchedule() { net.TurnOnDAGSchedule(); }
+		void TurnOffDAGSchedule() { net.TurnOffDAGSchedule(); }
+		void GetBlobMemoryCost(__int64& planned_bytes, __int64& naive_bytes) const { net.GetBlobMemoryCost(planned_bytes, naive_bytes); }
+		void GetInputDim(int& in_C, int& in_H, int& in_W) const { net.GetInputDim(in_C, in_H, in_W); }
+		__int64 GetNumOfMulAdd() const { return net.GetNumOfMulAdd(); }
+		float GetLastTimeOfLayerType(const std::string& layer_typename) const { return net.GetLastTimeOfLayerType(layer_typename); }
+
+		bool TuneGemm(const std::string& cache_file, int in_H = 0, int in_W = 0) { return net.TuneGemm(cache_file, in_H, in_W); }
+
+		/*it may change input in case of padding, but the data will not be lost*/
+		bool Forward(ZQ_CNN_Tensor4D& input)
+		{
+			return net.Forward(input);
+		}
+
+		/*only run the layers that the blobs wanted_outputs depend on*/
+		bool Forward(ZQ_CNN_Tensor4D& input, const std::vector<std::string>& wanted_outputs)
+		{
+			return net.Forward(input, wanted_outputs);
+		}
+
+		bool Forward(ZQ_CNN_Tensor4D& input, const std::string& start_layer_name, const std::string& end_layer_name)
+		{
+			return net.Forward(input, start_layer_name, end_layer_name);
+		}
+
+		const ZQ_CNN_Tensor4D* GetBlobByName(std::string name)
+		{
+			return net.GetBlobByName(name);
+		}
+
+	private:
+		ZQ_CNN_Net net;
+	};
+}
+
+#endif
@@ -2,15 +2,21 @@
 #define _ZQ_CNN_NET_H_
 #pragma once
 #include "ZQ_CNN_Layer.h"
+#include "ZQ_CNN_CPUInfo.h"
+#include "ZQ_CNN_GemmTuner.h"
+#include "ZQ_CNN_ThreadPool.h"
 #include <map>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <functional>
 namespace ZQ
 {
 	class ZQ_CNN_Net
 	{
+		friend class ZQ_CNN_ExecContext;
 	protected:
 		class Buffer
 		{
@@ -23,10 +29,25 @@ namespace ZQ
 			void Release() { if (data) _aligned_free(data); data = 0; len = 0; }
 		};
 
+		/*what _plan_memory makes for one input shape*/
+		class CachedPlan
+		{
+		public:
+			std::vector<int> blob_shapes;	//N,C,H,W of each blob
+			std::vector<__int64> blob_plan_offset;
+			std::vector<__int64> blob_plan_len;
+			std::vector<int> blob_concat_offset;
+			std::vector<bool> blob_reshape_planned;
+			__int64 planned_blob_bytes, naive_blob_bytes;
+		};
+
 	public:
-		ZQ_CNN_Net() :has_input_layer(false),show_debug_info(false),use_buffer(true),
-			has_innerproduct_layer(false), ignore_small_value(0) {}
-		~ZQ_CNN_Net() { _clear(); };
+		ZQ_CNN_Net() :has_input_layer(false),show_debug_info(false),use_buffer(true),use_winograd(true),use_int8(true),
+			ignore_small_value(0), has_innerproduct_layer(false), use_memory_plan(false), 
+			plan_N(-1), plan_C(-1), plan_H(-1), plan_W(-1), planned_blob_bytes(0), naive_blob_bytes(0),
+			use_epilogue(true), use_dag_schedule(false), step_use_dag(false),
+			num_threads(1), _buffer_data(1, (void*)0), _buffer_len(1, 0) {}
+		~ZQ_CNN_Net() { _clear(); _release_buffers(); };
 
 	private:
 		std::vector<ZQ_CNN_Layer*> layers;
@@ -41,20 +62,121 @@ namespace ZQ
 		bool has_input_layer;
 		bool show_debug_info;
 		bool use_buffer;
+		bool use_winograd;
+		bool use_int8;
 		float ignore_small_value;
-		Buffer _buffer;
 		bool has_innerproduct_layer;
 		int input_C, input_H, input_W;
+
+		/*memory plan: blobs whose lifetimes do not overlap share the same interval of _blob_memory*/
+		bool use_memory_plan;
+		Buffer _blob_memory;
+		std::vector<int> blob_first_layer;	//the step (see layer_step) that produces the blob, -1 for unused blobs
+		std::vector<int> blob_last_layer;	//the last step that uses the blob, layers.size() for output blobs
+		std::vector<__int64> blob_plan_offset;
+		std::vector<__int64> blob_plan_len;
+		int plan_N, plan_C, plan_H, plan_W;
+		__int64 planned_blob_bytes, naive_blob_bytes;
+		std::vector<int> plan_wanted_blobs;	//the lifetimes are for the layers needed by these blobs, all layers if it is empty
+		std::vector<int> plan_layer_step;	//the lifetimes are for these steps
+		/*plans of the input shapes (N,C,H,W) used before, so a Forward at a known shape neither sets up the layers
+		nor plans again, cleared when the lifetimes change*/
+		std::map<std::vector<int>, CachedPlan> plan_cache;
+
+		/*partial forward: forward_needed_layers are the layers needed by forward_wanted_blobs*/
+		std::vector<int> forward_wanted_blobs;
+		std::vector<bool> forward_needed_layers;
+
+		/*zero-copy concat: the producer of blob i writes into the channels [blob_concat_offset[i], +C) of the top of 
+		a channel concat (blob blob_concat_top[i]), so the concat copies nothing. blob_concat_top is found at load, 
+		blob_concat_offset is -1 if it cannot be done for the planned input shape (the channels must keep the alignment)*/
+		std::vector<int> blob_concat_top;
+		std::vector<int> blob_concat_offset;
+
+		/*zero-copy reshape: blob i is a Reshape, Flatten or Permute of blob blob_reshape_source[i] (found at load) and uses 
+		its memory if blob_reshape_planned[i] (the data order must be kept for the planned input shape)*/
+		std::vector<int> blob_reshape_source;
+		std::vector<bool> blob_reshape_planned;
+
+		/*border-aware allocation: blob i always has a border of at least blob_border_W[i] and blob_border_H[i] (the largest pads 
+		of the convolution and depthwise convolution layers using it), so padding it copies nothing and zeros the border once*/
+		std::vector<int> blob_border_W;
+		std::vector<int> blob_border_H;
+
+		/*band epilogue: layer i is folded into the epilogue of layer layer_fused_into[i] (-1 if not). In a Forward, layer i is 
+		skipped if forward_fused_into[i] is not -1, and the top 0 of layer i is forward_epilogue_top[i]*/
+		bool use_epilogue;
+		std::vector<int> layer_fused_into;
+		std::vector<int> forward_fused_into;
+		std::vector<int> forward_epilogue_top;
+
+		/*dag schedule: layer i runs at step layer_step[i] (i if the layers run one by one), the layers step_layers[s] of 
+		one step do not depend on each other and run at the same time. layer_step is made for step_use_dag and forward_fused_into*/
+		bool use_dag_schedule;
+		std::vector<int> layer_step;
+		std::vector<std::vector<int> > step_layers;
+		bool step_use_dag;
+
+		/*each thread has its own buffer*/
+		int num_threads;
+		std::vector<void*> _buffer_data;
+		std::vector<__int64> _buffer_len;
 	public:
 		void TurnOnShowDebugInfo() { show_debug_info = true; }
 		void TurnOffShowDebugInfo() { show_debug_info = false; }
 		void TurnOnUseBuffer() { use_buffer = true; }
 		void TurnOffUseBuffer() { use_buffer = false; }
+		void TurnOnWinograd() { use_winograd = true; }
+		void TurnOffWinograd() { use_winograd = false; }
+		/*layers with int8_scale (given in the param file or by CalibrateInt8) run in int8, turn it off to run all in float*/
+		void TurnOnInt8() { use_int8 = true; }
+		void TurnOffInt8() { use_int8 = false; }
+		/*split the work of convolution, depthwise convolution and inner product layers across num threads*/
+		void SetNumThreads(int num)
+		{
+			num = __max(1, num);
+			for (int i = num; i < _buffer_data.size(); i++)
+			{
+				if (_buffer_data[i])
+					_aligned_free(_buffer_data[i]);
+			}
+			_buffer_data.resize(num, (void*)0);
+			_buffer_len.resize(num, 0);
+			num_threads = num;
+		}
+		int GetNumThreads() const { return num_threads; }
+		/*with memory plan on, only the output blobs (not used by any later layer) and the wanted outputs of
+		Forward(input, wanted_outputs) are kept after Forward. It is off by default, so every blob can be read by GetBlobByName,
+		turn it on if only those outputs are read*/
+		void TurnOnMemoryPlan() { use_memory_plan = true; }
+		void TurnOffMemoryPlan() { use_memory_plan = false; _unbind_memory_plan(); }
+		/*do the relu, prelu, batchnorm, scale, scalar operation and eltwise sum layers after a convolution or depthwise
+		convolution in its epilogue: the convolution computes its output in bands of rows (ZQ_CNN_EPILOGUE_TILE_BYTES) and
+		runs these layers over each band while it is still in cache, instead of over the whole output after it. Turn it off
+		to run them as separate layers. A layer not in place (e.g. the eltwise sum of a residual) is only done so if its
+		bottom is not kept after Forward (see TurnOnMemoryPlan)*/
+		void TurnOnBandEpilogue() { use_epilogue = true; }
+		void TurnOffBandEpilogue() { use_epilogue = false; }
+		/*run the independent layers (e.g. the heads of SSD) at the same time if num_threads > 1, 
+		a layer doing most of the work of its step still uses all threads*/
+		void TurnOnDAGSchedule() { use_dag_schedule = true; }
+		void TurnOffDAGSchedule() { use_dag_schedule = false; }
+		/*bytes of all blobs (except the input) for the latest planned input shape, 
+		planned_bytes is the size of the shared memory, naive_bytes is the sum of all blobs*/
+		void GetBlobMemoryCost(__int64& planned_bytes, __int64& naive_bytes) const 
+		{
+			planned_bytes = planned_blob_bytes; 
+			naive_bytes = naive_blob_bytes; 
+		}
 		void GetInputDim(int& in_C, int& in_H, int& in_W)const { in_C = input_C; in_H = input_H; in_W = input_W; }
+		/*int8_model_file (if not empty) is saved by SaveInt8Param with the same param file, model file and merging,
+		the int8 weights of it are used directly instead of quantizing the float weights again*/
 		bool LoadFrom(const std::string& param_file, const std::string& model_file, bool merge_bn = false, float ignore_small_value = 1e-12,
-			bool merge_prelu = false)
+			bool merge_prelu = false, const std::string& int8_model_file = "")
 		{
 			_clear();
+			if (!_check_cpu())
+				return false;
 			this->ignore_small_value = ignore_small_value;
 			if (!_load_param_file(param_file))
 			{
@@ -84,6 +206,19 @@ namespace ZQ
 				if (!_merge_prelu())
 					return false;
 			}
+			if (int8_model_file != "" && !_load_int8_model_file(int8_model_file))
+			{
+				_clear();
+				return false;
+			}
+			_prepack();
+			_fold_into_epilogue();
+			_find_blob_borders();
+			_find_concat_views();
+			_find_reshape_views();
+			_update_forward_epilogue(std::vector<int>());
+			_compute_blob_lifetime();
+			_plan_memory(1, input_C, input_H, input_W);
 			return true;
 		}
 
@@ -94,13 +229,100 @@ namespace ZQ
 
 		bool SwapInputRGBandBGR(const std::vector<std::string>& layer_names)
 		{
-			return _swap_input_RGB_and_BGR(layer_names);
+			if (!_swap_input_RGB_and_BGR(layer_names))
+				return false;
+			_prepack();
+			return true;
+		}
+
+		/*remove the layers that the blobs output_names do not depend on, call it after loading,
+		the other blobs are not computed any more*/
+		bool PruneLayers(const std::vector<std::string>& output_names)
+		{
+			std::vector<int> wanted_blobs;
+			if (layers.size() == 0 || !_find_blobs(output_names, wanted_blobs))
+				return false;
+			std::vector<bool> needed;
+			_find_needed_layers(wanted_blobs, needed);
+			int layer_num = layers.size(), kept_num = 0;
+			/*a layer only keeps the epilogue of the layers folded into it before the first pruned one, and the residuals of it*/
+			for (int i = 0; i < layer_num; i++)
+			{
+				if (!needed[i] || layers[i]->fused_ops.size() == 0)
+					continue;
+				int op_num = 0;
+				bool is_pruned = false;
+				for (int j = i + 1; j < layer_num; j++)
+				{
+					if (layer_fused_into[j] != i)
+						continue;
+					is_pruned = is_pruned || !needed[j];
+					if (is_pruned)
+						layer_fused_into[j] = -1;
+					else
+						op_num++;
+				}
+				if (op_num == layers[i]->fused_ops.size())
+					continue;
+				layers[i]->fused_ops.resize(op_num);
+				int residual_num = 0;
+				for (int k = 0; k < op_num; k++)
+				{
+					if (layers[i]->fused_ops[k].type == ZQ_CNN_Forward_SSEUtils::EpilogueOp::ELTWISE_SUM)
+						residual_num++;
+				}
+				bottoms[i].resize(1 + residual_num);
+			}
+			_find_needed_layers(wanted_blobs, needed);
+			std::vector<int> new_idx(layer_num, -1);
+			for (int i = 0; i < layer_num; i++)
+			{
+				if (!needed[i])
+				{
+					if (show_debug_info)
+						printf("prune layer %s\n", layers[i]->name.c_str());
+					delete layers[i];
+					continue;
+				}
+				new_idx[i] = kept_num;
+				layers[kept_num] = layers[i];
+				layer_type_names[kept_num] = layer_type_names[i];
+				bottoms[kept_num] = bottoms[i];
+				tops[kept_num] = tops[i];
+				layer_fused_into[kept_num] = layer_fused_into[i] < 0 ? -1 : new_idx[layer_fused_into[i]];
+				kept_num++;
+			}
+			layers.resize(kept_num);
+			layer_type_names.resize(kept_num);
+			bottoms.resize(kept_num);
+			tops.resize(kept_num);
+			layer_fused_into.resize(kept_num);
+			map_name_to_layer_idx.clear();
+			has_innerproduct_layer = false;
+			for (int i = 0; i < kept_num; i++)
+			{
+				map_name_to_layer_idx[layers[i]->name] = i;
+				if (ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "InnerProduct") == 0)
+					has_innerproduct_layer = true;
+			}
+			forward_wanted_blobs.clear();
+			forward_needed_layers.clear();
+			layer_step.clear();
+			_find_blob_borders();
+			_find_concat_views();
+			_find_reshape_views();
+			_update_forward_epilogue(std::vector<int>());
+			_compute_blob_lifetime();
+			_plan_memory(1, input_C, input_H, input_W);
+			return true;
 		}
 
 		bool LoadFromBuffer(const char*& param_buffer, __int64 param_buffer_len, const char*& model_buffer, __int64 model_buffer_len, 
 			bool merge_bn = false, float ignore_small_value = 1e-12, bool merge_prelu = false)
 		{
 			_clear();
+			if (!_check_cpu())
+				return false;
 			this->ignore_small_value = ignore_small_value;
 			if (!_load_param_from_buffer(param_buffer, param_buffer_len))
 			{
@@ -130,6 +352,14 @@ namespace ZQ
 				if (!_merge_prelu())
 					return false;
 			}
+			_prepack();
+			_fold_into_epilogue();
+			_find_blob_borders();
+			_find_concat_views();
+			_find_reshape_views();
+			_update_forward_epilogue(std::vector<int>());
+			_compute_blob_lifetime();
+			_plan_memory(1, input_C, input_H, input_W);
 			return true;
 		}
 
@@ -141,6 +371,17 @@ namespace ZQ
 			return sum;
 		}
 
+		/*some layer reads the pixels around its bottom, so the outputs near the borders depend on the padding*/
+		bool HasPadding() const
+		{
+			for (int i = 0; i < layers.size(); i++)
+			{
+				if (layers[i]->HasPadding())
+					return true;
+			}
+			return false;
+		}
+
 		__int64 GetNumOfMulAddConv() const
 		{
 			__int64 sum = 0;
@@ -175,55 +416,213 @@ namespace ZQ
 		}
 
 
-		/*it may change input in case of padding, but the data will not be lost*/
-		bool Forward(ZQ_CNN_Tensor4D& input)
+		/*run the net once on a zero input of in_H x in_W (the model size if not given) to find its gemm shapes,
+		then tune the shapes not found in cache_file and save them back. The tuned kernels are used by
+		all nets in the process*/
+		bool TuneGemm(const std::string& cache_file, int in_H = 0, int in_W = 0)
 		{
-			if (map_name_to_blob_idx.size() == 0 || map_name_to_layer_idx.size() == 0 || tops.size() == 0)
+			if (layers.size() == 0)
 				return false;
-			if (has_innerproduct_layer)
+			in_H = in_H > 0 ? in_H : input_H;
+			in_W = in_W > 0 ? in_W : input_W;
+			if (in_H <= 0 || in_W <= 0)
 			{
-				if (input.GetH() != input_H || input.GetW() != input_W || input.GetC() != input_C)
+				std::cout << "TuneGemm needs the input size\n";
+				return false;
+			}
+			bool loaded = ZQ_CNN_GemmTuner::LoadCache(cache_file);
+			ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
+			if (!input.ChangeSize(1, in_H, in_W, input_C, 1, 1))
+				return false;
+			input.Reset();
+			std::vector<ZQ_CNN_GemmTuner::Shape> shapes;
+			ZQ_CNN_GemmTuner::StartRecording();
+			bool ret = Forward(input);
+			ZQ_CNN_GemmTuner::StopRecording(shapes);
+			if (!ret)
+				return false;
+			int tuned = ZQ_CNN_GemmTuner::Tune(shapes, show_debug_info);
+			if (tuned > 0 || !loaded)
+				return ZQ_CNN_GemmTuner::SaveCache(cache_file);
+			return true;
+		}
+
+		/*run the net in float over samples and record the per-channel range of the input of each convolution,
+		depthwise convolution and inner product layer (saved to range_file as "layer_name C min0 max0 min1 max1 ..."
+		if it is not empty), then quantize these layers to int8. The input channel c of depthwise convolution gets
+		int8_scale[c] = 127/max_c (max_c = max(|range of c|)), the other layers get 127/(max_c^a * max^(1-a)) (max is of all channels),
+		where a in {0, 0.5, 1} gives the closest int8 output to float (a > 0 makes the weights of small channels larger).
+		A layer whose int8 output has a cosine similarity to its float output (on the same input) less than min_similarity stays in float*/
+		bool CalibrateInt8(const std::vector<ZQ_CNN_Tensor4D*>& samples, const std::string& range_file = "", float min_similarity = 0.99f)
+		{
+			if (layers.size() == 0 || samples.size() == 0)
+				return false;
+			int layer_num = layers.size();
+			std::vector<std::vector<float> > min_vals(layer_num), max_vals(layer_num);
+			bool old_use_int8 = use_int8;
+			bool ret = true;
+			use_int8 = false;
+			for (int s = 0; s < samples.size() && ret; s++)
+			{
+				if (samples[s] == 0)
+					continue;
+				for (int i = 0; i < layer_num && ret; i++)
 				{
-					std::cout << "The dimenson doesnot match with the needed\n";
+					if (_is_int8_layer(i))
+					{
+						const ZQ_CNN_Tensor4D* in = bottoms[i][0] == 0 ? samples[s] : blobs[bottoms[i][0]];
+						if (in == 0)
+							ret = false;
+						else
+							_update_range(*in, min_vals[i], max_vals[i]);
+					}
+					if (ret)
+						ret = Forward(*samples[s], layers[i]->name, layers[i]->name);
+				}
+			}
+			use_int8 = old_use_int8;
+			if (!ret)
+				return false;
+
+			if (range_file != "")
+			{
+				std::ofstream out(range_file.c_str());
+				if (!out.is_open())
+				{
+					std::cout << "failed to open " << range_file << "\n";
 					return false;
 				}
+				for (int i = 0; i < layer_num; i++)
+				{
+					if (min_vals[i].size() == 0)
+						continue;
+					out << layers[i]->name << " " << min_vals[i].size();
+					for (int c = 0; c < min_vals[i].size(); c++)
+						out << " " << min_vals[i][c] << " " << max_vals[i][c];
+					out << "\n";
+				}
 			}
-			blobs[0] = &input;
-			
-			for (int i = 0; i < layers.size(); i++)
+
+			const int alpha_num = 3;
+			const float alphas[alpha_num] = { 0.0f, 0.5f, 1.0f };
+			std::vector<float> best_similarity(layer_num, -2.0f), similarity;
+			std::vector<std::vector<float> > best_scales(layer_num), scales(layer_num);
+			for (int k = 0; k < alpha_num; k++)
 			{
-				std::vector<ZQ_CNN_Tensor4D*> bottom_ptrs, top_ptrs;
-				for (int j = 0; j < bottoms[i].size(); j++)
-					bottom_ptrs.push_back(blobs[bottoms[i][j]]);
-				for (int j = 0; j < tops[i].size(); j++)	
-					top_ptrs.push_back(blobs[tops[i][j]]);
-				
-				layers[i]->show_debug_info = show_debug_info;
-				//printf("%d\n", i);
-				layers[i]->use_buffer = use_buffer;
-				layers[i]->buffer = &(_buffer.data);
-				layers[i]->buffer_len = &(_buffer.len);
-				if (!layers[i]->Forward(&bottom_ptrs, &top_ptrs))
+				for (int i = 0; i < layer_num; i++)
 				{
-					blobs[0] = 0;
-					tops[0][0] = 0;
-					printf("failed to run layer: %s\n", layers[i]->name.c_str());
+					if (min_vals[i].size() == 0)
+						continue;
+					bool depthwise = ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "DepthwiseConvolution") == 0;
+					scales[i] = _get_int8_scale_of_range(min_vals[i], max_vals[i], depthwise ? 1.0f : alphas[k]);
+					_set_int8_scale(i, scales[i]);
+				}
+				_prepack();
+				if (!_get_int8_similarity(samples, min_vals, similarity))
 					return false;
+				for (int i = 0; i < layer_num; i++)
+				{
+					if (min_vals[i].size() > 0 && similarity[i] > best_similarity[i])
+					{
+						best_similarity[i] = similarity[i];
+						best_scales[i] = scales[i];
+					}
 				}
-//				char buf[100];
-//#if defined(_WIN32)
-//				sprintf_s(buf, "NHWC_%d.txt", i);
-//#else
-//				sprintf(buf, "NHWC_%d.txt", i);
-//#endif
-//				top_ptrs[0]->SaveToFile(buf);
 			}
-			
-			blobs[0] = 0;
-			tops[0][0] = 0;
+			for (int i = 0; i < layer_num; i++)
+			{
+				if (min_vals[i].size() == 0)
+					continue;
+				if (show_debug_info)
+				{
+					printf("layer %s: int8 similarity = %.5f%s\n", layers[i]->name.c_str(), best_similarity[i],
+						best_similarity[i] < min_similarity ? ", it stays in float" : "");
+				}
+				_set_int8_scale(i, best_similarity[i] < min_similarity ? std::vector<float>() : best_scales[i]);
+			}
+			_prepack();
+			return true;
+		}
+
+		/*copy src_param_file to dst_param_file with int8_scale of the calibrated layers,
+		nets loaded from dst_param_file and the same model file run in int8 without calibration.
+		The quantized weights and their scales are saved to dst_int8_model_file if it is not empty*/
+		bool SaveInt8Param(const std::string& src_param_file, const std::string& dst_param_file, const std::string& dst_int8_model_file = "") const
+		{
+			std::ifstream in(src_param_file.c_str());
+			if (!in.is_open())
+			{
+				std::cout << "failed to open " << src_param_file << "\n";
+				return false;
+			}
+			std::vector<std::string> lines;
+			std::string line;
+			while (std::getline(in, line))
+			{
+				if (line.size() > 0 && line[line.size() - 1] == '\r')
+					line.erase(line.size() - 1);
+				std::vector<std::vector<std::string> > paras = ZQ_CNN_Layer::split_line(line);
+				std::string name;
+				for (int n = 0; n < paras.size(); n++)
+				{
+					if (paras[n].size() >= 2 && ZQ_CNN_Layer::_my_strcmpi("name", paras[n][0].c_str()) == 0)
+						name = paras[n][1];
+				}
+				std::string scale_str;
+				for (int i = 0; i < layers.size() && name != ""; i++)
+				{
+					if (layers[i]->name == name && paras.size() > 0 && paras[0].size() > 0
+						&& ZQ_CNN_Layer::_my_strcmpi(paras[0][0].c_str(), layer_type_names[i].c_str()) == 0)
+					{
+						scale_str = _get_int8_scale_str(i);
+						break;
+					}
+				}
+				if (scale_str != "")
+				{
+					std::string new_line;
+					std::vector<std::string> items;
+					_split_items(line, items);
+					for (int n = 0; n < items.size(); n++)
+					{
+						if (n < paras.size() && paras[n].size() > 0 && ZQ_CNN_Layer::_my_strcmpi("int8_scale", paras[n][0].c_str()) == 0)
+							continue;
+						new_line += (new_line.size() > 0 ? " " : "") + items[n];
+					}
+					line = new_line + " int8_scale=" + scale_str;
+				}
+				lines.push_back(line);
+			}
+			in.close();
+			std::ofstream out(dst_param_file.c_str());
+			if (!out.is_open())
+			{
+				std::cout << "failed to create " << dst_param_file << "\n";
+				return false;
+			}
+			for (int i = 0; i < lines.size(); i++)
+				out << lines[i] << "\n";
+			out.close();
+			if (dst_int8_model_file != "")
+				return _save_int8_model_file(dst_int8_model_file);
 			return true;
 		}
 
+		/*it may change input in case of padding, but the data will not be lost*/
+		bool Forward(ZQ_CNN_Tensor4D& input)
+		{
+			return _forward(input, std::vector<int>());
+		}
+
+		/*only run the layers that the blobs wanted_outputs depend on, the other blobs are not valid after it*/
+		bool Forward(ZQ_CNN_Tensor4D& input, const std::vector<std::string>& wanted_outputs)
+		{
+			std::vector<int> wanted_blobs;
+			if (!_find_blobs(wanted_outputs, wanted_blobs))
+				return false;
+			return _forward(input, wanted_blobs);
+		}
+
 		bool Forward(ZQ_CNN_Tensor4D& input, const std::string& start_layer_name, const std::string& end_layer_name)
 		{
 			if (map_name_to_blob_idx.size() == 0 || map_name_to_layer_idx.size() == 0 || tops.size() == 0)
@@ -236,6 +635,9 @@ namespace ZQ
 					return false;
 				}
 			}
+			/*blobs may be produced by previous calls, so they cannot share memory*/
+			_unbind_memory_plan();
+			_unbind_views();
 			blobs[0] = &input;
 
 			bool has_begin = false, has_end = false;
@@ -254,8 +656,12 @@ namespace ZQ
 				layers[i]->show_debug_info = show_debug_info;
 				//printf("%d\n", i);
 				layers[i]->use_buffer = use_buffer;
-				layers[i]->buffer = &(_buffer.data);
-				layers[i]->buffer_len = &(_buffer.len);
+				layers[i]->use_winograd = use_winograd;
+				layers[i]->use_int8 = use_int8;
+				layers[i]->use_epilogue = false;	//the blobs between the calls must be the outputs of their layers
+				layers[i]->num_threads = num_threads;
+				layers[i]->buffer = &_buffer_data[0];
+				layers[i]->buffer_len = &_buffer_len[0];
 				if (!layers[i]->Forward(&bottom_ptrs, &top_ptrs))
 				{
 					blobs[0] = 0;
@@ -289,82 +695,436 @@ namespace ZQ
 		}
 
 	private:
-		void _clear()
+		/*run the layers needed by wanted_blobs, all layers if it is empty*/
+		bool _forward(ZQ_CNN_Tensor4D& input, const std::vector<int>& wanted_blobs)
 		{
-			for (int i = 0; i < layers.size(); i++)
+			if (map_name_to_blob_idx.size() == 0 || map_name_to_layer_idx.size() == 0 || tops.size() == 0)
+				return false;
+			if (has_innerproduct_layer)
 			{
-				if (layers[i])
-					delete layers[i];
+				if (input.GetH() != input_H || input.GetW() != input_W || input.GetC() != input_C)
+				{
+					std::cout << "The dimenson doesnot match with the needed\n";
+					return false;
+				}
 			}
-			layers.clear();
-			layer_type_names.clear();
-			map_name_to_layer_idx.clear();
-			//blob[0] is a pointer to input blob, DONT FREE
-			for (int i = 1; i < blobs.size(); i++)
+			if (forward_needed_layers.size() != layers.size() || wanted_blobs != forward_wanted_blobs)
 			{
-				if (blobs[i])
-					delete blobs[i];
+				_find_needed_layers(wanted_blobs, forward_needed_layers);
+				forward_wanted_blobs = wanted_blobs;
 			}
-			blobs.clear();
-			map_name_to_layer_idx.clear();
-			has_input_layer = false;
+			_update_forward_epilogue(wanted_blobs);
+			_update_layer_step();
+			if (use_memory_plan)
+			{
+				if (!_bind_memory_plan(input.GetN(), input.GetC(), input.GetH(), input.GetW(), wanted_blobs))
+					_unbind_memory_plan();
+			}
+			else if (input.GetN() != plan_N || input.GetC() != plan_C || input.GetH() != plan_H || input.GetW() != plan_W)
+			{
+				//the concat and reshape views need the blob shapes
+				_plan_memory(input.GetN(), input.GetC(), input.GetH(), input.GetW());
+			}
+			_bind_concat_views(input.GetN(), input.GetC(), input.GetH(), input.GetW());
+			_bind_reshape_views(input.GetN(), input.GetC(), input.GetH(), input.GetW());
+			_rebind_blobs();
+			blobs[0] = &input;
+			
+			for (int s = 0; s < step_layers.size(); s++)
+			{
+				bool ok = step_use_dag ? _forward_step(step_layers[s]) 
+					: (!_need_to_run(step_layers[s][0]) || _run_layer(step_layers[s][0], num_threads, 0));
+				if (!ok)
+				{
+					blobs[0] = 0;
+					tops[0][0] = 0;
+					return false;
+				}
+			}
+			
+			blobs[0] = 0;
+			tops[0][0] = 0;
+			return true;
 		}
 
-		bool _getline(std::fstream& fin, const char*& buffer, __int64& buffer_len, std::string& line)
+		bool _need_to_run(int i) const
 		{
-			if (buffer == 0)
+			return forward_needed_layers[i] && forward_fused_into[i] < 0;
+		}
+
+		/*run layer i with threads threads and the buffers from _buffer_data[buffer_idx]*/
+		bool _run_layer(int i, int threads, int buffer_idx)
+		{
+			std::vector<ZQ_CNN_Tensor4D*> bottom_ptrs, top_ptrs;
+			for (int j = 0; j < bottoms[i].size(); j++)
+				bottom_ptrs.push_back(blobs[bottoms[i][j]]);
+			for (int j = 0; j < tops[i].size(); j++)	
+				top_ptrs.push_back(blobs[j == 0 ? forward_epilogue_top[i] : tops[i][j]]);
+			
+			layers[i]->show_debug_info = show_debug_info;
+			//printf("%d\n", i);
+			layers[i]->use_buffer = use_buffer;
+			layers[i]->use_winograd = use_winograd;
+			layers[i]->use_int8 = use_int8;
+			layers[i]->use_epilogue = use_epilogue;
+			layers[i]->num_threads = threads;
+			layers[i]->buffer = &_buffer_data[buffer_idx];
+			layers[i]->buffer_len = &_buffer_len[buffer_idx];
+			if (!layers[i]->Forward(&bottom_ptrs, &top_ptrs))
 			{
-				if (!fin.is_open() || fin.eof())
-					return false;
-				std::getline(fin, line);
-				return true;
+				printf("failed to run layer: %s\n", layers[i]->name.c_str());
+				return false;
 			}
-			else
+//			char buf[100];
+//#if defined(_WIN32)
+//			sprintf_s(buf, "NHWC_%d.txt", i);
+//#else
+//			sprintf(buf, "NHWC_%d.txt", i);
+//#endif
+//			top_ptrs[0]->SaveToFile(buf);
+			return true;
+		}
+
+		/*the layers with more than 1/num_threads of the work of the step run one by one with all threads, then the others
+		run at the same time with one thread each (the inner omp loops run in one thread), so there are never more threads than num_threads*/
+		bool _forward_step(const std::vector<int>& step)
+		{
+			std::vector<std::pair<__int64, int> > items, small_items;
+			__int64 total_cost = 0;
+			for (int k = 0; k < step.size(); k++)
 			{
-				if (buffer_len <= 0)
-					return false;
-				__int64 i = 0;
-				for (; i < buffer_len; i++)
+				if (!_need_to_run(step[k]))
+					continue;
+				__int64 cost = __max(1, layers[step[k]]->GetNumOfMulAdd());
+				items.push_back(std::make_pair(cost, step[k]));
+				total_cost += cost;
+			}
+			for (int k = 0; k < items.size(); k++)
+			{
+				if (items.size() == 1 || items[k].first * num_threads > total_cost)
 				{
-					if (buffer[i] != '\n' && buffer[i] != '\r')
-						break;
+					if (!_run_layer(items[k].second, num_threads, 0))
+						return false;
 				}
-				if (i == buffer_len)
-					return false;
+				else
+					small_items.push_back(items[k]);
+			}
+			if (small_items.size() == 0)
+				return true;
+			if (small_items.size() == 1)
+				return _run_layer(small_items[0].second, num_threads, 0);
 
-				__int64 j = i;
-				for (; j < buffer_len; j++)
+			/*padding a bottom may reallocate it, so a bottom shared by the layers is padded before*/
+			for (int a = 0; a < small_items.size(); a++)
+			{
+				int padW, padH;
+				_get_bottom_padding(small_items[a].second, padW, padH);
+				if (padW == 0 && padH == 0)
+					continue;
+				int blob = bottoms[small_items[a].second][0];
+				for (int b = 0; b < small_items.size(); b++)
 				{
-					if (buffer[j] == '\n' || buffer[j] == '\r')
+					const std::vector<int>& other = bottoms[small_items[b].second];
+					if (b != a && std::find(other.begin(), other.end(), blob) != other.end())
+					{
+						if (!blobs[blob]->Padding(padW, padH, 0))
+							return false;
 						break;
+					}
 				}
-
-				if (j == i)
-					return false;
-				__int64 cur_len = j - i;
-				line.clear();
-				line.append(buffer + i, cur_len);
-				buffer += cur_len;
-				buffer_len -= cur_len;
-				return true;
 			}
+
+			/*the largest first*/
+			std::sort(small_items.begin(), small_items.end(), std::greater<std::pair<__int64, int> >());
+			int thread_num = __min((int)small_items.size(), num_threads);
+			std::vector<int> succeeded(small_items.size(), 0);
+			ZQ_CNN_ThreadPool::ParallelFor(small_items.size(), thread_num, [&](int k, int thread_id)
+			{
+				succeeded[k] = _run_layer(small_items[k].second, 1, thread_id);
+			});
+			return std::find(succeeded.begin(), succeeded.end(), 0) == succeeded.end();
 		}
 
-		bool _load_param_file(const std::string& file)
+		void _get_bottom_padding(int i, int& padW, int& padH) const
 		{
-			std::fstream fin(file, std::ios::in);
-			if (!fin.is_open())
+			padW = padH = 0;
+			if (ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "Convolution") == 0)
 			{
-				std::cout << "failed to open file " << file << "\n";
-				return false;
+				padW = ((ZQ_CNN_Layer_Convolution*)layers[i])->pad_W;
+				padH = ((ZQ_CNN_Layer_Convolution*)layers[i])->pad_H;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "DepthwiseConvolution") == 0)
+			{
+				padW = ((ZQ_CNN_Layer_DepthwiseConvolution*)layers[i])->pad_W;
+				padH = ((ZQ_CNN_Layer_DepthwiseConvolution*)layers[i])->pad_H;
 			}
-			return _load_param_from_file_or_buffer(fin, NULL, 0);
 		}
 
-		bool _load_param_from_buffer(const char* buffer, __int64 buffer_len)
+		/*in dag schedule, a layer runs at the step after the layers it depends on: the last writers of its bottoms and tops,
+		and the readers of its tops. The layers fused into layer i are done by it, so their bottoms and tops are also of layer i*/
+		void _update_layer_step()
 		{
-			std::fstream fin;
-			return _load_param_from_file_or_buffer(fin, buffer, buffer_len);
+			bool use_dag = use_dag_schedule && num_threads > 1;
+			if (layer_step.size() == layers.size() && step_use_dag == use_dag)
+				return;
+			step_use_dag = use_dag;
+			int layer_num = layers.size();
+			layer_step.resize(layer_num);
+			step_layers.clear();
+			if (!use_dag)
+			{
+				step_layers.resize(layer_num);
+				for (int i = 0; i < layer_num; i++)
+				{
+					layer_step[i] = i;
+					step_layers[i].push_back(i);
+				}
+				return;
+			}
+			std::vector<int> owner(layer_num);
+			std::vector<std::vector<int> > reads(layer_num), writes(layer_num);
+			for (int i = 0; i < layer_num; i++)
+			{
+				owner[i] = forward_fused_into[i] >= 0 ? forward_fused_into[i] : i;
+				reads[owner[i]].insert(reads[owner[i]].end(), bottoms[i].begin(), bottoms[i].end());
+				writes[owner[i]].insert(writes[owner[i]].end(), tops[i].begin(), tops[i].end());
+			}
+			std::vector<int> last_write(blobs.size(), -1), last_read(blobs.size(), -1);
+			int step_num = 0;
+			for (int i = 0; i < layer_num; i++)
+			{
+				if (owner[i] != i)
+					continue;
+				int step = 0;
+				for (int j = 0; j < reads[i].size(); j++)
+					step = __max(step, last_write[reads[i][j]] + 1);
+				for (int j = 0; j < writes[i].size(); j++)
+					step = __max(step, __max(last_write[writes[i][j]], last_read[writes[i][j]]) + 1);
+				for (int j = 0; j < reads[i].size(); j++)
+					last_read[reads[i][j]] = __max(last_read[reads[i][j]], step);
+				for (int j = 0; j < writes[i].size(); j++)
+					last_write[writes[i][j]] = step;
+				layer_step[i] = step;
+				step_num = __max(step_num, step + 1);
+			}
+			step_layers.resize(step_num);
+			for (int i = 0; i < layer_num; i++)
+			{
+				layer_step[i] = layer_step[owner[i]];
+				step_layers[layer_step[i]].push_back(i);
+			}
+		}
+
+		/*the blobs of the names (after in-place simplification), sorted*/
+		bool _find_blobs(const std::vector<std::string>& names, std::vector<int>& blob_ids) const
+		{
+			blob_ids.clear();
+			for (int i = 0; i < names.size(); i++)
+			{
+				std::map<std::string, int>::const_iterator it = map_name_to_blob_idx.find(names[i]);
+				if (it == map_name_to_blob_idx.end())
+				{
+					std::cout << "blob " << names[i] << " does not exist\n";
+					return false;
+				}
+				std::map<int, int>::const_iterator inplace_it = simplify_inplace_blob_map.find(it->second);
+				blob_ids.push_back(inplace_it == simplify_inplace_blob_map.end() ? it->second : inplace_it->second);
+			}
+			std::sort(blob_ids.begin(), blob_ids.end());
+			blob_ids.erase(std::unique(blob_ids.begin(), blob_ids.end()), blob_ids.end());
+			return true;
+		}
+
+		/*a layer is needed if one of its tops is used (by a needed layer or as a wanted blob) before it is written again,
+		all layers are needed if wanted_blobs is empty*/
+		void _find_needed_layers(const std::vector<int>& wanted_blobs, std::vector<bool>& needed) const
+		{
+			int layer_num = layers.size();
+			needed.assign(layer_num, wanted_blobs.size() == 0);
+			if (wanted_blobs.size() == 0)
+				return;
+			std::vector<bool> is_used(blobs.size(), false);
+			for (int i = 0; i < wanted_blobs.size(); i++)
+				is_used[wanted_blobs[i]] = true;
+			for (int i = layer_num - 1; i > 0; i--)
+			{
+				for (int j = 0; j < tops[i].size(); j++)
+					needed[i] = needed[i] || is_used[tops[i][j]];
+				if (!needed[i])
+					continue;
+				for (int j = 0; j < tops[i].size(); j++)
+					is_used[tops[i][j]] = false;
+				for (int j = 0; j < bottoms[i].size(); j++)
+					is_used[bottoms[i][j]] = true;
+			}
+			if (layer_num > 0)
+				needed[0] = true;
+		}
+
+		void _release_buffers()
+		{
+			for (int i = 0; i < _buffer_data.size(); i++)
+			{
+				if (_buffer_data[i])
+					_aligned_free(_buffer_data[i]);
+				_buffer_data[i] = 0;
+				_buffer_len[i] = 0;
+			}
+		}
+
+		void _clear()
+		{
+			for (int i = 0; i < layers.size(); i++)
+			{
+				if (layers[i])
+					delete layers[i];
+			}
+			layers.clear();
+			layer_type_names.clear();
+			map_name_to_layer_idx.clear();
+			//blob[0] is a pointer to input blob, DONT FREE
+			for (int i = 1; i < blobs.size(); i++)
+			{
+				if (blobs[i])
+					delete blobs[i];
+			}
+			blobs.clear();
+			map_name_to_layer_idx.clear();
+			has_input_layer = false;
+			_blob_memory.Release();
+			blob_first_layer.clear();
+			blob_last_layer.clear();
+			blob_plan_offset.clear();
+			blob_plan_len.clear();
+			blob_concat_top.clear();
+			blob_concat_offset.clear();
+			blob_reshape_source.clear();
+			blob_reshape_planned.clear();
+			blob_border_W.clear();
+			blob_border_H.clear();
+			layer_fused_into.clear();
+			forward_fused_into.clear();
+			forward_epilogue_top.clear();
+			plan_wanted_blobs.clear();
+			plan_layer_step.clear();
+			plan_cache.clear();
+			layer_step.clear();
+			step_layers.clear();
+			forward_wanted_blobs.clear();
+			forward_needed_layers.clear();
+			plan_N = plan_C = plan_H = plan_W = -1;
+			planned_blob_bytes = 0;
+			naive_blob_bytes = 0;
+		}
+
+		/*copy the structure of a loaded net, the layers share the weights with it*/
+		bool _share_model_from(const ZQ_CNN_Net& model)
+		{
+			_clear();
+			if (model.layers.size() == 0)
+				return false;
+			for (int i = 0; i < model.layers.size(); i++)
+			{
+				ZQ_CNN_Layer* cur_layer = model.layers[i]->CloneSharedWeights();
+				if (cur_layer == 0)
+				{
+					std::cout << "failed to share layer " << model.layers[i]->name << "\n";
+					_clear();
+					return false;
+				}
+				layers.push_back(cur_layer);
+			}
+			layer_type_names = model.layer_type_names;
+			map_name_to_layer_idx = model.map_name_to_layer_idx;
+			map_name_to_blob_idx = model.map_name_to_blob_idx;
+			simplify_inplace_blob_map = model.simplify_inplace_blob_map;
+			bottoms = model.bottoms;
+			tops = model.tops;
+			input_name = model.input_name;
+			has_input_layer = model.has_input_layer;
+			ignore_small_value = model.ignore_small_value;
+			has_innerproduct_layer = model.has_innerproduct_layer;
+			input_C = model.input_C;
+			input_H = model.input_H;
+			input_W = model.input_W;
+			//blob[0] is a pointer to input blob
+			blobs.push_back(0);
+			for (int i = 1; i < model.blobs.size(); i++)
+			{
+				ZQ_CNN_Tensor4D* blob = _create_blob();
+				if (blob == 0)
+				{
+					std::cout << "failed to allocate a ZQ_CNN_Tensor4D\n";
+					_clear();
+					return false;
+				}
+				blobs.push_back(blob);
+			}
+			blob_concat_top = model.blob_concat_top;
+			blob_reshape_source = model.blob_reshape_source;
+			layer_fused_into = model.layer_fused_into;
+			_find_blob_borders();
+			_update_forward_epilogue(std::vector<int>());
+			_compute_blob_lifetime();
+			_plan_memory(1, input_C, input_H, input_W);
+			return true;
+		}
+
+		bool _getline(std::fstream& fin, const char*& buffer, __int64& buffer_len, std::string& line)
+		{
+			if (buffer == 0)
+			{
+				if (!fin.is_open() || fin.eof())
+					return false;
+				std::getline(fin, line);
+				return true;
+			}
+			else
+			{
+				if (buffer_len <= 0)
+					return false;
+				__int64 i = 0;
+				for (; i < buffer_len; i++)
+				{
+					if (buffer[i] != '\n' && buffer[i] != '\r')
+						break;
+				}
+				if (i == buffer_len)
+					return false;
+
+				__int64 j = i;
+				for (; j < buffer_len; j++)
+				{
+					if (buffer[j] == '\n' || buffer[j] == '\r')
+						break;
+				}
+
+				if (j == i)
+					return false;
+				__int64 cur_len = j - i;
+				line.clear();
+				line.append(buffer + i, cur_len);
+				buffer += cur_len;
+				buffer_len -= cur_len;
+				return true;
+			}
+		}
+
+		bool _load_param_file(const std::string& file)
+		{
+			std::fstream fin(file, std::ios::in);
+			if (!fin.is_open())
+			{
+				std::cout << "failed to open file " << file << "\n";
+				return false;
+			}
+			return _load_param_from_file_or_buffer(fin, NULL, 0);
+		}
+
+		bool _load_param_from_buffer(const char* buffer, __int64 buffer_len)
+		{
+			std::fstream fin;
+			return _load_param_from_file_or_buffer(fin, buffer, buffer_len);
 		}
 
 		bool _load_param_from_file_or_buffer(std::fstream& fin, const char* buffer, __int64 buffer_len)
@@ -1040,6 +1800,21 @@ namespace ZQ
 			return true;
 		}
 
+		static ZQ_CNN_Tensor4D* _create_blob()
+		{
+#if __ARM_NEON
+			return new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
+#else
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+			return new ZQ_CNN_Tensor4D_NHW_C_Align256bit();
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+			return new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
+#else
+			return new ZQ_CNN_Tensor4D_NHW_C_Align0();
+#endif
+#endif //__ARM_NEON
+		}
+
 		bool _add_layer_and_blobs(ZQ_CNN_Layer* cur_layer, const std::string& line, bool is_input_layer)
 		{
 			if (!cur_layer->ReadParam(line))
@@ -1071,17 +1846,7 @@ namespace ZQ
 						if (name_it == map_name_to_blob_idx.end())
 						{
 							int idx = blobs.size();
-#if __ARM_NEON
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
-#else
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align256bit();
-#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
-#else
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align0();
-#endif
-#endif //__ARM_NEON
+							ZQ_CNN_Tensor4D* blob = _create_blob();
 							if (blob == 0)
 							{
 								std::cout << "failed to allocate a ZQ_CNN_Tensor4D\n";
@@ -1103,17 +1868,7 @@ namespace ZQ
 						if (name_it == map_name_to_blob_idx.end())
 						{
 							int idx = blobs.size();
-#if __ARM_NEON
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
-#else
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align256bit();
-#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align128bit();
-#else
-							ZQ_CNN_Tensor4D* blob = new ZQ_CNN_Tensor4D_NHW_C_Align0();
-#endif
-#endif //__ARM_NEON
+							ZQ_CNN_Tensor4D* blob = _create_blob();
 							if (blob == 0)
 							{
 								std::cout << "failed to allocate a ZQ_CNN_Tensor4D\n";
@@ -1133,125 +1888,998 @@ namespace ZQ
 					layers.push_back(cur_layer);
 					map_name_to_layer_idx[layer_name] = layers.size() - 1;
 				}
-				else
+				else
+				{
+					std::cout << "There's already a layer named " << layer_name << "!\n";
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool _check_connect()
+		{
+			int blob_num = blobs.size();
+			int layer_num = layers.size();
+			if (layers.size() == 0 || blob_num == 0)
+				return false;
+			ZQ_CNN_Layer_Input* input_layer = (ZQ_CNN_Layer_Input*)(layers[0]);
+			if (has_innerproduct_layer)
+			{
+				if (!input_layer->has_H_val || !input_layer->has_W_val)
+				{
+					std::cout << "Input dim must be specified for InnerProduct layer\n";
+					return false;
+				}
+			}
+			std::vector<bool> visited(blob_num);
+			std::vector<int> blob_dim_C(blob_num);
+			std::vector<int> blob_dim_H(blob_num);
+			std::vector<int> blob_dim_W(blob_num);
+			visited[0] = true;
+			blob_dim_C[0] = input_layer->C;
+			blob_dim_H[0] = input_layer->H;
+			blob_dim_W[0] = input_layer->W;
+
+			for (int i = 1; i < blob_num; i++)
+				visited[i] = false;
+
+			for (int i = 1; i < layer_num; i++)
+			{
+				std::vector<std::string>& bottom_names = layers[i]->bottom_names;
+				int cur_bottom_c = 0;
+				int cur_bottom_h = 0;
+				int cur_bottom_w = 0;
+				for (int j = 0; j < bottom_names.size(); j++)
+				{
+					std::map<std::string, int>::iterator name_it = map_name_to_blob_idx.find(bottom_names[j]);
+					if (!visited[name_it->second])
+					{
+						std::cout << "unknown blob " << bottom_names[j] << " in Layer " << layers[i]->name << "\n";
+						return false;
+					}
+					/*if (j == 0)
+					{
+						cur_bottom_c = blob_dim_C[name_it->second];
+						cur_bottom_h = blob_dim_H[name_it->second];
+						cur_bottom_w = blob_dim_W[name_it->second];
+						layers[i]->SetBottomDim(cur_bottom_c,cur_bottom_h,cur_bottom_w);
+					}
+					else
+					{
+						if (blob_dim_C[name_it->second] != cur_bottom_c || blob_dim_H[name_it->second] != cur_bottom_h 
+							|| blob_dim_W[name_it->second] != cur_bottom_w)
+						{
+							std::cout << "Dimension mismatch detected in layer " << layers[i]->name << "\n";
+							return false;
+						}
+					}*/
+				}
+				std::vector<std::string>& top_names = layers[i]->top_names;
+				for (int j = 0; j < top_names.size(); j++)
+				{
+					std::map<std::string, int>::iterator name_it = map_name_to_blob_idx.find(top_names[j]);
+					visited[name_it->second] = true;
+					//layers[i]->GetTopDim(blob_dim_C[name_it->second], blob_dim_H[name_it->second], blob_dim_W[name_it->second]);
+				}
+			}
+
+			/*for (int i = 1; i < blob_num; i++)
+			{
+				blobs[i]->ChangeSize(1, blob_dim_H[i], blob_dim_W[i], blob_dim_C[i], 0, 0);
+			}*/
+
+			if (!_setup(1, input_C, input_H, input_W))
+			{
+				return false;
+			}
+			return true;
+		}
+
+		bool _setup(int in_N, int in_C, int in_H, int in_W)
+		{
+			ZQ_CNN_Tensor4D_NHW_C_Align0 input;
+			input.SetShape(in_N, in_C, in_H, in_W);
+			if (map_name_to_blob_idx.size() == 0 || map_name_to_layer_idx.size() == 0 || tops.size() == 0)
+				return false;
+			
+			blobs[0] = &input;
+
+			for (int i = 0; i < layers.size(); i++)
+			{
+				std::vector<ZQ_CNN_Tensor4D*> bottom_ptrs, top_ptrs;
+				for (int j = 0; j < bottoms[i].size(); j++)
+					bottom_ptrs.push_back(blobs[bottoms[i][j]]);
+				for (int j = 0; j < tops[i].size(); j++)
+					top_ptrs.push_back(blobs[tops[i][j]]);
+
+				layers[i]->show_debug_info = show_debug_info;
+				if (!layers[i]->LayerSetup(&bottom_ptrs, &top_ptrs))
+				{
+					blobs[0] = 0;
+					tops[0][0] = 0;
+					printf("failed to setup layer: %s\n", layers[i]->name.c_str());
+					return false;
+				}
+			}
+			blobs[0] = 0;
+			tops[0][0] = 0;
+			return true;
+		}
+
+		/*the kernels would crash with illegal instructions on a cpu older than the one they are compiled for*/
+		bool _check_cpu() const
+		{
+			if (show_debug_info)
+				printf("ZQ_CNN_Net: %s\n", ZQ_CNN_CPUInfo::GetSelectedPath().c_str());
+			if (!ZQ_CNN_CPUInfo::IsCompiledSSETypeSupported())
+			{
+				std::cout << "this cpu does not support " << ZQ_CNN_CPUInfo::GetSSETypeName(ZQ_CNN_CPUInfo::GetSelectedSSEType())
+					<< ", which ZQCNN is compiled for\n";
+				return false;
+			}
+			return true;
+		}
+
+		void _prepack()
+		{
+			for (int i = 0; i < layers.size(); i++)
+			{
+				layers[i]->Prepack();
+				layers[i]->int8_filters_loaded = false;
+			}
+		}
+
+		bool _is_int8_layer(int i) const
+		{
+			return ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "Convolution") == 0
+				|| ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "DepthwiseConvolution") == 0
+				|| ZQ_CNN_Layer::_my_strcmpi(layer_type_names[i].c_str(), "InnerProduct") == 0;
+		}
+
+		/*empty scales turn layers[i] back to float*/
+		void _set_int8_scale(int i, const std::vector<float>& scales)
+		{
+			std::string type = layer_type_names[i];
+			if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "Convolution") == 0)
+				((ZQ_CNN_Layer_Convolution*)layers[i])->int8_scale = scales;
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "DepthwiseConvolution") == 0)
+				((ZQ_CNN_Layer_DepthwiseConvolution*)layers[i])->int8_scale = scales;
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "InnerProduct") == 0)
+				((ZQ_CNN_Layer_InnerProduct*)layers[i])->int8_scale = scales;
+		}
+
+		/*int8_scale of layers[i] as it is written in the param file, empty if it is not quantized*/
+		std::string _get_int8_scale_str(int i) const
+		{
+			std::vector<float> scales;
+			std::string type = layer_type_names[i];
+			if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "Convolution") == 0)
+				scales = ((const ZQ_CNN_Layer_Convolution*)layers[i])->int8_scale;
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "DepthwiseConvolution") == 0)
+				scales = ((const ZQ_CNN_Layer_DepthwiseConvolution*)layers[i])->int8_scale;
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "InnerProduct") == 0)
+				scales = ((const ZQ_CNN_Layer_InnerProduct*)layers[i])->int8_scale;
+			std::string str;
+			char buf[50];
+			/*9 digits read back to the same float, so the nets loaded from the param file quantize as this one*/
+			for (int c = 0; c < scales.size(); c++)
+			{
+#if defined(_WIN32)
+				sprintf_s(buf, "%.9g", scales[c]);
+#else
+				sprintf(buf, "%.9g", scales[c]);
+#endif
+				if (c > 0)
+					str += ",";
+				str += buf;
+			}
+			return str;
+		}
+
+		/*the float filters, int8_scale and packed int8 filters of layers[i], return false if it is not an int8 layer*/
+		bool _get_int8_weights(int i, const ZQ_CNN_Tensor4D*& filters, std::vector<float>*& scales, void**& int8_filters, __int64*& int8_filters_len) const
+		{
+			std::string type = layer_type_names[i];
+			if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "Convolution") == 0)
+			{
+				ZQ_CNN_Layer_Convolution* layer = (ZQ_CNN_Layer_Convolution*)layers[i];
+				filters = layer->filters; scales = &layer->int8_scale; int8_filters = &layer->int8_filters; int8_filters_len = &layer->int8_filters_len;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "DepthwiseConvolution") == 0)
+			{
+				ZQ_CNN_Layer_DepthwiseConvolution* layer = (ZQ_CNN_Layer_DepthwiseConvolution*)layers[i];
+				filters = layer->filters; scales = &layer->int8_scale; int8_filters = &layer->int8_filters; int8_filters_len = &layer->int8_filters_len;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type.c_str(), "InnerProduct") == 0)
+			{
+				ZQ_CNN_Layer_InnerProduct* layer = (ZQ_CNN_Layer_InnerProduct*)layers[i];
+				filters = layer->filters; scales = &layer->int8_scale; int8_filters = &layer->int8_filters; int8_filters_len = &layer->int8_filters_len;
+			}
+			else
+				return false;
+			return filters != 0;
+		}
+
+		/*int8 model file: pack format, layer count, then for each quantized layer: name, filter N H W C, 
+		int8_scale (one for each channel), packed int8 filters (weights, and the scales of the output channels)*/
+		bool _save_int8_model_file(const std::string& file) const
+		{
+			FILE* out = 0;
+#if defined(_WIN32)
+			fopen_s(&out, file.c_str(), "wb");
+#else
+			out = fopen(file.c_str(), "wb");
+#endif
+			if (out == 0)
+			{
+				std::cout << "failed to create " << file << "\n";
+				return false;
+			}
+			std::vector<int> saved;
+			for (int i = 0; i < layers.size(); i++)
+			{
+				const ZQ_CNN_Tensor4D* filters;
+				std::vector<float>* scales;
+				void** int8_filters;
+				__int64* int8_filters_len;
+				if (_get_int8_weights(i, filters, scales, int8_filters, int8_filters_len) && *int8_filters != 0 
+					&& scales->size() == filters->GetC())
+					saved.push_back(i);
+			}
+			int head[2] = { ZQ_CNN_Forward_SSEUtils::Int8PackFormat(), (int)saved.size() };
+			bool ret = fwrite(head, sizeof(int), 2, out) == 2;
+			for (int k = 0; k < saved.size() && ret; k++)
+			{
+				const ZQ_CNN_Tensor4D* filters;
+				std::vector<float>* scales;
+				void** int8_filters;
+				__int64* int8_filters_len;
+				_get_int8_weights(saved[k], filters, scales, int8_filters, int8_filters_len);
+				const std::string& name = layers[saved[k]]->name;
+				int dim[5] = { (int)name.size(), filters->GetN(), filters->GetH(), filters->GetW(), filters->GetC() };
+				ret = fwrite(dim, sizeof(int), 5, out) == 5
+					&& fwrite(name.c_str(), 1, name.size(), out) == name.size()
+					&& fwrite(&(*scales)[0], sizeof(float), scales->size(), out) == scales->size()
+					&& fwrite(int8_filters_len, sizeof(__int64), 1, out) == 1
+					&& fwrite(*int8_filters, 1, *int8_filters_len, out) == *int8_filters_len;
+			}
+			fclose(out);
+			if (!ret)
+				std::cout << "failed to write " << file << "\n";
+			return ret;
+		}
+
+		/*the layers found in file with the same filter size and int8_scale get the int8 filters of it, 
+		the others (and all if file is of another pack format) are quantized from the float filters*/
+		bool _load_int8_model_file(const std::string& file)
+		{
+			FILE* in = 0;
+#if defined(_WIN32)
+			fopen_s(&in, file.c_str(), "rb");
+#else
+			in = fopen(file.c_str(), "rb");
+#endif
+			if (in == 0)
+			{
+				std::cout << "failed to open " << file << "\n";
+				return false;
+			}
+			int head[2];
+			if (fread(head, sizeof(int), 2, in) != 2 || head[1] < 0)
+			{
+				fclose(in);
+				std::cout << "failed to read " << file << "\n";
+				return false;
+			}
+			if (head[0] != ZQ_CNN_Forward_SSEUtils::Int8PackFormat())
+			{
+				fclose(in);
+				std::cout << "warning: " << file << " is packed for another build, the weights are quantized again\n";
+				return true;
+			}
+			for (int k = 0; k < head[1]; k++)
+			{
+				int dim[5];
+				__int64 len = 0;
+				if (fread(dim, sizeof(int), 5, in) != 5 || dim[0] <= 0 || dim[4] <= 0)
+				{
+					fclose(in);
+					std::cout << "failed to read " << file << "\n";
+					return false;
+				}
+				std::string name(dim[0], '\0');
+				std::vector<float> file_scales(dim[4]);
+				if (fread(&name[0], 1, dim[0], in) != dim[0]
+					|| fread(&file_scales[0], sizeof(float), dim[4], in) != dim[4]
+					|| fread(&len, sizeof(__int64), 1, in) != 1 || len <= 0)
+				{
+					fclose(in);
+					std::cout << "failed to read " << file << "\n";
+					return false;
+				}
+				std::map<std::string, int>::const_iterator it = map_name_to_layer_idx.find(name);
+				const ZQ_CNN_Tensor4D* filters = 0;
+				std::vector<float>* scales = 0;
+				void** int8_filters = 0;
+				__int64* int8_filters_len = 0;
+				bool matched = it != map_name_to_layer_idx.end()
+					&& _get_int8_weights(it->second, filters, scales, int8_filters, int8_filters_len)
+					&& filters->GetN() == dim[1] && filters->GetH() == dim[2] && filters->GetW() == dim[3] && filters->GetC() == dim[4]
+					&& (scales->size() == 1 || scales->size() == dim[4]);
+				/*int8_scale in the param file is printed with 9 digits, which reads back to the same float*/
+				for (int c = 0; c < dim[4] && matched; c++)
+				{
+					float scale = (*scales)[scales->size() == 1 ? 0 : c];
+					matched = fabs(scale - file_scales[c]) <= 1e-6f*fabs(file_scales[c]);
+				}
+				if (!matched)
+				{
+					if (show_debug_info)
+						printf("int8 weights of %s do not match the layer, it is quantized again\n", name.c_str());
+					fseek(in, (long)len, SEEK_CUR);
+					continue;
+				}
+				if (*int8_filters == 0 || *int8_filters_len < len)
+				{
+					if (*int8_filters)
+						_aligned_free(*int8_filters);
+					*int8_filters = _aligned_malloc(len, 32);
+					*int8_filters_len = len;
+				}
+				if (fread(*int8_filters, 1, len, in) != len)
+				{
+					fclose(in);
+					std::cout << "failed to read " << file << "\n";
+					return false;
+				}
+				*scales = file_scales;
+				layers[it->second]->int8_filters_loaded = true;
+			}
+			fclose(in);
+			return true;
+		}
+
+		/*int8_scale[c] = 127/(max_c^alpha * max^(1-alpha))*/
+		static std::vector<float> _get_int8_scale_of_range(const std::vector<float>& min_vals, const std::vector<float>& max_vals, float alpha)
+		{
+			int C = min_vals.size();
+			std::vector<float> abs_max(C), scales(C);
+			float all_abs_max = 0;
+			for (int c = 0; c < C; c++)
+			{
+				abs_max[c] = __max(-min_vals[c], max_vals[c]);
+				all_abs_max = __max(all_abs_max, abs_max[c]);
+			}
+			for (int c = 0; c < C; c++)
+			{
+				float range = abs_max[c] > 0 ? pow(abs_max[c], alpha)*pow(all_abs_max, 1.0f - alpha) : all_abs_max;
+				scales[c] = range > 0 ? 127.0f / range : 1.0f;
+			}
+			return scales;
+		}
+
+		/*similarity[i] is the cosine similarity of the int8 and float output of layers[i] (if it has ranges) on the same input,
+		the next layers get the float output*/
+		bool _get_int8_similarity(const std::vector<ZQ_CNN_Tensor4D*>& samples, const std::vector<std::vector<float> >& ranges,
+			std::vector<float>& similarity)
+		{
+			int layer_num = layers.size();
+			std::vector<double> dot(layer_num, 0), norm_int8(layer_num, 0), norm_float(layer_num, 0);
+			std::vector<float> int8_data, float_data;
+			bool old_use_int8 = use_int8;
+			bool ret = true;
+			for (int s = 0; s < samples.size() && ret; s++)
+			{
+				if (samples[s] == 0)
+					continue;
+				for (int i = 0; i < layer_num && ret; i++)
+				{
+					if (ranges[i].size() > 0)
+					{
+						use_int8 = true;
+						ret = Forward(*samples[s], layers[i]->name, layers[i]->name);
+						if (ret)
+							_get_data(*blobs[tops[i][0]], int8_data);
+					}
+					use_int8 = false;
+					if (ret)
+						ret = Forward(*samples[s], layers[i]->name, layers[i]->name);
+					if (ret && ranges[i].size() > 0)
+					{
+						_get_data(*blobs[tops[i][0]], float_data);
+						for (int j = 0; j < float_data.size(); j++)
+						{
+							dot[i] += (double)int8_data[j] * float_data[j];
+							norm_int8[i] += (double)int8_data[j] * int8_data[j];
+							norm_float[i] += (double)float_data[j] * float_data[j];
+						}
+					}
+				}
+			}
+			use_int8 = old_use_int8;
+			similarity.assign(layer_num, 1.0f);
+			for (int i = 0; i < layer_num; i++)
+			{
+				if (norm_int8[i] > 0 && norm_float[i] > 0)
+					similarity[i] = dot[i] / sqrt(norm_int8[i] * norm_float[i]);
+			}
+			return ret;
+		}
+
+		static void _get_data(const ZQ_CNN_Tensor4D& tensor, std::vector<float>& data)
+		{
+			int N = tensor.GetN(), H = tensor.GetH(), W = tensor.GetW(), C = tensor.GetC();
+			int pixStep = tensor.GetPixelStep(), widthStep = tensor.GetWidthStep(), sliceStep = tensor.GetSliceStep();
+			const float* ptr = tensor.GetFirstPixelPtr();
+			data.resize((__int64)N*H*W*C);
+			float* dst = data.size() > 0 ? &data[0] : 0;
+			for (int n = 0; n < N; n++)
+			{
+				for (int h = 0; h < H; h++)
+				{
+					for (int w = 0; w < W; w++, dst += C)
+						memcpy(dst, ptr + n*sliceStep + h*widthStep + w*pixStep, sizeof(float)*C);
+				}
+			}
+		}
+
+		static void _update_range(const ZQ_CNN_Tensor4D& tensor, std::vector<float>& min_vals, std::vector<float>& max_vals)
+		{
+			int N = tensor.GetN(), H = tensor.GetH(), W = tensor.GetW(), C = tensor.GetC();
+			int pixStep = tensor.GetPixelStep(), widthStep = tensor.GetWidthStep(), sliceStep = tensor.GetSliceStep();
+			const float* data = tensor.GetFirstPixelPtr();
+			if (min_vals.size() != C)
+			{
+				min_vals.assign(C, 0);
+				max_vals.assign(C, 0);
+			}
+			for (int n = 0; n < N; n++)
+			{
+				for (int h = 0; h < H; h++)
+				{
+					for (int w = 0; w < W; w++)
+					{
+						const float* pix = data + n*sliceStep + h*widthStep + w*pixStep;
+						for (int c = 0; c < C; c++)
+						{
+							min_vals[c] = __min(min_vals[c], pix[c]);
+							max_vals[c] = __max(max_vals[c], pix[c]);
+						}
+					}
+				}
+			}
+		}
+
+		/*split a line of the param file at spaces, keeping the items in order*/
+		static void _split_items(const std::string& line, std::vector<std::string>& items)
+		{
+			items.clear();
+			std::string cur;
+			for (int i = 0; i < line.size(); i++)
+			{
+				if (line[i] == ' ' || line[i] == '\t')
+				{
+					if (cur.size() > 0)
+						items.push_back(cur);
+					cur.clear();
+				}
+				else
+					cur += line[i];
+			}
+			if (cur.size() > 0)
+				items.push_back(cur);
+		}
+
+		/*lifetimes of the blobs when only the layers needed by wanted_blobs run (all layers if it is empty),
+		the wanted blobs are kept to the end*/
+		void _compute_blob_lifetime(const std::vector<int>& wanted_blobs = std::vector<int>())
+		{
+			int blob_num = blobs.size();
+			int layer_num = layers.size();
+			std::vector<int> last_consume(blob_num, -1), last_produce(blob_num, -1);
+			std::vector<bool> needed;
+			_find_needed_layers(wanted_blobs, needed);
+			_update_layer_step();
+			blob_first_layer.assign(blob_num, -1);
+			blob_last_layer.assign(blob_num, -1);
+			for (int i = 1; i < layer_num; i++)
+			{
+				if (!needed[i])
+					continue;
+				//a fused layer is done at the step of its owner, which writes forward_epilogue_top
+				int step = layer_step[forward_fused_into[i] >= 0 ? forward_fused_into[i] : i];
+				for (int j = 0; j < bottoms[i].size(); j++)
+					last_consume[bottoms[i][j]] = __max(last_consume[bottoms[i][j]], step);
+				for (int j = 0; j < tops[i].size(); j++)
+				{
+					int idx = j == 0 ? forward_epilogue_top[i] : tops[i][j];
+					if (blob_first_layer[idx] < 0 || blob_first_layer[idx] > step)
+						blob_first_layer[idx] = step;
+					last_produce[idx] = __max(last_produce[idx], step);
+				}
+			}
+			//blobs[0] is the input, it is never planned
+			for (int i = 1; i < blob_num; i++)
+			{
+				if (blob_first_layer[i] < 0)
+					continue;
+				if (last_produce[i] >= last_consume[i])
+					blob_last_layer[i] = layer_num;
+				else
+					blob_last_layer[i] = last_consume[i];
+			}
+			for (int i = 0; i < wanted_blobs.size(); i++)
+			{
+				if (blob_first_layer[wanted_blobs[i]] >= 0)
+					blob_last_layer[wanted_blobs[i]] = layer_num;
+			}
+			//the top of a zero-copy concat is written since the first of its bottoms, and lives as long as them
+			for (int i = 1; i < blob_num; i++)
+			{
+				int top = i < blob_concat_top.size() ? blob_concat_top[i] : -1;
+				if (top > 0 && blob_first_layer[i] >= 0 && blob_first_layer[top] >= 0)
+				{
+					blob_first_layer[top] = __min(blob_first_layer[top], blob_first_layer[i]);
+					blob_last_layer[top] = __max(blob_last_layer[top], blob_last_layer[i]);
+				}
+			}
+			//a reshape view is in the memory of its source, which must live as long as the view
+			for (int i = 1; i < blob_num; i++)
+			{
+				if (i >= blob_reshape_source.size() || blob_reshape_source[i] <= 0 || blob_first_layer[i] < 0)
+					continue;
+				int root = blob_reshape_source[i];
+				while (blob_reshape_source[root] > 0)
+					root = blob_reshape_source[root];
+				blob_last_layer[root] = __max(blob_last_layer[root], blob_last_layer[i]);
+			}
+			plan_wanted_blobs = wanted_blobs;
+			plan_layer_step = layer_step;
+			plan_cache.clear();
+			plan_N = plan_C = plan_H = plan_W = -1;
+		}
+
+		void _find_blob_borders()
+		{
+			int blob_num = blobs.size();
+			blob_border_W.assign(blob_num, 0);
+			blob_border_H.assign(blob_num, 0);
+			for (int i = 1; i < layers.size(); i++)
+			{
+				int padW, padH;
+				_get_bottom_padding(i, padW, padH);
+				if (bottoms[i].size() == 0 || bottoms[i][0] <= 0)
+					continue;
+				int blob = bottoms[i][0];
+				blob_border_W[blob] = __max(blob_border_W[blob], padW);
+				blob_border_H[blob] = __max(blob_border_H[blob], padH);
+			}
+			for (int i = 1; i < blob_num; i++)
+			{
+				if (blobs[i])
+					blobs[i]->SetMinBorder(blob_border_W[i], blob_border_H[i]);
+			}
+		}
+
+		/*a bottom of a channel concat can be written into the top if it is produced by one convolution, depthwise convolution,
+		pooling, eltwise or flatten layer (whose kernels write only the C channels of each pixel), and it is not used by any 
+		other layer except in-place relu, prelu, batchnorm, scale and epilogue layers before the concat*/
+		void _find_concat_views()
+		{
+			int blob_num = blobs.size();
+			int layer_num = layers.size();
+			blob_concat_top.assign(blob_num, -1);
+			blob_concat_offset.assign(blob_num, -1);
+			for (int k = 1; k < layer_num; k++)
+			{
+				if (ZQ_CNN_Layer::_my_strcmpi(layer_type_names[k].c_str(), "Concat") != 0
+					|| ((ZQ_CNN_Layer_Concat*)layers[k])->axis != 1 || tops[k].size() != 1 || tops[k][0] <= 0)
+					continue;
+				int top = tops[k][0];
+				int top_producer_num = 0;
+				for (int i = 1; i < layer_num; i++)
+				{
+					if (std::find(tops[i].begin(), tops[i].end(), top) != tops[i].end())
+						top_producer_num++;
+				}
+				if (top_producer_num != 1)
+					continue;
+				for (int j = 0; j < bottoms[k].size(); j++)
+				{
+					if (_can_write_into_concat(bottoms[k][j], k))
+						blob_concat_top[bottoms[k][j]] = top;
+				}
+			}
+		}
+
+		bool _can_write_into_concat(int blob, int concat_layer) const
+		{
+			if (blob <= 0 || blob == tops[concat_layer][0] || blob_border_W[blob] > 0 || blob_border_H[blob] > 0
+				|| std::count(bottoms[concat_layer].begin(), bottoms[concat_layer].end(), blob) != 1)
+				return false;
+			int producer = -1;
+			for (int i = 1; i < layers.size(); i++)
+			{
+				if (i == concat_layer)
+					continue;
+				bool is_bottom = std::find(bottoms[i].begin(), bottoms[i].end(), blob) != bottoms[i].end();
+				bool is_top = std::find(tops[i].begin(), tops[i].end(), blob) != tops[i].end();
+				const char* type = layer_type_names[i].c_str();
+				if (is_bottom && is_top)
+				{
+					if (i > concat_layer || tops[i].size() != 1)
+						return false;
+					if (layer_fused_into[i] < 0 && (bottoms[i].size() != 1
+						|| (ZQ_CNN_Layer::_my_strcmpi(type, "ReLU") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "PReLU") != 0
+							&& ZQ_CNN_Layer::_my_strcmpi(type, "BatchNormScale") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "BatchNorm") != 0
+							&& ZQ_CNN_Layer::_my_strcmpi(type, "Scale") != 0)))
+						return false;
+				}
+				else if (is_top)
 				{
-					std::cout << "There's already a layer named " << layer_name << "!\n";
+					if (producer >= 0 || tops[i].size() != 1
+						|| (ZQ_CNN_Layer::_my_strcmpi(type, "Convolution") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "DepthwiseConvolution") != 0
+							&& ZQ_CNN_Layer::_my_strcmpi(type, "Pooling") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "Eltwise") != 0
+							&& ZQ_CNN_Layer::_my_strcmpi(type, "Flatten") != 0))
+						return false;
+					producer = i;
+				}
+				else if (is_bottom)
 					return false;
+			}
+			return producer >= 0 && producer < concat_layer;
+		}
+
+		/*find the channel offsets of the concat views for the shapes given by _setup*/
+		void _plan_concat_views()
+		{
+			int blob_num = blobs.size();
+			blob_concat_offset.assign(blob_num, -1);
+			for (int k = 1; k < layers.size(); k++)
+			{
+				//the concat does not run in a partial forward if its top is not planned
+				if (tops[k].size() != 1 || tops[k][0] <= 0 || bottoms[k].size() == 0 || blob_first_layer[tops[k][0]] < 0)
+					continue;
+				int top = tops[k][0];
+				bool has_view = false;
+				for (int j = 0; j < bottoms[k].size(); j++)
+					has_view = has_view || (bottoms[k][j] > 0 && blob_concat_top[bottoms[k][j]] == top);
+				if (!has_view)
+					continue;
+				int top_N, top_C, top_H, top_W;
+				blobs[top]->GetShape(top_N, top_C, top_H, top_W);
+				int align_C = 1;
+				if (blobs[top]->GetLayoutAlignType() == ZQ_CNN_Tensor4D::ALIGN_128bit)
+					align_C = 4;
+				else if (blobs[top]->GetLayoutAlignType() == ZQ_CNN_Tensor4D::ALIGN_256bit)
+					align_C = 8;
+				int offset = 0;
+				for (int j = 0; j < bottoms[k].size(); j++)
+				{
+					int N, C, H, W;
+					if (bottoms[k][j] == 0)
+						break;
+					blobs[bottoms[k][j]]->GetShape(N, C, H, W);
+					if (N != top_N || H != top_H || W != top_W || C <= 0)
+						break;
+					if (blob_concat_top[bottoms[k][j]] == top && offset % align_C == 0 && C % align_C == 0)
+						blob_concat_offset[bottoms[k][j]] = offset;
+					offset += C;
+				}
+				if (offset != top_C)
+				{
+					for (int j = 0; j < bottoms[k].size(); j++)
+					{
+						if (bottoms[k][j] > 0)
+							blob_concat_offset[bottoms[k][j]] = -1;
+					}
 				}
 			}
-			return true;
 		}
 
-		bool _check_connect()
+		/*the top of a Reshape, Flatten or Permute layer can use the memory of the bottom if the layer is its only producer,
+		and the bottom is not used by any other layer except in-place layers before it (the view is never written back)*/
+		void _find_reshape_views()
 		{
 			int blob_num = blobs.size();
 			int layer_num = layers.size();
-			if (layers.size() == 0 || blob_num == 0)
-				return false;
-			ZQ_CNN_Layer_Input* input_layer = (ZQ_CNN_Layer_Input*)(layers[0]);
-			if (has_innerproduct_layer)
+			blob_reshape_source.assign(blob_num, -1);
+			blob_reshape_planned.assign(blob_num, false);
+			for (int k = 1; k < layer_num; k++)
 			{
-				if (!input_layer->has_H_val || !input_layer->has_W_val)
+				const char* type = layer_type_names[k].c_str();
+				if (ZQ_CNN_Layer::_my_strcmpi(type, "Reshape") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "Flatten") != 0
+					&& ZQ_CNN_Layer::_my_strcmpi(type, "Permute") != 0)
+					continue;
+				if (bottoms[k].size() != 1 || tops[k].size() != 1)
+					continue;
+				int src = bottoms[k][0], top = tops[k][0];
+				if (src <= 0 || top <= 0 || src == top || blob_concat_top[top] > 0)
+					continue;
+				//a view has no border
+				if (blob_border_W[src] > 0 || blob_border_H[src] > 0 || blob_border_W[top] > 0 || blob_border_H[top] > 0)
+					continue;
+				bool valid = true;
+				int src_producer = -1;
+				for (int i = 1; i < layer_num && valid; i++)
 				{
-					std::cout << "Input dim must be specified for InnerProduct layer\n";
-					return false;
+					if (i == k)
+						continue;
+					bool src_is_bottom = std::find(bottoms[i].begin(), bottoms[i].end(), src) != bottoms[i].end();
+					bool src_is_top = std::find(tops[i].begin(), tops[i].end(), src) != tops[i].end();
+					bool top_is_bottom = std::find(bottoms[i].begin(), bottoms[i].end(), top) != bottoms[i].end();
+					bool top_is_top = std::find(tops[i].begin(), tops[i].end(), top) != tops[i].end();
+					if (src_is_bottom)
+						valid = src_is_top && i < k;
+					else if (src_is_top)
+					{
+						valid = i < k;
+						src_producer = i;
+					}
+					if (top_is_top)
+						valid = valid && top_is_bottom && i > k;
 				}
+				if (valid && src_producer >= 0)
+					blob_reshape_source[top] = src;
 			}
-			std::vector<bool> visited(blob_num);
-			std::vector<int> blob_dim_C(blob_num);
-			std::vector<int> blob_dim_H(blob_num);
-			std::vector<int> blob_dim_W(blob_num);
-			visited[0] = true;
-			blob_dim_C[0] = input_layer->C;
-			blob_dim_H[0] = input_layer->H;
-			blob_dim_W[0] = input_layer->W;
+		}
 
-			for (int i = 1; i < blob_num; i++)
-				visited[i] = false;
+		/*true if the permute keeps the order of the data, i.e. only moves the dims of size 1*/
+		static bool _is_permute_order_kept(const int order[4], const int dims[4])
+		{
+			int last = -1;
+			for (int i = 0; i < 4; i++)
+			{
+				if (dims[order[i]] == 1)
+					continue;
+				if (order[i] < last)
+					return false;
+				last = order[i];
+			}
+			return true;
+		}
 
-			for (int i = 1; i < layer_num; i++)
+		/*find the reshape views that can be used for the shapes given by _setup*/
+		void _plan_reshape_views()
+		{
+			int blob_num = blobs.size();
+			blob_reshape_planned.assign(blob_num, false);
+			for (int i = 1; i < blob_num; i++)
 			{
-				std::vector<std::string>& bottom_names = layers[i]->bottom_names;
-				int cur_bottom_c = 0;
-				int cur_bottom_h = 0;
-				int cur_bottom_w = 0;
-				for (int j = 0; j < bottom_names.size(); j++)
+				int src = blob_reshape_source[i];
+				if (src <= 0 || blob_first_layer[i] < 0 || blob_concat_offset[src] >= 0)
+					continue;
+				int layer = 0;
+				while (tops[layer].size() != 1 || tops[layer][0] != i)
+					layer++;
+				int N, C, H, W, src_N, src_C, src_H, src_W;
+				blobs[i]->GetShape(N, C, H, W);
+				blobs[src]->GetShape(src_N, src_C, src_H, src_W);
+				if (N != src_N || C != src_C || H*W != src_H*src_W || N*C*H*W <= 0)
+					continue;
+				if (ZQ_CNN_Layer::_my_strcmpi(layer_type_names[layer].c_str(), "Permute") == 0)
 				{
-					std::map<std::string, int>::iterator name_it = map_name_to_blob_idx.find(bottom_names[j]);
-					if (!visited[name_it->second])
-					{
-						std::cout << "unknown blob " << bottom_names[j] << " in Layer " << layers[i]->name << "\n";
-						return false;
-					}
-					/*if (j == 0)
-					{
-						cur_bottom_c = blob_dim_C[name_it->second];
-						cur_bottom_h = blob_dim_H[name_it->second];
-						cur_bottom_w = blob_dim_W[name_it->second];
-						layers[i]->SetBottomDim(cur_bottom_c,cur_bottom_h,cur_bottom_w);
-					}
-					else
-					{
-						if (blob_dim_C[name_it->second] != cur_bottom_c || blob_dim_H[name_it->second] != cur_bottom_h 
-							|| blob_dim_W[name_it->second] != cur_bottom_w)
-						{
-							std::cout << "Dimension mismatch detected in layer " << layers[i]->name << "\n";
-							return false;
-						}
-					}*/
+					int dims[4] = { src_N, src_C, src_H, src_W };
+					if (!_is_permute_order_kept(((ZQ_CNN_Layer_Permute*)layers[layer])->order, dims))
+						continue;
 				}
-				std::vector<std::string>& top_names = layers[i]->top_names;
-				for (int j = 0; j < top_names.size(); j++)
+				blob_reshape_planned[i] = true;
+			}
+		}
+
+		/*the views are made when the layers call ChangeSize*/
+		void _bind_reshape_views(int in_N, int in_C, int in_H, int in_W)
+		{
+			bool planned = in_N == plan_N && in_C == plan_C && in_H == plan_H && in_W == plan_W;
+			for (int i = 1; i < blobs.size(); i++)
+			{
+				if (planned && blob_reshape_planned[i])
+					blobs[i]->SetReshapeView(blobs[blob_reshape_source[i]]);
+				else if (blob_reshape_source[i] > 0)
+					blobs[i]->SetReshapeView(0);
+			}
+		}
+
+		/*the tops are allocated before the layers that write into them*/
+		void _bind_concat_views(int in_N, int in_C, int in_H, int in_W)
+		{
+			bool planned = in_N == plan_N && in_C == plan_C && in_H == plan_H && in_W == plan_W;
+			for (int i = 1; i < blobs.size(); i++)
+			{
+				int top = blob_concat_top[i];
+				if (!planned || top <= 0 || blob_concat_offset[i] < 0)
 				{
-					std::map<std::string, int>::iterator name_it = map_name_to_blob_idx.find(top_names[j]);
-					visited[name_it->second] = true;
-					//layers[i]->GetTopDim(blob_dim_C[name_it->second], blob_dim_H[name_it->second], blob_dim_W[name_it->second]);
+					blobs[i]->SetChannelView(0, 0);
+					continue;
 				}
+				int N, C, H, W;
+				blobs[top]->GetShape(N, C, H, W);
+				if (blobs[top]->ChangeSize(N, H, W, C, 0, 0))
+					blobs[i]->SetChannelView(blobs[top], blob_concat_offset[i]);
+				else
+					blobs[i]->SetChannelView(0, 0);
 			}
+		}
 
-			/*for (int i = 1; i < blob_num; i++)
+		/*the layers do not call ChangeSize if the shape of a top is not changed, so the blobs are moved here 
+		to the memory and views of the current plan, which may differ from the last call (e.g. other wanted blobs)*/
+		void _rebind_blobs()
+		{
+			for (int i = 1; i < blobs.size(); i++)
 			{
-				blobs[i]->ChangeSize(1, blob_dim_H[i], blob_dim_W[i], blob_dim_C[i], 0, 0);
-			}*/
+				ZQ_CNN_Tensor4D* blob = blobs[i];
+				if (blob->GetN() > 0 && blob->GetH() > 0 && blob->GetW() > 0 && blob->GetC() > 0)
+					blob->ChangeSize(blob->GetN(), blob->GetH(), blob->GetW(), blob->GetC(), blob->GetBorderW(), blob->GetBorderH());
+			}
+		}
 
-			if (!_setup())
+		/*stops both the concat views and the reshape views*/
+		void _unbind_views()
+		{
+			for (int i = 1; i < blobs.size(); i++)
 			{
-				return false;
+				if (blobs[i])
+					blobs[i]->SetChannelView(0, 0);
 			}
-			return true;
 		}
 
-		bool _setup()
+		bool _plan_memory(int in_N, int in_C, int in_H, int in_W)
 		{
-			ZQ_CNN_Tensor4D_NHW_C_Align0 input;
-			input.SetShape(1, input_C, input_H, input_W);
-			if (map_name_to_blob_idx.size() == 0 || map_name_to_layer_idx.size() == 0 || tops.size() == 0)
-				return false;
-			
-			blobs[0] = &input;
+			std::vector<int> shape(4);
+			shape[0] = in_N;
+			shape[1] = in_C;
+			shape[2] = in_H;
+			shape[3] = in_W;
+			std::map<std::vector<int>, CachedPlan>::const_iterator it = plan_cache.find(shape);
+			if (it != plan_cache.end())
+			{
+				const CachedPlan& plan = it->second;
+				for (int i = 1; i < blobs.size(); i++)
+					blobs[i]->SetShape(plan.blob_shapes[i * 4], plan.blob_shapes[i * 4 + 1], plan.blob_shapes[i * 4 + 2], plan.blob_shapes[i * 4 + 3]);
+				blob_plan_offset = plan.blob_plan_offset;
+				blob_plan_len = plan.blob_plan_len;
+				blob_concat_offset = plan.blob_concat_offset;
+				blob_reshape_planned = plan.blob_reshape_planned;
+				planned_blob_bytes = plan.planned_blob_bytes;
+				naive_blob_bytes = plan.naive_blob_bytes;
+				plan_N = in_N;
+				plan_C = in_C;
+				plan_H = in_H;
+				plan_W = in_W;
+				return true;
+			}
 
-			for (int i = 0; i < layers.size(); i++)
+			blob_concat_offset.assign(blobs.size(), -1);
+			blob_reshape_planned.assign(blobs.size(), false);
+			if (!_setup(in_N, in_C, in_H, in_W))
+				return false;
+			_plan_concat_views();
+			_plan_reshape_views();
+			int blob_num = blobs.size();
+			const __int64 align_bytes = 64;
+			blob_plan_offset.assign(blob_num, 0);
+			blob_plan_len.assign(blob_num, 0);
+			naive_blob_bytes = 0;
+			std::vector<int> order;
+			for (int i = 1; i < blob_num; i++)
 			{
-				std::vector<ZQ_CNN_Tensor4D*> bottom_ptrs, top_ptrs;
-				for (int j = 0; j < bottoms[i].size(); j++)
-					bottom_ptrs.push_back(blobs[bottoms[i][j]]);
-				for (int j = 0; j < tops[i].size(); j++)
-					top_ptrs.push_back(blobs[tops[i][j]]);
+				if (blob_first_layer[i] < 0 || blob_concat_offset[i] >= 0 || blob_reshape_planned[i])
+					continue;
+				int N, C, H, W;
+				blobs[i]->GetShape(N, C, H, W);
+				if (N <= 0 || C <= 0 || H <= 0 || W <= 0)
+					continue;
+				__int64 pixStep = C;
+				if (blobs[i]->GetLayoutAlignType() == ZQ_CNN_Tensor4D::ALIGN_128bit)
+					pixStep = (C + 3) >> 2 << 2;
+				else if (blobs[i]->GetLayoutAlignType() == ZQ_CNN_Tensor4D::ALIGN_256bit)
+					pixStep = (C + 7) >> 3 << 3;
+				__int64 len = pixStep*(H + 2 * blob_border_H[i])*(W + 2 * blob_border_W[i])*N * sizeof(float);
+				blob_plan_len[i] = (len + align_bytes - 1) / align_bytes * align_bytes;
+				naive_blob_bytes += blob_plan_len[i];
+				order.push_back(i);
+			}
 
-				layers[i]->show_debug_info = show_debug_info;
-				if (!layers[i]->LayerSetup(&bottom_ptrs, &top_ptrs))
+			/*greedy: place the larger blobs first, each at the lowest offset not used by a live blob*/
+			for (int i = 0; i < order.size(); i++)
+			{
+				for (int j = i + 1; j < order.size(); j++)
 				{
-					blobs[0] = 0;
-					tops[0][0] = 0;
-					printf("failed to setup layer: %s\n", layers[i]->name.c_str());
-					return false;
+					if (blob_plan_len[order[j]] > blob_plan_len[order[i]])
+					{
+						int tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+					}
 				}
 			}
-			blobs[0] = 0;
-			tops[0][0] = 0;
+			__int64 total_len = 0;
+			for (int i = 0; i < order.size(); i++)
+			{
+				int cur = order[i];
+				std::vector<std::pair<__int64, __int64> > used;
+				for (int j = 0; j < i; j++)
+				{
+					int other = order[j];
+					if (blob_last_layer[cur] < blob_first_layer[other] || blob_last_layer[other] < blob_first_layer[cur])
+						continue;
+					used.push_back(std::make_pair(blob_plan_offset[other], blob_plan_offset[other] + blob_plan_len[other]));
+				}
+				std::sort(used.begin(), used.end());
+				__int64 offset = 0;
+				for (int j = 0; j < used.size(); j++)
+				{
+					if (offset + blob_plan_len[cur] <= used[j].first)
+						break;
+					offset = __max(offset, used[j].second);
+				}
+				blob_plan_offset[cur] = offset;
+				total_len = __max(total_len, offset + blob_plan_len[cur]);
+			}
+			planned_blob_bytes = total_len;
+			plan_N = in_N;
+			plan_C = in_C;
+			plan_H = in_H;
+			plan_W = in_W;
+			if (show_debug_info)
+			{
+				printf("memory plan for input %d x %d x %d x %d: %.2f M (naive %.2f M)\n", in_N, in_C, in_H, in_W,
+					planned_blob_bytes / (1024.0*1024.0), naive_blob_bytes / (1024.0*1024.0));
+			}
+
+			if (plan_cache.size() >= ZQ_CNN_MAX_CACHED_PLANS)
+				plan_cache.clear();
+			CachedPlan& plan = plan_cache[shape];
+			plan.blob_shapes.assign(blob_num * 4, 0);
+			for (int i = 1; i < blob_num; i++)
+				blobs[i]->GetShape(plan.blob_shapes[i * 4], plan.blob_shapes[i * 4 + 1], plan.blob_shapes[i * 4 + 2], plan.blob_shapes[i * 4 + 3]);
+			plan.blob_plan_offset = blob_plan_offset;
+			plan.blob_plan_len = blob_plan_len;
+			plan.blob_concat_offset = blob_concat_offset;
+			plan.blob_reshape_planned = blob_reshape_planned;
+			plan.planned_blob_bytes = planned_blob_bytes;
+			plan.naive_blob_bytes = naive_blob_bytes;
+			return true;
+		}
+
+		bool _bind_memory_plan(int in_N, int in_C, int in_H, int in_W, const std::vector<int>& wanted_blobs)
+		{
+			if (wanted_blobs != plan_wanted_blobs || layer_step != plan_layer_step)
+				_compute_blob_lifetime(wanted_blobs);
+			if (in_N != plan_N || in_C != plan_C || in_H != plan_H || in_W != plan_W)
+			{
+				if (!_plan_memory(in_N, in_C, in_H, in_W))
+					return false;
+			}
+			if (_blob_memory.len < planned_blob_bytes)
+			{
+				/*blobs still pointing to the old memory will not touch it before ChangeSize*/
+				_unbind_memory_plan();
+				_blob_memory.Release();
+				_blob_memory.data = _aligned_malloc(planned_blob_bytes, 64);
+				if (_blob_memory.data == 0)
+					return false;
+				memset(_blob_memory.data, 0, planned_blob_bytes);
+				_blob_memory.len = planned_blob_bytes;
+			}
+			for (int i = 1; i < blobs.size(); i++)
+			{
+				if (blob_plan_len[i] > 0)
+					blobs[i]->SetExternalMemory((unsigned char*)_blob_memory.data + blob_plan_offset[i], blob_plan_len[i]);
+				else
+					blobs[i]->SetExternalMemory(0, 0);
+			}
 			return true;
 		}
 
+		void _unbind_memory_plan()
+		{
+			for (int i = 1; i < blobs.size(); i++)
+			{
+				if (blobs[i])
+					blobs[i]->SetExternalMemory(0, 0);
+			}
+		}
+
 		void _simplify_inplace()
 		{
 			for (int i = 0; i < layers.size(); i++)
@@ -1700,6 +3328,196 @@ namespace ZQ
 			return true;
 		}
 
+		/*fold the elementwise layers after a convolution or depthwise convolution into its epilogue, a folded layer is kept
+		in the net with its own bottoms and tops to run by itself when it is not done by the epilogue (see _update_forward_epilogue)*/
+		void _fold_into_epilogue()
+		{
+			int layer_num = layers.size();
+			layer_fused_into.assign(layer_num, -1);
+			for (int i = 1; i < layer_num; i++)
+			{
+				layers[i]->fused_ops.clear();
+				const char* type = layer_type_names[i].c_str();
+				if ((ZQ_CNN_Layer::_my_strcmpi(type, "Convolution") != 0 && ZQ_CNN_Layer::_my_strcmpi(type, "DepthwiseConvolution") != 0)
+					|| bottoms[i].size() != 1 || tops[i].size() != 1 || tops[i][0] <= 0)
+					continue;
+				int top = tops[i][0];
+				for (int j = i + 1; j < layer_num; j++)
+				{
+					if (std::find(bottoms[j].begin(), bottoms[j].end(), top) == bottoms[j].end()
+						&& std::find(tops[j].begin(), tops[j].end(), top) == tops[j].end())
+						continue;
+					ZQ_CNN_Forward_SSEUtils::EpilogueOp op;
+					int residual = -1;
+					if (!_get_epilogue_op(j, top, op, residual) || !_can_fold_into(i, j, top, residual))
+						break;
+					layer_fused_into[j] = i;
+					top = tops[j][0];
+					layers[i]->fused_ops.push_back(op);
+					if (residual >= 0)
+						bottoms[i].push_back(residual);
+				}
+			}
+		}
+
+		/*the folded layers done by the epilogue in a Forward with wanted_blobs, all of them if use_epilogue. But a layer not in
+		place is done only if its bottom is not wanted (every blob is wanted if wanted_blobs is empty and the memory plan is off),
+		then its bottom is not written and the owner writes its top. The layers from the first one not done run by themselves*/
+		void _update_forward_epilogue(const std::vector<int>& wanted_blobs)
+		{
+			int layer_num = layers.size();
+			std::vector<int> fused_into(layer_num, -1), epilogue_top(layer_num, -1);
+			std::vector<bool> is_wanted(blobs.size(), wanted_blobs.size() == 0 && !use_memory_plan);
+			for (int i = 0; i < wanted_blobs.size(); i++)
+				is_wanted[wanted_blobs[i]] = true;
+			for (int i = 0; i < layer_num; i++)
+			{
+				layers[i]->used_fused_op_num = 0;
+				if (tops[i].size() == 0)
+					continue;
+				int top = tops[i][0];
+				for (int j = i + 1; j < layer_num && use_epilogue && layers[i]->fused_ops.size() > 0; j++)
+				{
+					if (layer_fused_into[j] != i)
+						continue;
+					bool is_needed = j >= forward_needed_layers.size() || forward_needed_layers[j];
+					if (!is_needed || (tops[j][0] != top && is_wanted[top]))
+						break;
+					fused_into[j] = i;
+					top = tops[j][0];
+					layers[i]->used_fused_op_num++;
+				}
+				epilogue_top[i] = top;
+			}
+			if (fused_into != forward_fused_into || epilogue_top != forward_epilogue_top)
+			{
+				forward_fused_into = fused_into;
+				forward_epilogue_top = epilogue_top;
+				//the steps and the lifetimes are made again
+				layer_step.clear();
+				plan_layer_step.clear();
+			}
+		}
+
+		/*the epilogue op of layer j whose input is blob top, residual is the other bottom of an eltwise sum*/
+		bool _get_epilogue_op(int j, int top, ZQ_CNN_Forward_SSEUtils::EpilogueOp& op, int& residual) const
+		{
+			typedef ZQ_CNN_Forward_SSEUtils::EpilogueOp Op;
+			const char* type = layer_type_names[j].c_str();
+			residual = -1;
+			if (tops[j].size() != 1 || tops[j][0] <= 0)
+				return false;
+			if (ZQ_CNN_Layer::_my_strcmpi(type, "Eltwise") == 0)
+			{
+				const ZQ_CNN_Layer_Eltwise* layer = (const ZQ_CNN_Layer_Eltwise*)layers[j];
+				if (layer->operation != ZQ_CNN_Layer_Eltwise::ELTWISE_SUM || layer->with_weight || bottoms[j].size() != 2
+					|| std::count(bottoms[j].begin(), bottoms[j].end(), top) != 1)
+					return false;
+				residual = bottoms[j][0] == top ? bottoms[j][1] : bottoms[j][0];
+				op = Op(Op::ELTWISE_SUM);
+				return true;
+			}
+			if (bottoms[j].size() != 1 || bottoms[j][0] != top)
+				return false;
+			if (ZQ_CNN_Layer::_my_strcmpi(type, "ReLU") == 0)
+			{
+				op = Op(Op::RELU, 0, 0, ((const ZQ_CNN_Layer_ReLU*)layers[j])->slope);
+				return true;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type, "PReLU") == 0)
+			{
+				const ZQ_CNN_Layer_PReLU* layer = (const ZQ_CNN_Layer_PReLU*)layers[j];
+				op = Op(Op::PRELU, layer->slope);
+				return layer->slope != 0;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type, "BatchNormScale") == 0)
+			{
+				const ZQ_CNN_Layer_BatchNormScale* layer = (const ZQ_CNN_Layer_BatchNormScale*)layers[j];
+				op = Op(Op::BATCHNORM_B_A, layer->a, layer->b);
+				return layer->a != 0 && layer->b != 0;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type, "BatchNorm") == 0)
+			{
+				const ZQ_CNN_Layer_BatchNorm* layer = (const ZQ_CNN_Layer_BatchNorm*)layers[j];
+				op = Op(Op::BATCHNORM_B_A, layer->a, layer->b);
+				return layer->a != 0 && layer->b != 0;
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type, "Scale") == 0)
+			{
+				const ZQ_CNN_Layer_Scale* layer = (const ZQ_CNN_Layer_Scale*)layers[j];
+				op = Op(Op::SCALE, layer->scale, layer->with_bias ? layer->bias : 0);
+				return layer->scale != 0 && (!layer->with_bias || layer->bias != 0);
+			}
+			else if (ZQ_CNN_Layer::_my_strcmpi(type, "ScalarOperation") == 0)
+			{
+				const ZQ_CNN_Layer_ScalarOperation* layer = (const ZQ_CNN_Layer_ScalarOperation*)layers[j];
+				float scalar = layer->scalar;
+				switch (layer->operation)
+				{
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_MUL:
+					op = Op(Op::SCALAR_MUL, 0, 0, scalar);
+					return true;
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_DIV:
+					op = Op(Op::SCALAR_MUL, 0, 0, 1.0 / scalar);
+					return true;
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_ADD:
+					op = Op(Op::SCALAR_ADD, 0, 0, scalar);
+					return true;
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_MINUS:
+					op = Op(Op::SCALAR_ADD, 0, 0, -scalar);
+					return true;
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_MAX:
+					op = Op(Op::SCALAR_MAX, 0, 0, scalar);
+					return true;
+				case ZQ_CNN_Layer_ScalarOperation::SCALAR_MIN:
+					op = Op(Op::SCALAR_MIN, 0, 0, scalar);
+					return true;
+				default:
+					return false;
+				}
+			}
+			return false;
+		}
+
+		/*layer j can be folded into layer i if the residual is ready before layer i and not changed until layer j, 
+		and if layer j is not in place, its input (blob top) is not used after it and its output has no other producer*/
+		bool _can_fold_into(int i, int j, int top, int residual) const
+		{
+			int new_top = tops[j][0];
+			if (residual >= 0)
+			{
+				if (residual == top || residual == new_top)
+					return false;
+				bool is_ready = false;
+				for (int k = 0; k < j; k++)
+				{
+					if (std::find(tops[k].begin(), tops[k].end(), residual) == tops[k].end())
+						continue;
+					if (k >= i)
+						return false;
+					is_ready = true;
+				}
+				if (!is_ready)
+					return false;
+			}
+			if (new_top != top)
+			{
+				for (int k = j + 1; k < layers.size(); k++)
+				{
+					if (std::find(bottoms[k].begin(), bottoms[k].end(), top) != bottoms[k].end())
+						return false;
+					if (std::find(tops[k].begin(), tops[k].end(), top) != tops[k].end())
+						break;
+				}
+				for (int k = 1; k < layers.size(); k++)
+				{
+					if (k != j && std::find(tops[k].begin(), tops[k].end(), new_top) != tops[k].end())
+						return false;
+				}
+			}
+			return true;
+		}
+
 		bool _swap_input_RGB_and_BGR(const std::vector<std::string>& layer_names)
 		{
 			int blob_num = blobs.size();
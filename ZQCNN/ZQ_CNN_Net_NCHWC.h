@@ -57,6 +57,8 @@ namespace ZQ
 			bool merge_prelu = false)
 		{
 			_clear();
+			if (!_check_cpu())
+				return false;
 			this->ignore_small_value = ignore_small_value;
 			if (!_load_param_file(param_file))
 			{
@@ -100,6 +102,8 @@ namespace ZQ
 			bool merge_bn = false, float ignore_small_value = 1e-12, bool merge_prelu = false)
 		{
 			_clear();
+			if (!_check_cpu())
+				return false;
 			this->ignore_small_value = ignore_small_value;
 			if (!_load_param_from_buffer(param_buffer, param_buffer_len))
 			{
@@ -744,6 +748,17 @@ namespace ZQ
 			return true;
 		}
 
+		/*the C8 kernels of a ZQ_CNN_DISPATCH_SSETYPE build only run on the cpus with AVX2*/
+		bool _check_cpu() const
+		{
+			if (Tensor4D().GetAlignType() == Tensor4D::ALIGN_C8 && !ZQ_CNN_CAN_RUN_256BIT)
+			{
+				std::cout << "this cpu does not support AVX2, which ZQ_CNN_Tensor4D_NCHWC8 needs, use ZQ_CNN_Tensor4D_NCHWC4 instead\n";
+				return false;
+			}
+			return true;
+		}
+
 		bool _check_connect()
 		{
 			int blob_num = blobs.size();
@@ -3,10 +3,123 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <limits.h>
 #include "layers_c/zq_cnn_resize_32f_align_c.h"
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <emmintrin.h>
+#endif
 
 using namespace ZQ;
 
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+/* B,G,R,0 of the pixel p in float, the 4 bytes are read unless p is the last pixel of the row */
+static inline __m128 _load_bgr_ps(const unsigned char* p, bool is_last)
+{
+	int v;
+	if (is_last)
+		v = p[0] | (p[1] << 8) | (p[2] << 16);
+	else
+	{
+		memcpy(&v, p, 4);
+		v &= 0x00FFFFFF;
+	}
+	__m128i zero = _mm_setzero_si128();
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero));
+}
+
+/* the pixels x0 and x1 (byte offsets) of the row, with one 8-byte read if they are neighbours inside the row */
+static inline void _load_bgr_pair_ps(const unsigned char* row, int x0, int x1, int row_len, __m128& v0, __m128& v1)
+{
+	if (x1 == x0 + 3 && x0 + 8 <= row_len)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i mask = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+		__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + x0)), zero);
+		v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_and_si128(v, mask), zero));
+		v1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_and_si128(_mm_srli_si128(v, 6), mask), zero));
+	}
+	else
+	{
+		v0 = _load_bgr_ps(row + x0, x0 + 3 == row_len);
+		v1 = _load_bgr_ps(row + x1, x1 + 3 == row_len);
+	}
+}
+#endif
+
+bool ZQ_CNN_Tensor4D::ResizeBilinearRectFromBGR(int n, const unsigned char* BGR_img, int _width, int _height, int _widthStep,
+	int src_off_x, int src_off_y, int src_rect_w, int src_rect_h, const float mean_val, const float scale)
+{
+	if (n < 0 || n >= N || C != 3 || H <= 0 || W <= 0 || _width <= 0 || _height <= 0 || src_rect_w <= 0 || src_rect_h <= 0)
+		return false;
+
+	/* the same map as zq_cnn_resize_without_safeborder: x is clamped in the image, y may be the border row below it */
+	std::vector<int> x0(W), x1(W);
+	std::vector<float> sx(W);
+	float w_step = 1.0f / (float)W*src_rect_w;
+	float h_step = 1.0f / (float)H*src_rect_h;
+	float coord_x = 0.5f*w_step - 0.5f + (float)src_off_x;
+	float coord_y = 0.5f*h_step - 0.5f + (float)src_off_y;
+	for (int w = 0; w < W; w++, coord_x += w_step)
+	{
+		float x0_f = floor(coord_x);
+		int cur_x = (int)x0_f;
+		sx[w] = coord_x - x0_f;
+		x0[w] = __min(_width - 1, __max(0, cur_x)) * 3;
+		x1[w] = __min(_width - 1, __max(0, cur_x + 1)) * 3;
+	}
+
+	float* out_row = firstPixelData + (long long)n*sliceStep;
+	for (int h = 0; h < H; h++, coord_y += h_step, out_row += widthStep)
+	{
+		float y0_f = floor(coord_y);
+		int y0 = (int)y0_f;
+		float sy = coord_y - y0_f;
+		int y1 = __min(_height, __max(0, y0 + 1));
+		y0 = __min(_height, __max(0, y0));
+		/* the border row is zero after normalizing, i.e. mean_val before */
+		const unsigned char* row0 = y0 < _height ? BGR_img + (long long)y0*_widthStep : 0;
+		const unsigned char* row1 = y1 < _height ? BGR_img + (long long)y1*_widthStep : 0;
+		float* out_pix = out_row;
+		int w = 0;
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+		if (pixelStep >= 4)
+		{
+			__m128 mean_v = _mm_setr_ps(mean_val, mean_val, mean_val, 0);
+			__m128 scale_v = _mm_set1_ps(scale);
+			__m128 sy_v = _mm_set1_ps(sy);
+			__m128 v00 = mean_v, v01 = mean_v, v10 = mean_v, v11 = mean_v;
+			int row_len = _width * 3;
+			for (; w < W; w++, out_pix += pixelStep)
+			{
+				__m128 cur_sx = _mm_set1_ps(sx[w]);
+				if (row0)
+					_load_bgr_pair_ps(row0, x0[w], x1[w], row_len, v00, v01);
+				if (row1)
+					_load_bgr_pair_ps(row1, x0[w], x1[w], row_len, v10, v11);
+				__m128 result0 = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v01, v00), cur_sx));
+				__m128 result1 = _mm_add_ps(v10, _mm_mul_ps(_mm_sub_ps(v11, v10), cur_sx));
+				__m128 sum = _mm_add_ps(result0, _mm_mul_ps(_mm_sub_ps(result1, result0), sy_v));
+				_mm_storeu_ps(out_pix, _mm_mul_ps(_mm_sub_ps(sum, mean_v), scale_v));
+			}
+		}
+#endif
+		for (; w < W; w++, out_pix += pixelStep)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				float v00 = row0 ? row0[x0[w] + c] : mean_val;
+				float v01 = row0 ? row0[x1[w] + c] : mean_val;
+				float v10 = row1 ? row1[x0[w] + c] : mean_val;
+				float v11 = row1 ? row1[x1[w] + c] : mean_val;
+				float result0 = v00 + (v01 - v00)*sx[w];
+				float result1 = v10 + (v11 - v10)*sx[w];
+				out_pix[c] = (result0 + (result1 - result0)*sy - mean_val)*scale;
+			}
+		}
+	}
+	return true;
+}
+
 
 ZQ_CNN_Tensor4D_NHW_C_Align0::ZQ_CNN_Tensor4D_NHW_C_Align0()
 {
@@ -29,6 +142,16 @@ ZQ_CNN_Tensor4D_NHW_C_Align0::ZQ_CNN_Tensor4D_NHW_C_Align0()
 	firstPixelData = 0;
 	rawData = 0;
 	rawDataLen = 0;
+	rawDataCapacity = 0;
+	externalData = 0;
+	externalDataLen = 0;
+	rawDataIsExternal = false;
+	minBorderW = 0;
+	minBorderH = 0;
+	borderIsZero = false;
+	viewTensor = 0;
+	viewChannelOffset = 0;
+	viewIsReshape = false;
 
 	align_type = ALIGN_0;
 }
@@ -36,11 +159,11 @@ ZQ_CNN_Tensor4D_NHW_C_Align0::ZQ_CNN_Tensor4D_NHW_C_Align0()
 
 ZQ_CNN_Tensor4D_NHW_C_Align0::~ZQ_CNN_Tensor4D_NHW_C_Align0()
 {
-	if (rawData)
+	if (rawData && !rawDataIsExternal)
 	{
 		free(rawData);
-		rawData = 0;
 	}
+	rawData = 0;
 }
 
 
@@ -65,6 +188,14 @@ void ZQ_CNN_Tensor4D_NHW_C_Align0::Swap(ZQ_CNN_Tensor4D_NHW_C_Align0& other)
 	float* tmp_firstPixelData = firstPixelData; firstPixelData = other.firstPixelData; other.firstPixelData = tmp_firstPixelData;
 	unsigned char* tmp_rawData = rawData; rawData = other.rawData; other.rawData = tmp_rawData;
 	long long tmp_rawDataLen = rawDataLen; rawDataLen = other.rawDataLen; other.rawDataLen = tmp_rawDataLen;
+	long long tmp_rawDataCapacity = rawDataCapacity; rawDataCapacity = other.rawDataCapacity; other.rawDataCapacity = tmp_rawDataCapacity;
+	unsigned char* tmp_externalData = externalData; externalData = other.externalData; other.externalData = tmp_externalData;
+	long long tmp_externalDataLen = externalDataLen; externalDataLen = other.externalDataLen; other.externalDataLen = tmp_externalDataLen;
+	bool tmp_rawDataIsExternal = rawDataIsExternal; rawDataIsExternal = other.rawDataIsExternal; other.rawDataIsExternal = tmp_rawDataIsExternal;
+	bool tmp_borderIsZero = borderIsZero; borderIsZero = other.borderIsZero; other.borderIsZero = tmp_borderIsZero;
+	ZQ_CNN_Tensor4D* tmp_viewTensor = viewTensor; viewTensor = other.viewTensor; other.viewTensor = tmp_viewTensor;
+	int tmp_viewChannelOffset = viewChannelOffset; viewChannelOffset = other.viewChannelOffset; other.viewChannelOffset = tmp_viewChannelOffset;
+	bool tmp_viewIsReshape = viewIsReshape; viewIsReshape = other.viewIsReshape; other.viewIsReshape = tmp_viewIsReshape;
 }
 
 
@@ -97,8 +228,9 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align0::Padding(int padW, int padH, int mode)
 			}
 		}
 		Swap(tmp);
+		borderIsZero = true;
 	}
-	else
+	else if (!borderIsZero)
 	{
 		float* slice_ptr = firstPixelData;
 		for (int n = 0; n < N; n++, slice_ptr += sliceStep)
@@ -116,14 +248,26 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align0::Padding(int padW, int padH, int mode)
 				memset(row_ptr + W*pixelStep, 0, sizeof(float)*borderW*pixelStep);
 			}
 		}
+		borderIsZero = true;
 	}
 	return true;
 }
 
 bool ZQ_CNN_Tensor4D_NHW_C_Align0::ChangeSize(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
 {
-	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH)
+	dst_borderW = __max(dst_borderW, minBorderW);
+	dst_borderH = __max(dst_borderH, minBorderH);
+	if (_can_use_view(dst_N, dst_H, dst_W, dst_C, dst_borderW, dst_borderH))
+	{
+		if (rawData && !rawDataIsExternal)
+			free(rawData);
+		_use_view(dst_N, dst_H, dst_W, dst_C);
+		return true;
+	}
+	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH
+		&& (externalData == 0 ? !rawDataIsExternal : rawData == externalData))
 		return true;
+	borderIsZero = false;
 	shape_nchw[0] = dst_N;
 	shape_nchw[1] = dst_C;
 	shape_nchw[2] = dst_H;
@@ -131,14 +275,19 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align0::ChangeSize(int dst_N, int dst_H, int dst_W, i
 	int dst_realW = dst_W + (dst_borderW << 1);
 	int dst_realH = dst_H + (dst_borderH << 1);
 	int dst_pixelStep = dst_C;
-	int dst_widthStep = dst_pixelStep*dst_realW;
-	int dst_sliceStep = dst_widthStep*dst_realH;
-	int dst_tensor_raw_size = dst_sliceStep*dst_N * sizeof(float);
-	int needed_dst_raw_len = dst_tensor_raw_size;
-	if (dst_tensor_raw_size == 0)
+	long long dst_widthStep = (long long)dst_pixelStep*dst_realW;
+	long long dst_sliceStep = dst_widthStep*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX) //the steps are int
+		return false;
+	if (needed_dst_raw_len == 0)
 	{
-		free(rawData);
-		rawData = 0;
+		//keep the owned memory for the next shape
+		if (rawDataIsExternal)
+		{
+			rawData = 0;
+			rawDataIsExternal = false;
+		}
 		firstPixelData = 0;
 		rawDataLen = 0;
 
@@ -156,15 +305,25 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align0::ChangeSize(int dst_N, int dst_H, int dst_W, i
 	}
 	else
 	{
-		if (rawDataLen != needed_dst_raw_len)
+		if (externalData != 0 && needed_dst_raw_len <= externalDataLen)
+		{
+			if (rawData && !rawDataIsExternal)
+				free(rawData);
+			rawData = externalData;
+			rawDataIsExternal = true;
+			rawDataCapacity = 0;
+		}
+		else if (rawDataIsExternal || rawDataCapacity < needed_dst_raw_len)
 		{
 			unsigned char* tmp_data = (unsigned char*)malloc(needed_dst_raw_len);
 			if (tmp_data == 0)
 				return false;
 			//memset(tmp_data, 0, needed_dst_raw_len);
-			if(rawData)	
+			if(rawData && !rawDataIsExternal)	
 				free(rawData);
 			rawData = tmp_data;
+			rawDataIsExternal = false;
+			rawDataCapacity = needed_dst_raw_len;
 		}
 
 		firstPixelData = (float*)rawData + dst_borderH*dst_widthStep + dst_borderW*dst_pixelStep;
@@ -180,13 +339,51 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align0::ChangeSize(int dst_N, int dst_H, int dst_W, i
 		realHeight = dst_realH;
 		realWidth = dst_realW;
 		pixelStep = dst_pixelStep;
-		widthStep = dst_widthStep;
-		sliceStep = dst_sliceStep;
+		widthStep = (int)dst_widthStep;
+		sliceStep = (int)dst_sliceStep;
 	}
 
 	return true;
 }
 
+bool ZQ_CNN_Tensor4D_NHW_C_Align0::Reserve(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
+{
+	if (rawDataIsExternal)
+		return true;
+	int dst_realW = dst_W + (dst_borderW << 1);
+	int dst_realH = dst_H + (dst_borderH << 1);
+	int dst_pixelStep = dst_C;
+	long long dst_sliceStep = (long long)dst_pixelStep*dst_realW*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX)
+		return false;
+	if (needed_dst_raw_len <= rawDataCapacity)
+		return true;
+	unsigned char* tmp_data = (unsigned char*)malloc(needed_dst_raw_len);
+	if (tmp_data == 0)
+		return false;
+	if (rawData)
+	{
+		//keep the current data
+		memcpy(tmp_data, rawData, rawDataLen);
+		if (firstPixelData)
+			firstPixelData = (float*)(tmp_data + ((unsigned char*)firstPixelData - rawData));
+		free(rawData);
+	}
+	rawData = tmp_data;
+	rawDataCapacity = needed_dst_raw_len;
+	return true;
+}
+
+void ZQ_CNN_Tensor4D_NHW_C_Align0::ShrinkToFit()
+{
+	ChangeSize(0, 0, 0, 0, 0, 0);
+	if (rawData && !rawDataIsExternal)
+		free(rawData);
+	rawData = 0;
+	rawDataCapacity = 0;
+}
+
 
 bool ZQ_CNN_Tensor4D_NHW_C_Align0::ResizeBilinearRect(ZQ_CNN_Tensor4D& dst, int dst_W, int dst_H, int dst_borderW, int dst_borderH,
 	int src_off_x, int src_off_y, int src_rect_w, int src_rect_h) const
@@ -389,6 +586,16 @@ ZQ_CNN_Tensor4D_NHW_C_Align128bit::ZQ_CNN_Tensor4D_NHW_C_Align128bit()
 	firstPixelData = 0;
 	rawData = 0;
 	rawDataLen = 0;
+	rawDataCapacity = 0;
+	externalData = 0;
+	externalDataLen = 0;
+	rawDataIsExternal = false;
+	minBorderW = 0;
+	minBorderH = 0;
+	borderIsZero = false;
+	viewTensor = 0;
+	viewChannelOffset = 0;
+	viewIsReshape = false;
 
 	align_type = ALIGN_128bit;
 }
@@ -396,11 +603,11 @@ ZQ_CNN_Tensor4D_NHW_C_Align128bit::ZQ_CNN_Tensor4D_NHW_C_Align128bit()
 
 ZQ_CNN_Tensor4D_NHW_C_Align128bit::~ZQ_CNN_Tensor4D_NHW_C_Align128bit()
 {
-	if (rawData)
+	if (rawData && !rawDataIsExternal)
 	{
 		_aligned_free(rawData);
-		rawData = 0;
 	}
+	rawData = 0;
 }
 
 
@@ -424,6 +631,14 @@ void ZQ_CNN_Tensor4D_NHW_C_Align128bit::Swap(ZQ_CNN_Tensor4D_NHW_C_Align128bit&
 	float* tmp_firstPixelData = firstPixelData; firstPixelData = other.firstPixelData; other.firstPixelData = tmp_firstPixelData;
 	unsigned char* tmp_rawData = rawData; rawData = other.rawData; other.rawData = tmp_rawData;
 	long long tmp_rawDataLen = rawDataLen; rawDataLen = other.rawDataLen; other.rawDataLen = tmp_rawDataLen;
+	long long tmp_rawDataCapacity = rawDataCapacity; rawDataCapacity = other.rawDataCapacity; other.rawDataCapacity = tmp_rawDataCapacity;
+	unsigned char* tmp_externalData = externalData; externalData = other.externalData; other.externalData = tmp_externalData;
+	long long tmp_externalDataLen = externalDataLen; externalDataLen = other.externalDataLen; other.externalDataLen = tmp_externalDataLen;
+	bool tmp_rawDataIsExternal = rawDataIsExternal; rawDataIsExternal = other.rawDataIsExternal; other.rawDataIsExternal = tmp_rawDataIsExternal;
+	bool tmp_borderIsZero = borderIsZero; borderIsZero = other.borderIsZero; other.borderIsZero = tmp_borderIsZero;
+	ZQ_CNN_Tensor4D* tmp_viewTensor = viewTensor; viewTensor = other.viewTensor; other.viewTensor = tmp_viewTensor;
+	int tmp_viewChannelOffset = viewChannelOffset; viewChannelOffset = other.viewChannelOffset; other.viewChannelOffset = tmp_viewChannelOffset;
+	bool tmp_viewIsReshape = viewIsReshape; viewIsReshape = other.viewIsReshape; other.viewIsReshape = tmp_viewIsReshape;
 }
 
 
@@ -456,8 +671,9 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::Padding(int padW, int padH, int mode)
 			}
 		}
 		Swap(tmp);
+		borderIsZero = true;
 	}
-	else
+	else if (!borderIsZero)
 	{
 		float* slice_ptr = firstPixelData;
 		for (int n = 0; n < N; n++, slice_ptr += sliceStep)
@@ -475,14 +691,26 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::Padding(int padW, int padH, int mode)
 				memset(row_ptr + W*pixelStep, 0, sizeof(float)*borderW*pixelStep);
 			}
 		}
+		borderIsZero = true;
 	}
 	return true;
 }
 
 bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ChangeSize(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
 {
-	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH)
+	dst_borderW = __max(dst_borderW, minBorderW);
+	dst_borderH = __max(dst_borderH, minBorderH);
+	if (_can_use_view(dst_N, dst_H, dst_W, dst_C, dst_borderW, dst_borderH))
+	{
+		if (rawData && !rawDataIsExternal)
+			_aligned_free(rawData);
+		_use_view(dst_N, dst_H, dst_W, dst_C);
+		return true;
+	}
+	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH
+		&& (externalData == 0 ? !rawDataIsExternal : rawData == externalData))
 		return true;
+	borderIsZero = false;
 	shape_nchw[0] = dst_N;
 	shape_nchw[1] = dst_C;
 	shape_nchw[2] = dst_H;
@@ -490,14 +718,19 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ChangeSize(int dst_N, int dst_H, int dst
 	int dst_realW = dst_W + (dst_borderW << 1);
 	int dst_realH = dst_H + (dst_borderH << 1);
 	int dst_pixelStep = (dst_C + 3) >> 2 << 2;
-	int dst_widthStep = dst_pixelStep*dst_realW;
-	int dst_sliceStep = dst_widthStep*dst_realH;
-	int dst_tensor_raw_size = dst_sliceStep*dst_N * sizeof(float);
-	int needed_dst_raw_len = dst_tensor_raw_size;
-	if (dst_tensor_raw_size == 0)
+	long long dst_widthStep = (long long)dst_pixelStep*dst_realW;
+	long long dst_sliceStep = dst_widthStep*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX) //the steps are int
+		return false;
+	if (needed_dst_raw_len == 0)
 	{
-		_aligned_free(rawData);
-		rawData = 0;
+		//keep the owned memory for the next shape
+		if (rawDataIsExternal)
+		{
+			rawData = 0;
+			rawDataIsExternal = false;
+		}
 		firstPixelData = 0;
 		rawDataLen = 0;
 
@@ -515,7 +748,15 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ChangeSize(int dst_N, int dst_H, int dst
 	}
 	else
 	{
-		if (rawDataLen != needed_dst_raw_len)
+		if (externalData != 0 && needed_dst_raw_len <= externalDataLen)
+		{
+			if (!rawDataIsExternal)
+				_aligned_free(rawData);
+			rawData = externalData;
+			rawDataIsExternal = true;
+			rawDataCapacity = 0;
+		}
+		else if (rawDataIsExternal || rawDataCapacity < needed_dst_raw_len)
 		{
 			unsigned char* tmp_data = (unsigned char*)_aligned_malloc(needed_dst_raw_len, 16);
 			if (tmp_data == 0)
@@ -523,8 +764,11 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ChangeSize(int dst_N, int dst_H, int dst
 #if __ARM_NEON
 			memset(tmp_data, 0, needed_dst_raw_len);
 #endif
-			_aligned_free(rawData);
+			if (!rawDataIsExternal)
+				_aligned_free(rawData);
 			rawData = tmp_data;
+			rawDataIsExternal = false;
+			rawDataCapacity = needed_dst_raw_len;
 		}
 
 		firstPixelData = (float*)rawData + dst_borderH*dst_widthStep + dst_borderW*dst_pixelStep;
@@ -539,13 +783,54 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ChangeSize(int dst_N, int dst_H, int dst
 		realHeight = dst_realH;
 		realWidth = dst_realW;
 		pixelStep = dst_pixelStep;
-		widthStep = dst_widthStep;
-		sliceStep = dst_sliceStep;
+		widthStep = (int)dst_widthStep;
+		sliceStep = (int)dst_sliceStep;
 	}
 
 	return true;
 }
 
+bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::Reserve(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
+{
+	if (rawDataIsExternal)
+		return true;
+	int dst_realW = dst_W + (dst_borderW << 1);
+	int dst_realH = dst_H + (dst_borderH << 1);
+	int dst_pixelStep = (dst_C + 3) >> 2 << 2;
+	long long dst_sliceStep = (long long)dst_pixelStep*dst_realW*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX)
+		return false;
+	if (needed_dst_raw_len <= rawDataCapacity)
+		return true;
+	unsigned char* tmp_data = (unsigned char*)_aligned_malloc(needed_dst_raw_len, 16);
+	if (tmp_data == 0)
+		return false;
+#if __ARM_NEON
+	memset(tmp_data, 0, needed_dst_raw_len);
+#endif
+	if (rawData)
+	{
+		//keep the current data
+		memcpy(tmp_data, rawData, rawDataLen);
+		if (firstPixelData)
+			firstPixelData = (float*)(tmp_data + ((unsigned char*)firstPixelData - rawData));
+		_aligned_free(rawData);
+	}
+	rawData = tmp_data;
+	rawDataCapacity = needed_dst_raw_len;
+	return true;
+}
+
+void ZQ_CNN_Tensor4D_NHW_C_Align128bit::ShrinkToFit()
+{
+	ChangeSize(0, 0, 0, 0, 0, 0);
+	if (rawData && !rawDataIsExternal)
+		_aligned_free(rawData);
+	rawData = 0;
+	rawDataCapacity = 0;
+}
+
 
 bool ZQ_CNN_Tensor4D_NHW_C_Align128bit::ResizeBilinearRect(ZQ_CNN_Tensor4D& dst, int dst_W, int dst_H, int dst_borderW, int dst_borderH,
 	int src_off_x, int src_off_y, int src_rect_w, int src_rect_h) const
@@ -783,6 +1068,16 @@ ZQ_CNN_Tensor4D_NHW_C_Align256bit::ZQ_CNN_Tensor4D_NHW_C_Align256bit()
 	firstPixelData = 0;
 	rawData = 0;
 	rawDataLen = 0;
+	rawDataCapacity = 0;
+	externalData = 0;
+	externalDataLen = 0;
+	rawDataIsExternal = false;
+	minBorderW = 0;
+	minBorderH = 0;
+	borderIsZero = false;
+	viewTensor = 0;
+	viewChannelOffset = 0;
+	viewIsReshape = false;
 
 	align_type = ALIGN_256bit;
 }
@@ -790,11 +1085,11 @@ ZQ_CNN_Tensor4D_NHW_C_Align256bit::ZQ_CNN_Tensor4D_NHW_C_Align256bit()
 
 ZQ_CNN_Tensor4D_NHW_C_Align256bit::~ZQ_CNN_Tensor4D_NHW_C_Align256bit()
 {
-	if (rawData)
+	if (rawData && !rawDataIsExternal)
 	{
 		_aligned_free(rawData);
-		rawData = 0;
 	}
+	rawData = 0;
 }
 
 void ZQ_CNN_Tensor4D_NHW_C_Align256bit::Swap(ZQ_CNN_Tensor4D_NHW_C_Align256bit& other)
@@ -817,6 +1112,14 @@ void ZQ_CNN_Tensor4D_NHW_C_Align256bit::Swap(ZQ_CNN_Tensor4D_NHW_C_Align256bit&
 	float* tmp_firstPixelData = firstPixelData; firstPixelData = other.firstPixelData; other.firstPixelData = tmp_firstPixelData;
 	unsigned char* tmp_rawData = rawData; rawData = other.rawData; other.rawData = tmp_rawData;
 	long long tmp_rawDataLen = rawDataLen; rawDataLen = other.rawDataLen; other.rawDataLen = tmp_rawDataLen;
+	long long tmp_rawDataCapacity = rawDataCapacity; rawDataCapacity = other.rawDataCapacity; other.rawDataCapacity = tmp_rawDataCapacity;
+	unsigned char* tmp_externalData = externalData; externalData = other.externalData; other.externalData = tmp_externalData;
+	long long tmp_externalDataLen = externalDataLen; externalDataLen = other.externalDataLen; other.externalDataLen = tmp_externalDataLen;
+	bool tmp_rawDataIsExternal = rawDataIsExternal; rawDataIsExternal = other.rawDataIsExternal; other.rawDataIsExternal = tmp_rawDataIsExternal;
+	bool tmp_borderIsZero = borderIsZero; borderIsZero = other.borderIsZero; other.borderIsZero = tmp_borderIsZero;
+	ZQ_CNN_Tensor4D* tmp_viewTensor = viewTensor; viewTensor = other.viewTensor; other.viewTensor = tmp_viewTensor;
+	int tmp_viewChannelOffset = viewChannelOffset; viewChannelOffset = other.viewChannelOffset; other.viewChannelOffset = tmp_viewChannelOffset;
+	bool tmp_viewIsReshape = viewIsReshape; viewIsReshape = other.viewIsReshape; other.viewIsReshape = tmp_viewIsReshape;
 }
 
 
@@ -848,8 +1151,9 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::Padding(int padW, int padH, int mode)
 			}
 		}
 		Swap(tmp);
+		borderIsZero = true;
 	}
-	else
+	else if (!borderIsZero)
 	{
 		float* slice_ptr = firstPixelData;
 		for (int n = 0; n < N; n++, slice_ptr += sliceStep)
@@ -867,14 +1171,26 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::Padding(int padW, int padH, int mode)
 				memset(row_ptr + W*pixelStep, 0, sizeof(float)*borderW*pixelStep);
 			}
 		}
+		borderIsZero = true;
 	}
 	return true;
 }
 
 bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::ChangeSize(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
 {
-	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH)
+	dst_borderW = __max(dst_borderW, minBorderW);
+	dst_borderH = __max(dst_borderH, minBorderH);
+	if (_can_use_view(dst_N, dst_H, dst_W, dst_C, dst_borderW, dst_borderH))
+	{
+		if (rawData && !rawDataIsExternal)
+			_aligned_free(rawData);
+		_use_view(dst_N, dst_H, dst_W, dst_C);
+		return true;
+	}
+	if (N == dst_N && H == dst_H && W == dst_W && C == dst_C && borderW == dst_borderW && borderH == dst_borderH
+		&& (externalData == 0 ? !rawDataIsExternal : rawData == externalData))
 		return true;
+	borderIsZero = false;
 	shape_nchw[0] = dst_N;
 	shape_nchw[1] = dst_C;
 	shape_nchw[2] = dst_H;
@@ -882,14 +1198,19 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::ChangeSize(int dst_N, int dst_H, int dst
 	int dst_realW = dst_W + (dst_borderW << 1);
 	int dst_realH = dst_H + (dst_borderH << 1);
 	int dst_pixelStep = (dst_C + 7) >> 3 << 3;
-	int dst_widthStep = dst_pixelStep*dst_realW;
-	int dst_sliceStep = dst_widthStep*dst_realH;
-	int dst_tensor_raw_size = dst_sliceStep*dst_N * sizeof(float);
-	int needed_dst_raw_len = dst_tensor_raw_size;
-	if (dst_tensor_raw_size == 0)
+	long long dst_widthStep = (long long)dst_pixelStep*dst_realW;
+	long long dst_sliceStep = dst_widthStep*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX) //the steps are int
+		return false;
+	if (needed_dst_raw_len == 0)
 	{
-		_aligned_free(rawData);
-		rawData = 0;
+		//keep the owned memory for the next shape
+		if (rawDataIsExternal)
+		{
+			rawData = 0;
+			rawDataIsExternal = false;
+		}
 		firstPixelData = 0;
 		rawDataLen = 0;
 
@@ -907,14 +1228,25 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::ChangeSize(int dst_N, int dst_H, int dst
 	}
 	else
 	{
-		if (rawDataLen != needed_dst_raw_len)
+		if (externalData != 0 && needed_dst_raw_len <= externalDataLen)
+		{
+			if (!rawDataIsExternal)
+				_aligned_free(rawData);
+			rawData = externalData;
+			rawDataIsExternal = true;
+			rawDataCapacity = 0;
+		}
+		else if (rawDataIsExternal || rawDataCapacity < needed_dst_raw_len)
 		{
 			unsigned char* tmp_data = (unsigned char*)_aligned_malloc(needed_dst_raw_len, 32);
 			if (tmp_data == 0)
 				return false;
 			//memset(tmp_data, 0, needed_dst_raw_len);
-			_aligned_free(rawData);
+			if (!rawDataIsExternal)
+				_aligned_free(rawData);
 			rawData = tmp_data;
+			rawDataIsExternal = false;
+			rawDataCapacity = needed_dst_raw_len;
 		}
 		firstPixelData = (float*)rawData + dst_borderH*dst_widthStep + dst_borderW*dst_pixelStep;
 		rawDataLen = needed_dst_raw_len;
@@ -928,13 +1260,51 @@ bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::ChangeSize(int dst_N, int dst_H, int dst
 		realHeight = dst_realH;
 		realWidth = dst_realW;
 		pixelStep = dst_pixelStep;
-		widthStep = dst_widthStep;
-		sliceStep = dst_sliceStep;
+		widthStep = (int)dst_widthStep;
+		sliceStep = (int)dst_sliceStep;
 	}
 
 	return true;
 }
 
+bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::Reserve(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH)
+{
+	if (rawDataIsExternal)
+		return true;
+	int dst_realW = dst_W + (dst_borderW << 1);
+	int dst_realH = dst_H + (dst_borderH << 1);
+	int dst_pixelStep = (dst_C + 7) >> 3 << 3;
+	long long dst_sliceStep = (long long)dst_pixelStep*dst_realW*dst_realH;
+	long long needed_dst_raw_len = dst_sliceStep*dst_N * sizeof(float);
+	if (dst_sliceStep > INT_MAX)
+		return false;
+	if (needed_dst_raw_len <= rawDataCapacity)
+		return true;
+	unsigned char* tmp_data = (unsigned char*)_aligned_malloc(needed_dst_raw_len, 32);
+	if (tmp_data == 0)
+		return false;
+	if (rawData)
+	{
+		//keep the current data
+		memcpy(tmp_data, rawData, rawDataLen);
+		if (firstPixelData)
+			firstPixelData = (float*)(tmp_data + ((unsigned char*)firstPixelData - rawData));
+		_aligned_free(rawData);
+	}
+	rawData = tmp_data;
+	rawDataCapacity = needed_dst_raw_len;
+	return true;
+}
+
+void ZQ_CNN_Tensor4D_NHW_C_Align256bit::ShrinkToFit()
+{
+	ChangeSize(0, 0, 0, 0, 0, 0);
+	if (rawData && !rawDataIsExternal)
+		_aligned_free(rawData);
+	rawData = 0;
+	rawDataCapacity = 0;
+}
+
 bool ZQ_CNN_Tensor4D_NHW_C_Align256bit::ResizeBilinearRect(ZQ_CNN_Tensor4D& dst, int dst_W, int dst_H, int dst_borderW, int dst_borderH,
 	int src_off_x, int src_off_y, int src_rect_w, int src_rect_h) const
 {
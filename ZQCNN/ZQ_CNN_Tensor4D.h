@@ -32,7 +32,38 @@ namespace ZQ
 		const int GetPixelStep() const { return pixelStep; }
 		const int GetWidthStep() const { return widthStep; }
 		const int GetSliceStep() const { return sliceStep; }
-		ALIGN_TYPE GetAlignType() const { return align_type; }
+		/*the kernels the tensor runs with, a ZQ_CNN_DISPATCH_SSETYPE build runs the 256bit tensors with the 128bit kernels
+		on the cpus without AVX2*/
+		ALIGN_TYPE GetAlignType() const
+		{
+#if ZQ_CNN_DISPATCH_SSETYPE
+			if (align_type == ALIGN_256bit && !ZQ_CNN_CAN_RUN_256BIT)
+				return ALIGN_128bit;
+#endif
+			return align_type;
+		}
+		/*the channels are padded to the multiple of 4 for ALIGN_128bit and of 8 for ALIGN_256bit*/
+		ALIGN_TYPE GetLayoutAlignType() const { return align_type; }
+		/*let ChangeSize use memory owned by others (such as the memory plan of ZQ_CNN_Net) if it is large enough,
+		the memory is never freed by the tensor, call SetExternalMemory(0,0) to allocate its own memory again*/
+		void SetExternalMemory(unsigned char* data, long long len) { externalData = data; externalDataLen = data == 0 ? 0 : len; borderIsZero = false; }
+		bool IsUsingExternalMemory() const { return rawDataIsExternal; }
+		/*let ChangeSize use a border of at least borderW and borderH, so Padding(padW,padH,...) with smaller pads copies nothing,
+		it is used by ZQ_CNN_Net for the blobs padded by their consumers, the setting stays with the tensor (Swap does not move it)*/
+		void SetMinBorder(int borderW, int borderH) { minBorderW = borderW; minBorderH = borderH; }
+		/*let ChangeSize(N,H,W,C,0,0) use the channels [c_offset, c_offset+C) of other (which has the same N,H,W) instead of its own memory,
+		so the data written into this tensor is in other, other must not change its size while it is used. 
+		It is used by ZQ_CNN_Net to let the bottoms of a concat write into its top, call SetChannelView(0,0) to stop it*/
+		void SetChannelView(ZQ_CNN_Tensor4D* other, int c_offset) { viewTensor = other; viewChannelOffset = other == 0 ? 0 : c_offset; viewIsReshape = false; }
+		/*let ChangeSize(N,H,W,C,0,0) alias the memory of other if other has the same N,C and H*W, no border and compact rows,
+		so the tensor is a reshape of other without copying. It is used by ZQ_CNN_Net for Reshape, Flatten and Permute layers,
+		call SetReshapeView(0) to stop it*/
+		void SetReshapeView(ZQ_CNN_Tensor4D* other) { viewTensor = other; viewChannelOffset = 0; viewIsReshape = other != 0; }
+		/*true if ChangeSize has made this tensor a reshape view of other, then its data is the data of other*/
+		bool IsReshapeViewOf(const ZQ_CNN_Tensor4D& other) const
+		{
+			return viewIsReshape && viewTensor == &other && rawDataLen == 0 && firstPixelData != 0 && firstPixelData == other.firstPixelData;
+		}
 		inline bool ResizeBilinear(ZQ_CNN_Tensor4D& dst, int dst_W, int dst_H, int dst_borderW, int dst_borderH) const
 		{
 			return ResizeBilinearRect(dst, dst_W, dst_H, dst_borderW, dst_borderH, 0, 0, W, H);
@@ -44,8 +75,15 @@ namespace ZQ
 			const std::vector<int>& src_off_x, const std::vector<int>& src_off_y, const std::vector<int>& src_rect_w, const std::vector<int>& src_rect_h) const = 0;
 
 		virtual bool Padding(int padW, int padH, int mode) = 0;
+		/*ChangeSize keeps the memory it owns and reuses it for any shape that fits, only a larger shape reallocates*/
 		virtual bool ChangeSize(int N, int H, int W, int C, int borderW, int borderH) = 0;
+		/*make the owned memory large enough for the shape without changing the current shape and data,
+		it does nothing while the tensor uses external memory or a view*/
+		virtual bool Reserve(int N, int H, int W, int C, int borderW, int borderH) = 0;
+		/*free the owned memory*/
 		virtual void ShrinkToFit() = 0;
+		/*bytes of the memory owned by the tensor*/
+		long long GetCapacity() const { return rawDataIsExternal ? 0 : rawDataCapacity; }
 		virtual bool IsBorderEnabled() const = 0;
 
 		virtual bool ROI(ZQ_CNN_Tensor4D& dst, int off_x, int off_y, int width, int height, int dst_borderH, int dst_borderW) const 
@@ -107,7 +145,7 @@ namespace ZQ
 		{
 			if (data == 0 || !ChangeSize(N, H, W, C, borderW, borderH))
 				return false;
-			memset(rawData, 0, sizeof(float)*N*sliceStep);
+			Reset();
 			int CHW = C*H*W;
 			int HW = H*W;
 			for (int n = 0; n < N; n++)
@@ -150,11 +188,14 @@ namespace ZQ
 			if (!ChangeSize(other.GetN(), other.GetH(), other.GetW(), other.GetC(), other.GetBorderW(), other.GetBorderH()))
 				return false;
 			Reset();
+			//the border may be larger than the border of other (see SetMinBorder)
+			int copy_borderW = __min(borderW, other.borderW);
+			int copy_borderH = __min(borderH, other.borderH);
 			for (int n = 0; n < N; n++)
 			{
-				for (int h = -borderH; h < H + borderH; h++)
+				for (int h = -copy_borderH; h < H + copy_borderH; h++)
 				{
-					for (int w = -borderW; w < W + borderW; w++)
+					for (int w = -copy_borderW; w < W + copy_borderW; w++)
 					{
 						memcpy(firstPixelData + n*sliceStep+ h*widthStep + w*pixelStep,
 							other.GetFirstPixelPtr() + n*other.GetSliceStep()+ h*other.GetWidthStep() + w*other.GetPixelStep(), sizeof(float)*C);
@@ -162,6 +203,8 @@ namespace ZQ
 				}
 
 			}
+			if (copy_borderW > 0 || copy_borderH > 0)
+				borderIsZero = other.borderIsZero;
 			return true;
 		}
 
@@ -243,8 +286,23 @@ namespace ZQ
 
 		virtual void Reset()
 		{
-			if(rawData)
+			if (rawData && rawDataLen > 0)
+			{
 				memset(rawData, 0, rawDataLen);
+				borderIsZero = true;
+			}
+			else if (firstPixelData)
+			{
+				//a channel view, only its own channels
+				for (int n = 0; n < N; n++)
+				{
+					for (int h = 0; h < H; h++)
+					{
+						for (int w = 0; w < W; w++)
+							memset(firstPixelData + n*sliceStep + h*widthStep + w*pixelStep, 0, sizeof(float)*C);
+					}
+				}
+			}
 		}
 
 		virtual bool ConvertFromBGR(const unsigned char* BGR_img, int _width, int _height, int _widthStep, const float mean_val = 127.5f, const float scale = 0.0078125f)
@@ -285,6 +343,12 @@ namespace ZQ
 			return true;
 		}
 
+		/*resize the rect of a BGR image to W x H of this tensor with bilinear into the slice n, normalized as ConvertFromBGR
+		in the same pass (no float copy of the image). C must be 3, the samples are the same as ResizeBilinearRect of the
+		image converted by ConvertFromBGR, including the zero border row below the image*/
+		bool ResizeBilinearRectFromBGR(int n, const unsigned char* BGR_img, int _width, int _height, int _widthStep,
+			int src_off_x, int src_off_y, int src_rect_w, int src_rect_h, const float mean_val = 127.5f, const float scale = 0.0078125f);
+
 		virtual bool ConvertFromGray(const unsigned char* gray_img, int _width, int _height, int _widthStep, const float mean_val = 127.5f, const float scale = 0.0078125f)
 		{
 			if (!ChangeSize(1, _height, _width, 1, 1, 1))
@@ -396,6 +460,8 @@ namespace ZQ
 				return false;
 			if (!output.ChangeSize(out_N, out_H, out_W, out_C, 0, 0))
 				return false;
+			if (output.IsReshapeViewOf(*this))
+				return true;
 
 			int old_steps[4] = { C*H*W,H*W,W,1 };
 			int new_steps[4] = { out_C*out_H*out_W, out_H*out_W, out_W,1 };
@@ -538,7 +604,10 @@ namespace ZQ
 			int out_N, out_C, out_H, out_W;
 			if (!Reshape_NCHW_get_size(shape, N, C, H, W, out_N, out_C, out_H, out_W))
 				return false;
-			output.ChangeSize(out_N, out_H, out_W, out_C, 0, 0);
+			if (!output.ChangeSize(out_N, out_H, out_W, out_C, 0, 0))
+				return false;
+			if (output.IsReshapeViewOf(*this))
+				return true;
 			int in_HW = H*W;
 			int in_CHW = C*in_HW;
 			int out_HW = out_H*out_W;
@@ -621,6 +690,48 @@ namespace ZQ
 			return true;
 		}
 
+	protected:
+		bool _can_use_view(int dst_N, int dst_H, int dst_W, int dst_C, int dst_borderW, int dst_borderH) const
+		{
+			if (viewTensor == 0 || viewTensor == this || viewTensor->firstPixelData == 0 || viewTensor->align_type != align_type
+				|| dst_borderW != 0 || dst_borderH != 0 || dst_C <= 0 || dst_N != viewTensor->N)
+				return false;
+			if (viewIsReshape)
+			{
+				return dst_C == viewTensor->C && dst_H*dst_W == viewTensor->H*viewTensor->W
+					&& viewTensor->borderW == 0 && viewTensor->borderH == 0 && viewTensor->widthStep == viewTensor->W*viewTensor->pixelStep
+					&& viewTensor->sliceStep == viewTensor->H*viewTensor->widthStep;
+			}
+			return viewChannelOffset >= 0 && viewChannelOffset + dst_C <= viewTensor->C
+				&& dst_H == viewTensor->H && dst_W == viewTensor->W;
+		}
+
+		/*the caller frees its own memory first*/
+		void _use_view(int dst_N, int dst_H, int dst_W, int dst_C)
+		{
+			N = dst_N;
+			H = dst_H;
+			W = dst_W;
+			C = dst_C;
+			shape_nchw[0] = N;
+			shape_nchw[1] = C;
+			shape_nchw[2] = H;
+			shape_nchw[3] = W;
+			borderW = 0;
+			borderH = 0;
+			realWidth = W;
+			realHeight = H;
+			pixelStep = viewTensor->pixelStep;
+			widthStep = viewIsReshape ? W*pixelStep : viewTensor->widthStep;
+			sliceStep = viewTensor->sliceStep;
+			firstPixelData = viewTensor->firstPixelData + viewChannelOffset;
+			rawData = (unsigned char*)firstPixelData;
+			rawDataLen = 0;
+			rawDataCapacity = 0;
+			rawDataIsExternal = true;
+			borderIsZero = false;
+		}
+
 	protected:
 		int shape_nchw[4];
 		int N;
@@ -637,6 +748,16 @@ namespace ZQ
 		float* firstPixelData;
 		unsigned char* rawData;
 		long long rawDataLen;
+		long long rawDataCapacity;
+		unsigned char* externalData;
+		long long externalDataLen;
+		bool rawDataIsExternal;
+		int minBorderW;
+		int minBorderH;
+		bool borderIsZero;	//set by Padding, cleared when the memory may be written by others
+		ZQ_CNN_Tensor4D* viewTensor;
+		int viewChannelOffset;
+		bool viewIsReshape;
 
 		ALIGN_TYPE align_type;
 	};
@@ -648,7 +769,8 @@ namespace ZQ
 		/*********************   Interface functions ********************/	
 		bool Padding(int padW, int padH, int mode);
 		bool ChangeSize(int N, int H, int W, int C, int borderW, int borderH);
-		void ShrinkToFit() { ChangeSize(0, 0, 0, 0, 0, 0); }
+		bool Reserve(int N, int H, int W, int C, int borderW, int borderH);
+		void ShrinkToFit();
 		
 		bool IsBorderEnabled() const { return true; }
 		
@@ -671,7 +793,8 @@ namespace ZQ
 		/*********************   Interface functions ********************/
 		bool Padding(int padW, int padH, int mode);
 		bool ChangeSize(int N, int H, int W, int C, int borderW, int borderH);
-		void ShrinkToFit() { ChangeSize(0, 0, 0, 0, 0, 0); }
+		bool Reserve(int N, int H, int W, int C, int borderW, int borderH);
+		void ShrinkToFit();
 		bool IsBorderEnabled() const { return true; }
 		
 		/*********************   other functions ********************/
@@ -692,7 +815,8 @@ namespace ZQ
 		/*********************   Interface functions ********************/
 		bool Padding(int padW, int padH, int mode);
 		bool ChangeSize(int N, int H, int W, int C, int borderW, int borderH);
-		void ShrinkToFit() { ChangeSize(0, 0, 0, 0, 0, 0); }
+		bool Reserve(int N, int H, int W, int C, int borderW, int borderH);
+		void ShrinkToFit();
 		bool IsBorderEnabled() const { return true; }
 		
 		/*********************   other functions ********************/
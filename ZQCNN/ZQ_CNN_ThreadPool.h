@@ -0,0 +1,310 @@
+#ifndef _ZQ_CNN_THREAD_POOL_H_
+#define _ZQ_CNN_THREAD_POOL_H_
+#pragma once
+#include "ZQ_CNN_CompileConfig.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__) || defined(__ANDROID__)
+#include <sched.h>
+#endif
+#if !__ARM_NEON
+#include <immintrin.h>
+#endif
+
+namespace ZQ
+{
+	/*the threads of the library: the kernels, ZQ_CNN_Net and the detectors run their parallel loops with ParallelFor
+	instead of their own omp parallel regions, so all of them together never use more threads than the pool.
+	ParallelFor can be called by several threads at the same time and inside a task, the caller works on its own
+	tasks and the idle workers help it. An idle worker spins for a while before it sleeps, so a loop starts in microseconds*/
+	class ZQ_CNN_ThreadPool
+	{
+	public:
+		/*the pool has num_threads-1 workers (the thread calling ParallelFor is the other one),
+		0 for the number of cpus. The workers are restarted when the running loops are done, the loops started in the
+		meantime are run by their callers alone. It must not be called inside a task of ParallelFor*/
+		static void SetNumThreads(int num_threads)
+		{
+			Pool& pool = _pool();
+			std::lock_guard<std::mutex> config_lock(pool.config_mutex);
+			_stop_workers(pool);
+			pool.num_threads = num_threads > 0 ? num_threads : _num_of_cpus();
+			_start_workers(pool);
+		}
+
+		static int GetNumThreads()
+		{
+			Pool& pool = _pool();
+			if (!pool.started.load())
+			{
+				std::lock_guard<std::mutex> config_lock(pool.config_mutex);
+				_start_workers(pool);
+			}
+			return pool.num_threads.load();
+		}
+
+		/*worker i is pinned to the cpu cpu_ids[i % cpu_ids.size()], the callers are not pinned, empty for no pinning
+		(not supported on macOS). The workers are restarted as in SetNumThreads*/
+		static void SetAffinity(const std::vector<int>& cpu_ids)
+		{
+			Pool& pool = _pool();
+			std::lock_guard<std::mutex> config_lock(pool.config_mutex);
+			_stop_workers(pool);
+			pool.cpu_ids = cpu_ids;
+			_start_workers(pool);
+		}
+
+		/*the number of polls of an idle worker (or a caller waiting for the workers) before it sleeps*/
+		static void SetSpinCount(int spin_count)
+		{
+			_pool().spin_count = __max(0, spin_count);
+		}
+
+		/*func(i, thread_id) for i in [0, num_tasks) with at most max_threads threads (the caller included),
+		thread_id is in [0, max_threads) and differs between the threads working on this call (like omp_get_thread_num)*/
+		template<class Func>
+		static void ParallelFor(int num_tasks, int max_threads, const Func& func)
+		{
+			if (num_tasks <= 0)
+				return;
+			max_threads = __min(max_threads, num_tasks);
+			if (max_threads > 1)
+				max_threads = __min(max_threads, GetNumThreads());
+			if (max_threads <= 1)
+			{
+				for (int i = 0; i < num_tasks; i++)
+					func(i, 0);
+				return;
+			}
+
+			Pool& pool = _pool();
+			Job job;
+			job.call = &_call<Func>;
+			job.func = (const void*)&func;
+			job.num_tasks = num_tasks;
+			job.max_threads = max_threads;
+			job.next_task = 0;
+			job.num_joined = 1;
+			job.num_working = 1;
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				if (pool.accept_jobs)
+				{
+					pool.jobs.push_back(&job);
+					pool.generation++;
+				}
+			}
+			for (int i = 1; i < max_threads; i++)
+				pool.job_cond.notify_one();
+
+			_work(job, 0);
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				for (int i = 0; i < pool.jobs.size(); i++)
+				{
+					if (pool.jobs[i] == &job)
+					{
+						pool.jobs.erase(pool.jobs.begin() + i);
+						break;
+					}
+				}
+				if (pool.jobs.size() == 0)
+					pool.done_cond.notify_all();
+			}
+			//wait for the workers still on their last tasks
+			job.num_working--;
+			for (int s = 0; s < pool.spin_count && job.num_working.load() > 0; s++)
+				_pause();
+			if (job.num_working.load() > 0)
+			{
+				std::unique_lock<std::mutex> lock(pool.mutex);
+				while (job.num_working.load() > 0)
+					pool.done_cond.wait(lock);
+			}
+		}
+
+	private:
+		class Job
+		{
+		public:
+			void(*call)(const void* func, int i, int thread_id);
+			const void* func;
+			int num_tasks;
+			int max_threads;
+			std::atomic<int> next_task;
+			int num_joined;		//the thread ids given, changed with the pool mutex
+			std::atomic<int> num_working;
+		};
+
+		class Pool
+		{
+		public:
+			std::mutex config_mutex;	//for changing num_threads, cpu_ids and the workers
+			std::atomic<int> num_threads;
+			std::vector<int> cpu_ids;
+			std::vector<std::thread> workers;
+			std::atomic<bool> started;
+			std::atomic<int> spin_count;
+
+			std::mutex mutex;	//for jobs, accept_jobs, stop and the waits
+			std::condition_variable job_cond, done_cond;
+			std::vector<Job*> jobs;
+			std::atomic<unsigned int> generation;	//increased when a job is added
+			bool accept_jobs;	//false while the workers are stopped, a new loop is then run by its caller alone
+			bool stop;
+
+			Pool() :num_threads(0), started(false), spin_count(20000), generation(0), accept_jobs(false), stop(false) {}
+			~Pool() { _stop_workers(*this); }
+		};
+
+		static Pool& _pool()
+		{
+			static Pool pool;
+			return pool;
+		}
+
+		template<class Func>
+		static void _call(const void* func, int i, int thread_id)
+		{
+			(*(const Func*)func)(i, thread_id);
+		}
+
+		static int _num_of_cpus()
+		{
+			int num = std::thread::hardware_concurrency();
+			return num > 0 ? num : 1;
+		}
+
+		static void _pause()
+		{
+#if !__ARM_NEON
+			_mm_pause();
+#else
+			std::this_thread::yield();
+#endif
+		}
+
+		static void _pin_current_thread(int cpu_id)
+		{
+#if defined(_WIN32)
+			SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu_id);
+#elif defined(__linux__) || defined(__ANDROID__)
+			cpu_set_t mask;
+			CPU_ZERO(&mask);
+			CPU_SET(cpu_id, &mask);
+			sched_setaffinity(0, sizeof(mask), &mask);
+#else
+			(void)cpu_id;
+#endif
+		}
+
+		/*with the config mutex*/
+		static void _start_workers(Pool& pool)
+		{
+			if (pool.started)
+				return;
+			if (pool.num_threads.load() <= 0)
+				pool.num_threads = _num_of_cpus();
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				pool.stop = false;
+				pool.accept_jobs = true;
+			}
+			for (int i = 0; i + 1 < pool.num_threads.load(); i++)
+			{
+				int cpu_id = pool.cpu_ids.size() > 0 ? pool.cpu_ids[i % pool.cpu_ids.size()] : -1;
+				pool.workers.push_back(std::thread(_worker_loop, &pool, cpu_id));
+			}
+			pool.started = true;
+		}
+
+		/*with the config mutex, waits for the running loops*/
+		static void _stop_workers(Pool& pool)
+		{
+			{
+				std::unique_lock<std::mutex> lock(pool.mutex);
+				pool.accept_jobs = false;
+				while (pool.jobs.size() > 0)
+					pool.done_cond.wait(lock);
+				pool.stop = true;
+			}
+			pool.job_cond.notify_all();
+			for (int i = 0; i < pool.workers.size(); i++)
+				pool.workers[i].join();
+			pool.workers.clear();
+			pool.started = false;
+		}
+
+		/*take a job with tasks left and a free thread id, with the pool mutex*/
+		static Job* _take_job(Pool& pool, int& thread_id)
+		{
+			for (int i = 0; i < pool.jobs.size(); i++)
+			{
+				Job* job = pool.jobs[i];
+				if (job->next_task.load() < job->num_tasks && job->num_joined < job->max_threads)
+				{
+					thread_id = job->num_joined++;
+					job->num_working++;
+					return job;
+				}
+			}
+			return 0;
+		}
+
+		static void _work(Job& job, int thread_id)
+		{
+			while (true)
+			{
+				int i = job.next_task.fetch_add(1);
+				if (i >= job.num_tasks)
+					break;
+				job.call(job.func, i, thread_id);
+			}
+		}
+
+		static void _worker_loop(Pool* pool, int cpu_id)
+		{
+			if (cpu_id >= 0)
+				_pin_current_thread(cpu_id);
+			while (true)
+			{
+				Job* job = 0;
+				int thread_id = 0;
+				unsigned int generation = pool->generation.load();
+				{
+					std::lock_guard<std::mutex> lock(pool->mutex);
+					if (pool->stop)
+						return;
+					job = _take_job(*pool, thread_id);
+				}
+				if (job)
+				{
+					_work(*job, thread_id);
+					std::lock_guard<std::mutex> lock(pool->mutex);
+					if (--job->num_working == 0)
+						pool->done_cond.notify_all();
+					continue;
+				}
+
+				int spin_count = pool->spin_count.load();
+				for (int s = 0; s < spin_count && pool->generation.load() == generation; s++)
+					_pause();
+				std::unique_lock<std::mutex> lock(pool->mutex);
+				while (!pool->stop && pool->generation.load() == generation)
+					pool->job_cond.wait(lock);
+				if (pool->stop)
+					return;
+			}
+		}
+	};
+}
+
+#endif
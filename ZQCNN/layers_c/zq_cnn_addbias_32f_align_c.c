@@ -150,6 +150,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_addbias_32f_align zq_cnn_addbias_32f_align256bit
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
@@ -186,6 +187,7 @@ extern "C" {
 #undef zq_mm_align_size8
 #undef zq_mm_align_size16
 #undef zq_mm_align_size32
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #endif //__ARM_NEON
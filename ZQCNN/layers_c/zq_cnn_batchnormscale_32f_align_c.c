@@ -191,6 +191,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_cnn_batchnormscale_32f_mean_var_scale_bias_align zq_cnn_batchnormscale_32f_mean_var_scale_bias_align256bit
 #define zq_cnn_batchnorm_32f_mean_var_align zq_cnn_batchnorm_32f_mean_var_align256bit
@@ -238,6 +239,7 @@ extern "C" {
 #undef zq_mm_align_size6
 #undef zq_mm_align_size7
 #undef zq_mm_align_size8
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 	/*
@@ -241,6 +241,7 @@ extern "C" {
 
 #endif
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_conv_no_padding_32f_kernel1x1 zq_cnn_conv_no_padding_32f_align256bit_kernel1x1
 #define zq_cnn_conv_no_padding_32f_kernel1x1_C4 zq_cnn_conv_no_padding_32f_align256bit_kernel1x1_C4
 #define zq_cnn_conv_no_padding_32f_kernel2x2 zq_cnn_conv_no_padding_32f_align256bit_kernel2x2
@@ -308,6 +309,7 @@ extern "C" {
 #undef zq_mm_bitor_longlong
 #undef zq_final_sum_q
 
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #endif //__ARM_NEON
@@ -512,6 +514,7 @@ extern "C" {
 
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
 #define zq_mm_add_ps _mm256_add_ps
@@ -1054,6 +1057,7 @@ extern "C" {
 #undef zq_mm_align_size_mul_8
 #undef zq_final_sum_q
 
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #if __ARM_NEON
@@ -62,7 +62,7 @@ void zq_cnn_conv_no_padding_32f_kernel1x1(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 	//zq_base_type result[zq_mm_align_size << 2];
 	//zq_base_type* q = (zq_base_type*)(((long long)result + (zq_mm_align_size << 2) - 1) & zq_mm_bitor_longlong);
 
@@ -169,7 +169,7 @@ void zq_cnn_conv_no_padding_32f_kernel1x1_C4(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 	//zq_base_type result[zq_mm_align_size << 2];
 	//zq_base_type* q = (zq_base_type*)(((long long)result + (zq_mm_align_size << 2) - 1) & zq_mm_bitor_longlong);
 
@@ -252,7 +252,7 @@ void zq_cnn_conv_no_padding_32f_kernel3x3(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 	//zq_base_type result[zq_mm_align_size << 2];
 	//zq_base_type* q = (zq_base_type*)(((long long)result + (zq_mm_align_size << 2) - 1) & zq_mm_bitor_longlong);
 
@@ -730,7 +730,7 @@ void zq_cnn_conv_no_padding_32f_kernel3x3_C3(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 
 	const zq_base_type* in_slice_ptr;
 	const zq_base_type* in_row_ptr;
@@ -858,7 +858,7 @@ void zq_cnn_conv_no_padding_32f_kernel3x3_C3_s1d1(
 	int filter_pixelStep2 = filter_pixelStep * 2;
 	int in_widthStep2 = in_widthStep * 2;
 	int out_n, out_h, out_w, out_c;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 
 	if (out_W % 3 == 0)
 	{
@@ -1302,7 +1302,7 @@ void zq_cnn_conv_no_padding_32f_kernel3x3_C3_s2d1(
 	int filter_pixelStep2 = filter_pixelStep * 2;
 	int in_pixelStep2 = in_pixelStep * 2;
 	int out_n, out_h, out_w, out_c;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 
 	if (out_W % 2 == 0)
 	{
@@ -1560,7 +1560,7 @@ void zq_cnn_conv_no_padding_32f_kernel2x2(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 	//zq_base_type result[zq_mm_align_size << 2];
 	//zq_base_type* q = (zq_base_type*)(((long long)result + (zq_mm_align_size << 2) - 1) & zq_mm_bitor_longlong);
 
@@ -1684,7 +1684,7 @@ void zq_cnn_conv_no_padding_32f_kernel5x5(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 	//zq_base_type result[zq_mm_align_size << 2];
 	//zq_base_type* q = (zq_base_type*)(((long long)result + (zq_mm_align_size << 2) - 1) & zq_mm_bitor_longlong);
 
@@ -1912,7 +1912,7 @@ void zq_cnn_conv_no_padding_32f_general(
 )
 {
 	register zq_mm_type sum;
-	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8];
+	ZQ_DECLSPEC_ALIGN32 zq_base_type q[8] = { 0 };
 
 	const zq_base_type* in_slice_ptr;
 	const zq_base_type* in_row_ptr;
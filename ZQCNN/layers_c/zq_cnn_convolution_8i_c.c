@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../ZQ_CNN_CompileConfig.h"
+#if __ARM_NEON
+#include <arm_neon.h>
+#else
+#if defined(__GNUC__)
+#if defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE
+#include <x86intrin.h>
+#endif
+#elif defined(_WIN32)
+#if defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE
+#include <immintrin.h>
+#endif
+#endif
+#endif //__ARM_NEON
+#include "math/zq_gemm_8i_c.h"
+#include "zq_cnn_convolution_8i_c.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+#define ZQ_CNN_8I_ZERO_POINT 128
+
+/*with VNNI the products are added in int32, else two of them are added in int16 and the weights must be in [-63,63],
+depthwise convolution multiplies in int16 and adds in int32*/
+#if ZQ_CNN_USE_VNNI
+#define ZQ_CNN_8I_GEMM_WEIGHT_MAX 127
+#else
+#define ZQ_CNN_8I_GEMM_WEIGHT_MAX 63
+#endif
+#define ZQ_CNN_8I_DW_WEIGHT_MAX 127
+
+/*the AVX2 kernels are built, a ZQ_CNN_DISPATCH_SSETYPE build also builds the plain C ones for the other cpus*/
+#if !__ARM_NEON && (defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE)
+#define ZQ_CNN_8I_USE_AVX2 1
+#else
+#define ZQ_CNN_8I_USE_AVX2 0
+#endif
+
+static int _zq_cnn_8i_align32(int K) { return (K + 31) >> 5 << 5; }
+static int _zq_cnn_8i_align16(int C) { return (C + 15) >> 4 << 4; }
+
+static void _zq_cnn_8i_realloc(void** data, __int64* len, __int64 need_len)
+{
+	if (*data == 0 || *len < need_len)
+	{
+		if (*data)
+			_aligned_free(*data);
+		*data = _aligned_malloc(need_len, 32);
+		*len = need_len;
+	}
+}
+
+/*weights[n] = round(filters[n]*w_scale[n]), deq[n] = 1/(in_scale*w_scale[n]), comp[n] = 128*sum(weights[n])*/
+static void _zq_cnn_8i_quantize_weights(const float* src, int len, float in_scale, int weight_max,
+	signed char* weights, float* deq, int* comp)
+{
+	float max_abs = 0, w_scale, v;
+	int i, q, sum = 0;
+	for (i = 0; i < len; i++)
+		max_abs = __max(max_abs, (float)fabs(src[i]));
+	w_scale = max_abs > 0 ? weight_max / max_abs : 1.0f;
+	for (i = 0; i < len; i++)
+	{
+		v = src[i] * w_scale;
+		q = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+		q = __max(-weight_max, __min(weight_max, q));
+		weights[i] = (signed char)q;
+		sum += q;
+	}
+	*deq = 1.0f / (in_scale*w_scale);
+	*comp = sum*ZQ_CNN_8I_ZERO_POINT;
+}
+
+int zq_cnn_8i_pack_format()
+{
+	return ZQ_CNN_8I_GEMM_WEIGHT_MAX;
+}
+
+/*packed: weights N x K_pad, deq N, comp N*/
+void zq_cnn_conv_gemm_8i_pack_filters(
+	const float* filters_data,
+	int filter_N,
+	int filter_H,
+	int filter_W,
+	int filter_C,
+	int filter_pixelStep,
+	int filter_widthStep,
+	int filter_sliceStep,
+	const float* in_scales,
+	void** packed_filters,
+	__int64* packed_filters_len
+)
+{
+	int K = filter_H*filter_W*filter_C;
+	int K_pad = _zq_cnn_8i_align32(K);
+	__int64 need_len = (__int64)filter_N*K_pad + (__int64)filter_N*(sizeof(float) + sizeof(int));
+	signed char* weights;
+	float* deq;
+	int* comp;
+	float* tmp = (float*)malloc(sizeof(float)*K);
+	int n, h, w, c;
+	_zq_cnn_8i_realloc(packed_filters, packed_filters_len, need_len);
+	weights = (signed char*)(*packed_filters);
+	deq = (float*)(weights + (__int64)filter_N*K_pad);
+	comp = (int*)(deq + filter_N);
+	memset(weights, 0, (__int64)filter_N*K_pad);
+	for (n = 0; n < filter_N; n++)
+	{
+		for (h = 0; h < filter_H; h++)
+		{
+			for (w = 0; w < filter_W; w++)
+			{
+				for (c = 0; c < filter_C; c++)
+					tmp[(h*filter_W + w)*filter_C + c] = filters_data[n*filter_sliceStep + h*filter_widthStep + w*filter_pixelStep + c] / in_scales[c];
+			}
+		}
+		/*the scales of the input channels are moved into the weights*/
+		_zq_cnn_8i_quantize_weights(tmp, K, 1.0f, ZQ_CNN_8I_GEMM_WEIGHT_MAX, weights + (__int64)n*K_pad, deq + n, comp + n);
+	}
+	free(tmp);
+}
+
+#if ZQ_CNN_8I_USE_AVX2
+ZQ_CNN_TARGET_AVX2_BEGIN
+#define zq_cnn_8i_use_avx2 1
+#define _zq_cnn_quantize_8u _zq_cnn_quantize_8u_avx2
+#define _zq_cnn_8i_dequantize _zq_cnn_8i_dequantize_avx2
+#define zq_cnn_conv_no_padding_gemm_8i zq_cnn_conv_no_padding_gemm_8i_avx2
+#define zq_cnn_depthwise_conv_no_padding_8i zq_cnn_depthwise_conv_no_padding_8i_avx2
+#include "zq_cnn_convolution_8i_c_raw.h"
+#undef zq_cnn_8i_use_avx2
+#undef _zq_cnn_quantize_8u
+#undef _zq_cnn_8i_dequantize
+#undef zq_cnn_conv_no_padding_gemm_8i
+#undef zq_cnn_depthwise_conv_no_padding_8i
+ZQ_CNN_TARGET_AVX2_END
+#endif
+
+#if !ZQ_CNN_8I_USE_AVX2 || ZQ_CNN_DISPATCH_SSETYPE
+#define zq_cnn_8i_use_avx2 0
+#define _zq_cnn_quantize_8u _zq_cnn_quantize_8u_c
+#define _zq_cnn_8i_dequantize _zq_cnn_8i_dequantize_c
+#define zq_cnn_conv_no_padding_gemm_8i zq_cnn_conv_no_padding_gemm_8i_c
+#define zq_cnn_depthwise_conv_no_padding_8i zq_cnn_depthwise_conv_no_padding_8i_c
+#include "zq_cnn_convolution_8i_c_raw.h"
+#undef zq_cnn_8i_use_avx2
+#undef _zq_cnn_quantize_8u
+#undef _zq_cnn_8i_dequantize
+#undef zq_cnn_conv_no_padding_gemm_8i
+#undef zq_cnn_depthwise_conv_no_padding_8i
+#endif
+
+void zq_cnn_conv_no_padding_gemm_8i(
+	const float* in_tensor4D_data,
+	int in_N,
+	int in_H,
+	int in_W,
+	int in_C,
+	int in_pixelStep,
+	int in_widthStep,
+	int in_sliceStep,
+	const float* in_scales,
+	const void* packed_filters,
+	int filter_N,
+	int filter_H,
+	int filter_W,
+	int filter_C,
+	int stride_H,
+	int stride_W,
+	int dilation_H,
+	int dilation_W,
+	float* out_tensor4D_data,
+	int out_N,
+	int out_H,
+	int out_W,
+	int out_C,
+	int out_pixelStep,
+	int out_widthStep,
+	int out_sliceStep,
+	const float* bias,
+	const float* slope,
+	void** buffer,
+	__int64* buffer_len
+)
+{
+#if ZQ_CNN_8I_USE_AVX2
+	if (ZQ_CNN_CAN_RUN_256BIT)
+	{
+		zq_cnn_conv_no_padding_gemm_8i_avx2(in_tensor4D_data, in_N, in_H, in_W, in_C, in_pixelStep, in_widthStep, in_sliceStep,
+			in_scales, packed_filters, filter_N, filter_H, filter_W, filter_C, stride_H, stride_W,
+			dilation_H, dilation_W, out_tensor4D_data, out_N, out_H, out_W, out_C, out_pixelStep,
+			out_widthStep, out_sliceStep, bias, slope, buffer, buffer_len);
+		return;
+	}
+#endif
+#if !ZQ_CNN_8I_USE_AVX2 || ZQ_CNN_DISPATCH_SSETYPE
+	zq_cnn_conv_no_padding_gemm_8i_c(in_tensor4D_data, in_N, in_H, in_W, in_C, in_pixelStep, in_widthStep, in_sliceStep,
+		in_scales, packed_filters, filter_N, filter_H, filter_W, filter_C, stride_H, stride_W,
+		dilation_H, dilation_W, out_tensor4D_data, out_N, out_H, out_W, out_C, out_pixelStep,
+		out_widthStep, out_sliceStep, bias, slope, buffer, buffer_len);
+#endif
+}
+
+/*packed: weights (filter_H*filter_W+1)/2 x C16 x 2 (two neighbouring taps of each channel), deq C16, comp C16*/
+void zq_cnn_depthwise_conv_8i_pack_filters(
+	const float* filters_data,
+	int filter_H,
+	int filter_W,
+	int filter_C,
+	int filter_pixelStep,
+	int filter_widthStep,
+	const float* in_scales,
+	void** packed_filters,
+	__int64* packed_filters_len
+)
+{
+	int taps = filter_H*filter_W;
+	int pairs = (taps + 1) / 2;
+	int C16 = _zq_cnn_8i_align16(filter_C);
+	__int64 need_len = (__int64)pairs*C16 * 2 * sizeof(short) + (__int64)C16*(sizeof(float) + sizeof(int));
+	short* weights;
+	float* deq;
+	int* comp;
+	float* tmp = (float*)malloc(sizeof(float)*taps);
+	signed char* tmp_q = (signed char*)malloc(taps);
+	int c, t;
+	_zq_cnn_8i_realloc(packed_filters, packed_filters_len, need_len);
+	weights = (short*)(*packed_filters);
+	deq = (float*)(weights + (__int64)pairs*C16 * 2);
+	comp = (int*)(deq + C16);
+	memset(*packed_filters, 0, need_len);
+	for (c = 0; c < filter_C; c++)
+	{
+		for (t = 0; t < taps; t++)
+			tmp[t] = filters_data[(t / filter_W)*filter_widthStep + (t%filter_W)*filter_pixelStep + c];
+		_zq_cnn_8i_quantize_weights(tmp, taps, in_scales[c], ZQ_CNN_8I_DW_WEIGHT_MAX, tmp_q, deq + c, comp + c);
+		for (t = 0; t < taps; t += 2)
+		{
+			weights[((__int64)(t / 2)*C16 + c) * 2] = tmp_q[t];
+			weights[((__int64)(t / 2)*C16 + c) * 2 + 1] = t + 1 < taps ? tmp_q[t + 1] : 0;
+		}
+	}
+	free(tmp);
+	free(tmp_q);
+}
+
+void zq_cnn_depthwise_conv_no_padding_8i(
+	const float* in_tensor4D_data,
+	int in_N,
+	int in_H,
+	int in_W,
+	int in_C,
+	int in_pixelStep,
+	int in_widthStep,
+	int in_sliceStep,
+	const float* in_scales,
+	const void* packed_filters,
+	int filter_H,
+	int filter_W,
+	int stride_H,
+	int stride_W,
+	float* out_tensor4D_data,
+	int out_N,
+	int out_H,
+	int out_W,
+	int out_C,
+	int out_pixelStep,
+	int out_widthStep,
+	int out_sliceStep,
+	const float* bias,
+	const float* slope,
+	void** buffer,
+	__int64* buffer_len
+)
+{
+#if ZQ_CNN_8I_USE_AVX2
+	if (ZQ_CNN_CAN_RUN_256BIT)
+	{
+		zq_cnn_depthwise_conv_no_padding_8i_avx2(in_tensor4D_data, in_N, in_H, in_W, in_C, in_pixelStep, in_widthStep, in_sliceStep,
+			in_scales, packed_filters, filter_H, filter_W, stride_H, stride_W, out_tensor4D_data, out_N,
+			out_H, out_W, out_C, out_pixelStep, out_widthStep, out_sliceStep, bias, slope,
+			buffer, buffer_len);
+		return;
+	}
+#endif
+#if !ZQ_CNN_8I_USE_AVX2 || ZQ_CNN_DISPATCH_SSETYPE
+	zq_cnn_depthwise_conv_no_padding_8i_c(in_tensor4D_data, in_N, in_H, in_W, in_C, in_pixelStep, in_widthStep, in_sliceStep,
+		in_scales, packed_filters, filter_H, filter_W, stride_H, stride_W, out_tensor4D_data, out_N,
+		out_H, out_W, out_C, out_pixelStep, out_widthStep, out_sliceStep, bias, slope,
+		buffer, buffer_len);
+#endif
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
@@ -0,0 +1,109 @@
+#ifndef _ZQ_CNN_CONVOLUTION_8I_C_H_
+#define _ZQ_CNN_CONVOLUTION_8I_C_H_
+#include "../ZQ_CNN_CompileConfig.h"
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*int8 convolution: channel c of the input is quantized to round(x*in_scales[c]) in [-127,127] (stored as unsigned char
+	with zero point 128), the filters are quantized per output channel when packed, and the int32 result is turned back to float
+	with bias (if not 0) and prelu (if not 0) applied. in_scales must be the same when packing and running*/
+
+	/*the packed filters of this build differ from the ones of builds returning another value*/
+	int zq_cnn_8i_pack_format();
+
+	/*filters for zq_cnn_conv_no_padding_gemm_8i, *packed_filters is reallocated if *packed_filters_len is not enough*/
+	void zq_cnn_conv_gemm_8i_pack_filters(
+		const float* filters_data,
+		int filter_N,
+		int filter_H,
+		int filter_W,
+		int filter_C,
+		int filter_pixelStep,
+		int filter_widthStep,
+		int filter_sliceStep,
+		const float* in_scales,
+		void** packed_filters,
+		__int64* packed_filters_len
+	);
+
+	void zq_cnn_conv_no_padding_gemm_8i(
+		const float* in_tensor4D_data,
+		int in_N,
+		int in_H,
+		int in_W,
+		int in_C,
+		int in_pixelStep,
+		int in_widthStep,
+		int in_sliceStep,
+		const float* in_scales,
+		const void* packed_filters,
+		int filter_N,
+		int filter_H,
+		int filter_W,
+		int filter_C, // must be in_C
+		int stride_H,
+		int stride_W,
+		int dilation_H,
+		int dilation_W,
+		float* out_tensor4D_data,
+		int out_N,	// must be in_N
+		int out_H,	// must be (in_H - (filter_H-1)*dilation_H - 1)/stride_H + 1
+		int out_W,	// must be (in_W - (filter_W-1)*dilation_W - 1)/stride_W + 1
+		int out_C,	// must be filter_N
+		int out_pixelStep,
+		int out_widthStep,
+		int out_sliceStep,
+		const float* bias,
+		const float* slope,
+		void** buffer,
+		__int64* buffer_len
+	);
+
+	/*filters for zq_cnn_depthwise_conv_no_padding_8i, *packed_filters is reallocated if *packed_filters_len is not enough*/
+	void zq_cnn_depthwise_conv_8i_pack_filters(
+		const float* filters_data,
+		int filter_H,
+		int filter_W,
+		int filter_C,
+		int filter_pixelStep,
+		int filter_widthStep,
+		const float* in_scales,
+		void** packed_filters,
+		__int64* packed_filters_len
+	);
+
+	void zq_cnn_depthwise_conv_no_padding_8i(
+		const float* in_tensor4D_data,
+		int in_N,
+		int in_H,
+		int in_W,
+		int in_C,
+		int in_pixelStep,
+		int in_widthStep,
+		int in_sliceStep,
+		const float* in_scales,
+		const void* packed_filters,
+		int filter_H,
+		int filter_W,
+		int stride_H,
+		int stride_W,
+		float* out_tensor4D_data,
+		int out_N,	// must be in_N
+		int out_H,	// must be (in_H - filter_H)/stride_H + 1
+		int out_W,	// must be (in_W - filter_W)/stride_W + 1
+		int out_C,	// must be in_C
+		int out_pixelStep,
+		int out_widthStep,
+		int out_sliceStep,
+		const float* bias,
+		const float* slope,
+		void** buffer,
+		__int64* buffer_len
+	);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,366 @@
+/*dst[c] = clamp(round(src[c]*scales[c]), -127, 127) + 128*/
+static void _zq_cnn_quantize_8u(const float* src, int C, const float* scales, unsigned char* dst)
+{
+	int c = 0, q;
+	float v;
+#if zq_cnn_8i_use_avx2
+	__m256i idx = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	__m256i low = _mm256_set1_epi8(-127);
+	__m256i zero_point = _mm256_set1_epi8((char)0x80);
+	__m256i q0, q1, q2, q3;
+	for (; c + 32 <= C; c += 32)
+	{
+		q0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + c), _mm256_loadu_ps(scales + c)));
+		q1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + c + 8), _mm256_loadu_ps(scales + c + 8)));
+		q2 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + c + 16), _mm256_loadu_ps(scales + c + 16)));
+		q3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + c + 24), _mm256_loadu_ps(scales + c + 24)));
+		q0 = _mm256_packs_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3));
+		q0 = _mm256_permutevar8x32_epi32(q0, idx);
+		q0 = _mm256_xor_si256(_mm256_max_epi8(q0, low), zero_point);
+		_mm256_storeu_si256((__m256i*)(dst + c), q0);
+	}
+#endif
+	for (; c < C; c++)
+	{
+		v = src[c] * scales[c];
+		q = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+		q = __max(-127, __min(127, q));
+		dst[c] = (unsigned char)(q + ZQ_CNN_8I_ZERO_POINT);
+	}
+}
+
+/*dst[c] = (sum[c]-comp[c])*deq[c] + bias[c], then prelu, only C channels are written (dst may be a channel slice of a concat)*/
+static void _zq_cnn_8i_dequantize(const int* sum, const int* comp, const float* deq, const float* bias, const float* slope,
+	int C, float* dst)
+{
+	int c = 0;
+	float v;
+#if zq_cnn_8i_use_avx2
+	__m256 vv, vzero = _mm256_setzero_ps();
+	for (; c + 8 <= C; c += 8)
+	{
+		vv = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(sum + c)), _mm256_loadu_si256((const __m256i*)(comp + c))));
+		vv = _mm256_mul_ps(vv, _mm256_loadu_ps(deq + c));
+		if (bias)
+			vv = _mm256_add_ps(vv, _mm256_loadu_ps(bias + c));
+		if (slope)
+			vv = _mm256_add_ps(_mm256_max_ps(vv, vzero), _mm256_mul_ps(_mm256_min_ps(vv, vzero), _mm256_loadu_ps(slope + c)));
+		_mm256_storeu_ps(dst + c, vv);
+	}
+#endif
+	for (; c < C; c++)
+	{
+		v = (float)(sum[c] - comp[c])*deq[c];
+		if (bias)
+			v += bias[c];
+		if (slope && v < 0)
+			v *= slope[c];
+		dst[c] = v;
+	}
+}
+
+static void zq_cnn_conv_no_padding_gemm_8i(
+	const float* in_tensor4D_data,
+	int in_N,
+	int in_H,
+	int in_W,
+	int in_C,
+	int in_pixelStep,
+	int in_widthStep,
+	int in_sliceStep,
+	const float* in_scales,
+	const void* packed_filters,
+	int filter_N,
+	int filter_H,
+	int filter_W,
+	int filter_C,
+	int stride_H,
+	int stride_W,
+	int dilation_H,
+	int dilation_W,
+	float* out_tensor4D_data,
+	int out_N,
+	int out_H,
+	int out_W,
+	int out_C,
+	int out_pixelStep,
+	int out_widthStep,
+	int out_sliceStep,
+	const float* bias,
+	const float* slope,
+	void** buffer,
+	__int64* buffer_len
+)
+{
+	int K = filter_H*filter_W*in_C;
+	int K_pad = _zq_cnn_8i_align32(K);
+	const signed char* weights = (const signed char*)packed_filters;
+	const float* deq = (const float*)(weights + (__int64)filter_N*K_pad);
+	const int* comp = (const int*)(deq + filter_N);
+	int out_HW = out_H*out_W;
+	/*the quantized rows keep in_C channels of each pixel, so 1x1 filters with stride 1 can use them as the im2col matrix*/
+	int direct_A = filter_H == 1 && filter_W == 1 && stride_H == 1 && stride_W == 1 && K_pad == in_C;
+	int q_widthStep = in_W*in_C;
+	int copy_len = dilation_W == 1 ? filter_W*in_C : in_C;
+	int copy_num = dilation_W == 1 ? 1 : filter_W;
+	int block_M, cur_M, m, r, oh, ow, kh, kw, w, out_n, ih, ih_begin, ih_end, max_rows;
+	__int64 need_scale_len_align32, need_row_len_align32, need_Q_len_align32, need_A_len_align32, need_C_len_align32, total_need_buffer_len;
+	float* row_scales = 0;
+	unsigned char* row_buffer = 0, *matrix_Q = 0, *matrix_A = 0, *A_ptr, *q_dst;
+	const unsigned char* q_row_ptr;
+	int* matrix_C = 0;
+	const float* in_slice_ptr;
+	float* out_slice_ptr, *out_pix_ptr;
+
+	/*the im2col matrix and the int32 result of one block of rows should not be larger than ZQ_CNN_GEMM_IM2COL_TILE_BYTES*/
+#if ZQ_CNN_GEMM_IM2COL_TILE_BYTES > 0
+	block_M = ZQ_CNN_GEMM_IM2COL_TILE_BYTES / (K_pad + filter_N * (int)sizeof(int));
+	block_M = __max(1, __min(out_HW, block_M));
+#else
+	block_M = out_HW;
+#endif
+	/*the input rows used by one block are quantized once, then copied to the im2col matrix.
+	copies of up to 32 bytes are done in 16 or 32 bytes, so the buffers have 32 more bytes*/
+	max_rows = (__min(out_H, (block_M - 1) / out_W + 2) - 1)*stride_H + (filter_H - 1)*dilation_H + 1;
+	max_rows = __min(in_H, max_rows);
+	need_scale_len_align32 = ((__int64)in_W*in_pixelStep * sizeof(float) + 31) / 32 * 32;
+	need_row_len_align32 = in_pixelStep == in_C ? 0 : ((__int64)in_W*in_pixelStep + 32 + 31) / 32 * 32;
+	need_Q_len_align32 = ((__int64)max_rows*q_widthStep + 32 + 31) / 32 * 32;
+	need_A_len_align32 = direct_A ? 0 : ((__int64)block_M*K_pad + 32 + 31) / 32 * 32;
+	need_C_len_align32 = ((__int64)block_M*filter_N * sizeof(int) + 31) / 32 * 32;
+	total_need_buffer_len = need_scale_len_align32 + need_row_len_align32 + need_Q_len_align32 + need_A_len_align32 + need_C_len_align32;
+	if (buffer == 0)
+	{
+		row_scales = (float*)_aligned_malloc(total_need_buffer_len, 32);
+	}
+	else
+	{
+		if (*buffer_len < total_need_buffer_len)
+		{
+			_aligned_free(*buffer);
+			*buffer = _aligned_malloc(total_need_buffer_len, 32);
+			*buffer_len = total_need_buffer_len;
+		}
+		row_scales = (float*)(*buffer);
+	}
+	row_buffer = (unsigned char*)row_scales + need_scale_len_align32;
+	matrix_Q = row_buffer + need_row_len_align32;
+
+	/*the scales of a whole row of the input, the padding channels are quantized to 0*/
+	for (w = 0; w < in_W; w++)
+	{
+		memcpy(row_scales + w*in_pixelStep, in_scales, sizeof(float)*in_C);
+		if (in_pixelStep > in_C)
+			memset(row_scales + w*in_pixelStep + in_C, 0, sizeof(float)*(in_pixelStep - in_C));
+	}
+	matrix_A = matrix_Q + need_Q_len_align32;
+	matrix_C = (int*)(matrix_A + need_A_len_align32);
+
+	for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
+		out_n < out_N;
+		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+	{
+		for (m = 0; m < out_HW; m += block_M)
+		{
+			cur_M = __min(block_M, out_HW - m);
+			ih_begin = m / out_W*stride_H;
+			ih_end = (m + cur_M - 1) / out_W*stride_H + (filter_H - 1)*dilation_H;
+			for (ih = ih_begin; ih <= ih_end; ih++)
+			{
+				q_dst = matrix_Q + (__int64)(ih - ih_begin)*q_widthStep;
+				if (in_pixelStep == in_C)
+				{
+					_zq_cnn_quantize_8u(in_slice_ptr + ih*in_widthStep, q_widthStep, row_scales, q_dst);
+				}
+				else
+				{
+					/*quantizing the whole row at once is faster, then drop the padding channels*/
+					_zq_cnn_quantize_8u(in_slice_ptr + ih*in_widthStep, in_W*in_pixelStep, row_scales, row_buffer);
+					for (w = 0; w < in_W; w++)
+					{
+						if (in_C <= 16)
+							memcpy(q_dst + w*in_C, row_buffer + w*in_pixelStep, 16);
+						else
+							memcpy(q_dst + w*in_C, row_buffer + w*in_pixelStep, in_C);
+					}
+				}
+			}
+
+			if (direct_A)
+			{
+				A_ptr = matrix_Q + (__int64)(m - ih_begin*out_W)*in_C;
+			}
+			else
+			{
+				/*the padding of each row (from K to K_pad) is multiplied by zero weights, it needs no values*/
+				for (r = 0; r < cur_M; r++)
+				{
+					oh = (m + r) / out_W;
+					ow = (m + r) % out_W;
+					A_ptr = matrix_A + (__int64)r*K_pad;
+					for (kh = 0; kh < filter_H; kh++)
+					{
+						q_row_ptr = matrix_Q + (__int64)(oh*stride_H + kh*dilation_H - ih_begin)*q_widthStep + ow*stride_W*in_C;
+						for (kw = 0; kw < copy_num; kw++, A_ptr += copy_len)
+						{
+							if (copy_len <= 16)
+								memcpy(A_ptr, q_row_ptr + kw*dilation_W*in_C, 16);
+							else if (copy_len <= 32)
+								memcpy(A_ptr, q_row_ptr + kw*dilation_W*in_C, 32);
+							else
+								memcpy(A_ptr, q_row_ptr + kw*dilation_W*in_C, copy_len);
+						}
+					}
+				}
+				A_ptr = matrix_A;
+			}
+
+			zq_gemm_8u8s_AnoTrans_Btrans(cur_M, filter_N, K_pad, A_ptr, K_pad, weights, K_pad, matrix_C, filter_N);
+
+			for (r = 0; r < cur_M; r++)
+			{
+				oh = (m + r) / out_W;
+				ow = (m + r) % out_W;
+				out_pix_ptr = out_slice_ptr + oh*out_widthStep + ow*out_pixelStep;
+				_zq_cnn_8i_dequantize(matrix_C + (__int64)r*filter_N, comp, deq, bias, slope, filter_N, out_pix_ptr);
+			}
+		}
+	}
+
+	if (buffer == 0)
+		_aligned_free(row_scales);
+}
+
+static void zq_cnn_depthwise_conv_no_padding_8i(
+	const float* in_tensor4D_data,
+	int in_N,
+	int in_H,
+	int in_W,
+	int in_C,
+	int in_pixelStep,
+	int in_widthStep,
+	int in_sliceStep,
+	const float* in_scales,
+	const void* packed_filters,
+	int filter_H,
+	int filter_W,
+	int stride_H,
+	int stride_W,
+	float* out_tensor4D_data,
+	int out_N,
+	int out_H,
+	int out_W,
+	int out_C,
+	int out_pixelStep,
+	int out_widthStep,
+	int out_sliceStep,
+	const float* bias,
+	const float* slope,
+	void** buffer,
+	__int64* buffer_len
+)
+{
+	int taps = filter_H*filter_W;
+	int pairs = (taps + 1) / 2;
+	int C16 = _zq_cnn_8i_align16(in_C);
+	const short* weights = (const short*)packed_filters;
+	const float* deq = (const float*)(weights + (__int64)pairs*C16 * 2);
+	const int* comp = (const int*)(deq + C16);
+	int q_widthStep = in_W*C16;
+	__int64 need_Q_len_align32, total_need_buffer_len;
+	unsigned char* quantized = 0;
+	int* sum = 0;
+	unsigned char* q_dst;
+	const unsigned char* x0_ptr, *x1_ptr, *q_pix_ptr;
+	const short* w_ptr;
+	const float* in_slice_ptr;
+	float* out_slice_ptr, *out_pix_ptr;
+	int out_n, h, w, c, p, t0, t1, oh, ow;
+#if zq_cnn_8i_use_avx2
+	__m128i x0, x1;
+	__m256i acc0, acc1;
+#else
+	int i;
+#endif
+
+	need_Q_len_align32 = ((__int64)in_H*q_widthStep + 31) / 32 * 32;
+	total_need_buffer_len = need_Q_len_align32 + (__int64)C16 * sizeof(int);
+	if (buffer == 0)
+	{
+		quantized = (unsigned char*)_aligned_malloc(total_need_buffer_len, 32);
+	}
+	else
+	{
+		if (*buffer_len < total_need_buffer_len)
+		{
+			_aligned_free(*buffer);
+			*buffer = _aligned_malloc(total_need_buffer_len, 32);
+			*buffer_len = total_need_buffer_len;
+		}
+		quantized = (unsigned char*)(*buffer);
+	}
+	sum = (int*)(quantized + need_Q_len_align32);
+
+	for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
+		out_n < out_N;
+		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+	{
+		/*each input pixel is used by several taps, so quantize the whole image once*/
+		for (h = 0; h < in_H; h++)
+		{
+			for (w = 0; w < in_W; w++)
+			{
+				q_dst = quantized + (__int64)h*q_widthStep + w*C16;
+				_zq_cnn_quantize_8u(in_slice_ptr + h*in_widthStep + w*in_pixelStep, in_C, in_scales, q_dst);
+				if (C16 > in_C)
+					memset(q_dst + in_C, ZQ_CNN_8I_ZERO_POINT, C16 - in_C);
+			}
+		}
+
+		for (oh = 0; oh < out_H; oh++)
+		{
+			for (ow = 0; ow < out_W; ow++)
+			{
+				q_pix_ptr = quantized + (__int64)oh*stride_H*q_widthStep + ow*stride_W*C16;
+				for (c = 0; c < C16; c += 16)
+				{
+#if zq_cnn_8i_use_avx2
+					acc0 = acc1 = _mm256_setzero_si256();
+#endif
+					for (p = 0; p < pairs; p++)
+					{
+						t0 = p * 2;
+						t1 = t0 + 1 < taps ? t0 + 1 : t0;
+						x0_ptr = q_pix_ptr + (t0 / filter_W)*q_widthStep + (t0%filter_W)*C16 + c;
+						x1_ptr = q_pix_ptr + (t1 / filter_W)*q_widthStep + (t1%filter_W)*C16 + c;
+						w_ptr = weights + ((__int64)p*C16 + c) * 2;
+#if zq_cnn_8i_use_avx2
+						x0 = _mm_loadu_si128((const __m128i*)x0_ptr);
+						x1 = _mm_loadu_si128((const __m128i*)x1_ptr);
+						acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(x0, x1)),
+							_mm256_loadu_si256((const __m256i*)w_ptr)));
+						acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpackhi_epi8(x0, x1)),
+							_mm256_loadu_si256((const __m256i*)(w_ptr + 16))));
+#else
+						for (i = 0; i < 16; i++)
+						{
+							if (p == 0)
+								sum[c + i] = 0;
+							sum[c + i] += (int)x0_ptr[i] * w_ptr[i * 2] + (int)x1_ptr[i] * w_ptr[i * 2 + 1];
+						}
+#endif
+					}
+#if zq_cnn_8i_use_avx2
+					_mm256_storeu_si256((__m256i*)(sum + c), acc0);
+					_mm256_storeu_si256((__m256i*)(sum + c + 8), acc1);
+#endif
+				}
+				out_pix_ptr = out_slice_ptr + oh*out_widthStep + ow*out_pixelStep;
+				_zq_cnn_8i_dequantize(sum, comp, deq, bias, slope, out_C, out_pix_ptr);
+			}
+		}
+	}
+
+	if (buffer == 0)
+		_aligned_free(quantized);
+}
@@ -43,6 +43,18 @@
 extern "C" {
 #endif
 
+/*number of output rows computed at once by the gemm convolution,
+the im2col matrix of these rows should not be larger than ZQ_CNN_GEMM_IM2COL_TILE_BYTES*/
+static int _zq_cnn_gemm_im2col_tile_H(int out_H, int out_W, int bytes_per_pixel)
+{
+#if ZQ_CNN_GEMM_IM2COL_TILE_BYTES > 0
+	int tile_H = ZQ_CNN_GEMM_IM2COL_TILE_BYTES / __max(1, out_W*bytes_per_pixel);
+	return __max(1, __min(out_H, tile_H));
+#else
+	return out_H;
+#endif
+}
+
 #if __ARM_NEON
 #define zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep zq_cnn_conv_no_padding_gemm_32f_align128bit_same_pixstep
 #define zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_kernel1x1 zq_cnn_conv_no_padding_gemm_32f_align128bit_same_pixstep_kernel1x1
@@ -232,6 +244,7 @@ extern "C" {
 
 #endif
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep zq_cnn_conv_no_padding_gemm_32f_align256bit_same_pixstep
 #define zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_kernel1x1 zq_cnn_conv_no_padding_gemm_32f_align256bit_same_pixstep_kernel1x1
@@ -291,6 +304,7 @@ extern "C" {
 #undef zq_mm_align_size
 #undef zq_mm_bitor_longlong
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
@@ -984,6 +998,63 @@ extern "C" {
 #endif
 #endif
 
+/*pack the filters as the compact matrix_Bt used by *_same_or_notsame_pixstep_C3,
+filter_N rows of filter_H*filter_W*filter_C values, zero padded to padK*/
+void zq_cnn_conv_gemm_32f_prepack_compact(
+	const float* filters_data,
+	int filter_N,
+	int filter_H,
+	int filter_W,
+	int filter_C,
+	int filter_pixelStep,
+	int filter_widthStep,
+	int filter_sliceStep,
+	void** packed_filters,
+	__int64* packed_filters_len
+)
+{
+	int K = filter_H*filter_W*filter_C;
+#if __ARM_NEON
+	int padK = (K + 3) / 4 * 4;
+#else
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+	int padK = (K + 15) / 16 * 16;
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+	int padK = (K + 7) / 8 * 8;
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	int padK = (K + 3) / 4 * 4;
+#else
+	int padK = K;
+#endif
+#endif
+	int padded_len = padK - K;
+	__int64 need_len_align32 = (filter_N*padK * sizeof(float) + 31) / 32 * 32;
+	const float* filter_slice_ptr, *filter_row_ptr, *filter_pix_ptr;
+	float* cp_dst_ptr;
+	int kn, kh, kw, kc;
+	if (*packed_filters_len < need_len_align32)
+	{
+		if (*packed_filters)
+			_aligned_free(*packed_filters);
+		*packed_filters = _aligned_malloc(need_len_align32, 32);
+		*packed_filters_len = need_len_align32;
+	}
+	cp_dst_ptr = (float*)(*packed_filters);
+	for (kn = 0, filter_slice_ptr = filters_data; kn < filter_N; kn++, filter_slice_ptr += filter_sliceStep)
+	{
+		for (kh = 0, filter_row_ptr = filter_slice_ptr; kh < filter_H; kh++, filter_row_ptr += filter_widthStep)
+		{
+			for (kw = 0, filter_pix_ptr = filter_row_ptr; kw < filter_W; kw++, filter_pix_ptr += filter_pixelStep)
+			{
+				memcpy(cp_dst_ptr, filter_pix_ptr, sizeof(float)*filter_C);
+				cp_dst_ptr += filter_C;
+			}
+		}
+		for (kc = 0; kc < padded_len; kc++)
+			*(cp_dst_ptr++) = 0;
+	}
+}
+
 #if defined(__cplusplus) || defined(c_plusplus) 
 }
 #endif
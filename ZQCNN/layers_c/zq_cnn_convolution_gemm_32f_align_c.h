@@ -249,7 +249,8 @@ extern "C" {
 		int out_widthStep,
 		int out_sliceStep,
 		void** buffer,
-		__int64* buffer_len
+		__int64* buffer_len,
+		const float* packed_filters	// filters packed by zq_cnn_conv_gemm_32f_prepack_compact, can be 0
 	);
 
 	/*in_pixStep can be different with filter_pixStep,
@@ -567,7 +568,8 @@ extern "C" {
 		int out_widthStep,
 		int out_sliceStep,
 		void** buffer,
-		__int64* buffer_len
+		__int64* buffer_len,
+		const float16_t* packed_filters	// filters packed by zq_cnn_conv_gemm_32f_prepack_compact, can be 0
 	);
 
 	/*in_pixStep can be different with filter_pixStep,
@@ -1044,7 +1046,8 @@ extern "C" {
 		int out_widthStep,
 		int out_sliceStep,
 		void** buffer,
-		__int64* buffer_len
+		__int64* buffer_len,
+		const float* packed_filters	// filters packed by zq_cnn_conv_gemm_32f_prepack_compact, can be 0
 	);
 
 	
@@ -1120,7 +1123,8 @@ extern "C" {
 		int out_widthStep,
 		int out_sliceStep,
 		void** buffer,
-		__int64* buffer_len
+		__int64* buffer_len,
+		const float* packed_filters	// filters packed by zq_cnn_conv_gemm_32f_prepack_compact, can be 0
 	);
 
 	
@@ -1242,6 +1246,21 @@ extern "C" {
 
 #endif //__ARM_NEON
 
+	/*pack the filters as the compact matrix_Bt used by *_same_or_notsame_pixstep_C3,
+	*packed_filters is reallocated if *packed_filters_len is not enough*/
+	void zq_cnn_conv_gemm_32f_prepack_compact(
+		const float* filters_data,
+		int filter_N,
+		int filter_H,
+		int filter_W,
+		int filter_C,
+		int filter_pixelStep,
+		int filter_widthStep,
+		int filter_sliceStep,
+		void** packed_filters,
+		__int64* packed_filters_len
+	);
+
 #if defined(__cplusplus) || defined(c_plusplus) 
 }
 #endif
@@ -40,7 +40,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep(
 	int dilate_W_mul_in_pixStep = dilation_W*in_pixelStep;
 	int filter_pixStep_mul_filter_W = filter_pixelStep*filter_W;
 	int matrix_A_cols = filter_sliceStep;
-	int matrix_A_rows = out_H*out_W;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_H, out_W, matrix_A_cols*sizeof(zq_base_type));
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = filter_sliceStep;
 	__int64 need_A_buffer_len_align32 = (matrix_A_rows*matrix_A_cols*sizeof(zq_base_type) + 31) / 32 * 32;
@@ -56,13 +57,13 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep(
 	const zq_base_type* matrix_Bt = filters_data;
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr;
 	int out_row_idx;
-	int out_HW = out_H*out_W;
+	int tile_h, cur_tile_H, cur_A_rows;
 	double t1, t2, t3, t4, t5, t6, alloc_time, make_A_time = 0, gemm_time = 0;
 	t1 = omp_get_wtime();
 	int need_allocate_tmp_out = (out_pixelStep != filter_N) || (out_pixelStep*out_W != out_widthStep) || (out_widthStep*out_H != out_sliceStep);
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_HW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
@@ -95,87 +96,91 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep(
 		out_n < out_N;
 		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
 	{
-		t3 = omp_get_wtime();
-		matrix_A_row_ptr = matrix_A;
-		if (dilation_W == 1)
+		for (tile_h = 0; tile_h < out_H; tile_h += tile_H)
 		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			cur_tile_H = __min(tile_H, out_H - tile_h);
+			cur_A_rows = cur_tile_H*out_W;
+			t3 = omp_get_wtime();
+			matrix_A_row_ptr = matrix_A;
+			if (dilation_W == 1)
 			{
-				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+				for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 				{
-					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
-						kh < filter_H;
-						kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_pixStep_mul_filter_W)
+					for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 					{
-						//memcpy(matrix_A_col_ptr, cur_in_row_ptr, sizeof(zq_base_type)*filter_pixStep_mul_filter_W);
-						for (pp = 0, cp_src_ptr = cur_in_row_ptr, cp_dst_ptr = matrix_A_col_ptr;
-							pp < filter_pixStep_mul_filter_W;
-							pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size, cp_dst_ptr += zq_mm_align_size)
-							zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
+						for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
+							kh < filter_H;
+							kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_pixStep_mul_filter_W)
+						{
+							//memcpy(matrix_A_col_ptr, cur_in_row_ptr, sizeof(zq_base_type)*filter_pixStep_mul_filter_W);
+							for (pp = 0, cp_src_ptr = cur_in_row_ptr, cp_dst_ptr = matrix_A_col_ptr;
+								pp < filter_pixStep_mul_filter_W;
+								pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size, cp_dst_ptr += zq_mm_align_size)
+								zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
 
+						}
+						matrix_A_row_ptr += matrix_A_cols;
 					}
-					matrix_A_row_ptr += matrix_A_cols;
 				}
 			}
-		}
-		else
-		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			else
 			{
-				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+				for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 				{
-					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
-						kh < filter_H;
-						kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_pixStep_mul_filter_W)
+					for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 					{
-						cp_dst_ptr = matrix_A_col_ptr;
-						for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+						for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
+							kh < filter_H;
+							kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_pixStep_mul_filter_W)
 						{
-							for (pp = 0, cp_src_ptr = cur_in_pix_ptr;
-								pp < filter_C;
-								pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size, cp_dst_ptr += zq_mm_align_size)
-								zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
-						}
+							cp_dst_ptr = matrix_A_col_ptr;
+							for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+							{
+								for (pp = 0, cp_src_ptr = cur_in_pix_ptr;
+									pp < filter_C;
+									pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size, cp_dst_ptr += zq_mm_align_size)
+									zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
+							}
 
+						}
+						matrix_A_row_ptr += matrix_A_cols;
 					}
-					matrix_A_row_ptr += matrix_A_cols;
 				}
 			}
-		}
 
-		t4 = omp_get_wtime();
-		make_A_time += t4 - t3;
-		/*gemm*/
+			t4 = omp_get_wtime();
+			make_A_time += t4 - t3;
+			/*gemm*/
+			if (!need_allocate_tmp_out)
+				matrix_C = out_slice_ptr + tile_h*out_widthStep;
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-		{
-			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
-		}
+			if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+			{
+				zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+					matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			}
 #else
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
 #endif
-		t5 = omp_get_wtime();
-		gemm_time += t5 - t4;
-		if (need_allocate_tmp_out)
-		{
-			/*   col2im      */
-			out_row_idx = 0;
-			matrix_C_row_ptr = matrix_C;
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			t5 = omp_get_wtime();
+			gemm_time += t5 - t4;
+			if (need_allocate_tmp_out)
 			{
-				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+				/*   col2im      */
+				out_row_idx = 0;
+				matrix_C_row_ptr = matrix_C;
+				for (out_h = 0, out_row_ptr = out_slice_ptr + tile_h*out_widthStep; out_h < cur_tile_H; out_h++, out_row_ptr += out_widthStep)
 				{
-					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
-					matrix_C_row_ptr += matrix_B_cols;
+					for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+					{
+						memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
+						matrix_C_row_ptr += matrix_B_cols;
+					}
 				}
 			}
 		}
-		else
-			matrix_C += out_sliceStep;
-
 	}
 
 	if (buffer == 0)
@@ -427,7 +432,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_C4(
 	int filter_pixStep_mul_filter_W = filter_pixelStep*filter_W;
 	int filter_C_mul_filter_W = filter_C*filter_W;
 	int matrix_A_cols = filter_sliceStep;
-	int matrix_A_rows = out_H*out_W;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_H, out_W, matrix_A_cols*sizeof(zq_base_type));
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = filter_sliceStep;
 	__int64 need_A_buffer_len_align32 = (matrix_A_rows*matrix_A_cols * sizeof(zq_base_type) + 31) / 32 * 32;
@@ -443,13 +449,13 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_C4(
 	const zq_base_type* matrix_Bt = filters_data;
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr = 0;
 	int out_row_idx;
-	int out_HW = out_H*out_W;
+	int tile_h, cur_tile_H, cur_A_rows;
 	double t1, t2, t3, t4, t5, t6, alloc_time, make_A_time = 0, gemm_time = 0;
 	t1 = omp_get_wtime();
 	int need_allocate_tmp_out = (out_pixelStep != filter_N) || (out_pixelStep*out_W != out_widthStep) || (out_widthStep*out_H != out_sliceStep);
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_HW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
@@ -483,90 +489,95 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_C4(
 		out_n < out_N;
 		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
 	{
-		t3 = omp_get_wtime();
-		matrix_A_row_ptr = matrix_A;
-		if (dilation_W == 1)
+		for (tile_h = 0; tile_h < out_H; tile_h += tile_H)
 		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			cur_tile_H = __min(tile_H, out_H - tile_h);
+			cur_A_rows = cur_tile_H*out_W;
+			t3 = omp_get_wtime();
+			matrix_A_row_ptr = matrix_A;
+			if (dilation_W == 1)
 			{
-				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+				for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 				{
-					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
-						kh < filter_H;
-						kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_C_mul_filter_W)
+					for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 					{
-						for (pp = 0, cp_src_ptr = cur_in_row_ptr, cp_dst_ptr = matrix_A_col_ptr;
-							pp < filter_pixStep_mul_filter_W;
-							pp += filter_pixelStep, cp_src_ptr += filter_pixelStep, cp_dst_ptr += 4)
-							zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
+						for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
+							kh < filter_H;
+							kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_C_mul_filter_W)
+						{
+							for (pp = 0, cp_src_ptr = cur_in_row_ptr, cp_dst_ptr = matrix_A_col_ptr;
+								pp < filter_pixStep_mul_filter_W;
+								pp += filter_pixelStep, cp_src_ptr += filter_pixelStep, cp_dst_ptr += 4)
+								zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cp_src_ptr));
 
+						}
+						matrix_A_row_ptr += matrix_A_cols;
 					}
-					matrix_A_row_ptr += matrix_A_cols;
 				}
 			}
-		}
-		else
-		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			else
 			{
-				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+				for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 				{
-					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
-						kh < filter_H;
-						kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_C_mul_filter_W)
+					for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 					{
-						cp_dst_ptr = matrix_A_col_ptr;
-						for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+						for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
+							kh < filter_H;
+							kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep, matrix_A_col_ptr += filter_C_mul_filter_W)
 						{
-							zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cur_in_pix_ptr));
-							cp_dst_ptr += 4;
-						}
+							cp_dst_ptr = matrix_A_col_ptr;
+							for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+							{
+								zq_mm_store_ps(cp_dst_ptr, zq_mm_load_ps(cur_in_pix_ptr));
+								cp_dst_ptr += 4;
+							}
 
+						}
+						matrix_A_row_ptr += matrix_A_cols;
 					}
-					matrix_A_row_ptr += matrix_A_cols;
 				}
 			}
-		}
 
-		t4 = omp_get_wtime();
-		make_A_time += t4 - t3;
-		/*gemm*/
+			t4 = omp_get_wtime();
+			make_A_time += t4 - t3;
+			/*gemm*/
+			if (!need_allocate_tmp_out)
+				matrix_C = out_slice_ptr + tile_h*out_widthStep;
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-		{
-			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
-		}
+			if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+			{
+				zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+					matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			}
 #else
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
 #endif
-		t5 = omp_get_wtime();
-		gemm_time += t5 - t4;
-		if (need_allocate_tmp_out)
-		{
-			/*   col2im      */
-			out_row_idx = 0;
-			matrix_C_row_ptr = matrix_C;
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			t5 = omp_get_wtime();
+			gemm_time += t5 - t4;
+			if (need_allocate_tmp_out)
 			{
-				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+				/*   col2im      */
+				out_row_idx = 0;
+				matrix_C_row_ptr = matrix_C;
+				for (out_h = 0, out_row_ptr = out_slice_ptr + tile_h*out_widthStep; out_h < cur_tile_H; out_h++, out_row_ptr += out_widthStep)
 				{
-					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
-					matrix_C_row_ptr += matrix_B_cols;
+					for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+					{
+						memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
+						matrix_C_row_ptr += matrix_B_cols;
+					}
 				}
 			}
 		}
-		else
-			matrix_C += out_sliceStep;
-
 	}
 
 	if(buffer == 0)
 	{ 
 		_aligned_free(matrix_A);
-		_aligned_free(matrix_C);
+		if (need_allocate_tmp_out)
+			_aligned_free(matrix_C);
 	}
 	t6 = omp_get_wtime();
 	/*if (filter_H == 1 && filter_W == 1 && filter_C == 4)
@@ -619,7 +630,9 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 	int dilate_W_mul_in_pixStep = dilation_W*in_pixelStep;
 	int filter_pixStep_mul_filter_W = filter_pixelStep*filter_W;
 	int matrix_A_cols = filter_sliceStep;
-	int matrix_A_rows = out_N*out_H*out_W;
+	int out_NH = out_N*out_H;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_NH, out_W, matrix_A_cols*sizeof(zq_base_type));	//rows of all the images
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = filter_sliceStep;
 	__int64 need_A_buffer_len_align32 = (matrix_A_rows*matrix_A_cols * sizeof(zq_base_type) + 31) / 32 * 32;
@@ -630,20 +643,18 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 	zq_base_type *cp_dst_ptr;
 	int out_n, out_h, out_w, kh, kw, pp;
 	zq_base_type* matrix_A_row_ptr, *matrix_A_col_ptr;
-	zq_base_type* out_slice_ptr, *out_row_ptr, *out_pix_ptr;
-	const zq_base_type* in_slice_ptr;
+	zq_base_type* out_row_ptr, *out_pix_ptr;
 	const zq_base_type* matrix_Bt = filters_data;
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr;
 	int out_row_idx;
-	int out_HW = out_H*out_W;
-	int out_NHW = out_HW*out_N;
-	double t1, t2, t3, t4, t5;
+	int tile_r, out_r, cur_tile_H, cur_A_rows;
+	double t1, t2, t3, t4, t5, make_A_time = 0, gemm_time = 0;
 	int need_allocate_tmp_out;
 	t1 = omp_get_wtime();
 	need_allocate_tmp_out = (out_pixelStep != filter_N) || (out_pixelStep*out_W != out_widthStep) || (out_widthStep*out_H != out_sliceStep);
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_NHW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
@@ -672,15 +683,19 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 
 
 	t2 = omp_get_wtime();
-	matrix_A_row_ptr = matrix_A;
-	if (dilation_W == 1)
+	for (tile_r = 0; tile_r < out_NH; tile_r += tile_H)
 	{
-		for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
-			out_n < out_N;
-			out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+		cur_tile_H = __min(tile_H, out_NH - tile_r);
+		cur_A_rows = cur_tile_H*out_W;
+		t3 = omp_get_wtime();
+		matrix_A_row_ptr = matrix_A;
+		if (dilation_W == 1)
 		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			for (out_r = tile_r; out_r < tile_r + cur_tile_H; out_r++)
 			{
+				out_n = out_r / out_H;
+				out_h = out_r - out_n*out_H;
+				in_row_ptr = in_tensor4D_data + (__int64)out_n*in_sliceStep + out_h*in_widthStep_mul_stride_H;
 				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 				{
 					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
@@ -698,15 +713,13 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 				}
 			}
 		}
-	}
-	else
-	{
-		for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
-			out_n < out_N;
-			out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+		else
 		{
-			for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+			for (out_r = tile_r; out_r < tile_r + cur_tile_H; out_r++)
 			{
+				out_n = out_r / out_H;
+				out_h = out_r - out_n*out_H;
+				in_row_ptr = in_tensor4D_data + (__int64)out_n*in_sliceStep + out_h*in_widthStep_mul_stride_H;
 				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 				{
 					for (kh = 0, cur_in_row_ptr = in_pix_ptr, matrix_A_col_ptr = matrix_A_row_ptr;
@@ -729,34 +742,36 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 				}
 			}
 		}
-	}
-	
 
-	t3 = omp_get_wtime();
-	/*gemm*/
+		t4 = omp_get_wtime();
+		make_A_time += t4 - t3;
+		/*gemm*/
+		if (!need_allocate_tmp_out)
+			matrix_C = out_tensor4D_data + (__int64)tile_r*out_widthStep;	//the images are packed, so are their rows
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-	if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
-		matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-	{
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0, matrix_C, matrix_B_cols);
-	}
+		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
+			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+		{
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0, matrix_C, matrix_B_cols);
+		}
 #else
-	zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-		matrix_Bt, matrix_A_cols, 0, matrix_C, matrix_B_cols);
+		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+			matrix_Bt, matrix_A_cols, 0, matrix_C, matrix_B_cols);
 #endif
-	t4 = omp_get_wtime();
-
+		t5 = omp_get_wtime();
+		gemm_time += t5 - t4;
 
-	if (need_allocate_tmp_out)
-	{
-		/*   col2im      */
-		out_row_idx = 0;
-		matrix_C_row_ptr = matrix_C;
-		for (out_n = 0, out_slice_ptr = out_tensor4D_data; out_n < out_N; out_n++, out_slice_ptr += out_sliceStep)
+		if (need_allocate_tmp_out)
 		{
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			/*   col2im      */
+			out_row_idx = 0;
+			matrix_C_row_ptr = matrix_C;
+			for (out_r = tile_r; out_r < tile_r + cur_tile_H; out_r++)
 			{
+				out_n = out_r / out_H;
+				out_h = out_r - out_n*out_H;
+				out_row_ptr = out_tensor4D_data + (__int64)out_n*out_sliceStep + out_h*out_widthStep;
 				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
 				{
 					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
@@ -768,13 +783,14 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_pixstep_batch(
 	if (buffer == 0)
 	{
 		_aligned_free(matrix_A);
-		_aligned_free(matrix_C);
+		if (need_allocate_tmp_out)
+			_aligned_free(matrix_C);
 	}
 	t5 = omp_get_wtime();
 	//if (filter_H == 3 && filter_W == 3 && filter_C == 3)
 	/*{
-		printf("gemm_same_pixstep_batch total: %.3f ms, alloc %.3f ms, makeA: %.3f ms, gemm: %.3f ms, copy_C: %.3f ms\n", 1000 * (t5 - t1), 1000 * (t2 - t1),
-			1000 * (t3 - t2), 1000 * (t4 - t3), 1000 * (t5 - t4));
+		printf("gemm_same_pixstep_batch total: %.3f ms, alloc %.3f ms, makeA: %.3f ms, gemm: %.3f ms\n", 1000 * (t5 - t1), 1000 * (t2 - t1),
+			1000 * make_A_time, 1000 * gemm_time);
 	}*/
 }
 
@@ -822,7 +838,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep(
 	int dilate_W_mul_in_pixStep = dilation_W*in_pixelStep;
 	int common_pixStep_mul_filter_W = common_align_pixStep*filter_W;
 	int matrix_A_cols = filter_H*filter_W*common_align_pixStep;
-	int matrix_A_rows = out_H*out_W;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_H, out_W, matrix_A_cols*sizeof(zq_base_type));
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = filter_H*filter_W*common_align_pixStep;
 	__int64 need_A_buffer_len_align32 = (matrix_A_rows*matrix_A_cols * sizeof(zq_base_type) + 31) / 32 * 32;
@@ -840,7 +857,7 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep(
 	
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr;
 	int out_row_idx;
-	int out_HW = out_H*out_W;
+	int tile_h, cur_tile_H, cur_A_rows;
 	double t1, t2, t3, t4, t5, alloc_time, make_A_time =0, gemm_time = 0;
 	int need_allocate_tmp_out, need_allocate_matrix_Bt;
 	t1 = omp_get_wtime();
@@ -848,7 +865,7 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep(
 	need_allocate_matrix_Bt = common_align_pixStep != filter_pixelStep;
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_HW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
@@ -911,64 +928,68 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep(
 		out_n < out_N;
 		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
 	{
-		t3 = omp_get_wtime();
-		matrix_A_row_ptr = matrix_A;
-		for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+		for (tile_h = 0; tile_h < out_H; tile_h += tile_H)
 		{
-			for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+			cur_tile_H = __min(tile_H, out_H - tile_h);
+			cur_A_rows = cur_tile_H*out_W;
+			t3 = omp_get_wtime();
+			matrix_A_row_ptr = matrix_A;
+			for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 			{
-				matrix_A_col_ptr = matrix_A_row_ptr;
-				for (kh = 0, cur_in_row_ptr = in_pix_ptr;kh < filter_H;	kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep)
+				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 				{
-					for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+					matrix_A_col_ptr = matrix_A_row_ptr;
+					for (kh = 0, cur_in_row_ptr = in_pix_ptr;kh < filter_H;	kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep)
 					{
-						for (pp = 0, cp_src_ptr = cur_in_pix_ptr; pp < common_align_pixStep;
-							pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size)
+						for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
 						{
-							zq_mm_store_ps(matrix_A_col_ptr, zq_mm_load_ps(cp_src_ptr));
-							matrix_A_col_ptr += zq_mm_align_size;
+							for (pp = 0, cp_src_ptr = cur_in_pix_ptr; pp < common_align_pixStep;
+								pp += zq_mm_align_size, cp_src_ptr += zq_mm_align_size)
+							{
+								zq_mm_store_ps(matrix_A_col_ptr, zq_mm_load_ps(cp_src_ptr));
+								matrix_A_col_ptr += zq_mm_align_size;
+							}
 						}
-					}
 					
 
+					}
+					matrix_A_row_ptr += matrix_A_cols;
 				}
-				matrix_A_row_ptr += matrix_A_cols;
 			}
-		}
-		t4 = omp_get_wtime();
-		make_A_time += t4 - t3;
-		/*gemm*/
+			t4 = omp_get_wtime();
+			make_A_time += t4 - t3;
+			/*gemm*/
+			if (!need_allocate_tmp_out)
+				matrix_C = out_slice_ptr + tile_h*out_widthStep;
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-		{
-			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
-		}
+			if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+			{
+				zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+					matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			}
 #else
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
 #endif
 		
-		t5 = omp_get_wtime();
-		gemm_time += t5 - t4;
-		if (need_allocate_tmp_out)
-		{
-			/*   col2im      */
-			out_row_idx = 0;
-			matrix_C_row_ptr = matrix_C;
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			t5 = omp_get_wtime();
+			gemm_time += t5 - t4;
+			if (need_allocate_tmp_out)
 			{
-				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+				/*   col2im      */
+				out_row_idx = 0;
+				matrix_C_row_ptr = matrix_C;
+				for (out_h = 0, out_row_ptr = out_slice_ptr + tile_h*out_widthStep; out_h < cur_tile_H; out_h++, out_row_ptr += out_widthStep)
 				{
-					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
-					matrix_C_row_ptr += matrix_B_cols;
+					for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+					{
+						memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
+						matrix_C_row_ptr += matrix_B_cols;
+					}
 				}
 			}
 		}
-		else
-			matrix_C += out_sliceStep;
-		
 	}
 
 	if (buffer == 0)
@@ -1019,7 +1040,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 	int out_widthStep,
 	int out_sliceStep,
 	void** buffer,
-	__int64* buffer_len
+	__int64* buffer_len,
+	const zq_base_type* packed_filters	// filters packed by zq_cnn_conv_gemm_32f_prepack_compact, can be 0
 )
 {
 	/************** image to col **************/
@@ -1029,7 +1051,9 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 	int padK = (K + 3) / 4 * 4;
 #endif
 #else
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+	int padK = (K + 15) / 16 * 16;
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
 	int padK = (K + 7) / 8*8;
 #elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
 	int padK = (K + 3) / 4 * 4;
@@ -1042,7 +1066,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 	int dilate_H_mul_in_widthStep = dilation_H*in_widthStep;
 	int dilate_W_mul_in_pixStep = dilation_W*in_pixelStep;
 	int matrix_A_cols = padK;
-	int matrix_A_rows = out_H*out_W;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_H, out_W, matrix_A_cols*sizeof(zq_base_type));
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = padK;
 	int padded_len = padK - K;
@@ -1060,25 +1085,27 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr;
 	int out_row_idx;
-	int out_HW = out_H*out_W;
+	int tile_h, cur_tile_H, cur_A_rows;
 	double t1, t2, t3, t4, t5, alloc_time, make_A_time = 0, gemm_time = 0;
 	int need_allocate_tmp_out;
 	t1 = omp_get_wtime();
 	need_allocate_tmp_out = (out_pixelStep != filter_N) || (out_pixelStep*out_W != out_widthStep) || (out_widthStep*out_H != out_sliceStep);
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_HW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
 		matrix_C = out_tensor4D_data;
 	}
-	need_B_buffer_len_align32 = (matrix_B_rows*matrix_B_cols * sizeof(zq_base_type) + 31) / 32 * 32;
+	if (packed_filters == 0)
+		need_B_buffer_len_align32 = (matrix_B_rows*matrix_B_cols * sizeof(zq_base_type) + 31) / 32 * 32;
 	total_need_buffer_len = need_A_buffer_len_align32 + need_B_buffer_len_align32 + need_C_buffer_len_align32;
 	if (buffer == 0)
 	{
 		matrix_A = (zq_base_type*)_aligned_malloc(need_A_buffer_len_align32, 32);
-		matrix_Bt = (zq_base_type*)_aligned_malloc(need_B_buffer_len_align32, 32);
+		if (packed_filters == 0)
+			matrix_Bt = (zq_base_type*)_aligned_malloc(need_B_buffer_len_align32, 32);
 		if (need_allocate_tmp_out)
 			matrix_C = (zq_base_type*)_aligned_malloc(need_C_buffer_len_align32, 32);
 	}
@@ -1096,21 +1123,26 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 			matrix_C = (zq_base_type*)((char*)(*buffer) + need_A_buffer_len_align32 + need_B_buffer_len_align32);
 	}
 
-	matrix_Bt_row_ptr = matrix_Bt;
-	for (kn = 0, filter_slice_ptr = filters_data; kn < filter_N; kn++, filter_slice_ptr += filter_sliceStep)
+	if (packed_filters)
+		matrix_Bt = (zq_base_type*)packed_filters;
+	else
 	{
-		cp_dst_ptr = matrix_Bt_row_ptr;
-		for (kh = 0, filter_row_ptr = filter_slice_ptr; kh < filter_H; kh++, filter_row_ptr += filter_widthStep)
+		matrix_Bt_row_ptr = matrix_Bt;
+		for (kn = 0, filter_slice_ptr = filters_data; kn < filter_N; kn++, filter_slice_ptr += filter_sliceStep)
 		{
-			for (kw = 0, filter_pix_ptr = filter_row_ptr; kw < filter_W; kw++, filter_pix_ptr += filter_pixelStep)
+			cp_dst_ptr = matrix_Bt_row_ptr;
+			for (kh = 0, filter_row_ptr = filter_slice_ptr; kh < filter_H; kh++, filter_row_ptr += filter_widthStep)
 			{
-				memcpy(cp_dst_ptr, filter_pix_ptr, sizeof(zq_base_type)*filter_C);
-				cp_dst_ptr += filter_C;
+				for (kw = 0, filter_pix_ptr = filter_row_ptr; kw < filter_W; kw++, filter_pix_ptr += filter_pixelStep)
+				{
+					memcpy(cp_dst_ptr, filter_pix_ptr, sizeof(zq_base_type)*filter_C);
+					cp_dst_ptr += filter_C;
+				}
 			}
+			for (kc = 0; kc < padded_len; kc++)
+				*(cp_dst_ptr++) = 0;
+			matrix_Bt_row_ptr += matrix_B_rows;
 		}
-		for (kc = 0; kc < padded_len; kc++)
-			*(cp_dst_ptr++) = 0;
-		matrix_Bt_row_ptr += matrix_B_rows;
 	}
 	
 
@@ -1120,65 +1152,70 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_C3(
 		out_n < out_N;
 		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
 	{
-		t3 = omp_get_wtime();
-		matrix_A_row_ptr = matrix_A;
-		for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+		for (tile_h = 0; tile_h < out_H; tile_h += tile_H)
 		{
-			for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
+			cur_tile_H = __min(tile_H, out_H - tile_h);
+			cur_A_rows = cur_tile_H*out_W;
+			t3 = omp_get_wtime();
+			matrix_A_row_ptr = matrix_A;
+			for (out_h = 0, in_row_ptr = in_slice_ptr + tile_h*in_widthStep_mul_stride_H; out_h < cur_tile_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
 			{
-				matrix_A_col_ptr = matrix_A_row_ptr;
-				for (kh = 0, cur_in_row_ptr = in_pix_ptr; kh < filter_H; kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep)
+				for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 				{
-					for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+					matrix_A_col_ptr = matrix_A_row_ptr;
+					for (kh = 0, cur_in_row_ptr = in_pix_ptr; kh < filter_H; kh++, cur_in_row_ptr += dilate_H_mul_in_widthStep)
 					{
-						memcpy(matrix_A_col_ptr, cur_in_pix_ptr, sizeof(zq_base_type)*in_C);
-						matrix_A_col_ptr += in_C;
+						for (kw = 0, cur_in_pix_ptr = cur_in_row_ptr; kw < filter_W; kw++, cur_in_pix_ptr += dilate_W_mul_in_pixStep)
+						{
+							memcpy(matrix_A_col_ptr, cur_in_pix_ptr, sizeof(zq_base_type)*in_C);
+							matrix_A_col_ptr += in_C;
+						}
 					}
+					for (kc = 0; kc < padded_len; kc++)
+						*(matrix_A_col_ptr++) = 0;
+					matrix_A_row_ptr += matrix_A_cols;
 				}
-				for (kc = 0; kc < padded_len; kc++)
-					*(matrix_A_col_ptr++) = 0;
-				matrix_A_row_ptr += matrix_A_cols;
 			}
-		}
-		t4 = omp_get_wtime();
-		make_A_time += t4 - t3;
-		/*gemm*/
+			t4 = omp_get_wtime();
+			make_A_time += t4 - t3;
+			/*gemm*/
+			if (!need_allocate_tmp_out)
+				matrix_C = out_slice_ptr + tile_h*out_widthStep;
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, padK, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-		{
-			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, padK, 1, matrix_A, matrix_A_cols,
-				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
-		}
+			if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, padK, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+			{
+				zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, padK, 1, matrix_A, matrix_A_cols,
+					matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			}
 #else
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, padK, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, padK, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
 #endif
-		t5 = omp_get_wtime();
-		gemm_time += t5 - t4;
-		if (need_allocate_tmp_out)
-		{
-			/*   col2im      */
-			out_row_idx = 0;
-			matrix_C_row_ptr = matrix_C;
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			t5 = omp_get_wtime();
+			gemm_time += t5 - t4;
+			if (need_allocate_tmp_out)
 			{
-				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+				/*   col2im      */
+				out_row_idx = 0;
+				matrix_C_row_ptr = matrix_C;
+				for (out_h = 0, out_row_ptr = out_slice_ptr + tile_h*out_widthStep; out_h < cur_tile_H; out_h++, out_row_ptr += out_widthStep)
 				{
-					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
-					matrix_C_row_ptr += matrix_B_cols;
+					for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
+					{
+						memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
+						matrix_C_row_ptr += matrix_B_cols;
+					}
 				}
 			}
 		}
-		else
-			matrix_C += out_sliceStep;
-
 	}
 
 	if (buffer == 0)
 	{
 		_aligned_free(matrix_A);
-		_aligned_free(matrix_Bt);
+		if (packed_filters == 0)
+			_aligned_free(matrix_Bt);
 		if (need_allocate_tmp_out)
 			_aligned_free(matrix_C);
 	}
@@ -1236,7 +1273,9 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 	int dilate_W_mul_in_pixStep = dilation_W*in_pixelStep;
 	int filter_pixStep_mul_filter_W = filter_pixelStep*filter_W;
 	int matrix_A_cols = filter_H*filter_W*common_align_pixStep;
-	int matrix_A_rows = out_N*out_H*out_W;
+	int out_NH = out_N*out_H;
+	int tile_H = _zq_cnn_gemm_im2col_tile_H(out_NH, out_W, matrix_A_cols*sizeof(zq_base_type));	//rows of all the images
+	int matrix_A_rows = tile_H*out_W;
 	int matrix_B_cols = filter_N;
 	int matrix_B_rows = filter_H*filter_W*common_align_pixStep;
 	__int64 need_A_buffer_len_align32 = (matrix_A_rows*matrix_A_cols * sizeof(zq_base_type) + 31) / 32 * 32;
@@ -1245,22 +1284,22 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 	__int64 total_need_buffer_len;
 	zq_base_type* matrix_A = 0;
 	zq_base_type* matrix_Bt = 0;
-	const zq_base_type* in_slice_ptr, *in_row_ptr, *in_pix_ptr, *cur_in_row_ptr, *cur_in_pix_ptr, *filter_slice_ptr, *filter_row_ptr, *filter_pix_ptr;
+	const zq_base_type* in_row_ptr, *in_pix_ptr, *cur_in_row_ptr, *cur_in_pix_ptr, *filter_slice_ptr, *filter_row_ptr, *filter_pix_ptr;
 	int out_n, out_h, out_w, kn, kh, kw, pp;
 	zq_base_type* matrix_A_row_ptr, *matrix_A_col_ptr, *cp_dst_ptr;
 	const zq_base_type* cp_src_ptr;
-	zq_base_type* out_slice_ptr, *out_row_ptr, *out_pix_ptr;
+	zq_base_type* out_row_ptr, *out_pix_ptr;
 	zq_base_type* matrix_C = 0, *matrix_C_row_ptr;
 	int out_row_idx;
-	int out_NHW = out_N*out_H*out_W;
-	double t1, t2, t3, t4, t5;
+	int tile_r, out_r, cur_tile_H, cur_A_rows;
+	double t1, t2, t3, t4, t5, make_A_time = 0, gemm_time = 0;
 	int need_allocate_matrix_Bt, need_allocate_tmp_out;
 	t1 = omp_get_wtime();
 	need_allocate_matrix_Bt = common_align_pixStep != filter_pixelStep;
 	need_allocate_tmp_out = (out_pixelStep != filter_N) || (out_pixelStep*out_W != out_widthStep) || (out_widthStep*out_H != out_sliceStep);
 	if (need_allocate_tmp_out)
 	{
-		need_C_buffer_len_align32 = (out_NHW*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
+		need_C_buffer_len_align32 = (matrix_A_rows*filter_N * sizeof(zq_base_type) + 31) / 32 * 32;
 	}
 	else
 	{
@@ -1318,14 +1357,17 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 
 	t2 = omp_get_wtime();
 
-
-	matrix_A_row_ptr = matrix_A;
-	for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
-		out_n < out_N;
-		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+	for (tile_r = 0; tile_r < out_NH; tile_r += tile_H)
 	{
-		for (out_h = 0, in_row_ptr = in_slice_ptr; out_h < out_H; out_h++, in_row_ptr += in_widthStep_mul_stride_H)
+		cur_tile_H = __min(tile_H, out_NH - tile_r);
+		cur_A_rows = cur_tile_H*out_W;
+		t3 = omp_get_wtime();
+		matrix_A_row_ptr = matrix_A;
+		for (out_r = tile_r; out_r < tile_r + cur_tile_H; out_r++)
 		{
+			out_n = out_r / out_H;
+			out_h = out_r - out_n*out_H;
+			in_row_ptr = in_tensor4D_data + (__int64)out_n*in_sliceStep + out_h*in_widthStep_mul_stride_H;
 			for (out_w = 0, in_pix_ptr = in_row_ptr; out_w < out_W; out_w++, in_pix_ptr += in_pixelStep_mul_stride_W)
 			{
 				matrix_A_col_ptr = matrix_A_row_ptr;
@@ -1346,31 +1388,35 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 				matrix_A_row_ptr += matrix_A_cols;
 			}
 		}
-	}
 
-	t3 = omp_get_wtime();
-	/*gemm*/
+		t4 = omp_get_wtime();
+		make_A_time += t4 - t3;
+		/*gemm*/
+		if (!need_allocate_tmp_out)
+			matrix_C = out_tensor4D_data + (__int64)tile_r*out_widthStep;	//the images are packed, so are their rows
 #if __ARM_NEON && ZQ_CNN_USE_ZQ_GEMM && ZQ_CNN_USE_BLAS_GEMM
-	if (0 == zq_gemm_32f_AnoTrans_Btrans_special(matrix_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
-		matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
-	{
-		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
-	}
+		if (0 == zq_gemm_32f_AnoTrans_Btrans_special(cur_A_rows, matrix_B_cols, matrix_A_cols, matrix_A, matrix_A_cols,
+			matrix_Bt, matrix_A_cols, matrix_C, matrix_B_cols))
+		{
+			zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+				matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+		}
 #else
-	zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, matrix_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
-		matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
+		zq_cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, cur_A_rows, matrix_B_cols, matrix_A_cols, 1, matrix_A, matrix_A_cols,
+			matrix_Bt, matrix_A_cols, 0.0f, matrix_C, matrix_B_cols);
 #endif
-	t4 = omp_get_wtime();
-	if (need_allocate_tmp_out)
-	{
-		/*   col2im      */
-		out_row_idx = 0;
-		matrix_C_row_ptr = matrix_C;
-		for (out_n = 0, out_slice_ptr = out_tensor4D_data; out_n < out_N; out_n++,out_slice_ptr+=out_sliceStep)
+		t5 = omp_get_wtime();
+		gemm_time += t5 - t4;
+		if (need_allocate_tmp_out)
 		{
-			for (out_h = 0, out_row_ptr = out_slice_ptr; out_h < out_H; out_h++, out_row_ptr += out_widthStep)
+			/*   col2im      */
+			out_row_idx = 0;
+			matrix_C_row_ptr = matrix_C;
+			for (out_r = tile_r; out_r < tile_r + cur_tile_H; out_r++)
 			{
+				out_n = out_r / out_H;
+				out_h = out_r - out_n*out_H;
+				out_row_ptr = out_tensor4D_data + (__int64)out_n*out_sliceStep + out_h*out_widthStep;
 				for (out_w = 0, out_pix_ptr = out_row_ptr; out_w < out_W; out_w++, out_pix_ptr += out_pixelStep)
 				{
 					memcpy(out_pix_ptr, matrix_C_row_ptr, sizeof(zq_base_type)*matrix_B_cols);
@@ -1379,8 +1425,6 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 			}
 		}
 	}
-	else
-		matrix_C += out_sliceStep;
 	t5 = omp_get_wtime();
 
 	if (buffer == 0)
@@ -1393,8 +1437,8 @@ void zq_cnn_conv_no_padding_gemm_32f_align_same_or_notsame_pixstep_batch(
 	}
 	//if (filter_H == 3 && filter_W == 3 && filter_C == 3)
 	/*{
-		printf("gemm_same_pixstep_batch total: %.3f ms, alloc %.3f ms, makeA: %.3f ms, gemm: %.3f ms, copy_C: %.3f ms\n", 1000 * (t5 - t1), 1000 * (t2 - t1),
-			1000 * (t3 - t2), 1000 * (t4 - t3), 1000 * (t5 - t4));
+		printf("gemm_same_pixstep_batch total: %.3f ms, alloc %.3f ms, makeA: %.3f ms, gemm: %.3f ms\n", 1000 * (t5 - t1), 1000 * (t2 - t1),
+			1000 * make_A_time, 1000 * gemm_time);
 	}*/
 }
 
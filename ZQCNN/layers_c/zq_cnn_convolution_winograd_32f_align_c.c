@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../ZQ_CNN_CompileConfig.h"
+#if __ARM_NEON
+#include <arm_neon.h>
+#else
+#if defined(__GNUC__)
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <smmintrin.h>
+#endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+#include <x86intrin.h>
+#endif
+#elif defined(_WIN32)
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <xmmintrin.h> //SSE(include mmintrin.h)  
+#endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+#include <immintrin.h>//AVX(include wmmintrin.h)  
+#endif
+#endif
+#endif //__ARM_NEON
+#include "math/zq_gemm_32f_align_c.h"
+#if ZQ_CNN_USE_BLAS_GEMM
+#include <openblas/cblas.h>
+#elif ZQ_CNN_USE_MKL_GEMM
+#include <mkl/mkl.h>
+#endif
+#include "zq_cnn_convolution_winograd_32f_align_c.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+#if (ZQ_CNN_USE_BLAS_GEMM || ZQ_CNN_USE_MKL_GEMM)
+#define zq_cnn_winograd_sgemm(M, N, K, A, lda, Bt, ldb, C, ldc) \
+	cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, M, N, K, 1, A, lda, Bt, ldb, 0.0f, C, ldc)
+#else
+#define zq_cnn_winograd_sgemm(M, N, K, A, lda, Bt, ldb, C, ldc) \
+	zq_gemm_32f_AnoTrans_Btrans_auto(M, N, K, A, lda, Bt, ldb, C, ldc)
+#endif
+
+#if __ARM_NEON
+#define zq_mm_loadu_ps vld1q_f32
+#define zq_mm_storeu_ps vst1q_f32
+#define zq_mm_set1_ps vdupq_n_f32
+#if ZQ_CNN_USE_FMADD128
+#define zq_mm_fmadd_ps(A, B, C) vfmaq_f32(C, A, B)
+#else
+#define zq_mm_fmadd_ps(A, B, C) vaddq_f32(vmulq_f32(A, B), C)
+#endif
+#define zq_mm_type float32x4_t
+#define zq_mm_align_size 4
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX && !ZQ_CNN_DISPATCH_SSETYPE
+#define zq_mm_loadu_ps _mm256_loadu_ps
+#define zq_mm_storeu_ps _mm256_storeu_ps
+#define zq_mm_set1_ps _mm256_set1_ps
+#if ZQ_CNN_USE_FMADD256
+#define zq_mm_fmadd_ps _mm256_fmadd_ps
+#else
+#define zq_mm_fmadd_ps(A, B, C) _mm256_add_ps(_mm256_mul_ps(A, B), C)
+#endif
+#define zq_mm_type __m256
+#define zq_mm_align_size 8
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+/*a ZQ_CNN_DISPATCH_SSETYPE build also transforms with SSE on the cpus with AVX2, only its gemm is chosen by the cpu*/
+#define zq_mm_loadu_ps _mm_loadu_ps
+#define zq_mm_storeu_ps _mm_storeu_ps
+#define zq_mm_set1_ps _mm_set1_ps
+#define zq_mm_fmadd_ps(A, B, C) _mm_add_ps(_mm_mul_ps(A, B), C)
+#define zq_mm_type __m128
+#define zq_mm_align_size 4
+#endif
+
+static const float zq_cnn_winograd_F2233_BT[16] = {
+	1, 0, -1, 0,
+	0, 1, 1, 0,
+	0, -1, 1, 0,
+	0, 1, 0, -1
+};
+
+static const float zq_cnn_winograd_F2233_G[12] = {
+	1, 0, 0,
+	0.5f, 0.5f, 0.5f,
+	0.5f, -0.5f, 0.5f,
+	0, 0, 1
+};
+
+static const float zq_cnn_winograd_F2233_AT[8] = {
+	1, 1, 1, 0,
+	0, 1, -1, -1
+};
+
+static const float zq_cnn_winograd_F4433_BT[36] = {
+	4, 0, -5, 0, 1, 0,
+	0, -4, -4, 1, 1, 0,
+	0, 4, -4, -1, 1, 0,
+	0, -2, -1, 2, 1, 0,
+	0, 2, -1, -2, 1, 0,
+	0, 4, 0, -5, 0, 1
+};
+
+static const float zq_cnn_winograd_F4433_G[18] = {
+	1.0f / 4, 0, 0,
+	-1.0f / 6, -1.0f / 6, -1.0f / 6,
+	-1.0f / 6, 1.0f / 6, -1.0f / 6,
+	1.0f / 24, 1.0f / 12, 1.0f / 6,
+	1.0f / 24, -1.0f / 12, 1.0f / 6,
+	0, 0, 1
+};
+
+static const float zq_cnn_winograd_F4433_AT[24] = {
+	1, 1, 1, 1, 1, 0,
+	0, 1, -1, 2, -2, 0,
+	0, 1, 1, 4, 4, 0,
+	0, 1, -1, 8, -8, 1
+};
+
+/*channels are padded as the gemm convolution does*/
+static int _zq_cnn_winograd_padC(int C)
+{
+#if __ARM_NEON
+	return (C + 3) / 4 * 4;
+#else
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+	return (C + 7) / 8 * 8;
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	return (C + 3) / 4 * 4;
+#else
+	return C;
+#endif
+#endif
+}
+
+/*dst[c] += l*src[c]*/
+static void _zq_cnn_winograd_axpy(float l, const float* src, float* dst, int C)
+{
+	int c = 0;
+#if defined(zq_mm_align_size)
+	zq_mm_type vl = zq_mm_set1_ps(l);
+	for (; c + zq_mm_align_size <= C; c += zq_mm_align_size)
+		zq_mm_storeu_ps(dst + c, zq_mm_fmadd_ps(vl, zq_mm_loadu_ps(src + c), zq_mm_loadu_ps(dst + c)));
+#endif
+	for (; c < C; c++)
+		dst[c] += l*src[c];
+}
+
+/*dst[i][j][c] = sum_k L[i][k]*src[k][j][c], L is L_rows x L_cols, src is L_cols x src_cols x C*/
+static void _zq_cnn_winograd_mul_left(const float* L, int L_rows, int L_cols, const float* src, int src_cols, int C, float* dst)
+{
+	int i, j, k;
+	float l;
+	const float* src_ptr;
+	float* dst_ptr;
+	memset(dst, 0, sizeof(float)*L_rows*src_cols*C);
+	for (i = 0; i < L_rows; i++)
+	{
+		for (k = 0; k < L_cols; k++)
+		{
+			l = L[i*L_cols + k];
+			if (l == 0)
+				continue;
+			for (j = 0; j < src_cols; j++)
+			{
+				src_ptr = src + (k*src_cols + j)*C;
+				dst_ptr = dst + (i*src_cols + j)*C;
+				_zq_cnn_winograd_axpy(l, src_ptr, dst_ptr, C);
+			}
+		}
+	}
+}
+
+/*dst[i][j][c] = sum_k src[i][k][c]*L[j][k], L is L_rows x L_cols, src is src_rows x L_cols x C*/
+static void _zq_cnn_winograd_mul_right(const float* L, int L_rows, int L_cols, const float* src, int src_rows, int C, float* dst)
+{
+	int i, j, k;
+	float l;
+	const float* src_ptr;
+	float* dst_ptr;
+	memset(dst, 0, sizeof(float)*src_rows*L_rows*C);
+	for (i = 0; i < src_rows; i++)
+	{
+		for (j = 0; j < L_rows; j++)
+		{
+			dst_ptr = dst + (i*L_rows + j)*C;
+			for (k = 0; k < L_cols; k++)
+			{
+				l = L[j*L_cols + k];
+				if (l == 0)
+					continue;
+				src_ptr = src + (i*L_cols + k)*C;
+				_zq_cnn_winograd_axpy(l, src_ptr, dst_ptr, C);
+			}
+		}
+	}
+}
+
+void zq_cnn_winograd_transform_filters_32f(
+	int out_tile,
+	const float* filters_data,
+	int filter_N,
+	int filter_C,
+	int filter_pixelStep,
+	int filter_widthStep,
+	int filter_sliceStep,
+	void** trans_filters,
+	__int64* trans_filters_len
+)
+{
+	int alpha = out_tile + 2;
+	int alpha2 = alpha*alpha;
+	const float* G = out_tile == 2 ? zq_cnn_winograd_F2233_G : zq_cnn_winograd_F4433_G;
+	int padC = _zq_cnn_winograd_padC(filter_C);
+	__int64 need_len_align32 = ((__int64)alpha2*filter_N*padC * sizeof(float) + 31) / 32 * 32;
+	float* g = (float*)malloc(sizeof(float) * 9 * filter_C);
+	float* tmp = (float*)malloc(sizeof(float)*alpha * 3 * filter_C);
+	float* res = (float*)malloc(sizeof(float)*alpha2*filter_C);
+	float* dst;
+	int n, kh, kw, xi;
+	if (*trans_filters_len < need_len_align32)
+	{
+		if (*trans_filters)
+			_aligned_free(*trans_filters);
+		*trans_filters = _aligned_malloc(need_len_align32, 32);
+		*trans_filters_len = need_len_align32;
+	}
+	dst = (float*)(*trans_filters);
+	memset(dst, 0, need_len_align32);
+	for (n = 0; n < filter_N; n++)
+	{
+		for (kh = 0; kh < 3; kh++)
+		{
+			for (kw = 0; kw < 3; kw++)
+				memcpy(g + (kh * 3 + kw)*filter_C, filters_data + n*filter_sliceStep + kh*filter_widthStep + kw*filter_pixelStep, sizeof(float)*filter_C);
+		}
+		_zq_cnn_winograd_mul_left(G, alpha, 3, g, 3, filter_C, tmp);
+		_zq_cnn_winograd_mul_right(G, alpha, 3, tmp, alpha, filter_C, res);
+		for (xi = 0; xi < alpha2; xi++)
+			memcpy(dst + ((__int64)xi*filter_N + n)*padC, res + xi*filter_C, sizeof(float)*filter_C);
+	}
+	free(g);
+	free(tmp);
+	free(res);
+}
+
+void zq_cnn_conv_no_padding_winograd_32f(
+	int out_tile,
+	const float* in_tensor4D_data,
+	int in_N,
+	int in_H,
+	int in_W,
+	int in_C,
+	int in_pixelStep,
+	int in_widthStep,
+	int in_sliceStep,
+	const float* trans_filters,
+	int filter_N,
+	float* out_tensor4D_data,
+	int out_N,
+	int out_H,
+	int out_W,
+	int out_C,
+	int out_pixelStep,
+	int out_widthStep,
+	int out_sliceStep,
+	void** buffer,
+	__int64* buffer_len
+)
+{
+	int alpha = out_tile + 2;
+	int alpha2 = alpha*alpha;
+	const float* BT = out_tile == 2 ? zq_cnn_winograd_F2233_BT : zq_cnn_winograd_F4433_BT;
+	const float* AT = out_tile == 2 ? zq_cnn_winograd_F2233_AT : zq_cnn_winograd_F4433_AT;
+	int padC = _zq_cnn_winograd_padC(in_C);
+	int max_C = __max(padC, filter_N);
+	int tiles_H = (out_H + out_tile - 1) / out_tile;
+	int tiles_W = (out_W + out_tile - 1) / out_tile;
+	int block_tiles_H, block_tiles, cur_tiles_H, cur_tiles;
+	__int64 need_V_buffer_len_align32, need_M_buffer_len_align32, need_tmp_buffer_len_align32, total_need_buffer_len;
+	float* matrix_V = 0, *matrix_M = 0, *tile_d = 0, *tile_tmp = 0, *tile_res = 0;
+	const float* in_slice_ptr, *in_pix_ptr;
+	float* out_slice_ptr, *out_pix_ptr;
+	int out_n, tile_h, t, th, tw, i, j, h, w, xi;
+
+	/*the transformed data of one block of tile rows should not be larger than ZQ_CNN_GEMM_IM2COL_TILE_BYTES*/
+#if ZQ_CNN_GEMM_IM2COL_TILE_BYTES > 0
+	block_tiles_H = ZQ_CNN_GEMM_IM2COL_TILE_BYTES / __max(1, tiles_W*alpha2*(padC + filter_N) * (int)sizeof(float));
+	block_tiles_H = __max(1, __min(tiles_H, block_tiles_H));
+#else
+	block_tiles_H = tiles_H;
+#endif
+	block_tiles = block_tiles_H*tiles_W;
+	need_V_buffer_len_align32 = ((__int64)block_tiles*alpha2*padC * sizeof(float) + 31) / 32 * 32;
+	need_M_buffer_len_align32 = ((__int64)block_tiles*alpha2*filter_N * sizeof(float) + 31) / 32 * 32;
+	need_tmp_buffer_len_align32 = ((__int64)alpha2*max_C * sizeof(float) + 31) / 32 * 32;
+	total_need_buffer_len = need_V_buffer_len_align32 + need_M_buffer_len_align32 + need_tmp_buffer_len_align32 * 3;
+	if (buffer == 0)
+	{
+		matrix_V = (float*)_aligned_malloc(total_need_buffer_len, 32);
+	}
+	else
+	{
+		if (*buffer_len < total_need_buffer_len)
+		{
+			_aligned_free(*buffer);
+			*buffer = _aligned_malloc(total_need_buffer_len, 32);
+			*buffer_len = total_need_buffer_len;
+		}
+		matrix_V = (float*)(*buffer);
+	}
+	matrix_M = (float*)((char*)matrix_V + need_V_buffer_len_align32);
+	tile_d = (float*)((char*)matrix_M + need_M_buffer_len_align32);
+	tile_tmp = (float*)((char*)tile_d + need_tmp_buffer_len_align32);
+	tile_res = (float*)((char*)tile_tmp + need_tmp_buffer_len_align32);
+
+	for (out_n = 0, in_slice_ptr = in_tensor4D_data, out_slice_ptr = out_tensor4D_data;
+		out_n < out_N;
+		out_n++, in_slice_ptr += in_sliceStep, out_slice_ptr += out_sliceStep)
+	{
+		for (tile_h = 0; tile_h < tiles_H; tile_h += block_tiles_H)
+		{
+			cur_tiles_H = __min(block_tiles_H, tiles_H - tile_h);
+			cur_tiles = cur_tiles_H*tiles_W;
+
+			/* V = BT * d * B */
+			for (t = 0; t < cur_tiles; t++)
+			{
+				th = tile_h + t / tiles_W;
+				tw = t % tiles_W;
+				memset(tile_d, 0, sizeof(float)*alpha2*padC);
+				for (i = 0; i < alpha; i++)
+				{
+					h = th*out_tile + i;
+					if (h >= in_H)
+						break;
+					for (j = 0; j < alpha; j++)
+					{
+						w = tw*out_tile + j;
+						if (w >= in_W)
+							break;
+						in_pix_ptr = in_slice_ptr + h*in_widthStep + w*in_pixelStep;
+						memcpy(tile_d + (i*alpha + j)*padC, in_pix_ptr, sizeof(float)*in_C);
+					}
+				}
+				_zq_cnn_winograd_mul_left(BT, alpha, alpha, tile_d, alpha, padC, tile_tmp);
+				_zq_cnn_winograd_mul_right(BT, alpha, alpha, tile_tmp, alpha, padC, tile_res);
+				for (xi = 0; xi < alpha2; xi++)
+					memcpy(matrix_V + ((__int64)xi*cur_tiles + t)*padC, tile_res + xi*padC, sizeof(float)*padC);
+			}
+
+			/* M = V * U, one gemm for each of the alpha*alpha positions */
+			for (xi = 0; xi < alpha2; xi++)
+			{
+				zq_cnn_winograd_sgemm(cur_tiles, filter_N, padC, matrix_V + (__int64)xi*cur_tiles*padC, padC,
+					trans_filters + (__int64)xi*filter_N*padC, padC, matrix_M + (__int64)xi*cur_tiles*filter_N, filter_N);
+			}
+
+			/* Y = AT * M * A */
+			for (t = 0; t < cur_tiles; t++)
+			{
+				th = tile_h + t / tiles_W;
+				tw = t % tiles_W;
+				for (xi = 0; xi < alpha2; xi++)
+					memcpy(tile_d + xi*filter_N, matrix_M + ((__int64)xi*cur_tiles + t)*filter_N, sizeof(float)*filter_N);
+				_zq_cnn_winograd_mul_left(AT, out_tile, alpha, tile_d, alpha, filter_N, tile_tmp);
+				_zq_cnn_winograd_mul_right(AT, out_tile, alpha, tile_tmp, out_tile, filter_N, tile_res);
+				for (i = 0; i < out_tile; i++)
+				{
+					h = th*out_tile + i;
+					if (h >= out_H)
+						break;
+					for (j = 0; j < out_tile; j++)
+					{
+						w = tw*out_tile + j;
+						if (w >= out_W)
+							break;
+						out_pix_ptr = out_slice_ptr + h*out_widthStep + w*out_pixelStep;
+						memcpy(out_pix_ptr, tile_res + (i*out_tile + j)*filter_N, sizeof(float)*filter_N);
+					}
+				}
+			}
+		}
+	}
+
+	if (buffer == 0)
+		_aligned_free(matrix_V);
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
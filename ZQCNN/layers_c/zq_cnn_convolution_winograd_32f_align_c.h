@@ -0,0 +1,53 @@
+#ifndef _ZQ_CNN_CONVOLUTION_WINOGRAD_32F_ALIGN_C_H_
+#define _ZQ_CNN_CONVOLUTION_WINOGRAD_32F_ALIGN_C_H_
+#include "../ZQ_CNN_CompileConfig.h"
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*transform 3x3 filters for winograd F(out_tile x out_tile, 3x3), out_tile must be 2 or 4,
+	trans_filters is (out_tile+2)^2 matrices of filter_N x padC,
+	*trans_filters is reallocated if *trans_filters_len is not enough*/
+	void zq_cnn_winograd_transform_filters_32f(
+		int out_tile,
+		const float* filters_data,
+		int filter_N,
+		int filter_C,
+		int filter_pixelStep,
+		int filter_widthStep,
+		int filter_sliceStep,
+		void** trans_filters,
+		__int64* trans_filters_len
+	);
+
+	/*3x3 convolution with stride 1 and dilation 1, trans_filters is made by zq_cnn_winograd_transform_filters_32f,
+	and the aligned channels should be set to zero*/
+	void zq_cnn_conv_no_padding_winograd_32f(
+		int out_tile,
+		const float* in_tensor4D_data,
+		int in_N,
+		int in_H,
+		int in_W,
+		int in_C,
+		int in_pixelStep,
+		int in_widthStep,
+		int in_sliceStep,
+		const float* trans_filters,
+		int filter_N,
+		float* out_tensor4D_data,
+		int out_N,	// must be in_N
+		int out_H,	// must be in_H - 2
+		int out_W,	// must be in_W - 2
+		int out_C,	// must be filter_N
+		int out_pixelStep,
+		int out_widthStep,
+		int out_sliceStep,
+		void** buffer,
+		__int64* buffer_len
+	);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
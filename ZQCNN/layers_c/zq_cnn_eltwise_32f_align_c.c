@@ -186,6 +186,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_eltwise_sum_32f_align zq_cnn_eltwise_sum_32f_align256bit
 #define zq_cnn_eltwise_sum_with_weight_32f_align zq_cnn_eltwise_sum_with_weight_32f_align256bit
 #define zq_cnn_eltwise_mul_32f_align zq_cnn_eltwise_mul_32f_align256bit
@@ -234,6 +235,7 @@ extern "C" {
 #undef zq_mm_align_size8
 #undef zq_mm_align_size16
 #undef zq_mm_align_size32
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
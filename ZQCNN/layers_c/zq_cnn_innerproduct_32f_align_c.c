@@ -145,6 +145,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_innerproduct_32f_align zq_cnn_innerproduct_32f_align256bit
 #define	zq_cnn_innerproduct_32f_align_noborder zq_cnn_innerproduct_32f_align256bit_noborder
 #define zq_mm_load_ps _mm256_load_ps
@@ -179,6 +180,7 @@ extern "C" {
 #undef zq_mm_align_size
 #undef zq_mm_bitor_longlong
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
@@ -198,6 +198,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_innerproduct_gemm_32f_align_same_pixstep zq_cnn_innerproduct_gemm_32f_align256bit_same_pixstep
 #define zq_cnn_innerproduct_gemm_32f_align_same_pixstep_batch zq_cnn_innerproduct_gemm_32f_align256bit_same_pixstep_batch
 #define zq_mm_load_ps _mm256_load_ps
@@ -250,6 +251,7 @@ extern "C" {
 #undef zq_mm_bitor_longlong
 #undef zq_final_sum_q
 
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #endif //__ARM_NEON
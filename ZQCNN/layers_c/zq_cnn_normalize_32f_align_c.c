@@ -199,6 +199,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_normalize_not_across_spatial_32f_align zq_cnn_normalize_not_across_spatial_32f_align256bit
 #define zq_cnn_normalize_across_spatial_32f_align zq_cnn_normalize_across_spatial_32f_align256bit
 #define zq_mm_load_ps _mm256_load_ps
@@ -251,6 +252,7 @@ extern "C" {
 #undef zq_mm_align_size_mul_16
 #undef zq_mm_align_size_mul_32
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
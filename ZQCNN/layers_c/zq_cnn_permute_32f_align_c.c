@@ -0,0 +1,207 @@
+#include <string.h>
+#include "../ZQ_CNN_CompileConfig.h"
+#if __ARM_NEON
+#include <arm_neon.h>
+#else
+#if defined(__GNUC__)
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <smmintrin.h>
+#endif
+#elif defined(_WIN32)
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#include <mmintrin.h> //MMX
+#include <xmmintrin.h> //SSE(include mmintrin.h)
+#endif
+#endif
+#endif //__ARM_NEON
+#include "zq_cnn_permute_32f_align_c.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*dst[j*dst_step+i] = src[i*src_step+j] for i,j in [0,4)*/
+	static void _zq_cnn_transpose_4x4_32f(const float* src, int src_step, float* dst, int dst_step, int use_simd)
+	{
+		int i, j;
+#if __ARM_NEON
+		if (use_simd)
+		{
+			float32x4_t r0 = vld1q_f32(src), r1 = vld1q_f32(src + src_step);
+			float32x4_t r2 = vld1q_f32(src + src_step * 2), r3 = vld1q_f32(src + src_step * 3);
+			float32x4x2_t t01 = vtrnq_f32(r0, r1);
+			float32x4x2_t t23 = vtrnq_f32(r2, r3);
+			vst1q_f32(dst, vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+			vst1q_f32(dst + dst_step, vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+			vst1q_f32(dst + dst_step * 2, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+			vst1q_f32(dst + dst_step * 3, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+			return;
+		}
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+		if (use_simd)
+		{
+			__m128 r0 = _mm_loadu_ps(src), r1 = _mm_loadu_ps(src + src_step);
+			__m128 r2 = _mm_loadu_ps(src + src_step * 2), r3 = _mm_loadu_ps(src + src_step * 3);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(dst, r0);
+			_mm_storeu_ps(dst + dst_step, r1);
+			_mm_storeu_ps(dst + dst_step * 2, r2);
+			_mm_storeu_ps(dst + dst_step * 3, r3);
+			return;
+		}
+#endif
+		for (i = 0; i < 4; i++)
+		{
+			for (j = 0; j < 4; j++)
+				dst[j*dst_step + i] = src[i*src_step + j];
+		}
+	}
+
+	static void _zq_cnn_permute_32f(const float* in_data, const int dims[4], const int in_steps[4],
+		float* out_data, const int out_steps[4], int use_simd)
+	{
+		int a = -1, b = -1, o1, o2, o3, i, j, k, i0, j0;
+		int other[4], other_num = 0;
+		const float* in_ptr1, *in_ptr2, *in_ptr3;
+		float* out_ptr1, *out_ptr2, *out_ptr3;
+		for (i = 0; i < 4; i++)
+		{
+			if (dims[i] <= 0)
+				return;
+		}
+		/*b: contiguous in the output, a: contiguous in the input*/
+		for (i = 0; i < 4; i++)
+		{
+			if (b < 0 && out_steps[i] == 1 && dims[i] > 1)
+				b = i;
+			if (a < 0 && in_steps[i] == 1 && dims[i] > 1)
+				a = i;
+		}
+		if (b >= 0 && in_steps[b] == 1)
+		{
+			for (i = 0; i < 4; i++)
+			{
+				if (i != b)
+					other[other_num++] = i;
+			}
+			o1 = other[0]; o2 = other[1]; o3 = other[2];
+			for (i = 0, in_ptr1 = in_data, out_ptr1 = out_data; i < dims[o1]; i++, in_ptr1 += in_steps[o1], out_ptr1 += out_steps[o1])
+			{
+				for (j = 0, in_ptr2 = in_ptr1, out_ptr2 = out_ptr1; j < dims[o2]; j++, in_ptr2 += in_steps[o2], out_ptr2 += out_steps[o2])
+				{
+					for (k = 0, in_ptr3 = in_ptr2, out_ptr3 = out_ptr2; k < dims[o3]; k++, in_ptr3 += in_steps[o3], out_ptr3 += out_steps[o3])
+						memcpy(out_ptr3, in_ptr3, sizeof(float)*dims[b]);
+				}
+			}
+			return;
+		}
+		if (b < 0)
+			b = 3;
+		if (a < 0 || a == b)
+		{
+			for (i = 0; i < 4; i++)
+			{
+				if (i != b)
+					other[other_num++] = i;
+			}
+			o1 = other[0]; o2 = other[1]; o3 = other[2];
+			for (i = 0, in_ptr1 = in_data, out_ptr1 = out_data; i < dims[o1]; i++, in_ptr1 += in_steps[o1], out_ptr1 += out_steps[o1])
+			{
+				for (j = 0, in_ptr2 = in_ptr1, out_ptr2 = out_ptr1; j < dims[o2]; j++, in_ptr2 += in_steps[o2], out_ptr2 += out_steps[o2])
+				{
+					for (k = 0, in_ptr3 = in_ptr2, out_ptr3 = out_ptr2; k < dims[o3]; k++, in_ptr3 += in_steps[o3], out_ptr3 += out_steps[o3])
+					{
+						for (i0 = 0; i0 < dims[b]; i0++)
+							out_ptr3[i0*out_steps[b]] = in_ptr3[i0*in_steps[b]];
+					}
+				}
+			}
+			return;
+		}
+
+		/*transpose a (contiguous in the input) and b (contiguous in the output) in 4x4 blocks*/
+		for (i = 0; i < 4; i++)
+		{
+			if (i != a && i != b)
+				other[other_num++] = i;
+		}
+		o1 = other[0]; o2 = other[1];
+		for (i = 0, in_ptr1 = in_data, out_ptr1 = out_data; i < dims[o1]; i++, in_ptr1 += in_steps[o1], out_ptr1 += out_steps[o1])
+		{
+			for (j = 0, in_ptr2 = in_ptr1, out_ptr2 = out_ptr1; j < dims[o2]; j++, in_ptr2 += in_steps[o2], out_ptr2 += out_steps[o2])
+			{
+				for (j0 = 0; j0 < dims[b]; j0 += 4)
+				{
+					for (i0 = 0; i0 < dims[a]; i0 += 4)
+					{
+						in_ptr3 = in_ptr2 + j0*in_steps[b] + i0;
+						out_ptr3 = out_ptr2 + i0*out_steps[a] + j0;
+						if (j0 + 4 <= dims[b] && i0 + 4 <= dims[a])
+						{
+							_zq_cnn_transpose_4x4_32f(in_ptr3, in_steps[b], out_ptr3, out_steps[a], use_simd);
+						}
+						else
+						{
+							for (k = 0; k < 4 && j0 + k < dims[b]; k++)
+							{
+								for (o3 = 0; o3 < 4 && i0 + o3 < dims[a]; o3++)
+									out_ptr3[o3*out_steps[a] + k] = in_ptr3[k*in_steps[b] + o3];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void zq_cnn_permute_32f_align0(
+		const float* in_data,
+		int N,
+		int C,
+		int H,
+		int W,
+		int in_N_step,
+		int in_C_step,
+		int in_H_step,
+		int in_W_step,
+		float* out_data,
+		int out_N_step,
+		int out_C_step,
+		int out_H_step,
+		int out_W_step
+	)
+	{
+		int dims[4] = { N, C, H, W };
+		int in_steps[4] = { in_N_step, in_C_step, in_H_step, in_W_step };
+		int out_steps[4] = { out_N_step, out_C_step, out_H_step, out_W_step };
+		_zq_cnn_permute_32f(in_data, dims, in_steps, out_data, out_steps, 0);
+	}
+
+#if __ARM_NEON || ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	void zq_cnn_permute_32f_align128bit(
+		const float* in_data,
+		int N,
+		int C,
+		int H,
+		int W,
+		int in_N_step,
+		int in_C_step,
+		int in_H_step,
+		int in_W_step,
+		float* out_data,
+		int out_N_step,
+		int out_C_step,
+		int out_H_step,
+		int out_W_step
+	)
+	{
+		int dims[4] = { N, C, H, W };
+		int in_steps[4] = { in_N_step, in_C_step, in_H_step, in_W_step };
+		int out_steps[4] = { out_N_step, out_C_step, out_H_step, out_W_step };
+		_zq_cnn_permute_32f(in_data, dims, in_steps, out_data, out_steps, 1);
+	}
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
@@ -0,0 +1,50 @@
+#ifndef _ZQ_CNN_PERMUTE_32F_ALIGN_C_H_
+#define _ZQ_CNN_PERMUTE_32F_ALIGN_C_H_
+#include "../ZQ_CNN_CompileConfig.h"
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*out[n*out_N_step+c*out_C_step+h*out_H_step+w*out_W_step] = in[n*in_N_step+c*in_C_step+h*in_H_step+w*in_W_step],
+	N,C,H,W are the dims of the output. It is a memcpy of each run if one dim has step 1 in both, else the dim with
+	in step 1 and the dim with out step 1 are copied in 4x4 blocks (transposed with SIMD for align128bit)*/
+	void zq_cnn_permute_32f_align0(
+		const float* in_data,
+		int N,
+		int C,
+		int H,
+		int W,
+		int in_N_step,
+		int in_C_step,
+		int in_H_step,
+		int in_W_step,
+		float* out_data,
+		int out_N_step,
+		int out_C_step,
+		int out_H_step,
+		int out_W_step
+	);
+
+#if __ARM_NEON || ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	void zq_cnn_permute_32f_align128bit(
+		const float* in_data,
+		int N,
+		int C,
+		int H,
+		int W,
+		int in_N_step,
+		int in_C_step,
+		int in_H_step,
+		int in_W_step,
+		float* out_data,
+		int out_N_step,
+		int out_C_step,
+		int out_H_step,
+		int out_W_step
+	);
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+#endif
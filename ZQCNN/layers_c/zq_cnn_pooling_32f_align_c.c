@@ -170,6 +170,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_maxpooling_nopadding_suredivided_kernel2x2 zq_cnn_maxpooling_nopadding_suredivided_32f_align256bit_kernel2x2
 #define zq_cnn_maxpooling_nopadding_suredivided_kernel3x3 zq_cnn_maxpooling_nopadding_suredivided_32f_align256bit_kernel3x3
 #define zq_cnn_maxpooling_nopadding_suredivided_kernel5x5 zq_cnn_maxpooling_nopadding_suredivided_32f_align256bit_kernel5x5
@@ -211,6 +212,7 @@ extern "C" {
 #undef zq_mm_type
 #undef zq_base_type
 #undef zq_mm_align_size
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
@@ -120,6 +120,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_resize_with_safeborder zq_cnn_resize_with_safeborder_32f_align256bit
 #define zq_cnn_resize_without_safeborder zq_cnn_resize_without_safeborder_32f_align256bit
 #define zq_mm_load_ps _mm256_load_ps
@@ -145,6 +146,7 @@ extern "C" {
 #undef zq_mm_type
 #undef zq_base_type
 #undef zq_mm_align_size
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif//__ARM_NEON
 
@@ -77,6 +77,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_softmax_32f_align_C zq_cnn_softmax_32f_align256bit_C
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
@@ -110,6 +111,7 @@ extern "C" {
 #undef zq_mm_bitor_longlong
 #undef zq_final_max_q
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #endif //__ARM_NEON
@@ -112,6 +112,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_cnn_batchnormscale_mean_var_scale_bias_nchwc zq_cnn_batchnormscale_mean_var_scale_bias_nchwc8
 #define zq_cnn_batchnorm_mean_var_nchwc zq_cnn_batchnorm_32f_mean_var_nchwc8
@@ -145,6 +146,7 @@ extern "C" {
 #undef zq_mm_type
 #undef zq_base_type
 #undef zq_mm_align_size
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 	
@@ -402,6 +402,7 @@ extern "C" {
 
 #endif
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_loadu_ps _mm256_loadu_ps
@@ -524,6 +525,7 @@ extern "C" {
 #undef zq_mm_align_size8
 #undef zq_mm_bitor_longlong
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
@@ -242,6 +242,7 @@ extern "C" {
 #endif//ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
@@ -342,6 +343,7 @@ extern "C" {
 #undef zq_mm_align_size4
 #undef zq_mm_align_size5
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif //ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
 
 #endif //__ARM_NEON
@@ -152,6 +152,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_eltwise_sum_nchwc zq_cnn_eltwise_sum_nchwc8
 #define zq_cnn_eltwise_sum_with_weight_nchwc zq_cnn_eltwise_sum_with_weight_nchwc8
 #define zq_cnn_eltwise_mul_nchwc zq_cnn_eltwise_mul_nchwc8
@@ -209,6 +210,7 @@ extern "C" {
 #undef zq_mm_align_size32
 #undef zq_mm_align_size64
 
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
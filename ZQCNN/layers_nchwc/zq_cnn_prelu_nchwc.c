@@ -154,6 +154,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
 #define zq_mm_set1_ps _mm256_set1_ps
@@ -211,6 +212,7 @@ extern "C" {
 #undef zq_mm_align_size2
 #undef zq_mm_align_size3
 #undef zq_mm_align_size4
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif //__ARM_NEON
 
@@ -92,6 +92,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_resize_with_safeborder zq_cnn_resize_with_safeborder_nchwc8
 #define zq_cnn_resize_without_safeborder zq_cnn_resize_without_safeborder_nchwc8
 #define zq_mm_load_ps _mm256_load_ps
@@ -117,6 +118,7 @@ extern "C" {
 #undef zq_mm_type
 #undef zq_base_type
 #undef zq_mm_align_size
+ZQ_CNN_TARGET_AVX2_END
 #endif
 #endif//__ARM_NEON
 
@@ -108,6 +108,7 @@ extern "C" {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #define zq_cnn_softmax_nchwc_C zq_cnn_softmax_nchwc8_C
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
@@ -141,6 +142,7 @@ extern "C" {
 #undef zq_mm_bitor_longlong
 #undef zq_final_max_q
 #undef zq_final_sum_q
+ZQ_CNN_TARGET_AVX2_END
 #endif
 
 #endif //__ARM_NEON
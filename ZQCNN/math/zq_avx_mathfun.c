@@ -30,6 +30,7 @@ misrepresented as being the original software.
 */
 #include "../ZQ_CNN_CompileConfig.h"
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 #include <immintrin.h>
 #if defined(__cplusplus) || defined(c_plusplus) 
 extern "C" {
@@ -724,4 +725,5 @@ v8sf log256_ps(v8sf x) {
 }
 #endif
 
+ZQ_CNN_TARGET_AVX2_END
 #endif
\ No newline at end of file
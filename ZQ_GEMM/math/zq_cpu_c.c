@@ -0,0 +1,96 @@
+#include "ZQ_CNN_CompileConfig.h"
+#if !__ARM_NEON
+#if defined(_WIN32)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif // __ARM_NEON
+#include "zq_cpu_c.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*-1 if not checked yet, the check gives the same value in every thread, so it needs no lock*/
+	static int zq_cpu_detected_sse_type = -1;
+	static int zq_cpu_sse_type_limit = ZQ_CNN_SSETYPE_AVX512;
+
+#if !__ARM_NEON
+	static int _zq_cpuid(unsigned int leaf, unsigned int regs[4])
+	{
+#if defined(_WIN32)
+		int tmp[4], i;
+		__cpuidex(tmp, leaf, 0);
+		for (i = 0; i < 4; i++)
+			regs[i] = tmp[i];
+		return 1;
+#else
+		return __get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]) != 0;
+#endif
+	}
+
+	static unsigned long long _zq_xgetbv0()
+	{
+#if defined(_WIN32)
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+#endif // __ARM_NEON
+
+	static int _zq_cpu_detect_sse_type()
+	{
+#if __ARM_NEON
+		return ZQ_CNN_SSETYPE_NONE;
+#else
+		unsigned int regs1[4] = { 0 }, regs7[4] = { 0 };
+		int max_leaf, has_sse41, has_fma, has_avx, has_osxsave, has_avx2, has_avx512f, os_saves_ymm, os_saves_zmm;
+		unsigned long long xcr0;
+		if (!_zq_cpuid(0, regs1) || regs1[0] < 1)
+			return ZQ_CNN_SSETYPE_NONE;
+		max_leaf = regs1[0];
+		_zq_cpuid(1, regs1);
+		if (max_leaf >= 7)
+			_zq_cpuid(7, regs7);
+		has_sse41 = (regs1[2] & (1 << 19)) != 0;
+		has_fma = (regs1[2] & (1 << 12)) != 0;
+		has_avx = (regs1[2] & (1 << 28)) != 0;
+		has_osxsave = (regs1[2] & (1 << 27)) != 0;
+		has_avx2 = (regs7[1] & (1 << 5)) != 0;
+		has_avx512f = (regs7[1] & (1 << 16)) != 0;
+		xcr0 = has_osxsave ? _zq_xgetbv0() : 0;
+		os_saves_ymm = (xcr0 & 0x6) == 0x6;
+		os_saves_zmm = (xcr0 & 0xE6) == 0xE6;
+		if (has_avx && os_saves_ymm)
+		{
+			if (has_avx512f && has_avx2 && has_fma && os_saves_zmm)
+				return ZQ_CNN_SSETYPE_AVX512;
+			if (has_avx2 && has_fma)
+				return ZQ_CNN_SSETYPE_AVX2;
+			return ZQ_CNN_SSETYPE_AVX;
+		}
+		if (has_sse41)
+			return ZQ_CNN_SSETYPE_SSE;
+		return ZQ_CNN_SSETYPE_NONE;
+#endif
+	}
+
+	int zq_cpu_sse_type()
+	{
+		if (zq_cpu_detected_sse_type < 0)
+			zq_cpu_detected_sse_type = _zq_cpu_detect_sse_type();
+		return __min(zq_cpu_detected_sse_type, zq_cpu_sse_type_limit);
+	}
+
+	void zq_cpu_limit_sse_type(int sse_type)
+	{
+		zq_cpu_sse_type_limit = sse_type;
+	}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
@@ -0,0 +1,21 @@
+#ifndef _ZQ_CPU_C_H_
+#define _ZQ_CPU_C_H_
+#include "ZQ_CNN_CompileConfig.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*the best ZQ_CNN_SSETYPE_xxx the running cpu supports, checked once with cpuid,
+	AVX and AVX512 also need the os to save the ymm and zmm registers*/
+	int zq_cpu_sse_type();
+
+	/*zq_cpu_sse_type() returns at most sse_type after this call, such as ZQ_CNN_SSETYPE_SSE to run the SSE kernels
+	of a ZQ_CNN_DISPATCH_SSETYPE build on an AVX2 cpu. Call it before any tensor is created*/
+	void zq_cpu_limit_sse_type(int sse_type);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
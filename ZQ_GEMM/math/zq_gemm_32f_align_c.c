@@ -1475,6 +1475,7 @@ union union_type_s_mm128 {
 #endif
 
 #if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+ZQ_CNN_TARGET_AVX2_BEGIN
 
 #define zq_mm_load_ps _mm256_load_ps
 #define zq_mm_store_ps _mm256_store_ps
@@ -1963,8 +1964,574 @@ union union_type_s_mm256 {
 #undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign16
 #undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign32
 #undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_Kgeneral
 
 
+ZQ_CNN_TARGET_AVX2_END
+#endif
+
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+ZQ_CNN_TARGET_AVX512_BEGIN
+
+/* the rows are only 32-byte aligned, so the 512-bit loads are unaligned ones */
+#define zq_mm_load_ps _mm512_loadu_ps
+#define zq_mm_store_ps _mm512_storeu_ps
+#define zq_mm_set1_ps _mm512_set1_ps
+#define zq_mm_setzero_ps _mm512_setzero_ps
+#define zq_mm_mul_ps _mm512_mul_ps
+#define zq_mm_type __m512
+#define zq_base_type float
+#define zq_mm_align_size 16
+#define zq_mm_align_size2 32
+#define zq_mm_align_size3 48
+#define zq_mm_align_size4 64
+#define zq_mm_align_size5 80
+#define zq_mm_align_size6 96
+#define zq_mm_align_size7 112
+#define zq_mm_align_size8 128
+#define CUR_IS_AVX 0
+union union_type_s_mm512 {
+	float s[16];
+	__m512 v;
+};
+#define zq_q_type \
+	union union_type_s_mm512
+
+#define zq_store_to_q(x,y)\
+	q.v = (y)
+
+#define zq_final_sum_q0_4 _mm512_reduce_add_ps(q.v)
+#define zq_final_sum_q0_2 _mm512_reduce_add_ps(q.v)
+#define zq_final_sum_q _mm512_reduce_add_ps(q.v)
+#if ZQ_CNN_USE_FMADD512
+#define zq_mm_fmadd_ps _mm512_fmadd_ps
+#else
+#define zq_mm_fmadd_ps(A, B, C) _mm512_add_ps(_mm512_mul_ps(A, B), C)
+#endif
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N1
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N2
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N4
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N8
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N1_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N2_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N4_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_N8_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N8_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv1024
+
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N1
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N2
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N4
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N8
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N1_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N2_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N4_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_N8_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N8_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv1024
+
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N1
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N1_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_N4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv1024
+
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_N1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N1
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_N2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N2
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_N1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N1_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_N2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N2_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv1024
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv1024
+
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_N1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_N1
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_N1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_N1_Kgeneral 
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_Kgeneral zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kgeneral
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign1 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq16
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign2 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq32
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign3 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq48
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign5 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq80
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign6 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq96
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign7 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Keq112
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign4 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kdiv64
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign8 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kdiv128
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign16 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kdiv256
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign32 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kdiv512
+#define zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign64 zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_caseNdiv1_Kdiv1024
+
+
+#include "zq_gemm_32f_align_c_raw.h"
+
+#undef zq_mm_load_ps
+#undef zq_mm_store_ps
+#undef zq_mm_set1_ps
+#undef zq_mm_setzero_ps
+#undef zq_mm_mul_ps
+#undef zq_mm_type
+#undef zq_base_type
+#undef zq_mm_align_size
+#undef zq_mm_align_size2
+#undef zq_mm_align_size3
+#undef zq_mm_align_size4
+#undef zq_mm_align_size5
+#undef zq_mm_align_size6
+#undef zq_mm_align_size7
+#undef zq_mm_align_size8
+#undef CUR_IS_AVX
+#undef zq_q_type
+#undef zq_store_to_q
+#undef zq_final_sum_q0_4
+#undef zq_final_sum_q0_2
+#undef zq_final_sum_q
+#undef zq_mm_fmadd_ps
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_N8_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv2_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv4_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M1_caseNdiv8_KdivAlign64
+
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_N8_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv2_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv4_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M2_caseNdiv8_KdivAlign64
+
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_N4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv2_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M4_caseNdiv4_KdivAlign64
+
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_N1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_N2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_N1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_N2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_KdivAlign64
+
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_N1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_N1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign1
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign2
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign3
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign5
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign6
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KeqAlign7
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign4
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign8
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign16
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign32
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_KdivAlign64
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv1_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M8_caseNdiv2_Kgeneral
+#undef zq_gemm_32f_align_AnoTrans_Btrans_M16_caseNdiv1_Kgeneral
+
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(int M, int N, int K, int K_begin, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		const float* Aptr1, *Aptr2, *Aptr3, *Aptr4, *Bptr;
+		float* Cptr1, *Cptr2, *Cptr3, *Cptr4;
+		__mmask16 last_mask = (__mmask16)((1 << ((K - K_begin) % 16)) - 1), mask;
+		__m512 a_vec1, a_vec2, a_vec3, a_vec4, b_vec;
+		__m512 sum_vec1, sum_vec2, sum_vec3, sum_vec4;
+		int m, n, k;
+		if (K <= K_begin)
+			return;
+		if (last_mask == 0)
+			last_mask = 0xFFFF;
+		for (m = 0; m < M - 3; m += 4)
+		{
+			Aptr1 = A + m*lda;
+			Aptr2 = Aptr1 + lda;
+			Aptr3 = Aptr2 + lda;
+			Aptr4 = Aptr3 + lda;
+			Cptr1 = C + m*ldc;
+			Cptr2 = Cptr1 + ldc;
+			Cptr3 = Cptr2 + ldc;
+			Cptr4 = Cptr3 + ldc;
+			for (n = 0, Bptr = Bt; n < N; n++, Bptr += ldb)
+			{
+				sum_vec1 = _mm512_setzero_ps();
+				sum_vec2 = _mm512_setzero_ps();
+				sum_vec3 = _mm512_setzero_ps();
+				sum_vec4 = _mm512_setzero_ps();
+				for (k = K_begin; k < K; k += 16)
+				{
+					mask = k + 16 <= K ? 0xFFFF : last_mask;
+					b_vec = _mm512_maskz_loadu_ps(mask, Bptr + k);
+					a_vec1 = _mm512_maskz_loadu_ps(mask, Aptr1 + k);
+					a_vec2 = _mm512_maskz_loadu_ps(mask, Aptr2 + k);
+					a_vec3 = _mm512_maskz_loadu_ps(mask, Aptr3 + k);
+					a_vec4 = _mm512_maskz_loadu_ps(mask, Aptr4 + k);
+					sum_vec1 = _mm512_fmadd_ps(a_vec1, b_vec, sum_vec1);
+					sum_vec2 = _mm512_fmadd_ps(a_vec2, b_vec, sum_vec2);
+					sum_vec3 = _mm512_fmadd_ps(a_vec3, b_vec, sum_vec3);
+					sum_vec4 = _mm512_fmadd_ps(a_vec4, b_vec, sum_vec4);
+				}
+				Cptr1[n] += _mm512_reduce_add_ps(sum_vec1);
+				Cptr2[n] += _mm512_reduce_add_ps(sum_vec2);
+				Cptr3[n] += _mm512_reduce_add_ps(sum_vec3);
+				Cptr4[n] += _mm512_reduce_add_ps(sum_vec4);
+			}
+		}
+		for (; m < M; m++)
+		{
+			Aptr1 = A + m*lda;
+			Cptr1 = C + m*ldc;
+			for (n = 0, Bptr = Bt; n < N; n++, Bptr += ldb)
+			{
+				sum_vec1 = _mm512_setzero_ps();
+				for (k = K_begin; k < K; k += 16)
+				{
+					mask = k + 16 <= K ? 0xFFFF : last_mask;
+					b_vec = _mm512_maskz_loadu_ps(mask, Bptr + k);
+					a_vec1 = _mm512_maskz_loadu_ps(mask, Aptr1 + k);
+					sum_vec1 = _mm512_fmadd_ps(a_vec1, b_vec, sum_vec1);
+				}
+				Cptr1[n] += _mm512_reduce_add_ps(sum_vec1);
+			}
+		}
+	}
+
+ZQ_CNN_TARGET_AVX512_END
 #endif
 
 #endif//__ARM_NEON
@@ -8,6 +8,18 @@ extern "C" {
 
 	void zq_gemm_32f_AnoTrans_Btrans_auto(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
 
+	/*kernels zq_gemm_32f_AnoTrans_Btrans_auto can be tuned to, kernel 0 is its hand-written table.
+	The tuned table is shared by the process, it can be set while other threads run gemm*/
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_count();
+	const char* zq_gemm_32f_AnoTrans_Btrans_kernel_name(int kernel_id);
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_id(const char* name);	// -1 if not found
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_usable(int kernel_id, int K, const float* A, int lda, const float* Bt, int ldb);
+	int zq_gemm_32f_AnoTrans_Btrans_by_kernel(int kernel_id, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	int zq_gemm_32f_AnoTrans_Btrans_set_tuned(int M, int N, int K, int kernel_id);
+	void zq_gemm_32f_AnoTrans_Btrans_clear_tuned();
+	/*recorder is called with every shape zq_gemm_32f_AnoTrans_Btrans_auto gets, 0 to stop*/
+	void zq_gemm_32f_AnoTrans_Btrans_set_recorder(void(*recorder)(int M, int N, int K, void* arg), void* arg);
+
 	void zq_gemm_32f_align0_AnoTrans_Btrans(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
 
 #if __ARM_NEON
@@ -820,6 +832,205 @@ extern "C" {
 	
 #endif
 
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+	/*C = A*B ,
+	A: M * K,
+	Bt: N * K,
+	K % 16 == 0
+	*/
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N1(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N2(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N4(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N8(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N1_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N2_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N4_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_N8_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv1_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv2_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv4_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M1_caseNdiv8_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N1(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N2(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N4(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N8(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N1_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N2_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N4_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_N8_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv1_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv2_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv4_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M2_caseNdiv8_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N1(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N1_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv1_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv2_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_caseNdiv4_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N1(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N2(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N1_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N2_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv2_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_N1(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M16_N1_Kgeneral(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq16(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq32(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq48(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq80(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq96(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Keq112(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv64(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv128(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv256(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv512(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_caseNdiv1_Kdiv1024(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+	
+	/*C += A(:, K_begin:K)*Bt(:, K_begin:K)', the columns left by the kernels above,
+	K - K_begin need not be a multiple of 16, the last 16 columns are read with masked loads
+	*/
+	void zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(int M, int N, int K, int K_begin, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+#endif
+
 #endif
 
 #if defined(__cplusplus) || defined(c_plusplus) 
@@ -1,9 +1,285 @@
 #include "zq_gemm_32f_align_c.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #if defined(__cplusplus) || defined(c_plusplus) 
 extern "C" {
 #endif
 
+	/******************** tuned kernels ********************/
+
+	typedef void(*zq_gemm_32f_AnoTrans_Btrans_func)(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+
+	typedef struct
+	{
+		const char* name;
+		zq_gemm_32f_AnoTrans_Btrans_func func;
+		int K_align;		// K, lda and ldb must be multiples of it
+		int K_min;
+		int ptr_align;		// A and Bt must be aligned to it (bytes)
+		int sse_type;		// the cpu must support it in a ZQ_CNN_DISPATCH_SSETYPE build
+	} zq_gemm_32f_candidate;
+
+#if !__ARM_NEON && ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+	static void _zq_gemm_32f_align512bit_M4_N4_masked(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		int mainK = K >> 6 << 6;
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4(M, N, mainK, A, lda, Bt, ldb, C, ldc);
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(M, N, K, mainK, A, lda, Bt, ldb, C, ldc);
+	}
+
+	static void _zq_gemm_32f_align512bit_M4_N2_masked(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		int mainK = K >> 6 << 6;
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2(M, N, mainK, A, lda, Bt, ldb, C, ldc);
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(M, N, K, mainK, A, lda, Bt, ldb, C, ldc);
+	}
+
+	static void _zq_gemm_32f_align512bit_M8_N2_masked(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		int mainK = K >> 6 << 6;
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_M8_N2(M, N, mainK, A, lda, Bt, ldb, C, ldc);
+		zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(M, N, K, mainK, A, lda, Bt, ldb, C, ldc);
+	}
+#endif
+
+	/*the first one is the hand-written table in zq_gemm_32f_AnoTrans_Btrans_auto*/
+	static const zq_gemm_32f_candidate zq_gemm_32f_candidates[] =
+	{
+		{ "auto", 0, 1, 1, 1, 0 },
+#if __ARM_NEON
+#if !__ARM_NEON_FP16
+		{ "align128bit_M1_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M1_N4, 4, 4, 4, 0 },
+		{ "align128bit_M2_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M2_N4, 4, 4, 4, 0 },
+		{ "align128bit_M4_N2", zq_gemm_32f_align128bit_AnoTrans_Btrans_M4_N2, 4, 4, 4, 0 },
+		{ "align128bit_M4_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M4_N4, 4, 4, 4, 0 },
+		{ "align128bit_M8_N1", zq_gemm_32f_align128bit_AnoTrans_Btrans_M8_N1, 4, 4, 4, 0 },
+#endif
+#else
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+		{ "align128bit_M1_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M1_N4, 4, 4, 16, 0 },
+		{ "align128bit_M2_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M2_N4, 4, 4, 16, 0 },
+		{ "align128bit_M4_N2", zq_gemm_32f_align128bit_AnoTrans_Btrans_M4_N2, 4, 4, 16, 0 },
+		{ "align128bit_M4_N4", zq_gemm_32f_align128bit_AnoTrans_Btrans_M4_N4, 4, 4, 16, 0 },
+		{ "align128bit_M8_N1", zq_gemm_32f_align128bit_AnoTrans_Btrans_M8_N1, 4, 4, 16, 0 },
+#endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+		{ "align256bit_M2_N4", zq_gemm_32f_align256bit_AnoTrans_Btrans_M2_N4, 8, 8, 32, ZQ_CNN_SSETYPE_AVX2 },
+		{ "align256bit_M4_N2", zq_gemm_32f_align256bit_AnoTrans_Btrans_M4_N2, 8, 8, 32, ZQ_CNN_SSETYPE_AVX2 },
+		{ "align256bit_M4_N4", zq_gemm_32f_align256bit_AnoTrans_Btrans_M4_N4, 8, 8, 32, ZQ_CNN_SSETYPE_AVX2 },
+		{ "align256bit_M8_N1", zq_gemm_32f_align256bit_AnoTrans_Btrans_M8_N1, 8, 8, 32, ZQ_CNN_SSETYPE_AVX2 },
+#endif
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+		{ "align512bit_M4_N4", _zq_gemm_32f_align512bit_M4_N4_masked, 1, 64, 4, ZQ_CNN_SSETYPE_AVX512 },
+		{ "align512bit_M4_N2", _zq_gemm_32f_align512bit_M4_N2_masked, 1, 64, 4, ZQ_CNN_SSETYPE_AVX512 },
+		{ "align512bit_M8_N2", _zq_gemm_32f_align512bit_M8_N2_masked, 1, 64, 4, ZQ_CNN_SSETYPE_AVX512 },
+#endif
+#endif
+	};
+
+#if defined(_MSC_VER)
+#define ZQ_GEMM_LOAD_PTR(p) _InterlockedCompareExchangePointer((void* volatile*)(p), 0, 0)
+#define ZQ_GEMM_CAS_PTR(p, old_v, new_v) (_InterlockedCompareExchangePointer((void* volatile*)(p), (void*)(new_v), (void*)(old_v)) == (void*)(old_v))
+#define ZQ_GEMM_STORE_PTR(p, v) _InterlockedExchangePointer((void* volatile*)(p), (void*)(v))
+#else
+#define ZQ_GEMM_LOAD_PTR(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ZQ_GEMM_CAS_PTR(p, old_v, new_v) __atomic_compare_exchange_n((p), &(old_v), (new_v), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define ZQ_GEMM_STORE_PTR(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+	typedef struct
+	{
+		int M, N, K;
+		int kernel_id;	// 0 for the hand-written table
+	} zq_gemm_32f_tuned_entry;
+
+	/*a published table is never changed: set_tuned and clear_tuned make a new one and swap the pointer,
+	so a gemm running at the same time reads either the old or the new table. The old tables are kept
+	(in the retired list) because a gemm may still be reading them, they have one entry per tuned shape*/
+	typedef struct zq_gemm_32f_tuned_table_s
+	{
+		int count;
+		zq_gemm_32f_tuned_entry* entries;	// sorted by M, N, K
+		struct zq_gemm_32f_tuned_table_s* retired_next;
+	} zq_gemm_32f_tuned_table;
+
+	typedef void(*zq_gemm_32f_recorder_func)(int M, int N, int K, void* arg);
+
+	static zq_gemm_32f_tuned_table* zq_gemm_32f_tuned = 0;
+	static zq_gemm_32f_tuned_table* zq_gemm_32f_tuned_retired = 0;
+	static zq_gemm_32f_recorder_func zq_gemm_32f_shape_recorder = 0;
+	static void* zq_gemm_32f_shape_recorder_arg = 0;
+
+	static void _zq_gemm_32f_AnoTrans_Btrans_auto(int use_tuned, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc);
+
+	static int _zq_gemm_32f_tuned_compare(const zq_gemm_32f_tuned_entry* e, int M, int N, int K)
+	{
+		if (e->M != M) return e->M < M ? -1 : 1;
+		if (e->N != N) return e->N < N ? -1 : 1;
+		if (e->K != K) return e->K < K ? -1 : 1;
+		return 0;
+	}
+
+	/*the index of the entry of M, N, K, or where it should be inserted (found = 0)*/
+	static int _zq_gemm_32f_tuned_find(const zq_gemm_32f_tuned_table* table, int M, int N, int K, int* found)
+	{
+		int lo = 0, hi = table ? table->count : 0;
+		*found = 0;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) >> 1;
+			int cmp = _zq_gemm_32f_tuned_compare(table->entries + mid, M, N, K);
+			if (cmp == 0)
+			{
+				*found = 1;
+				return mid;
+			}
+			if (cmp < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	static void _zq_gemm_32f_tuned_retire(zq_gemm_32f_tuned_table* table)
+	{
+		zq_gemm_32f_tuned_table* head;
+		if (!table)
+			return;
+		do
+		{
+			head = (zq_gemm_32f_tuned_table*)ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_tuned_retired);
+			table->retired_next = head;
+		} while (!ZQ_GEMM_CAS_PTR(&zq_gemm_32f_tuned_retired, head, table));
+	}
+
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_count()
+	{
+		return sizeof(zq_gemm_32f_candidates) / sizeof(zq_gemm_32f_candidates[0]);
+	}
+
+	const char* zq_gemm_32f_AnoTrans_Btrans_kernel_name(int kernel_id)
+	{
+		if (kernel_id < 0 || kernel_id >= zq_gemm_32f_AnoTrans_Btrans_kernel_count())
+			return 0;
+		return zq_gemm_32f_candidates[kernel_id].name;
+	}
+
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_id(const char* name)
+	{
+		int i;
+		for (i = 0; i < zq_gemm_32f_AnoTrans_Btrans_kernel_count(); i++)
+		{
+			if (strcmp(zq_gemm_32f_candidates[i].name, name) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	int zq_gemm_32f_AnoTrans_Btrans_kernel_usable(int kernel_id, int K, const float* A, int lda, const float* Bt, int ldb)
+	{
+		const zq_gemm_32f_candidate* c;
+		if (kernel_id < 0 || kernel_id >= zq_gemm_32f_AnoTrans_Btrans_kernel_count())
+			return 0;
+		c = zq_gemm_32f_candidates + kernel_id;
+		return K >= c->K_min && K % c->K_align == 0 && lda % c->K_align == 0 && ldb % c->K_align == 0
+			&& ((size_t)A) % c->ptr_align == 0 && ((size_t)Bt) % c->ptr_align == 0
+			&& (c->sse_type < ZQ_CNN_SSETYPE_AVX2 || ZQ_CNN_CAN_RUN_256BIT) && (c->sse_type < ZQ_CNN_SSETYPE_AVX512 || ZQ_CNN_CAN_RUN_512BIT);
+	}
+
+	int zq_gemm_32f_AnoTrans_Btrans_by_kernel(int kernel_id, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		if (!zq_gemm_32f_AnoTrans_Btrans_kernel_usable(kernel_id, K, A, lda, Bt, ldb))
+			return 0;
+		if (kernel_id == 0)
+			_zq_gemm_32f_AnoTrans_Btrans_auto(0, M, N, K, A, lda, Bt, ldb, C, ldc);	//skip the tuned table and the recorder
+		else
+			zq_gemm_32f_candidates[kernel_id].func(M, N, K, A, lda, Bt, ldb, C, ldc);
+		return 1;
+	}
+
+	int zq_gemm_32f_AnoTrans_Btrans_set_tuned(int M, int N, int K, int kernel_id)
+	{
+		zq_gemm_32f_tuned_table* old_table;
+		zq_gemm_32f_tuned_table* new_table;
+		int idx, found;
+		if (kernel_id < 0 || kernel_id >= zq_gemm_32f_AnoTrans_Btrans_kernel_count())
+			return 0;
+		do
+		{
+			old_table = (zq_gemm_32f_tuned_table*)ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_tuned);
+			idx = _zq_gemm_32f_tuned_find(old_table, M, N, K, &found);
+			new_table = (zq_gemm_32f_tuned_table*)malloc(sizeof(zq_gemm_32f_tuned_table));
+			if (!new_table)
+				return 0;
+			new_table->count = (old_table ? old_table->count : 0) + (found ? 0 : 1);
+			new_table->retired_next = 0;
+			new_table->entries = (zq_gemm_32f_tuned_entry*)malloc(sizeof(zq_gemm_32f_tuned_entry)*new_table->count);
+			if (!new_table->entries)
+			{
+				free(new_table);
+				return 0;
+			}
+			if (idx > 0)
+				memcpy(new_table->entries, old_table->entries, sizeof(zq_gemm_32f_tuned_entry)*idx);
+			if (old_table && old_table->count > idx + found)
+				memcpy(new_table->entries + idx + 1, old_table->entries + idx + found, sizeof(zq_gemm_32f_tuned_entry)*(old_table->count - idx - found));
+			new_table->entries[idx].M = M;
+			new_table->entries[idx].N = N;
+			new_table->entries[idx].K = K;
+			new_table->entries[idx].kernel_id = kernel_id;
+			if (ZQ_GEMM_CAS_PTR(&zq_gemm_32f_tuned, old_table, new_table))
+				break;
+			/*another thread published a table in between, redo it on that one*/
+			free(new_table->entries);
+			free(new_table);
+		} while (1);
+		_zq_gemm_32f_tuned_retire(old_table);
+		return 1;
+	}
+
+	void zq_gemm_32f_AnoTrans_Btrans_clear_tuned()
+	{
+		zq_gemm_32f_tuned_table* old_table;
+		do
+		{
+			old_table = (zq_gemm_32f_tuned_table*)ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_tuned);
+		} while (old_table && !ZQ_GEMM_CAS_PTR(&zq_gemm_32f_tuned, old_table, (zq_gemm_32f_tuned_table*)0));
+		_zq_gemm_32f_tuned_retire(old_table);
+	}
+
+	void zq_gemm_32f_AnoTrans_Btrans_set_recorder(void(*recorder)(int M, int N, int K, void* arg), void* arg)
+	{
+		/*the arg is set first, so a gemm seeing the new recorder also sees its arg*/
+		ZQ_GEMM_STORE_PTR(&zq_gemm_32f_shape_recorder_arg, arg);
+		ZQ_GEMM_STORE_PTR(&zq_gemm_32f_shape_recorder, recorder);
+	}
+
+	static int _zq_gemm_32f_AnoTrans_Btrans_tuned(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		const zq_gemm_32f_tuned_table* table;
+		zq_gemm_32f_recorder_func recorder;
+		int idx, found, kernel_id;
+		recorder = (zq_gemm_32f_recorder_func)ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_shape_recorder);
+		if (recorder)
+			recorder(M, N, K, ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_shape_recorder_arg));
+		table = (const zq_gemm_32f_tuned_table*)ZQ_GEMM_LOAD_PTR(&zq_gemm_32f_tuned);
+		if (!table)
+			return 0;
+		idx = _zq_gemm_32f_tuned_find(table, M, N, K, &found);
+		if (!found)
+			return 0;
+		kernel_id = table->entries[idx].kernel_id;
+		if (kernel_id == 0 || !zq_gemm_32f_AnoTrans_Btrans_kernel_usable(kernel_id, K, A, lda, Bt, ldb))
+			return 0;
+		zq_gemm_32f_candidates[kernel_id].func(M, N, K, A, lda, Bt, ldb, C, ldc);
+		return 1;
+	}
+
+	/*******************************************************/
+
 #if __ARM_NEON 
 #define SWAP_A_Bt \
 	if (M*N < 0.1*(M*N*K) && M + 8 < N) \
@@ -158,7 +434,7 @@ extern "C" {
 
 	
 #if __ARM_NEON_ARMV8
-	void zq_gemm_32f_AnoTrans_Btrans_auto(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	static void _zq_gemm_32f_AnoTrans_Btrans_auto(int use_tuned, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
 	{
 		const float* oldA = A, *oldB = Bt;
 		float* old_C = C;
@@ -166,6 +442,8 @@ extern "C" {
 		int m, n;
 		int swap = 0;
 		int handled = 0;
+		if (use_tuned && _zq_gemm_32f_AnoTrans_Btrans_tuned(M, N, K, A, lda, Bt, ldb, C, ldc))
+			return;
 		if (K == 8)
 		{
 			SWAP_A_Bt;
@@ -256,7 +534,7 @@ extern "C" {
 
 #else // not ARMV8
 	
-	void zq_gemm_32f_AnoTrans_Btrans_auto(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	static void _zq_gemm_32f_AnoTrans_Btrans_auto(int use_tuned, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
 	{
 		const float* oldA = A, *oldB = Bt;
 		float* old_C = C;
@@ -264,6 +542,8 @@ extern "C" {
 		int m, n;
 		int swap = 0;
 		int handled = 0;
+		if (use_tuned && _zq_gemm_32f_AnoTrans_Btrans_tuned(M, N, K, A, lda, Bt, ldb, C, ldc))
+			return;
 		if (K == 16)
 		{
 			if (N >= 8)
@@ -419,30 +699,26 @@ extern "C" {
 	
 #else // not __ARM_NEON
 
-	void zq_gemm_32f_AnoTrans_Btrans_auto(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+	/*the table of the 256bit (and 512bit) kernels, a ZQ_CNN_DISPATCH_SSETYPE build only uses it on the cpus with AVX2+FMA,
+	and its 512bit kernels on the cpus with AVX512*/
+	static void _zq_gemm_32f_AnoTrans_Btrans_table256bit(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
 	{
-		const float* oldA = A, *oldB = Bt;
-		float* old_C = C;
-		int old_lda = lda, old_ldb = ldb, old_ldc = ldc, old_M = M, old_N = N;
-		int m, n;
-		int swap = 0;
-		if (M*N < 0.1*(M*N*K) && M + 8 < N)
+		int handled = 0;
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX512
+		/* the 512bit kernels take the multiple of 64 part of K, the rest is added with masked loads */
+		if (K >= 64 && ZQ_CNN_CAN_RUN_512BIT)
 		{
-			swap = 1;
-			A = oldB;
-			Bt = oldA;
-			lda = old_ldb;
-			ldb = old_lda;
-			M = old_N;
-			N = old_M;
-			ldc = N;
-			C = _aligned_malloc(M*N * sizeof(float), 32);
+			int mainK = K >> 6 << 6;
+			if (N >= 4)
+				zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N4(M, N, mainK, A, lda, Bt, ldb, C, ldc);
+			else
+				zq_gemm_32f_align512bit_AnoTrans_Btrans_M4_N2(M, N, mainK, A, lda, Bt, ldb, C, ldc);
+			zq_gemm_32f_align512bit_AnoTrans_Btrans_Ktail(M, N, K, mainK, A, lda, Bt, ldb, C, ldc);
+			handled = 1;
 		}
-		int handled = 0;
-
-
-#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
-
+		else
+#endif
 		if (K == 16)
 		{
 			if (N >= 8)
@@ -558,8 +834,13 @@ extern "C" {
 				handled = 1;
 			}
 		}
+	}
+#endif
 
-#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+	static void _zq_gemm_32f_AnoTrans_Btrans_table128bit(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		int handled = 0;
 		if (K == 16)
 		{
 			if (N >= 8)
@@ -675,6 +956,38 @@ extern "C" {
 				handled = 1;
 			}
 		}
+	}
+#endif
+
+	static void _zq_gemm_32f_AnoTrans_Btrans_auto(int use_tuned, int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		const float* oldA = A, *oldB = Bt;
+		float* old_C = C;
+		int old_lda = lda, old_ldb = ldb, old_ldc = ldc, old_M = M, old_N = N;
+		int m, n;
+		int swap = 0;
+		if (use_tuned && _zq_gemm_32f_AnoTrans_Btrans_tuned(M, N, K, A, lda, Bt, ldb, C, ldc))
+			return;
+		if (M*N < 0.1*(M*N*K) && M + 8 < N)
+		{
+			swap = 1;
+			A = oldB;
+			Bt = oldA;
+			lda = old_ldb;
+			ldb = old_lda;
+			M = old_N;
+			N = old_M;
+			ldc = N;
+			C = _aligned_malloc(M*N * sizeof(float), 32);
+		}
+
+#if ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_AVX
+		if (ZQ_CNN_CAN_RUN_256BIT)
+			_zq_gemm_32f_AnoTrans_Btrans_table256bit(M, N, K, A, lda, Bt, ldb, C, ldc);
+		else
+			_zq_gemm_32f_AnoTrans_Btrans_table128bit(M, N, K, A, lda, Bt, ldb, C, ldc);
+#elif ZQ_CNN_USE_SSETYPE >= ZQ_CNN_SSETYPE_SSE
+		_zq_gemm_32f_AnoTrans_Btrans_table128bit(M, N, K, A, lda, Bt, ldb, C, ldc);
 #else
 		zq_gemm_32f_align0_AnoTrans_Btrans(M, N, K, A, lda, Bt, ldb, C, ldc);
 #endif
@@ -695,6 +1008,11 @@ extern "C" {
 
 #endif
 
+	void zq_gemm_32f_AnoTrans_Btrans_auto(int M, int N, int K, const float* A, int lda, const float* Bt, int ldb, float* C, int ldc)
+	{
+		_zq_gemm_32f_AnoTrans_Btrans_auto(1, M, N, K, A, lda, Bt, ldb, C, ldc);
+	}
+
 #if defined(__cplusplus) || defined(c_plusplus) 
 	}
 #endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "ZQ_CNN_CompileConfig.h"
+#if __ARM_NEON
+#include <arm_neon.h>
+#else
+#if defined(__GNUC__)
+#if defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE
+#include <x86intrin.h>
+#endif
+#elif defined(_WIN32)
+#if defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE
+#include <immintrin.h>
+#endif
+#endif
+#endif // __ARM_NEON
+#include "zq_gemm_8i_c.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*a ZQ_CNN_DISPATCH_SSETYPE build also builds the plain C kernel for the cpus without AVX2*/
+#if !__ARM_NEON && (defined(__AVX2__) || ZQ_CNN_DISPATCH_SSETYPE)
+#define ZQ_GEMM_8I_USE_AVX2 1
+#else
+#define ZQ_GEMM_8I_USE_AVX2 0
+#endif
+
+#if ZQ_GEMM_8I_USE_AVX2
+ZQ_CNN_TARGET_AVX2_BEGIN
+
+	/*acc += sum of the 4 products of a (unsigned) and b (signed) in each int32*/
+	static __m256i _zq_mm256_dot_8u8s(__m256i acc, __m256i a, __m256i b)
+	{
+#if ZQ_CNN_USE_VNNI
+		return _mm256_dpbusd_epi32(acc, a, b);
+#else
+		return _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), _mm256_set1_epi16(1)));
+#endif
+	}
+
+	static int _zq_mm256_hsum_epi32(__m256i v)
+	{
+		__m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(s);
+	}
+
+	/*four sums of 8 int32 in one __m128i*/
+	static __m128i _zq_mm256_hsum4_epi32(__m256i v0, __m256i v1, __m256i v2, __m256i v3)
+	{
+		__m256i s01 = _mm256_hadd_epi32(v0, v1);
+		__m256i s23 = _mm256_hadd_epi32(v2, v3);
+		__m256i s = _mm256_hadd_epi32(s01, s23);
+		return _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+	}
+
+	static void _zq_gemm_8u8s_AnoTrans_Btrans_avx2(int M, int N, int K, const unsigned char* A, int lda, const signed char* Bt, int ldb, int* C, int ldc)
+	{
+		int m = 0, n, k;
+		const unsigned char* A_ptr0, *A_ptr1;
+		const signed char* B_ptr0, *B_ptr1, *B_ptr2, *B_ptr3;
+		__m256i a0, a1, b, sum00, sum01, sum02, sum03, sum10, sum11, sum12, sum13;
+		for (; m + 2 <= M; m += 2)
+		{
+			n = 0;
+			for (; n + 4 <= N; n += 4)
+			{
+				A_ptr0 = A + m*lda;
+				A_ptr1 = A_ptr0 + lda;
+				B_ptr0 = Bt + n*ldb;
+				B_ptr1 = B_ptr0 + ldb;
+				B_ptr2 = B_ptr1 + ldb;
+				B_ptr3 = B_ptr2 + ldb;
+				sum00 = sum01 = sum02 = sum03 = _mm256_setzero_si256();
+				sum10 = sum11 = sum12 = sum13 = _mm256_setzero_si256();
+				for (k = 0; k < K; k += 32)
+				{
+					a0 = _mm256_loadu_si256((const __m256i*)(A_ptr0 + k));
+					a1 = _mm256_loadu_si256((const __m256i*)(A_ptr1 + k));
+					b = _mm256_loadu_si256((const __m256i*)(B_ptr0 + k));
+					sum00 = _zq_mm256_dot_8u8s(sum00, a0, b);
+					sum10 = _zq_mm256_dot_8u8s(sum10, a1, b);
+					b = _mm256_loadu_si256((const __m256i*)(B_ptr1 + k));
+					sum01 = _zq_mm256_dot_8u8s(sum01, a0, b);
+					sum11 = _zq_mm256_dot_8u8s(sum11, a1, b);
+					b = _mm256_loadu_si256((const __m256i*)(B_ptr2 + k));
+					sum02 = _zq_mm256_dot_8u8s(sum02, a0, b);
+					sum12 = _zq_mm256_dot_8u8s(sum12, a1, b);
+					b = _mm256_loadu_si256((const __m256i*)(B_ptr3 + k));
+					sum03 = _zq_mm256_dot_8u8s(sum03, a0, b);
+					sum13 = _zq_mm256_dot_8u8s(sum13, a1, b);
+				}
+				_mm_storeu_si128((__m128i*)(C + m*ldc + n), _zq_mm256_hsum4_epi32(sum00, sum01, sum02, sum03));
+				_mm_storeu_si128((__m128i*)(C + (m + 1)*ldc + n), _zq_mm256_hsum4_epi32(sum10, sum11, sum12, sum13));
+			}
+			for (; n < N; n++)
+			{
+				A_ptr0 = A + m*lda;
+				A_ptr1 = A_ptr0 + lda;
+				B_ptr0 = Bt + n*ldb;
+				sum00 = sum10 = _mm256_setzero_si256();
+				for (k = 0; k < K; k += 32)
+				{
+					b = _mm256_loadu_si256((const __m256i*)(B_ptr0 + k));
+					sum00 = _zq_mm256_dot_8u8s(sum00, _mm256_loadu_si256((const __m256i*)(A_ptr0 + k)), b);
+					sum10 = _zq_mm256_dot_8u8s(sum10, _mm256_loadu_si256((const __m256i*)(A_ptr1 + k)), b);
+				}
+				C[m*ldc + n] = _zq_mm256_hsum_epi32(sum00);
+				C[(m + 1)*ldc + n] = _zq_mm256_hsum_epi32(sum10);
+			}
+		}
+		for (; m < M; m++)
+		{
+			n = 0;
+			for (; n + 4 <= N; n += 4)
+			{
+				A_ptr0 = A + m*lda;
+				B_ptr0 = Bt + n*ldb;
+				B_ptr1 = B_ptr0 + ldb;
+				B_ptr2 = B_ptr1 + ldb;
+				B_ptr3 = B_ptr2 + ldb;
+				sum00 = sum01 = sum02 = sum03 = _mm256_setzero_si256();
+				for (k = 0; k < K; k += 32)
+				{
+					a0 = _mm256_loadu_si256((const __m256i*)(A_ptr0 + k));
+					sum00 = _zq_mm256_dot_8u8s(sum00, a0, _mm256_loadu_si256((const __m256i*)(B_ptr0 + k)));
+					sum01 = _zq_mm256_dot_8u8s(sum01, a0, _mm256_loadu_si256((const __m256i*)(B_ptr1 + k)));
+					sum02 = _zq_mm256_dot_8u8s(sum02, a0, _mm256_loadu_si256((const __m256i*)(B_ptr2 + k)));
+					sum03 = _zq_mm256_dot_8u8s(sum03, a0, _mm256_loadu_si256((const __m256i*)(B_ptr3 + k)));
+				}
+				_mm_storeu_si128((__m128i*)(C + m*ldc + n), _zq_mm256_hsum4_epi32(sum00, sum01, sum02, sum03));
+			}
+			for (; n < N; n++)
+			{
+				A_ptr0 = A + m*lda;
+				B_ptr0 = Bt + n*ldb;
+				sum00 = _mm256_setzero_si256();
+				for (k = 0; k < K; k += 32)
+				{
+					sum00 = _zq_mm256_dot_8u8s(sum00, _mm256_loadu_si256((const __m256i*)(A_ptr0 + k)),
+						_mm256_loadu_si256((const __m256i*)(B_ptr0 + k)));
+				}
+				C[m*ldc + n] = _zq_mm256_hsum_epi32(sum00);
+			}
+		}
+	}
+
+ZQ_CNN_TARGET_AVX2_END
+#endif
+
+#if !ZQ_GEMM_8I_USE_AVX2 || ZQ_CNN_DISPATCH_SSETYPE
+	static void _zq_gemm_8u8s_AnoTrans_Btrans_c(int M, int N, int K, const unsigned char* A, int lda, const signed char* Bt, int ldb, int* C, int ldc)
+	{
+		int m, n, k, sum;
+		const unsigned char* A_ptr;
+		const signed char* B_ptr;
+		for (m = 0; m < M; m++)
+		{
+			A_ptr = A + m*lda;
+			for (n = 0; n < N; n++)
+			{
+				B_ptr = Bt + n*ldb;
+				sum = 0;
+				for (k = 0; k < K; k++)
+					sum += (int)A_ptr[k] * (int)B_ptr[k];
+				C[m*ldc + n] = sum;
+			}
+		}
+	}
+#endif
+
+	void zq_gemm_8u8s_AnoTrans_Btrans(int M, int N, int K, const unsigned char* A, int lda, const signed char* Bt, int ldb, int* C, int ldc)
+	{
+#if ZQ_GEMM_8I_USE_AVX2
+		if (ZQ_CNN_CAN_RUN_256BIT)
+		{
+			_zq_gemm_8u8s_AnoTrans_Btrans_avx2(M, N, K, A, lda, Bt, ldb, C, ldc);
+			return;
+		}
+#endif
+#if !ZQ_GEMM_8I_USE_AVX2 || ZQ_CNN_DISPATCH_SSETYPE
+		_zq_gemm_8u8s_AnoTrans_Btrans_c(M, N, K, A, lda, Bt, ldb, C, ldc);
+#endif
+	}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
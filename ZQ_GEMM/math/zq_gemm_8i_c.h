@@ -0,0 +1,21 @@
+#ifndef _ZQ_GEMM_8I_H_
+#define _ZQ_GEMM_8I_H_
+#include "ZQ_CNN_CompileConfig.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+	/*C = A*Bt' in int32,
+	A: M * K unsigned char,
+	Bt: N * K signed char,
+	K % 32 == 0.
+	Without VNNI (ZQ_CNN_USE_VNNI) two neighbouring products are added in int16 by _mm256_maddubs_epi16,
+	so the elements of Bt should be in [-63,63] to avoid saturation*/
+	void zq_gemm_8u8s_AnoTrans_Btrans(int M, int N, int K, const unsigned char* A, int lda, const signed char* Bt, int ldb, int* C, int ldc);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
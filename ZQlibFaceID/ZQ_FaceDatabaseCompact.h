@@ -6,7 +6,9 @@
 #include <stdio.h>
 #include <vector>
 #include <omp.h>
+#include <mutex>
 #include "ZQ_FaceRecognizerSphereFace.h"
+#include "ZQ_CNN_ThreadPool.h"
 #include "ZQ_MathBase.h"
 #include "ZQ_MergeSort.h"
 
@@ -252,36 +254,44 @@ namespace ZQ
 					int chunk_size = (total_face_num + real_threads - 1) / real_threads;
 					if (dim == 128)
 					{
-#pragma omp parallel for schedule(static, chunk_size) num_threads(real_threads)
-						for (int i = 0; i < total_face_num; i++)
+						ZQ_CNN_ThreadPool::ParallelFor((total_face_num + chunk_size - 1) / chunk_size, real_threads, [&](int chunk_id, int thread_id)
 						{
-							scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim128(tmp_feat, all_face_feats + i*dim));
-						}
+							for (int i = chunk_id*chunk_size; i < __min(total_face_num, (chunk_id + 1)*chunk_size); i++)
+							{
+								scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim128(tmp_feat, all_face_feats + i*dim));
+							}
+						});
 					}
 					else if (dim == 256)
 					{
-#pragma omp parallel for schedule(static, chunk_size) num_threads(real_threads)
-						for (int i = 0; i < total_face_num; i++)
+						ZQ_CNN_ThreadPool::ParallelFor((total_face_num + chunk_size - 1) / chunk_size, real_threads, [&](int chunk_id, int thread_id)
 						{
-							scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim256(tmp_feat, all_face_feats + i*dim));
-						}
+							for (int i = chunk_id*chunk_size; i < __min(total_face_num, (chunk_id + 1)*chunk_size); i++)
+							{
+								scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim256(tmp_feat, all_face_feats + i*dim));
+							}
+						});
 					}
 					else if (dim == 512)
 					{
-#pragma omp parallel for schedule(static, chunk_size) num_threads(real_threads)
-						for (int i = 0; i < total_face_num; i++)
+						ZQ_CNN_ThreadPool::ParallelFor((total_face_num + chunk_size - 1) / chunk_size, real_threads, [&](int chunk_id, int thread_id)
 						{
-							scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim512(tmp_feat, all_face_feats + i*dim));
-						}
+							for (int i = chunk_id*chunk_size; i < __min(total_face_num, (chunk_id + 1)*chunk_size); i++)
+							{
+								scores[i] = __max(scores[i], ZQ_FaceRecognizerSphereFace::_cal_similarity_avx_dim512(tmp_feat, all_face_feats + i*dim));
+							}
+						});
 					}
 
 					else
 					{
-#pragma omp parallel for schedule(static, chunk_size) num_threads(real_threads)
-						for (long long i = 0; i < total_face_num; i++)
+						ZQ_CNN_ThreadPool::ParallelFor((total_face_num + chunk_size - 1) / chunk_size, real_threads, [&](int chunk_id, int thread_id)
 						{
-							scores[i] = __max(scores[i], ZQ_MathBase::DotProduct(dim, tmp_feat, all_face_feats + i*dim));
-						}
+							for (long long i = (long long)chunk_id*chunk_size; i < __min(total_face_num, (chunk_id + 1)*chunk_size); i++)
+							{
+								scores[i] = __max(scores[i], ZQ_MathBase::DotProduct(dim, tmp_feat, all_face_feats + i*dim));
+							}
+						});
 					}
 				}
 			}
@@ -310,16 +320,18 @@ namespace ZQ
 			else
 			{
 				int chunk_size = (person_num + real_threads - 1) / real_threads;
-#pragma omp parallel for schedule(static, chunk_size) num_threads(real_threads)
-				for (int i = 0; i < person_num; i++)
+				ZQ_CNN_ThreadPool::ParallelFor((person_num + chunk_size - 1) / chunk_size, real_threads, [&](int chunk_id, int thread_id)
 				{
-					float tmp = -FLT_MAX;
-					for (long long j = person_face_offset[i]; j < person_face_offset[i] + person_face_num[i]; j++)
+					for (int i = chunk_id*chunk_size; i < __min(person_num, (chunk_id + 1)*chunk_size); i++)
 					{
-						tmp = __max(tmp, scores[j]);
+						float tmp = -FLT_MAX;
+						for (long long j = person_face_offset[i]; j < person_face_offset[i] + person_face_num[i]; j++)
+						{
+							tmp = __max(tmp, scores[j]);
+						}
+						max_scores[i] = tmp;
 					}
-					max_scores[i] = tmp;
-				}
+				});
 			}
 			
 			_aligned_free(feat_aligned);
@@ -460,12 +472,11 @@ namespace ZQ
 			}
 			else
 			{
-				int chunk_size = 100;
 				int handled[1] = { 0 };
 				__int64 tmp_same_pair_num[1] = { 0 };
+				std::mutex mutex;
 				printf("real_thread_num = %d\n", real_thread_num);
-#pragma omp parallel for schedule(dynamic,chunk_size) num_threads(real_thread_num) shared(handled)
-				for (int pp = 0; pp < person_num; pp++)
+				ZQ_CNN_ThreadPool::ParallelFor(person_num, real_thread_num, [&](int pp, int thread_id)
 				{
 
 					__int64 cur_face_offset = person_face_offset[pp];
@@ -495,8 +506,8 @@ namespace ZQ
 								idx++;
 							}
 						}
-#pragma omp critical
 						{
+							std::lock_guard<std::mutex> lock(mutex);
 							if (idx > 0)
 							{
 								for (int kk = 0; kk < idx; kk++)
@@ -518,12 +529,12 @@ namespace ZQ
 							}
 						}
 					}
-#pragma omp critical
 					{
+						std::lock_guard<std::mutex> lock(mutex);
 						(*handled) ++;
 						printf("%d/%d\n", *handled, person_num);
 					}
-				}
+				});
 				same_pair_num = tmp_same_pair_num[0];
 				notsame_pair_num = all_pair_num - same_pair_num;
 			}
@@ -628,9 +639,8 @@ namespace ZQ
 				}
 				else
 				{
-					int chunk_size = (person_num + max_thread_num - 1) / max_thread_num;
-#pragma omp parallel for schedule(static,chunk_size) num_threads(max_thread_num)
-					for (int p = 0; p < person_num; p++)
+					std::mutex mutex;
+					ZQ_CNN_ThreadPool::ParallelFor(person_num, max_thread_num, [&](int p, int thread_id)
 					{
 						__int64 cur_offset = person_face_offset[p];
 						__int64 cur_num = person_face_num[p];
@@ -664,10 +674,9 @@ namespace ZQ
 							}
 						}
 						pivot_ids[p] = pivot_id;
-					}
+					});
 
-#pragma omp parallel for schedule(static,chunk_size) num_threads(max_thread_num)
-					for (int i = 0; i < person_num; i++)
+					ZQ_CNN_ThreadPool::ParallelFor(person_num, max_thread_num, [&](int i, int thread_id)
 					{
 						for (int j = i + 1; j < person_num; j++)
 						{
@@ -676,14 +685,14 @@ namespace ZQ
 							float tmp_score = _compute_similarity(dim, cur_i_feat, cur_j_feat);
 							if (tmp_score >= similarity_thresh)
 							{
-#pragma omp critical
 								{
+									std::lock_guard<std::mutex> lock(mutex);
 									repeat_pairs.push_back(std::make_pair(i, j));
 									repeat_scores.push_back(tmp_score);
 								}
 							}
 						}
-					}
+					});
 				}
 			}
 			else
@@ -722,9 +731,8 @@ namespace ZQ
 				else
 				{
 					int handled[1] = { 0 };
-					int chunk_size = (person_num + max_thread_num - 1) / max_thread_num;
-#pragma omp parallel for schedule(static,chunk_size) num_threads(max_thread_num)
-					for (int i = 0; i < person_num; i++)
+					std::mutex mutex;
+					ZQ_CNN_ThreadPool::ParallelFor(person_num, max_thread_num, [&](int i, int thread_id)
 					{
 						for (int j = i + 1; j < person_num; j++)
 						{
@@ -741,22 +749,22 @@ namespace ZQ
 							}
 							if (max_score >= similarity_thresh)
 							{
-#pragma omp critical
 								{
+									std::lock_guard<std::mutex> lock(mutex);
 									repeat_pairs.push_back(std::make_pair(i, j));
 									repeat_scores.push_back(max_score);
 								}
 							}
 						}
-#pragma omp critical
 						{
+							std::lock_guard<std::mutex> lock(mutex);
 							handled[0] ++;
 							if (handled[0] % 10 == 0)
 							{
 								printf("%d/%d handled\n", handled[0], person_num);
 							}
 						}
-					}
+					});
 				}
 			}
 			return true;
@@ -2,7 +2,7 @@
 #define _ZQ_FACE_RECOGNIZER_SPHERE_FACE_ZQCNN_H_
 #pragma once
 #include "ZQ_FaceRecognizerSphereFace.h"
-#include "ZQ_CNN_Net.h"
+#include "ZQ_CNN_Model.h"
 #include "ZQ_MathBase.h"
 #include <string.h>
 namespace ZQ
@@ -54,7 +54,7 @@ namespace ZQ
 			
 			if (catch_predefined)
 			{
-				if (!net.LoadFrom(zqparam_file, nchwbin_file))
+				if (!model.LoadFrom(zqparam_file, nchwbin_file) || !net.Init(model))
 				{
 					feat_dim = 0;
 					return false;
@@ -65,32 +65,41 @@ namespace ZQ
 			{
 				zqparam_file = prototxt_file;
 				nchwbin_file = caffemodel_file;
-				output_blob_name = out_blob_name;
-
-				if (!net.LoadFrom(zqparam_file, nchwbin_file))
+				if (!model.LoadFrom(zqparam_file, nchwbin_file))
 				{
 					feat_dim = 0;
 					return false;
 				}
-				
-				int C, H, W;
-				net.GetInputDim(C, H, W);
-				ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
-				input.ChangeSize(1, H, W, C, 0, 0);
-				
-				if (!net.Forward(input))
-				{
-					printf("failed to forward\n");
-					return false;
-				}
-				const ZQ_CNN_Tensor4D* out = net.GetBlobByName(output_blob_name);
-				if (out == NULL)
-					return false;
-				feat_dim = out->GetC();
-				return true;
+				return InitShared(model, out_blob_name);
 			}
 		}
 
+		/*run a model loaded by the caller, so that the recognizers of all threads share one copy of the weights,
+		the model must live longer than this recognizer*/
+		bool InitShared(const ZQ_CNN_Model& shared_model, const std::string out_blob_name)
+		{
+			output_blob_name = out_blob_name;
+			feat_dim = 0;
+			if (!net.Init(shared_model))
+				return false;
+
+			int C, H, W;
+			net.GetInputDim(C, H, W);
+			ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
+			input.ChangeSize(1, H, W, C, 0, 0);
+
+			if (!net.Forward(input))
+			{
+				printf("failed to forward\n");
+				return false;
+			}
+			const ZQ_CNN_Tensor4D* out = net.GetBlobByName(output_blob_name);
+			if (out == NULL)
+				return false;
+			feat_dim = out->GetC();
+			return true;
+		}
+
 		virtual int GetFeatDim() const
 		{
 			return feat_dim;
@@ -212,7 +221,8 @@ namespace ZQ
 
 		ZQ_CNN_Tensor4D_NHW_C_Align128bit input;
 		std::vector<unsigned char> bgr_buffer;
-		ZQ_CNN_Net net;
+		ZQ_CNN_Model model;
+		ZQ_CNN_ExecContext net;
 		int feat_dim;
 		std::string zqparam_file;
 		std::string nchwbin_file;